@@ -52,6 +52,7 @@ typedef struct arguments_t {
 	int init_pct;
 	int read_pct;
 	bool del_bin;
+	bool key_digest;
 	uint64_t transactions_limit;
 	int threads;
 	int throughput;
@@ -134,6 +135,7 @@ typedef struct threaddata_t {
 int run_benchmark(arguments* args);
 int linear_write(clientdata* data);
 int random_read_write(clientdata* data);
+int key_digest(arguments* args);
 
 threaddata* create_threaddata(clientdata* cdata, uint64_t key_start, uint64_t n_keys);
 void destroy_threaddata(threaddata* tdata);
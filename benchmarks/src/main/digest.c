@@ -0,0 +1,123 @@
+/*******************************************************************************
+ * Copyright 2008-2018 by Aerospike.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ******************************************************************************/
+#include "benchmark.h"
+#include <aerospike/as_key.h>
+#include <citrusleaf/cf_clock.h>
+#include <string.h>
+
+// Keys per digest call.  Matches a typical batch read size.
+#define DIGEST_BATCH_SIZE 5000
+
+static void
+init_keys(as_key* keys, uint32_t n_keys, const char* ns, const char* set, uint64_t key)
+{
+	for (uint32_t i = 0; i < n_keys; i++) {
+		as_key_init_int64(&keys[i], ns, set, (int64_t)(key + i));
+	}
+}
+
+static void
+reset_keys(as_key* keys, uint32_t n_keys)
+{
+	for (uint32_t i = 0; i < n_keys; i++) {
+		keys[i].digest.init = false;
+	}
+}
+
+int
+key_digest(arguments* args)
+{
+	// Digest computation does not access the server.  Time the same keys with the
+	// per-key and the multi-key digest functions on the calling thread.
+	uint64_t n_keys = args->keys;
+	uint32_t batch_size = n_keys < DIGEST_BATCH_SIZE ? (uint32_t)n_keys : DIGEST_BATCH_SIZE;
+
+	if (batch_size == 0) {
+		blog_error("No keys to digest");
+		return -1;
+	}
+
+	as_key* keys = malloc(sizeof(as_key) * batch_size);
+	as_key* check = malloc(sizeof(as_key) * batch_size);
+	uint64_t scalar_ns = 0;
+	uint64_t batch_ns = 0;
+	uint64_t key = args->start_key;
+	uint64_t remaining = n_keys;
+	int ret = 0;
+	as_error err;
+
+	while (remaining > 0) {
+		uint32_t n = remaining < batch_size ? (uint32_t)remaining : batch_size;
+
+		init_keys(keys, n, args->namespace, args->set, key);
+
+		uint64_t begin = cf_getns();
+
+		for (uint32_t i = 0; i < n; i++) {
+			if (as_key_set_digest(&err, &keys[i]) != AEROSPIKE_OK) {
+				blog_error("Key digest failed: %d - %s", err.code, err.message);
+				ret = -1;
+				goto Done;
+			}
+		}
+		scalar_ns += cf_getns() - begin;
+
+		memcpy(check, keys, sizeof(as_key) * n);
+		reset_keys(keys, n);
+
+		begin = cf_getns();
+
+		if (as_keys_set_digests(&err, keys, n) != AEROSPIKE_OK) {
+			blog_error("Keys digest failed: %d - %s", err.code, err.message);
+			ret = -1;
+			goto Done;
+		}
+		batch_ns += cf_getns() - begin;
+
+		for (uint32_t i = 0; i < n; i++) {
+			if (memcmp(keys[i].digest.value, check[i].digest.value, AS_DIGEST_VALUE_SIZE) != 0) {
+				blog_error("Digest mismatch for key %" PRIu64, key + i);
+				ret = -1;
+				goto Done;
+			}
+		}
+
+		for (uint32_t i = 0; i < n; i++) {
+			as_key_destroy(&keys[i]);
+		}
+		key += n;
+		remaining -= n;
+	}
+
+	blog_info("digest(keys=%" PRIu64 " batch=%u)", n_keys, batch_size);
+	blog_info("as_key_set_digest:   %.1f ns/key", (double)scalar_ns / n_keys);
+	blog_info("as_keys_set_digests: %.1f ns/key", (double)batch_ns / n_keys);
+
+	if (batch_ns > 0) {
+		blog_info("speedup:             %.2fx", (double)scalar_ns / batch_ns);
+	}
+
+Done:
+	free(check);
+	free(keys);
+	return ret;
+}
@@ -160,11 +160,13 @@ print_usage(const char* program)
 	blog_line("    Stop approximately after number of transaction performed in random read/write mode.");
 	blog_line("");
 
-	blog_line("-w --workload I,<percent> | RU,<read percent> | DB  # Default: RU,50");
+	blog_line("-w --workload I,<percent> | RU,<read percent> | DB | KD  # Default: RU,50");
 	blog_line("   Desired workload.");
 	blog_line("   -w I,60  : Linear 'insert' workload initializing 60%% of the keys.");
 	blog_line("   -w RU,80 : Random read/update workload with 80%% reads and 20%% writes.");
 	blog_line("   -w DB    : Bin delete workload.");
+	blog_line("   -w KD    : Key digest workload.  Compares per-key and multi-key digest");
+	blog_line("              computation of <keys> keys.  The server is not accessed.");
 	blog_line("");
 	
 	blog_line("-z --threads <count> # Default: 16");
@@ -374,6 +376,8 @@ print_args(arguments* args)
 		blog_line("initialize %d%% of records", args->init_pct);
 	} else if (args->del_bin) {
 		blog_line("delete %d bins in %d records", args->numbins, args->keys);
+	} else if (args->key_digest) {
+		blog_line("digest %" PRIu64 " keys", args->keys);
 	} else if (args->read_pct) {
 		blog_line("read %d%% write %d%%", args->read_pct, 100 - args->read_pct);
 		blog_line("stop after:             %" PRIu64 " transactions", args->transactions_limit);
@@ -657,6 +661,8 @@ set_args(int argc, char * const * argv, arguments* args)
 				} else if (strncmp(tmp, "DB", 2) == 0) {
 					args->init = true;
 					args->del_bin = true;
+				} else if (strncmp(tmp, "KD", 2) == 0) {
+					args->key_digest = true;
 				}
 
 				free(tmp);
@@ -866,6 +872,7 @@ main(int argc, char * const * argv)
 	args.init_pct = 100;
 	args.read_pct = 50;
 	args.del_bin = false;
+	args.key_digest = false;
 	args.threads = 16;
 	args.throughput = 0;
 	args.read_timeout = 0;
@@ -891,7 +898,13 @@ main(int argc, char * const * argv)
 	
 	if (ret == 0) {
 		print_args(&args);
-		run_benchmark(&args);
+
+		if (args.key_digest) {
+			ret = key_digest(&args);
+		}
+		else {
+			run_benchmark(&args);
+		}
 	}
 	else {
 		print_usage(argv[0]);
@@ -53,6 +53,10 @@ ifeq ($(EVENT_LIB),libevent)
   TEST_LDFLAGS += -levent_core -levent_pthreads
 endif
 
+ifeq ($(EVENT_LIB),liburing)
+  TEST_LDFLAGS += -luring
+endif
+
 AS_HOST := 127.0.0.1
 AS_PORT := 3000
 AS_ARGS := -h $(AS_HOST) -p $(AS_PORT)
@@ -27,6 +27,7 @@
  */
 
 #include <aerospike/aerospike.h>
+#include <aerospike/as_arena.h>
 #include <aerospike/as_batch.h>
 #include <aerospike/as_listener.h>
 #include <aerospike/as_error.h>
@@ -38,6 +39,7 @@
 #include <aerospike/as_status.h>
 #include <aerospike/as_val.h>
 #include <aerospike/as_vector.h>
+#include <citrusleaf/alloc.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -107,8 +109,119 @@ typedef struct as_batch_read_records_s {
 	 * List of as_batch_read_record(s).
 	 */
 	as_vector list;
+
+	/**
+	 * @private
+	 * Memory blocks that hold record bin values when as_policy_batch.arena_bins is true.
+	 */
+	as_arena arena;
+
+	/**
+	 * @private
+	 * If true, as_batch_read_destroy() frees this instance.
+	 */
+	bool _free;
 } as_batch_read_records;
 
+/**
+ * Type of write performed on a batch write record.
+ */
+typedef enum as_batch_write_type_e {
+	/**
+	 * Apply as_batch_write_record.ops to the record.
+	 */
+	AS_BATCH_WRITE_OPERATE,
+
+	/**
+	 * Delete the record.
+	 */
+	AS_BATCH_WRITE_REMOVE,
+
+	/**
+	 * Apply user defined function as_batch_write_record.function in module
+	 * as_batch_write_record.module with as_batch_write_record.arglist to the record.
+	 */
+	AS_BATCH_WRITE_APPLY
+} as_batch_write_type;
+
+/**
+ * Key and write command used in batch write commands where a different write can be
+ * applied to each key.  The per-record results are located in the same batch record.
+ */
+typedef struct as_batch_write_record_s {
+	/**
+	 * The key requested.
+	 */
+	as_key key;
+
+	/**
+	 * Type of write to perform.
+	 */
+	as_batch_write_type type;
+
+	/**
+	 * Operations to apply when type is AS_BATCH_WRITE_OPERATE.  Records may share the
+	 * same operations.  Consecutive records with the same operations pointer are sent
+	 * to the server only once.
+	 */
+	as_operations* ops;
+
+	/**
+	 * UDF module when type is AS_BATCH_WRITE_APPLY.
+	 */
+	const char* module;
+
+	/**
+	 * UDF function when type is AS_BATCH_WRITE_APPLY.
+	 */
+	const char* function;
+
+	/**
+	 * UDF arguments when type is AS_BATCH_WRITE_APPLY.  May be NULL.
+	 */
+	as_list* arglist;
+
+	/**
+	 * The result of the write transaction.
+	 *
+	 * Values:
+	 * <ul>
+	 * <li>
+	 * AEROSPIKE_OK: write succeeded
+	 * </li>
+	 * <li>
+	 * AEROSPIKE_NO_RESPONSE: the server did not respond for this record
+	 * </li>
+	 * <li>
+	 * Other: transaction error code
+	 * </li>
+	 * </ul>
+	 */
+	as_status result;
+
+	/**
+	 * Bins returned by the write.  This contains the results of read operations for
+	 * AS_BATCH_WRITE_OPERATE and the "SUCCESS" or "FAILURE" bin for AS_BATCH_WRITE_APPLY.
+	 */
+	as_record record;
+
+	/**
+	 * Is it possible that the write transaction completed even though this record
+	 * received an error.
+	 */
+	bool in_doubt;
+} as_batch_write_record;
+
+/**
+ * List of as_batch_write_record(s).
+ */
+typedef struct as_batch_write_records_s {
+	/**
+	 * List of as_batch_write_record(s).
+	 */
+	as_vector list;
+} as_batch_write_records;
+
 /**
  * This callback will be called with the results of aerospike_batch_get(),
  * or aerospike_batch_exists() functions.
@@ -155,6 +268,22 @@ typedef bool (*as_batch_callback_xdr)(as_key* key, as_record* record, void* udat
  */
 typedef void (*as_async_batch_listener)(as_error* err, as_batch_read_records* records, void* udata, as_event_loop* event_loop);
 
+/**
+ * Asynchronous batch write user callback.  This function is called once when the batch completes
+ * or an error has occurred.
+ *
+ * @param err			This error structure is only populated when the command fails. Null on success.
+ * @param records 		Records with per-record results.  Records must be destroyed with
+ * 						as_batch_write_destroy() when done.
+ * @param udata 		User data that is forwarded from asynchronous command function.
+ * @param event_loop 	Event loop that this command was executed on.  Use this event loop when running
+ * 						nested asynchronous commands when single threaded behavior is desired for the
+ * 						group of commands.
+ *
+ * @ingroup batch_operations
+ */
+typedef void (*as_async_batch_write_listener)(as_error* err, as_batch_write_records* records, void* udata, as_event_loop* event_loop);
+
 /******************************************************************************
  * FUNCTIONS
  *****************************************************************************/
@@ -172,7 +301,9 @@ typedef void (*as_async_batch_listener)(as_error* err, as_batch_read_records* re
  * @ingroup batch_operations
  */
 #define as_batch_read_inita(__records, __capacity) \
-	as_vector_inita(&((__records)->list), sizeof(as_batch_read_record), __capacity);
+	as_vector_inita(&((__records)->list), sizeof(as_batch_read_record), __capacity);\
+	as_arena_init(&((__records)->arena));\
+	(__records)->_free = false;
 
 /**
  * Initialize `as_batch_read_records` with specified capacity on the heap.
@@ -190,6 +321,8 @@ static inline void
 as_batch_read_init(as_batch_read_records* records, uint32_t capacity)
 {
 	as_vector_init(&records->list, sizeof(as_batch_read_record), capacity);
+	as_arena_init(&records->arena);
+	records->_free = false;
 }
 
 /**
@@ -207,7 +340,10 @@ as_batch_read_init(as_batch_read_records* records, uint32_t capacity)
 static inline as_batch_read_records*
 as_batch_read_create(uint32_t capacity)
 {
-	return (as_batch_read_records*) as_vector_create(sizeof(as_batch_read_record), capacity);
+	as_batch_read_records* records = (as_batch_read_records*)cf_malloc(sizeof(as_batch_read_records));
+	as_batch_read_init(records, capacity);
+	records->_free = true;
+	return records;
 }
 
 /**
@@ -237,6 +373,84 @@ as_batch_read_reserve(as_batch_read_records* records)
 AS_EXTERN void
 as_batch_read_destroy(as_batch_read_records* records);
 
+/**
+ * Initialize `as_batch_write_records` with specified capacity on the stack using alloca().
+ *
+ * When the batch is no longer needed, then use as_batch_write_destroy() to
+ * release the batch and associated resources.
+ *
+ * @param __records		Batch record list.
+ * @param __capacity	Initial capacity of batch record list. List will resize when necessary.
+ *
+ * @relates as_batch_write_record
+ * @ingroup batch_operations
+ */
+#define as_batch_write_inita(__records, __capacity) \
+	as_vector_inita(&((__records)->list), sizeof(as_batch_write_record), __capacity);
+
+/**
+ * Initialize `as_batch_write_records` with specified capacity on the heap.
+ *
+ * When the batch is no longer needed, then use as_batch_write_destroy() to
+ * release the batch and associated resources.
+ *
+ * @param records	Batch record list.
+ * @param capacity	Initial capacity of batch record list. List will resize when necessary.
+ *
+ * @relates as_batch_write_record
+ * @ingroup batch_operations
+ */
+static inline void
+as_batch_write_init(as_batch_write_records* records, uint32_t capacity)
+{
+	as_vector_init(&records->list, sizeof(as_batch_write_record), capacity);
+}
+
+/**
+ * Create `as_batch_write_records` on heap with specified list capacity on the heap.
+ *
+ * When the batch is no longer needed, then use as_batch_write_destroy() to
+ * release the batch and associated resources.
+ *
+ * @param capacity	Initial capacity of batch record list. List will resize when necessary.
+ * @return			Batch record list.
+ *
+ * @relates as_batch_write_record
+ * @ingroup batch_operations
+ */
+static inline as_batch_write_records*
+as_batch_write_create(uint32_t capacity)
+{
+	return (as_batch_write_records*) as_vector_create(sizeof(as_batch_write_record), capacity);
+}
+
+/**
+ * Reserve a new `as_batch_write_record` slot.  Capacity will be increased when necessary.
+ * Return reference to record.  The record is already initialized to zeroes.
+ *
+ * @param records	Batch record list.
+ *
+ * @relates as_batch_write_record
+ * @ingroup batch_operations
+ */
+static inline as_batch_write_record*
+as_batch_write_reserve(as_batch_write_records* records)
+{
+	return (as_batch_write_record*)as_vector_reserve(&records->list);
+}
+
+/**
+ * Destroy keys and records in record list.  It's the responsility of the caller to
+ * destroy `as_batch_write_record.ops` and `as_batch_write_record.arglist` when necessary.
+ *
+ * @param records	Batch record list.
+ *
+ * @relates as_batch_write_record
+ * @ingroup batch_operations
+ */
+AS_EXTERN void
+as_batch_write_destroy(as_batch_write_records* records);
+
 /**
  * Do the connected servers support the new batch index protocol.
  * The cluster must already be connected (aerospike_connect()) prior to making this call.
@@ -478,6 +692,199 @@ aerospike_batch_exists(
 	aerospike_batch_read_callback callback, void* udata
 	);
 
+/**
+ * Write multiple records in one batch call.  Each record specifies its own write type
+ * (operate, remove or apply) and the per-record results are located in the same batch array.
+ * This method requires servers that support batch writes ("batch-any" feature).
+ *
+ * ~~~~~~~~~~{.c}
+ * as_operations ops;
+ * as_operations_inita(&ops, 1);
+ * as_operations_add_write_int64(&ops, "bin1", 100);
+ *
+ * as_batch_write_records records;
+ * as_batch_write_inita(&records, 2);
+ *
+ * as_batch_write_record* record = as_batch_write_reserve(&records);
+ * as_key_init(&record->key, "ns", "set", "key1");
+ * record->type = AS_BATCH_WRITE_OPERATE;
+ * record->ops = &ops;
+ *
+ * record = as_batch_write_reserve(&records);
+ * as_key_init(&record->key, "ns", "set", "key2");
+ * record->type = AS_BATCH_WRITE_REMOVE;
+ *
+ * if (aerospike_batch_write(&as, &err, NULL, NULL, &records) != AEROSPIKE_OK) {
+ *     fprintf(stderr, "error(%d) %s at [%s:%d]", err.code, err.message, err.file, err.line);
+ * }
+ *
+ * as_batch_write_destroy(&records);
+ * as_operations_destroy(&ops);
+ * ~~~~~~~~~~
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The batch policy to use for this operation. If NULL, then the default batch
+ * 						policy with max_retries set to zero will be used.
+ * @param policy_write	The per-record write policy. If NULL, then the default batch write policy
+ * 						will be used.
+ * @param records		List of keys and writes.  The per-record results are located in the same array.
+ *
+ * @return AEROSPIKE_OK if all node commands succeeded. Otherwise an error.  Per-record errors are
+ * returned in as_batch_write_record.result.
+ *
+ * @ingroup batch_operations
+ */
+AS_EXTERN as_status
+aerospike_batch_write(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_batch_write_records* records
+	);
+
+/**
+ * Asynchronously write multiple records in one batch call.  Each record specifies its own
+ * write type (operate, remove or apply).  This method requires servers that support batch
+ * writes ("batch-any" feature).
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The batch policy to use for this operation. If NULL, then the default batch
+ * 						policy with max_retries set to zero will be used.
+ * @param policy_write	The per-record write policy. If NULL, then the default batch write policy
+ * 						will be used.
+ * @param records		List of keys and writes.  The per-record results are located in the same array.
+ * 						Must create using as_batch_write_create() (which allocates memory on heap) because
+ * 						async method will return immediately after queueing command.
+ * @param listener 		User function to be called with command results.
+ * @param udata 		User data to be forwarded to user callback.
+ * @param event_loop 	Event loop assigned to run this command. If NULL, an event loop will be choosen by round-robin.
+ *
+ * @return AEROSPIKE_OK if async command succesfully queued. Otherwise an error.
+ *
+ * @ingroup batch_operations
+ */
+AS_EXTERN as_status
+aerospike_batch_write_async(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_batch_write_records* records,
+	as_async_batch_write_listener listener, void* udata, as_event_loop* event_loop
+	);
+
+/**
+ * Apply the same operations to multiple records in one batch call.  The type and ops
+ * of each batch record are set by this function.  The per-record results are located
+ * in the same batch array.
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The batch policy to use for this operation. If NULL, then the default batch
+ * 						policy with max_retries set to zero will be used.
+ * @param policy_write	The per-record write policy. If NULL, then the default batch write policy
+ * 						will be used.
+ * @param records		List of keys.  The per-record results are located in the same array.
+ * @param ops			The operations to apply to each record.
+ *
+ * @return AEROSPIKE_OK if all node commands succeeded. Otherwise an error.
+ *
+ * @ingroup batch_operations
+ */
+AS_EXTERN as_status
+aerospike_batch_operate(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_batch_write_records* records,
+	const as_operations* ops
+	);
+
+/**
+ * Asynchronously apply the same operations to multiple records in one batch call.
+ * See aerospike_batch_operate() and aerospike_batch_write_async().
+ *
+ * @ingroup batch_operations
+ */
+AS_EXTERN as_status
+aerospike_batch_operate_async(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_batch_write_records* records,
+	const as_operations* ops, as_async_batch_write_listener listener, void* udata,
+	as_event_loop* event_loop
+	);
+
+/**
+ * Delete multiple records in one batch call.  The type of each batch record is set by
+ * this function.  The per-record results are located in the same batch array.
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The batch policy to use for this operation. If NULL, then the default batch
+ * 						policy with max_retries set to zero will be used.
+ * @param policy_write	The per-record write policy. If NULL, then the default batch write policy
+ * 						will be used.
+ * @param records		List of keys.  The per-record results are located in the same array.
+ *
+ * @return AEROSPIKE_OK if all node commands succeeded. Otherwise an error.
+ *
+ * @ingroup batch_operations
+ */
+AS_EXTERN as_status
+aerospike_batch_remove(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_batch_write_records* records
+	);
+
+/**
+ * Asynchronously delete multiple records in one batch call.
+ * See aerospike_batch_remove() and aerospike_batch_write_async().
+ *
+ * @ingroup batch_operations
+ */
+AS_EXTERN as_status
+aerospike_batch_remove_async(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_batch_write_records* records,
+	as_async_batch_write_listener listener, void* udata, as_event_loop* event_loop
+	);
+
+/**
+ * Apply the same user defined function to multiple records in one batch call.  The type
+ * and UDF fields of each batch record are set by this function.  The UDF return value of
+ * each record is located in the "SUCCESS" bin of as_batch_write_record.record.
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The batch policy to use for this operation. If NULL, then the default batch
+ * 						policy with max_retries set to zero will be used.
+ * @param policy_write	The per-record write policy. If NULL, then the default batch write policy
+ * 						will be used.
+ * @param records		List of keys.  The per-record results are located in the same array.
+ * @param module		The module containing the function to execute.
+ * @param function		The function to execute.
+ * @param arglist		The arguments for the function.
+ *
+ * @return AEROSPIKE_OK if all node commands succeeded. Otherwise an error.
+ *
+ * @ingroup batch_operations
+ */
+AS_EXTERN as_status
+aerospike_batch_apply(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_batch_write_records* records,
+	const char* module, const char* function, as_list* arglist
+	);
+
+/**
+ * Asynchronously apply the same user defined function to multiple records in one batch call.
+ * See aerospike_batch_apply() and aerospike_batch_write_async().
+ *
+ * @ingroup batch_operations
+ */
+AS_EXTERN as_status
+aerospike_batch_apply_async(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_batch_write_records* records,
+	const char* module, const char* function, as_list* arglist,
+	as_async_batch_write_listener listener, void* udata, as_event_loop* event_loop
+	);
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
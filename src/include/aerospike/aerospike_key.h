@@ -34,6 +34,7 @@
 #include <aerospike/as_key.h>
 #include <aerospike/as_list.h>
 #include <aerospike/as_operations.h>
+#include <aerospike/as_operations_template.h>
 #include <aerospike/as_policy.h>
 #include <aerospike/as_record.h>
 #include <aerospike/as_status.h>
@@ -352,6 +353,10 @@ aerospike_key_put(
  * as_record_destroy(&rec);
  * ~~~~~~~~~~
  *
+ * Heap allocated string and blob values of at least 16KB that own their data are sent in place.
+ * The command holds a reference to these values until it completes, so they must not be
+ * modified until the listener is called.
+ *
  * @param as				The aerospike instance to use for this operation.
  * @param err				The as_error to be populated if an error occurs.
  * @param policy			The policy to use for this operation. If NULL, then the default policy will be used.
@@ -531,6 +536,73 @@ aerospike_key_operate_async(
 	as_async_record_listener listener, void* udata, as_event_loop* event_loop, as_pipe_listener pipe_listener
 	);
 
+/**
+ * Lookup a record by key, then perform operations that were serialized in advance
+ * with `as_operations_template_init()`.  Scalar operation values, ttl and generation
+ * can be replaced per call with `args`.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_template_args args;
+ * as_template_args_inita(&args, &tmpl);
+ * as_template_args_set_int64(&args, 0, 456);
+ *
+ * as_record* rec = NULL;
+ *
+ * if (aerospike_key_operate_template(&as, &err, NULL, &key, &tmpl, &args, &rec) != AEROSPIKE_OK) {
+ * 	   printf("error(%d) %s at [%s:%d]", err.code, err.message, err.file, err.line);
+ * }
+ * else {
+ * 	   as_record_destroy(rec);
+ * }
+ * ~~~~~~~~~~
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param key			The key of the record.
+ * @param tmpl			The serialized operations to perform on the record.
+ * @param args			Replacement values for this call. If NULL, template values are used.
+ * @param rec			The record to be populated with the data from AS_OPERATOR_READ operations.
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ *
+ * @ingroup key_operations
+ */
+AS_EXTERN as_status
+aerospike_key_operate_template(
+	aerospike* as, as_error* err, const as_policy_operate* policy, const as_key* key,
+	const as_operations_template* tmpl, const as_template_args* args, as_record** rec
+	);
+
+/**
+ * Asynchronously lookup a record by key, then perform operations that were serialized
+ * in advance with `as_operations_template_init()`.  Replacement values are copied into
+ * the command before this function returns.
+ *
+ * @param as				The aerospike instance to use for this operation.
+ * @param err				The as_error to be populated if an error occurs.
+ * @param policy			The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param key				The key of the record.
+ * @param tmpl				The serialized operations to perform on the record.
+ * @param args				Replacement values for this call. If NULL, template values are used.
+ * @param listener			User function to be called with command results.
+ * @param udata				User data to be forwarded to user callback.
+ * @param event_loop		Event loop assigned to run this command. If NULL, an event loop will be choosen by round-robin.
+ * @param pipe_listener		Enables command pipelining, if not NULL. The given callback is invoked after the current command
+ * 							has been sent to the server. This allows for issuing the next command even before receiving a
+ * 							result for the current command.
+ *
+ * @return AEROSPIKE_OK if async command succesfully queued. Otherwise an error.
+ *
+ * @ingroup key_operations
+ */
+AS_EXTERN as_status
+aerospike_key_operate_template_async(
+	aerospike* as, as_error* err, const as_policy_operate* policy, const as_key* key,
+	const as_operations_template* tmpl, const as_template_args* args,
+	as_async_record_listener listener, void* udata, as_event_loop* event_loop, as_pipe_listener pipe_listener
+	);
+
 /**
  * Lookup a record by key, then apply the UDF.
  *
@@ -0,0 +1,287 @@
+/*
+ * Copyright 2008-2018 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+/**
+ * @defgroup pipeline_operations Pipeline Operations
+ * @ingroup client_operations
+ *
+ * A pipeline queues single record commands on the calling thread and executes them
+ * together in `aerospike_pipeline_flush()`.  Queued commands are grouped by target node.
+ * Each node's commands are written back-to-back on one connection, and the responses
+ * are read in order.  Commands to different nodes are in flight at the same time.
+ * This gives synchronous callers pipelining throughput without an event loop.
+ *
+ * Each command keeps its own policy.  Timeouts and retries follow the same rules as
+ * the equivalent `aerospike_key_*` call, except that hedged reads are not supported.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_pipeline pipeline;
+ * aerospike_pipeline_begin(&as, &pipeline);
+ *
+ * as_record* recs[3] = {NULL, NULL, NULL};
+ *
+ * for (uint32_t i = 0; i < 3; i++) {
+ *     aerospike_pipeline_get(&pipeline, &err, NULL, &keys[i], &recs[i]);
+ * }
+ *
+ * aerospike_pipeline_flush(&pipeline, &err);
+ *
+ * for (uint32_t i = 0; i < 3; i++) {
+ *     if (as_pipeline_get_result(&pipeline, i)->status == AEROSPIKE_OK) {
+ *         // Process recs[i]
+ *         as_record_destroy(recs[i]);
+ *     }
+ * }
+ *
+ * aerospike_pipeline_end(&pipeline);
+ * ~~~~~~~~~~
+ *
+ * A pipeline must only be used by one thread at a time.
+ */
+
+#include <aerospike/aerospike.h>
+#include <aerospike/as_error.h>
+#include <aerospike/as_key.h>
+#include <aerospike/as_operations.h>
+#include <aerospike/as_policy.h>
+#include <aerospike/as_record.h>
+#include <aerospike/as_status.h>
+#include <aerospike/as_vector.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * Default maximum number of commands written to one connection before their
+ * responses are read.
+ *
+ * @ingroup pipeline_operations
+ */
+#define AS_PIPELINE_WINDOW_DEFAULT 256
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Result of one pipelined command.
+ *
+ * @ingroup pipeline_operations
+ */
+typedef struct as_pipeline_result_s {
+	/**
+	 * Command status.  AEROSPIKE_NO_RESPONSE if the command has not been executed.
+	 */
+	as_status status;
+
+	/**
+	 * Is it possible that the write command completed even though an error occurred?
+	 */
+	bool in_doubt;
+} as_pipeline_result;
+
+/**
+ * Commands queued on one thread for pipelined execution.
+ *
+ * @ingroup pipeline_operations
+ */
+typedef struct as_pipeline_s {
+	/**
+	 * @private
+	 * Client instance.
+	 */
+	aerospike* as;
+
+	/**
+	 * @private
+	 * Queued commands.
+	 */
+	as_vector commands;
+
+	/**
+	 * @private
+	 * Results of the last flush.
+	 */
+	as_vector results;
+
+	/**
+	 * @private
+	 * Serialized queued commands.
+	 */
+	uint8_t* buf;
+
+	/**
+	 * @private
+	 * Bytes used in buf.
+	 */
+	size_t buf_size;
+
+	/**
+	 * @private
+	 * Bytes allocated for buf.
+	 */
+	size_t buf_capacity;
+
+	/**
+	 * Maximum number of commands written to one connection before their responses are
+	 * read.  Limits the data buffered by the server and client sockets while the
+	 * connection is not being read.
+	 *
+	 * Default: AS_PIPELINE_WINDOW_DEFAULT
+	 */
+	uint32_t window;
+} as_pipeline;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Initialize an empty pipeline.  Call `aerospike_pipeline_end()` when done.
+ *
+ * @param as			The aerospike instance to use for pipelined commands.
+ * @param pipeline		The pipeline to initialize.
+ *
+ * @ingroup pipeline_operations
+ */
+AS_EXTERN void
+aerospike_pipeline_begin(aerospike* as, as_pipeline* pipeline);
+
+/**
+ * Queue a read of all bins of a record.  The command is serialized now and executed
+ * by `aerospike_pipeline_flush()`.
+ *
+ * @param pipeline		The pipeline.
+ * @param err			The as_error to be populated if the command can't be queued.
+ * @param policy		The policy to use for this command. If NULL, then the default policy will be used.
+ * @param key			The key of the record.  The key is not referenced after this call.
+ * @param rec 			The record to be populated when the pipeline is flushed. If the record pointer
+ *						is preset to NULL, the record will be created and initialized. If the record
+ *						pointer is not NULL, the record is assumed to be valid and will be reused. The
+ *						record pointer must remain valid until the pipeline is flushed.
+ *
+ * @return AEROSPIKE_OK if the command was queued. Otherwise an error.
+ *
+ * @ingroup pipeline_operations
+ */
+AS_EXTERN as_status
+aerospike_pipeline_get(
+	as_pipeline* pipeline, as_error* err, const as_policy_read* policy, const as_key* key,
+	as_record** rec
+	);
+
+/**
+ * Queue a write of a record.  The command is serialized now, so the key and record
+ * may be destroyed after this call.  The command is executed by `aerospike_pipeline_flush()`.
+ *
+ * @param pipeline		The pipeline.
+ * @param err			The as_error to be populated if the command can't be queued.
+ * @param policy		The policy to use for this command. If NULL, then the default policy will be used.
+ * @param key			The key of the record.
+ * @param rec 			The record containing the data to be written.
+ *
+ * @return AEROSPIKE_OK if the command was queued. Otherwise an error.
+ *
+ * @ingroup pipeline_operations
+ */
+AS_EXTERN as_status
+aerospike_pipeline_put(
+	as_pipeline* pipeline, as_error* err, const as_policy_write* policy, const as_key* key,
+	as_record* rec
+	);
+
+/**
+ * Queue multiple operations on a single record.  The command is serialized now, so the
+ * key and operations may be destroyed after this call.  The command is executed by
+ * `aerospike_pipeline_flush()`.
+ *
+ * @param pipeline		The pipeline.
+ * @param err			The as_error to be populated if the command can't be queued.
+ * @param policy		The policy to use for this command. If NULL, then the default policy will be used.
+ * @param key			The key of the record.
+ * @param ops			The operations to perform on the record.
+ * @param rec			The record to be populated with read operation results when the pipeline
+ *						is flushed.  May be NULL.  Otherwise, the record pointer must remain valid
+ *						until the pipeline is flushed.
+ *
+ * @return AEROSPIKE_OK if the command was queued. Otherwise an error.
+ *
+ * @ingroup pipeline_operations
+ */
+AS_EXTERN as_status
+aerospike_pipeline_operate(
+	as_pipeline* pipeline, as_error* err, const as_policy_operate* policy, const as_key* key,
+	const as_operations* ops, as_record** rec
+	);
+
+/**
+ * Execute all queued commands and empty the queue.  Results are stored in queue order
+ * and can be read with `as_pipeline_get_result()` until the next flush.
+ *
+ * @param pipeline		The pipeline.
+ * @param err			The as_error to be populated with the error of the first failed command.
+ *
+ * @return AEROSPIKE_OK if all commands succeeded. Otherwise the status of the first
+ * failed command in queue order.
+ *
+ * @ingroup pipeline_operations
+ */
+AS_EXTERN as_status
+aerospike_pipeline_flush(as_pipeline* pipeline, as_error* err);
+
+/**
+ * Release pipeline resources.  Commands that have not been flushed are discarded.
+ *
+ * @param pipeline		The pipeline.
+ *
+ * @ingroup pipeline_operations
+ */
+AS_EXTERN void
+aerospike_pipeline_end(as_pipeline* pipeline);
+
+/**
+ * Return number of commands queued since the last flush.
+ *
+ * @ingroup pipeline_operations
+ */
+static inline uint32_t
+as_pipeline_size(const as_pipeline* pipeline)
+{
+	return pipeline->commands.size;
+}
+
+/**
+ * Return result of command at index in the last flush.  Commands are indexed in the
+ * order they were queued.
+ *
+ * @ingroup pipeline_operations
+ */
+static inline as_pipeline_result*
+as_pipeline_get_result(as_pipeline* pipeline, uint32_t index)
+{
+	return (as_pipeline_result*)as_vector_get(&pipeline->results, index);
+}
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
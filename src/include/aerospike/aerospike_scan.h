@@ -96,6 +96,7 @@
 #include <aerospike/aerospike.h>
 #include <aerospike/as_listener.h>
 #include <aerospike/as_error.h>
+#include <aerospike/as_partition_filter.h>
 #include <aerospike/as_policy.h>
 #include <aerospike/as_record.h>
 #include <aerospike/as_scan.h>
@@ -118,6 +119,7 @@ extern "C" {
  * The following functions accept the callback:
  * - aerospike_scan_foreach()
  * - aerospike_scan_node()
+ * - aerospike_scan_partitions()
  * 
  * ~~~~~~~~~~{.c}
  * bool my_callback(const as_val * val, void* udata) {
@@ -328,6 +330,61 @@ aerospike_scan_node(
 	const char* node_name, aerospike_scan_foreach_callback callback, void* udata
 	);
 
+/**
+ * Scan the records in the specified namespace and set for a range of partitions.
+ *
+ * Partitions are grouped by the node that currently owns them and split into work units.
+ * If as_scan.concurrent is true, the units run in parallel on the cluster thread pool, so
+ * parallelism is not limited to the number of nodes.  Completion is tracked per partition.
+ * Partitions that fail because their node is unreachable or is migrating are retried
+ * against their current owner, up to policy->base.max_retries times, resuming after the
+ * last record returned.
+ *
+ * The scan progress is stored in pf->parts_all.  If the scan fails, the progress can be
+ * persisted with as_partitions_status_serialize() and passed back later with
+ * as_partition_filter_set_partitions() to resume the scan.  Requires servers that support
+ * partition scans.
+ *
+ * The callback function will be called for each record scanned. When all records have
+ * been scanned, then callback will be called with a NULL value for the record.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_scan scan;
+ * as_scan_init(&scan, "test", "demo");
+ * as_scan_set_concurrent(&scan, true);
+ *
+ * as_partition_filter pf;
+ * as_partition_filter_set_all(&pf);
+ *
+ * if (aerospike_scan_partitions(&as, &err, NULL, &scan, &pf, callback, NULL) != AEROSPIKE_OK ) {
+ * 	   uint32_t size;
+ * 	   uint8_t* cursor = as_partitions_status_serialize(pf.parts_all, &size);
+ * 	   // Save cursor to resume scan later.
+ * 	   cf_free(cursor);
+ * }
+ *
+ * as_partition_filter_destroy(&pf);
+ * as_scan_destroy(&scan);
+ * ~~~~~~~~~~
+ *
+ * @param as			The aerospike instance to use for this operation.
+ * @param err			The as_error to be populated if an error occurs.
+ * @param policy		The policy to use for this operation. If NULL, then the default policy will be used.
+ * @param scan			The scan to execute against the cluster.
+ * @param pf			Partitions to scan and the scan progress.
+ * @param callback		The function to be called for each record scanned.
+ * @param udata			User-data to be passed to the callback.
+ *
+ * @return AEROSPIKE_OK on success. Otherwise an error occurred.
+ *
+ * @ingroup scan_operations
+ */
+AS_EXTERN as_status
+aerospike_scan_partitions(
+	aerospike* as, as_error* err, const as_policy_scan* policy, const as_scan* scan,
+	as_partition_filter* pf, aerospike_scan_foreach_callback callback, void* udata
+	);
+
 /**
  * Asynchronously scan the records in the specified namespace and set in the cluster.
  *
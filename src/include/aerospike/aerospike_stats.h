@@ -17,6 +17,7 @@
 #pragma once
 
 #include <aerospike/aerospike.h>
+#include <aerospike/as_compress.h>
 #include <aerospike/as_node.h>
 
 /**
@@ -50,6 +51,18 @@ typedef struct as_conn_stats_s {
 	 */
 	uint32_t in_use;
 
+	/**
+	 * Connections opened on this node since the node was added to the cluster.
+	 * There can be multiple pools per node. This value is a summary of those pools on this node.
+	 */
+	uint64_t opened;
+
+	/**
+	 * Connections closed on this node since the node was added to the cluster.
+	 * There can be multiple pools per node. This value is a summary of those pools on this node.
+	 */
+	uint64_t closed;
+
 } as_conn_stats;
 
 /**
@@ -77,6 +90,26 @@ typedef struct as_node_stats_s {
 	 */
 	as_conn_stats pipeline;
 
+	/**
+	 * Sync connection requests satisfied by the lock-free connection cache on this node.
+	 * Sampled, so the count is approximate.
+	 */
+	uint64_t conn_cache_hits;
+
+	/**
+	 * Sync connection requests that missed the lock-free connection cache and fell back
+	 * to the locked connection pool on this node.  Sampled, so the count is approximate.
+	 */
+	uint64_t conn_cache_misses;
+
+	/**
+	 * Snapshot of command latency histograms and counters on this node.
+	 * Includes socket peeks saved by as_config.skip_conn_validation (conn_peeks_skipped)
+	 * and the stale pooled connections that mode detected (stale_conns).
+	 * See aerospike_node_metrics_reset() for interval reporting.
+	 */
+	as_node_metrics metrics;
+
 } as_node_stats;
 
 /**
@@ -100,6 +133,27 @@ typedef struct as_cluster_stats_s {
 	 */
 	uint32_t thread_pool_queued_tasks;
 
+	/**
+	 * Duration of the last cluster tend in microseconds.  Info requests are sent to all
+	 * nodes concurrently, so this is bounded by the slowest node rather than the sum of all nodes.
+	 */
+	uint64_t tend_duration;
+
+	/**
+	 * Number of cluster tends since the cluster was created.
+	 */
+	uint64_t tend_count;
+
+	/**
+	 * Statistics for commands compressed by the client.
+	 */
+	as_compress_stats compress;
+
+	/**
+	 * Statistics for compressed responses inflated by the client.
+	 */
+	as_compress_stats inflate;
+
 } as_cluster_stats;
 
 struct as_cluster_s;
@@ -173,6 +227,53 @@ aerospike_node_stats_destroy(as_node_stats* stats)
 	as_node_release(stats->node);
 }
 
+/**
+ * Reset node command metrics to zero.  Each counter is swapped atomically, so concurrent
+ * command updates are not lost.  If metrics is not null, it receives the values that were
+ * reset.  This is useful for reporting metrics over fixed intervals.
+ *
+ * Connection opened/closed counts are not reset.
+ *
+ * @param node		The server node.
+ * @param metrics	Optional metrics that existed before the reset. May be null.
+ *
+ * @ingroup cluster_stats
+ */
+AS_EXTERN void
+aerospike_node_metrics_reset(as_node* node, as_node_metrics* metrics);
+
+/**
+ * Reset command metrics to zero for all nodes in the cluster.  Cluster compression
+ * statistics are also reset.
+ *
+ * @param cluster	The aerospike cluster.
+ *
+ * @ingroup cluster_stats
+ */
+AS_EXTERN void
+aerospike_cluster_metrics_reset(struct as_cluster_s* cluster);
+
+/**
+ * Reset command metrics to zero for all nodes used by the client instance.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_cluster_stats stats;
+ * aerospike_stats(&as, &stats);
+ * aerospike_metrics_reset(&as);
+ * // Report stats.nodes[i].metrics.
+ * aerospike_stats_destroy(&stats);
+ * ~~~~~~~~~~
+ *
+ * @param as		The aerospike instance.
+ *
+ * @ingroup cluster_stats
+ */
+static inline void
+aerospike_metrics_reset(aerospike* as)
+{
+	aerospike_cluster_metrics_reset(as->cluster);
+}
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2008-2018 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Default arena block capacity.
+ */
+#define AS_ARENA_BLOCK_SIZE (64 * 1024)
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * @private
+ * Arena memory block.
+ */
+typedef struct as_arena_block_s {
+	struct as_arena_block_s* next;
+	uint32_t capacity;
+	uint32_t used;
+	uint8_t data[];
+} as_arena_block;
+
+/**
+ * @private
+ * Bump allocator whose allocations are released together in as_arena_destroy().
+ * An arena is not thread safe.  Threads should fill separate arenas and combine them
+ * with as_arena_move() when done.
+ */
+typedef struct as_arena_s {
+	as_arena_block* head;
+} as_arena;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Initialize empty arena.  A zeroed arena is also valid.
+ */
+static inline void
+as_arena_init(as_arena* arena)
+{
+	arena->head = NULL;
+}
+
+/**
+ * @private
+ * Allocate 8 byte aligned memory from arena.
+ */
+void*
+as_arena_alloc(as_arena* arena, size_t size);
+
+/**
+ * @private
+ * Transfer all memory blocks from src to dst.  src is empty afterwards.
+ */
+void
+as_arena_move(as_arena* dst, as_arena* src);
+
+/**
+ * @private
+ * Release all memory blocks.
+ */
+void
+as_arena_destroy(as_arena* arena);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -97,11 +97,13 @@ as_async_write_command_create(
 	cmd->parse_results = parse_results;
 	cmd->pipe_listener = pipe_listener;
 	cmd->buf = wcmd->space;
+	cmd->iov = NULL;
 	cmd->read_capacity = (uint32_t)(s - size - sizeof(as_async_write_command));
 	cmd->type = AS_ASYNC_TYPE_WRITE;
 	cmd->state = AS_ASYNC_STATE_UNREGISTERED;
 	cmd->flags = flags;
 	cmd->deserialize = false;
+	cmd->borrow = false;
 	wcmd->listener = listener;
 	return cmd;
 }
@@ -133,11 +135,13 @@ as_async_record_command_create(
 	cmd->parse_results = parse_results;
 	cmd->pipe_listener = pipe_listener;
 	cmd->buf = rcmd->space;
+	cmd->iov = NULL;
 	cmd->read_capacity = (uint32_t)(s - size - sizeof(as_async_record_command));
 	cmd->type = AS_ASYNC_TYPE_RECORD;
 	cmd->state = AS_ASYNC_STATE_UNREGISTERED;
 	cmd->flags = flags;
 	cmd->deserialize = deserialize;
+	cmd->borrow = false;
 	rcmd->listener = listener;
 	return cmd;
 }
@@ -168,11 +172,13 @@ as_async_value_command_create(
 	cmd->parse_results = parse_results;
 	cmd->pipe_listener = pipe_listener;
 	cmd->buf = vcmd->space;
+	cmd->iov = NULL;
 	cmd->read_capacity = (uint32_t)(s - size - sizeof(as_async_value_command));
 	cmd->type = AS_ASYNC_TYPE_VALUE;
 	cmd->state = AS_ASYNC_STATE_UNREGISTERED;
 	cmd->flags = flags;
 	cmd->deserialize = false;
+	cmd->borrow = false;
 	vcmd->listener = listener;
 	return cmd;
 }
@@ -201,11 +207,13 @@ as_async_info_command_create(
 	cmd->parse_results = as_event_command_parse_info;
 	cmd->pipe_listener = NULL;
 	cmd->buf = icmd->space;
+	cmd->iov = NULL;
 	cmd->read_capacity = (uint32_t)(s - size - sizeof(as_async_info_command));
 	cmd->type = AS_ASYNC_TYPE_INFO;
 	cmd->state = AS_ASYNC_STATE_UNREGISTERED;
 	cmd->flags = AS_ASYNC_FLAGS_MASTER;
 	cmd->deserialize = false;
+	cmd->borrow = false;
 	icmd->listener = listener;
 	return cmd;
 }
@@ -42,6 +42,13 @@ extern "C" {
  */
 #define AS_BIN_NAME_MAX_LEN (AS_BIN_NAME_MAX_SIZE - 1)
 
+/**
+ * @private
+ * Minimum bins capacity that reserves room for a bin name index.  Smaller records
+ * are searched linearly.
+ */
+#define AS_BINS_INDEX_MIN 16
+
 /******************************************************************************
  * TYPES
  *****************************************************************************/
@@ -121,12 +128,101 @@ typedef struct as_bins_s {
 	 */
 	bool _free;
 
+	/**
+	 * @private
+	 * If true, entries was allocated with as_bins_alloc_size() and holds a bin name
+	 * index after the last entry.  The index is extended by the functions that append
+	 * bins, so lookups do not modify the record.  Bins must not be renamed or removed
+	 * while the index is enabled.
+	 */
+	bool _index;
+
 } as_bins;
 
 /******************************************************************************
  * INLINE FUNCTIONS
  *****************************************************************************/
 
+/**
+ * @private
+ * Return number of bin name index slots for a bins capacity.
+ */
+static inline uint32_t
+as_bins_index_slots(uint16_t capacity)
+{
+	// Keep load factor at or below 1/2.
+	uint32_t slots = AS_BINS_INDEX_MIN * 2;
+
+	while (slots < (uint32_t)capacity * 2) {
+		slots <<= 1;
+	}
+	return slots;
+}
+
+/**
+ * @private
+ * Return size to allocate for capacity bin entries.  Capacities of at least
+ * AS_BINS_INDEX_MIN include room for a bin name index.
+ */
+static inline size_t
+as_bins_alloc_size(uint16_t capacity)
+{
+	size_t size = sizeof(as_bin) * capacity;
+
+	if (capacity >= AS_BINS_INDEX_MIN) {
+		// Indexed bin count followed by slots.
+		size += sizeof(uint32_t) * (as_bins_index_slots(capacity) + 1);
+	}
+	return size;
+}
+
+/**
+ * @private
+ * Clear bin name index.  Must be called when bins are reset.
+ */
+static inline void
+as_bins_index_clear(as_bins* bins)
+{
+	if (bins->_index) {
+		*(uint32_t*)(bins->entries + bins->capacity) = 0;
+	}
+}
+
+/**
+ * @private
+ * Enable bin name index on entries allocated with as_bins_alloc_size().
+ */
+static inline void
+as_bins_index_init(as_bins* bins)
+{
+	bins->_index = bins->capacity >= AS_BINS_INDEX_MIN;
+	as_bins_index_clear(bins);
+}
+
+/**
+ * @private
+ * Return bin name hash used by the bin name index (FNV-1a).
+ */
+static inline uint32_t
+as_bins_name_hash(const char* name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name) {
+		hash ^= (uint8_t)*name++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/**
+ * @private
+ * Add bins appended since the last call to the bin name index.  Must be called by
+ * functions that append bins, before the record is shared with readers.
+ */
+void
+as_bins_index_update(as_bins* bins);
+
 /**
  * Get the name of the bin.
  *
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <aerospike/as_atomic.h>
+#include <aerospike/as_compress.h>
 #include <aerospike/as_config.h>
 #include <aerospike/as_node.h>
 #include <aerospike/as_partition.h>
@@ -202,6 +203,30 @@ typedef struct as_cluster_s {
 	 */
 	pthread_cond_t tend_cond;
 
+	/**
+	 * @private
+	 * Duration of the last cluster tend in microseconds.
+	 */
+	uint64_t tend_duration;
+
+	/**
+	 * @private
+	 * Number of cluster tends since cluster was created.
+	 */
+	uint64_t tend_count;
+
+	/**
+	 * @private
+	 * Statistics for compressed commands.
+	 */
+	as_compress_stats compress_stats;
+
+	/**
+	 * @private
+	 * Statistics for inflated responses.
+	 */
+	as_compress_stats inflate_stats;
+
 	/**
 	 * @private
 	 * Milliseconds between cluster tends.
@@ -236,6 +261,12 @@ typedef struct as_cluster_s {
 	 */
 	uint32_t conn_pools_per_node;
 
+	/**
+	 * @private
+	 * Number of lock-free connection cache slots per synchronous connection pool.
+	 */
+	uint32_t conn_cache_size;
+
 	/**
 	 * @private
 	 * Initial connection timeout in milliseconds.
@@ -283,6 +314,12 @@ typedef struct as_cluster_s {
 	 * If "services-alternate" should be used instead of "services"
 	 */
 	bool use_services_alternate;
+
+	/**
+	 * @private
+	 * Skip socket peek on connections taken from pool.
+	 */
+	bool skip_conn_validation;
 	
 	/**
 	 * @private
@@ -16,6 +16,7 @@
  */
 #pragma once 
 
+#include <aerospike/as_arena.h>
 #include <aerospike/as_bin.h>
 #include <aerospike/as_buffer.h>
 #include <aerospike/as_cluster.h>
@@ -42,6 +43,8 @@ extern "C" {
 #define AS_FIELD_TASK_ID 7
 #define AS_FIELD_SCAN_OPTIONS 8
 #define AS_FIELD_SCAN_TIMEOUT 9
+#define AS_FIELD_PID_ARRAY 11
+#define AS_FIELD_PID_DIGEST_ARRAY 12
 #define AS_FIELD_INDEX_RANGE 22
 #define AS_FIELD_INDEX_FILTER 23
 #define AS_FIELD_INDEX_LIMIT 24
@@ -64,7 +67,7 @@ extern "C" {
 #define AS_MSG_INFO1_XDR				(1 << 4) // operation is being performed by XDR
 #define AS_MSG_INFO1_GET_NOBINDATA		(1 << 5) // do not get information about bins and its data
 #define AS_MSG_INFO1_CONSISTENCY_ALL	(1 << 6) // read consistency level - bit 0
-// (Note:  Bit 7 is unused.)
+#define AS_MSG_INFO1_COMPRESS_RESPONSE	(1 << 7) // tell server to compress its response
 
 // Message info2 bits
 #define AS_MSG_INFO2_WRITE				(1 << 0) // contains a write semantic
@@ -79,7 +82,7 @@ extern "C" {
 // Message info3 bits
 #define AS_MSG_INFO3_LAST				(1 << 0) // this is the last of a multi-part message
 #define AS_MSG_INFO3_COMMIT_MASTER  	(1 << 1) // write commit level - bit 0
-// (Note:  Bit 2 is unused.)
+#define AS_MSG_INFO3_PARTITION_DONE		(1 << 2) // partition scan is complete for the partition in generation
 #define AS_MSG_INFO3_UPDATE_ONLY		(1 << 3) // update existing record only, do not create new record
 #define AS_MSG_INFO3_CREATE_OR_REPLACE	(1 << 4) // completely replace existing record, or create new record
 #define AS_MSG_INFO3_REPLACE_ONLY		(1 << 5) // completely replace existing record, do not create new record
@@ -102,6 +105,10 @@ extern "C" {
 
 #define AS_STACK_BUF_SIZE (1024 * 16)
 
+// String and blob bin values at least this size are sent in place instead of
+// being copied into the command buffer.
+#define AS_COMMAND_ZERO_COPY_MIN (1024 * 16)
+
 /**
  * @private
  * Macros use these stand-ins for cf_malloc() / cf_free(), so that
@@ -145,6 +152,9 @@ typedef struct as_command_node_s {
 	const char* ns;
 	const uint8_t* digest;
 	as_policy_replica replica;
+	as_node* hedge_node;   // Alternate node for hedged fixed node commands.  May be null.
+	uint32_t hedge_delay;  // Milliseconds before hedge command is sent.  0 disables hedging.
+	as_latency_type latency_type;  // Node latency histogram that records this command.
 } as_command_node;
 
 /**
@@ -156,16 +166,44 @@ typedef struct as_command_parse_result_data_s {
 	bool deserialize;
 } as_command_parse_result_data;
 
+/**
+ * @private
+ * Command written as a sequence of buffers.  Header, key and small bins are written to a
+ * scratch buffer.  Large string and blob bin values are referenced in place.
+ */
+typedef struct as_command_iov_s {
+	as_iovec* iov;     // Buffer segments.  Capacity must cover 2 * zero copy bins + 1.
+	as_val** vals;     // If not null, referenced values are reserved and stored here.
+	uint8_t* begin;    // Start of scratch segment that has not been added to iov yet.
+	size_t len;        // Total length of segments in iov.
+	uint32_t n_iov;
+	uint32_t n_vals;
+} as_command_iov;
+
 /**
  * @private
  * Parse results callback used in as_command_execute().
  */
 typedef as_status (*as_parse_results_fn) (as_error* err, as_socket* sock, as_node* node, uint32_t socket_timeout, uint64_t deadline_ms, void* user_data);
 
+/**
+ * @private
+ * Parse records callback used in as_command_parse_stream().  Parses all messages in one
+ * proto block.  Return AEROSPIKE_NO_MORE_RECORDS when the last message is found.
+ */
+typedef as_status (*as_parse_records_fn) (as_error* err, uint8_t* buf, size_t size, void* user_data);
+
 /******************************************************************************
  * FUNCTIONS
  ******************************************************************************/
 
+/**
+ * @private
+ * Calculate size of user key field.
+ */
+size_t
+as_command_user_key_size(const as_key* key);
+
 /**
  * @private
  * Calculate size of command header plus key fields.
@@ -210,6 +248,14 @@ as_command_bin_size(const as_bin* bin, as_buffer* buffer)
 	return strlen(bin->name) + as_command_value_size((as_val*)bin->valuep, buffer) + 8;
 }
 
+/**
+ * @private
+ * Calculate size of operations and derive the read/write attributes they require.
+ * List/map values are serialized into buffers, which are freed by as_command_write_bin().
+ */
+size_t
+as_command_operate_set_attr(const as_operations* ops, as_buffer* buffers, uint8_t* rattr, uint8_t* wattr);
+
 /**
  * @private
  * Calculate size of bin name. Return error is bin name greater than AS_BIN_NAME_MAX_LEN characters.
@@ -246,6 +292,16 @@ as_command_write_header(uint8_t* cmd, uint8_t read_attr, uint8_t write_attr,
 	bool linearize_read, as_policy_exists exists, as_policy_gen gen_policy, uint32_t gen,
 	uint32_t ttl, uint32_t timeout_ms, uint16_t n_fields, uint16_t n_bins, bool durable_delete);
 
+/**
+ * @private
+ * Return read attribute that requests a compressed response when enabled by policy.
+ */
+static inline uint8_t
+as_command_compress_attr(const as_policy_base* policy)
+{
+	return policy->compress ? AS_MSG_INFO1_COMPRESS_RESPONSE : 0;
+}
+
 /**
  * @private
  * Write command header for read commands only.
@@ -341,6 +397,13 @@ as_command_write_field_digest(uint8_t* p, const as_digest* val)
 	return p + AS_DIGEST_VALUE_SIZE;
 }
 
+/**
+ * @private
+ * Write user key field.
+ */
+uint8_t*
+as_command_write_user_key(uint8_t* begin, const as_key* key);
+
 /**
  * @private
  * Write key structure.
@@ -391,6 +454,46 @@ as_command_write_end(uint8_t* begin, uint8_t* end)
 	return len;
 }
 
+/**
+ * @private
+ * Return bin value size if the bin value can be sent in place, otherwise return zero.
+ * If retain is true, only values that can outlive the caller's record are eligible.
+ * Must be called after as_command_bin_size().
+ */
+size_t
+as_command_zero_copy_size(const as_bin* bin, bool retain);
+
+/**
+ * @private
+ * Initialize buffer segment command.  The scratch buffer starts at begin.
+ */
+static inline void
+as_command_iov_init(as_command_iov* ci, as_iovec* iov, as_val** vals, uint8_t* begin)
+{
+	ci->iov = iov;
+	ci->vals = vals;
+	ci->begin = begin;
+	ci->len = 0;
+	ci->n_iov = 0;
+	ci->n_vals = 0;
+}
+
+/**
+ * @private
+ * Write bin.  Large string and blob values are referenced in place.
+ */
+uint8_t*
+as_command_write_bin_iov(
+	as_command_iov* ci, uint8_t* begin, uint8_t operation_type, const as_bin* bin, as_buffer* buffer
+	);
+
+/**
+ * @private
+ * Finish writing buffer segment command.  Return total command length.
+ */
+size_t
+as_command_iov_end(as_command_iov* ci, uint8_t* end);
+
 /**
  * @private
  * Finish writing compressed command.
@@ -421,7 +524,44 @@ as_command_compress_max_size(size_t cmd_sz);
  * Compress command buffer.
  */
 as_status
-as_command_compress(as_error* err, uint8_t* cmd, size_t cmd_sz, uint8_t* compressed_cmd, size_t* compressed_size);
+as_command_compress(
+	as_cluster* cluster, as_error* err, uint8_t* cmd, size_t cmd_sz, uint8_t* compressed_cmd,
+	size_t* compressed_size, int level
+	);
+
+/**
+ * @private
+ * Inflate compressed proto body into out.  The body starts with the uncompressed size,
+ * which must equal out_len.
+ */
+as_status
+as_command_inflate(
+	as_cluster* cluster, as_error* err, const uint8_t* body, size_t body_len, uint8_t* out,
+	size_t out_len
+	);
+
+/**
+ * @private
+ * Return uncompressed size of compressed proto body.
+ */
+static inline uint64_t
+as_command_compressed_size(const uint8_t* body)
+{
+	// Uncompressed size is not in network byte order.  See as_command_compress_write_end().
+	return cf_swap_from_le64(*(uint64_t*)body);
+}
+
+/**
+ * @private
+ * Read len bytes starting with the proto header of the next response message.
+ * Compressed responses are inflated into the socket's inflate buffer and the
+ * uncompressed message is returned.  The proto header is not byte swapped.
+ */
+as_status
+as_command_read_proto(
+	as_error* err, as_socket* sock, as_node* node, uint8_t* buf, size_t len,
+	uint32_t socket_timeout, uint64_t deadline_ms
+	);
 
 /**
  * @private
@@ -434,6 +574,35 @@ as_command_execute(
 	bool is_read
 );
 
+/**
+ * @private
+ * Send command composed of buffer segments to the server.  The first segment must
+ * contain the command header.
+ */
+as_status
+as_command_execute_iov(
+	as_cluster* cluster, as_error* err, const as_policy_base* policy, as_command_node* cn,
+	as_iovec* iov, uint32_t n_iov, as_parse_results_fn parse_results_fn, void* parse_results_data,
+	bool is_read
+);
+
+/**
+ * @private
+ * Read a multi-record response (batch, scan, query) in a separate reader thread while the
+ * calling thread parses proto blocks and runs user callbacks.  Each calling thread keeps
+ * its reader thread until the calling thread exits.  The reader fills a ring of
+ * n_buffers proto blocks and stops reading when all buffers are waiting to be parsed, so
+ * the server is paced by the parser.
+ *
+ * If stop_on_error is true, a message with a non-zero result code ends the response
+ * (scan/query).  Otherwise, only the last message flag ends the response (batch).
+ */
+as_status
+as_command_parse_stream(
+	as_error* err, as_socket* sock, as_node* node, uint32_t socket_timeout, uint64_t deadline_ms,
+	uint32_t n_buffers, bool stop_on_error, as_parse_records_fn parse_records_fn, void* user_data
+	);
+
 /**
  * @private
  * Parse header of server response.
@@ -465,9 +634,16 @@ as_command_parse_success_failure_bins(uint8_t** pp, as_error* err, as_msg* msg,
 /**
  * @private
  * Parse bins received from the server.
+ * If borrow is true, string, geojson and blob values reference the response buffer
+ * directly, so the record is only valid while that buffer is valid.
+ * If arena is not null, string, geojson and blob values are allocated from the arena
+ * and are released when the arena is destroyed.
  */
 as_status
-as_command_parse_bins(uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bins, bool deserialize);
+as_command_parse_bins(
+	uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bins, bool deserialize, bool borrow,
+	as_arena* arena
+	);
 
 /**
  * @private
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2008-2018 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Compression statistics for one direction (compressed commands or inflated responses).
+ * The compression ratio is raw_bytes / zip_bytes.
+ *
+ * @ingroup cluster_stats
+ */
+typedef struct as_compress_stats_s {
+	/**
+	 * Number of buffers compressed or inflated.
+	 */
+	uint64_t count;
+
+	/**
+	 * Total uncompressed bytes.
+	 */
+	uint64_t raw_bytes;
+
+	/**
+	 * Total compressed bytes.
+	 */
+	uint64_t zip_bytes;
+
+	/**
+	 * Total time spent compressing or inflating in microseconds.
+	 */
+	uint64_t usec;
+} as_compress_stats;
+
+struct z_stream_s;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Compress in to out with the calling thread's deflate stream.  out_len is the capacity
+ * of out on input and the compressed size on output.  The stream is created on first use
+ * and reset between calls, so the deflate state is not reallocated for every command.
+ * Return zlib status code.
+ */
+int
+as_compress_deflate(uint8_t* out, size_t* out_len, const uint8_t* in, size_t in_len, int level);
+
+/**
+ * @private
+ * Return the calling thread's inflate stream, reset and ready for a new zlib stream.
+ * Return NULL if the stream could not be created.
+ */
+struct z_stream_s*
+as_compress_inflater(void);
+
+/**
+ * @private
+ * Inflate in to out with the calling thread's inflate stream.  out_len is the capacity
+ * of out on input and the inflated size on output.  Return zlib status code.
+ */
+int
+as_compress_inflate(uint8_t* out, size_t* out_len, const uint8_t* in, size_t in_len);
+
+/**
+ * @private
+ * Add one compressed or inflated buffer to statistics.  begin is the start time in
+ * microseconds.
+ */
+void
+as_compress_stats_add(as_compress_stats* stats, size_t raw_bytes, size_t zip_bytes, uint64_t begin);
+
+/**
+ * @private
+ * Copy statistics to trg.  If reset is true, counters are atomically set to zero.
+ * trg may be null.
+ */
+void
+as_compress_stats_copy(as_compress_stats* src, as_compress_stats* trg, bool reset);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
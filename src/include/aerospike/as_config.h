@@ -499,6 +499,19 @@ typedef struct as_config_s {
 	 */
 	uint32_t conn_pools_per_node;
 
+	/**
+	 * Number of lock-free connection cache slots in front of each synchronous connection pool.
+	 * Threads first try to get/put connections from/to these slots using atomic operations only.
+	 * The locked connection pool queue is used only when the cache is empty (get) or full (put).
+	 * Each thread prefers its own slot, so hot threads usually reuse the same connection without
+	 * contending with other threads.
+	 *
+	 * Cache hit/miss counts are reported in aerospike_node_stats().  Set to zero to disable.
+	 *
+	 * Default: 8
+	 */
+	uint32_t conn_cache_size;
+
 	/**
 	 * Initial host connection timeout in milliseconds.  The timeout when opening a connection
 	 * to the server host for the first time.
@@ -605,6 +618,27 @@ typedef struct as_config_s {
 	 */
 	bool use_services_alternate;
 
+	/**
+	 * Skip the socket peek (recv with MSG_PEEK) normally performed on every connection taken
+	 * from a connection pool.  The peek costs an extra system call per command.
+	 *
+	 * When enabled, only the cheap checks (unread response bytes and max_socket_idle) are
+	 * applied when a pooled connection is reused.  Connections closed by the server are
+	 * instead detected by:
+	 *
+	 * - The cluster tend thread, which peeks all idle sync pooled connections in bulk once
+	 *   per tender_interval and discards dead ones.
+	 * - The command itself.  If a connection taken from the pool fails before any command
+	 *   bytes are sent, the command is retried on another connection without counting
+	 *   against max_retries.  Failures after the command was sent use the normal retry
+	 *   rules, because the server may have executed it.
+	 *
+	 * Skipped peeks and stale connections are reported in aerospike_node_stats() metrics.
+	 *
+	 * Default: false
+	 */
+	bool skip_conn_validation;
+
 	/**
 	 * Indicates if shared memory should be used for cluster tending.  Shared memory
 	 * is useful when operating in single threaded mode with multiple client processes.
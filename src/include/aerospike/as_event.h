@@ -26,7 +26,7 @@
  * Generic asynchronous events abstraction.  Designed to support multiple event libraries.
  * Only one library is supported per build.
  */
-#if defined(AS_USE_LIBEV) || defined(AS_USE_LIBUV) || defined(AS_USE_LIBEVENT)
+#if defined(AS_USE_LIBEV) || defined(AS_USE_LIBUV) || defined(AS_USE_LIBEVENT) || defined(AS_USE_LIBURING)
 #define AS_EVENT_LIB_DEFINED 1
 #endif
 
@@ -36,6 +36,8 @@
 #include <uv.h>
 #elif defined(AS_USE_LIBEVENT)
 #include <event2/event_struct.h>
+#elif defined(AS_USE_LIBURING)
+#include <liburing.h>
 #else
 #endif
 
@@ -113,13 +115,25 @@ typedef struct as_event_loop {
 #elif defined(AS_USE_LIBEVENT)
 	struct event_base* loop;
 	struct event wakeup;
+#elif defined(AS_USE_LIBURING)
+	struct io_uring* loop;
+	struct as_event_command** timers;  // Min-heap of command timers ordered by expiration.
+	uint32_t timers_size;
+	uint32_t timers_capacity;
+	uint64_t wakeup_value;             // Eventfd read target.
+	int wakeup;                        // Eventfd used to wake up loop.
 #else
 	void* loop;
 #endif
 		
 	struct as_event_loop* next;
+	struct as_event_ring* ring;  // Lock-free command submission queue.
 	pthread_mutex_t lock;
-	as_queue queue;
+	as_queue queue;              // Overflow command queue used when ring is full.
+	uint32_t overflow;           // Number of commands in overflow queue.
+	uint32_t wakeup_pending;     // Wakeup has been sent and queue has not been processed yet.
+	uint8_t* zbuf;               // Compressed response block being inflated.
+	uint32_t zbuf_capacity;
 	as_queue delay_queue;
 	as_queue pipe_cb_queue;
 	pthread_t thread;
@@ -434,6 +448,25 @@ as_event_close_loops();
 AS_EXTERN void
 as_event_destroy_loops();
 
+#if defined(AS_USE_LIBURING)
+/**
+ * Run one iteration of an external io_uring event loop.  Queued requests are submitted,
+ * the calling thread waits for at least one completion or the nearest command timeout,
+ * and all available completions and expired timers are processed.
+ *
+ * The io_uring instance passed to as_event_set_external_loop() must be initialized by the
+ * application and must only be used by the client.  This function must be called
+ * repeatedly from the event loop thread until it returns false.
+ *
+ * @param event_loop	Event loop returned by as_event_set_external_loop().
+ * @return				False if the event loop has been closed.
+ *
+ * @ingroup async_events
+ */
+AS_EXTERN bool
+as_event_uring_run_once(as_event_loop* event_loop);
+#endif
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
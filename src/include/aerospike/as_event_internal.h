@@ -31,6 +31,8 @@
 #include <uv.h>
 #elif defined(AS_USE_LIBEVENT)
 #include <event2/event.h>
+#elif defined(AS_USE_LIBURING)
+#include <liburing.h>
 #else
 #endif
 
@@ -70,9 +72,29 @@ extern "C" {
 #define AS_EVENT_CONNECTION_ERROR 2
 
 #define AS_EVENT_QUEUE_INITIAL_CAPACITY 256
+
+// Command submission ring size.  Must be a power of 2.
+#define AS_EVENT_RING_SIZE 4096
+#define AS_EVENT_RING_MASK (AS_EVENT_RING_SIZE - 1)
 	
 struct as_event_command;
 struct as_event_executor;
+
+#if defined(AS_USE_LIBURING)
+#define AS_URING_TIMER_STOPPED 0xFFFFFFFF
+
+typedef void (*as_uring_timer_fn) (struct as_event_command* cmd);
+
+/**
+ * Command timer stored in the event loop timer heap.
+ */
+typedef struct {
+	uint64_t expire;         // Expiration in milliseconds.
+	uint32_t repeat;         // Repeat interval in milliseconds.  Zero for one-off timers.
+	uint32_t index;          // Position in timer heap or AS_URING_TIMER_STOPPED.
+	as_uring_timer_fn callback;
+} as_uring_timer;
+#endif
 	
 typedef struct {
 #if defined(AS_USE_LIBEV)
@@ -88,6 +110,13 @@ typedef struct {
 #elif defined(AS_USE_LIBEVENT)
 	struct event watcher;
 	as_socket socket;
+#elif defined(AS_USE_LIBURING)
+	as_socket socket;
+	struct as_event_command* owner;  // Command that submitted the outstanding connect/write/read.
+	uint32_t pending;                // Submitted requests that reference this connection.
+	uint16_t polled;                 // Poll mask of outstanding poll request.
+	uint8_t io;                      // Outstanding connect/write/read request type.
+	bool closed;                     // Free connection when pending requests complete.
 #else
 #endif
 	int watching;
@@ -109,6 +138,19 @@ typedef bool (*as_event_parse_results_fn) (struct as_event_command* cmd);
 typedef void (*as_event_executor_complete_fn) (struct as_event_executor* executor);
 typedef void (*as_event_executor_destroy_fn) (struct as_event_executor* executor);
 
+/**
+ * Command write buffer segments.  The first segment is the command scratch buffer.
+ * Remaining segments reference reserved bin values that are released when the
+ * command is freed.
+ */
+typedef struct as_event_iov {
+	as_val** vals;
+	uint32_t n_vals;
+	uint32_t n_iov;
+	uint32_t len;
+	as_iovec iov[];
+} as_event_iov;
+
 typedef struct as_event_command {
 #if defined(AS_USE_LIBEV)
 	struct ev_timer timer;
@@ -116,9 +158,14 @@ typedef struct as_event_command {
 	uv_timer_t timer;
 #elif defined(AS_USE_LIBEVENT)
 	struct event timer;
+#elif defined(AS_USE_LIBURING)
+	as_uring_timer timer;
+	uint32_t ops;   // Outstanding writes/reads that reference command buffers.
+	bool released;  // Free command when outstanding writes/reads complete.
 #else
 #endif
 	uint64_t total_deadline;
+	uint64_t begin;  // Start of current attempt in microseconds.  Used in node latency histograms.
 	uint32_t socket_timeout;
 	uint32_t max_retries;
 	uint32_t iteration;
@@ -134,6 +181,7 @@ typedef struct as_event_command {
 	cf_ll_element pipe_link;
 	
 	uint8_t* buf;
+	as_event_iov* iov;  // Write buffer segments.  Null if write buffer is contiguous.
 	uint32_t command_sent_counter;
 	uint32_t write_offset;
 	uint32_t write_len;
@@ -145,6 +193,9 @@ typedef struct as_event_command {
 	uint8_t state;
 	uint8_t flags;
 	bool deserialize;
+	bool borrow;  // Parse bin values in place.  Records are only valid during the callback.
+	bool conn_unvalidated;  // Connection was taken from pool without peek.
+	bool compressed;  // Current response body is compressed.
 } as_event_command;
 
 typedef struct {
@@ -152,6 +203,24 @@ typedef struct {
 	void* udata;
 } as_event_commander;
 
+typedef struct {
+	uint32_t seq;
+	as_event_commander cmd;
+} as_event_ring_slot;
+
+/**
+ * Bounded multi-producer/single-consumer command ring.  Producers claim a slot by
+ * advancing tail and publish it through the slot sequence.  Only the event loop thread
+ * advances head.  Head and tail are kept on separate cache lines.
+ */
+typedef struct as_event_ring {
+	uint32_t tail;
+	char pad1[60];
+	uint32_t head;
+	char pad2[60];
+	as_event_ring_slot slots[AS_EVENT_RING_SIZE];
+} as_event_ring;
+
 typedef struct as_event_executor {
 	pthread_mutex_t lock;
 	struct as_event_command** commands;
@@ -184,6 +253,9 @@ as_event_total_timeout(as_event_command* cmd);
 
 bool
 as_event_command_retry(as_event_command* cmd, bool alternate);
+
+bool
+as_event_command_retry_stale(as_event_command* cmd);
 	
 void
 as_event_query_complete(as_event_command* cmd);
@@ -212,6 +284,9 @@ as_event_socket_error(as_event_command* cmd, as_error* err);
 void
 as_event_response_error(as_event_command* cmd, as_error* err);
 
+bool
+as_event_command_inflate(as_event_command* cmd);
+
 bool
 as_event_command_parse_result(as_event_command* cmd);
 	
@@ -247,6 +322,27 @@ as_event_register_external_loop(as_event_loop* event_loop);
 bool
 as_event_execute(as_event_loop* event_loop, as_event_executable executable, void* udata);
 
+/**
+ * Schedule execution of multiple functions on specified event loop with at most one
+ * event loop wakeup.  Functions are executed in array order.
+ * Return number of functions queued.
+ */
+uint32_t
+as_event_execute_batch(as_event_loop* event_loop, const as_event_commander* cmds, uint32_t n_cmds);
+
+/**
+ * Wake up event loop to process its command queue.  Implemented by each event library.
+ */
+void
+as_event_send_wakeup(as_event_loop* event_loop);
+
+/**
+ * Process commands queued by as_event_execute().  Called from event loop wakeup.
+ * Return false if the stop signal was received.
+ */
+bool
+as_event_process_queue(as_event_loop* event_loop);
+
 void
 as_event_command_write_start(as_event_command* cmd);
 
@@ -269,9 +365,9 @@ void as_ev_socket_timeout(struct ev_loop* loop, ev_timer* timer, int revents);
 void as_ev_total_timeout(struct ev_loop* loop, ev_timer* timer, int revents);
 
 static inline int
-as_event_validate_connection(as_event_connection* conn)
+as_event_validate_connection(as_event_connection* conn, bool peek)
 {
-	return as_socket_validate(&conn->socket);
+	return as_socket_validate(&conn->socket, peek);
 }
 
 static inline void
@@ -355,8 +451,12 @@ void as_uv_total_timeout(uv_timer_t* timer);
 void as_uv_socket_timeout(uv_timer_t* timer);
 
 static inline int
-as_event_validate_connection(as_event_connection* conn)
+as_event_validate_connection(as_event_connection* conn, bool peek)
 {
+	if (! peek) {
+		return 0;
+	}
+
 	// Libuv does not have a peek function, so use fd directly.
 	uv_os_fd_t fd;
 	
@@ -442,9 +542,9 @@ void as_libevent_socket_timeout(evutil_socket_t sock, short events, void* udata)
 void as_libevent_total_timeout(evutil_socket_t sock, short events, void* udata);
 
 static inline int
-as_event_validate_connection(as_event_connection* conn)
+as_event_validate_connection(as_event_connection* conn, bool peek)
 {
-	return as_socket_validate(&conn->socket);
+	return as_socket_validate(&conn->socket, peek);
 }
 
 static inline void
@@ -524,6 +624,96 @@ as_event_command_release(as_event_command* cmd)
 	as_event_command_free(cmd);
 }
 
+/******************************************************************************
+ * LIBURING INLINE FUNCTIONS
+ *****************************************************************************/
+
+#elif defined(AS_USE_LIBURING)
+
+void as_uring_timer_start(as_event_command* cmd, uint64_t timeout, uint32_t repeat, as_uring_timer_fn callback);
+void as_uring_timer_stop(as_event_command* cmd);
+void as_uring_stop_watcher(as_event_loop* event_loop, as_event_connection* conn);
+
+static inline int
+as_event_validate_connection(as_event_connection* conn, bool peek)
+{
+	return as_socket_validate(&conn->socket, peek);
+}
+
+static inline void
+as_event_set_conn_last_used(as_event_connection* conn, uint32_t max_socket_idle)
+{
+	// TLS connections default to 55 seconds.
+	if (max_socket_idle == 0 && conn->socket.ctx) {
+		max_socket_idle = 55;
+	}
+
+	if (max_socket_idle > 0) {
+		conn->socket.idle_check.max_socket_idle = max_socket_idle;
+		conn->socket.idle_check.last_used = (uint32_t)cf_get_seconds();
+	}
+	else {
+		conn->socket.idle_check.max_socket_idle = conn->socket.idle_check.last_used = 0;
+	}
+}
+
+static inline void
+as_event_init_total_timer(as_event_command* cmd, uint64_t timeout)
+{
+	cmd->timer.index = AS_URING_TIMER_STOPPED;
+	as_uring_timer_start(cmd, timeout, 0, as_event_total_timeout);
+}
+
+static inline void
+as_event_set_total_timer(as_event_command* cmd, uint64_t timeout)
+{
+	as_uring_timer_start(cmd, timeout, 0, as_event_total_timeout);
+}
+
+static inline void
+as_event_init_socket_timer(as_event_command* cmd)
+{
+	cmd->timer.index = AS_URING_TIMER_STOPPED;
+	as_uring_timer_start(cmd, cmd->socket_timeout, cmd->socket_timeout, as_event_socket_timeout);
+}
+
+static inline void
+as_event_set_socket_timer(as_event_command* cmd)
+{
+	as_uring_timer_start(cmd, cmd->socket_timeout, cmd->socket_timeout, as_event_socket_timeout);
+}
+
+static inline void
+as_event_repeat_socket_timer(as_event_command* cmd)
+{
+	as_uring_timer_start(cmd, cmd->socket_timeout, cmd->socket_timeout, as_event_socket_timeout);
+}
+
+static inline void
+as_event_stop_timer(as_event_command* cmd)
+{
+	as_uring_timer_stop(cmd);
+}
+
+static inline void
+as_event_stop_watcher(as_event_command* cmd, as_event_connection* conn)
+{
+	as_uring_stop_watcher(cmd->event_loop, conn);
+}
+
+static inline void
+as_event_command_release(as_event_command* cmd)
+{
+	if (cmd->ops > 0) {
+		// The kernel may still reference command buffers.  Free command when the
+		// outstanding requests complete.
+		cmd->released = true;
+	}
+	else {
+		as_event_command_free(cmd);
+	}
+}
+
 /******************************************************************************
  * EVENT_LIB NOT DEFINED INLINE FUNCTIONS
  *****************************************************************************/
@@ -531,7 +721,7 @@ as_event_command_release(as_event_command* cmd)
 #else
 
 static inline int
-as_event_validate_connection(as_event_connection* conn)
+as_event_validate_connection(as_event_connection* conn, bool peek)
 {
 	return -1;
 }
@@ -624,13 +814,117 @@ as_event_set_auth_parse_header(as_event_command* cmd)
 	cmd->state = AS_ASYNC_STATE_AUTH_READ_BODY;
 }
 
+static inline bool
+as_event_command_parse_results(as_event_command* cmd)
+{
+	// Inflate compressed response body before parsing.  Inflate errors complete the command.
+	if (cmd->compressed && ! as_event_command_inflate(cmd)) {
+		return true;
+	}
+	return cmd->parse_results(cmd);
+}
+
 static inline void
 as_event_set_write(as_event_command* cmd)
 {
-	cmd->len = cmd->write_len;
+	cmd->len = cmd->iov ? cmd->iov->len : cmd->write_len;
 	cmd->pos = 0;
 }
 
+static inline as_event_iov*
+as_event_iov_create(uint32_t n_iov, uint32_t n_vals)
+{
+	as_event_iov* ei = (as_event_iov*)cf_malloc(sizeof(as_event_iov) + sizeof(as_iovec) * n_iov +
+		sizeof(as_val*) * n_vals);
+	ei->vals = (as_val**)&ei->iov[n_iov];
+	ei->n_vals = 0;
+	ei->n_iov = 0;
+	ei->len = 0;
+	return ei;
+}
+
+static inline void
+as_event_iov_destroy(as_event_iov* ei)
+{
+	for (uint32_t i = 0; i < ei->n_vals; i++) {
+		as_val_destroy(ei->vals[i]);
+	}
+	cf_free(ei);
+}
+
+/**
+ * Fill segments that remain to be written starting at cmd->pos.
+ * Return number of segments filled.
+ */
+static inline uint32_t
+as_event_iov_remaining(as_event_command* cmd, as_iovec* out, uint32_t max)
+{
+	as_event_iov* ei = cmd->iov;
+	size_t offset = cmd->pos;
+	uint32_t n = 0;
+
+	for (uint32_t i = 0; i < ei->n_iov && n < max; i++) {
+		size_t len = ei->iov[i].iov_len;
+
+		if (offset >= len) {
+			offset -= len;
+			continue;
+		}
+		out[n].iov_base = (uint8_t*)ei->iov[i].iov_base + offset;
+		out[n].iov_len = len - offset;
+		offset = 0;
+		n++;
+	}
+	return n;
+}
+
+/**
+ * Return contiguous bytes that remain to be written starting at cmd->pos.
+ */
+static inline uint8_t*
+as_event_write_segment(as_event_command* cmd, uint32_t* size)
+{
+	if (cmd->iov && cmd->state == AS_ASYNC_STATE_COMMAND_WRITE) {
+		as_iovec iov;
+		as_event_iov_remaining(cmd, &iov, 1);
+		*size = (uint32_t)iov.iov_len;
+		return (uint8_t*)iov.iov_base;
+	}
+	*size = cmd->len - cmd->pos;
+	return (uint8_t*)cmd + cmd->write_offset + cmd->pos;
+}
+
+#define AS_EVENT_IOV_MAX 64
+
+/**
+ * Send bytes that remain to be written on a non-TLS socket.
+ */
+static inline int
+as_event_send(as_event_command* cmd, as_socket_fd fd)
+{
+#if !defined(_MSC_VER)
+	if (cmd->iov && cmd->state == AS_ASYNC_STATE_COMMAND_WRITE) {
+		as_iovec iov[AS_EVENT_IOV_MAX];
+		struct msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = iov;
+		msg.msg_iovlen = as_event_iov_remaining(cmd, iov, AS_EVENT_IOV_MAX);
+		return (int)sendmsg(fd, &msg, MSG_NOSIGNAL);
+	}
+#endif
+
+	uint32_t size;
+	uint8_t* buf = as_event_write_segment(cmd, &size);
+
+#if defined(__linux__)
+	return (int)send(fd, buf, size, MSG_NOSIGNAL);
+#elif defined(_MSC_VER)
+	return send(fd, buf, size, 0);
+#else
+	return (int)write(fd, buf, size);
+#endif
+}
+
 static inline void
 as_event_release_connection(as_event_connection* conn, as_conn_pool* pool)
 {
@@ -681,6 +975,10 @@ as_event_socket_retry(as_event_command* cmd)
 
 	as_event_stop_watcher(cmd, cmd->conn);
 	as_event_release_async_connection(cmd);
+
+	if (cmd->conn_unvalidated) {
+		return as_event_command_retry_stale(cmd);
+	}
 	return as_event_command_retry(cmd, true);
 }
 
@@ -696,12 +994,20 @@ as_event_command_destroy(as_event_command* cmd)
 {
 	// Use this function to free commands that were never started.
 	as_node_release(cmd->node);
+
+	if (cmd->iov) {
+		as_event_iov_destroy(cmd->iov);
+	}
 	cf_free(cmd);
 }
 
 static inline void
 as_event_loop_destroy(as_event_loop* event_loop)
 {
+	cf_free(event_loop->ring);
+	event_loop->ring = NULL;
+	cf_free(event_loop->zbuf);
+	event_loop->zbuf = NULL;
 	as_queue_destroy(&event_loop->queue);
 	as_queue_destroy(&event_loop->delay_queue);
 	as_queue_destroy(&event_loop->pipe_cb_queue);
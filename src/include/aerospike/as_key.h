@@ -689,6 +689,37 @@ as_key_digest(as_key* key);
 AS_EXTERN as_status
 as_key_set_digest(as_error* err, as_key* key);
 
+/**
+ * Set the digest value of each key in an array.  Keys that already have a digest are
+ * skipped.  Digests of short keys are computed several at a time, which is faster than
+ * calling as_key_set_digest() on each key.
+ *
+ * ~~~~~~~~~~{.c}
+ * if (as_keys_set_digests(&err, keys, n_keys) != AEROSPIKE_OK) {
+ *     printf("error(%d) %s at [%s:%d]", err.code, err.message, err.file, err.line);
+ * }
+ * ~~~~~~~~~~
+ *
+ * @param err Error message that is populated on error.
+ * @param keys The keys to set digests for.
+ * @param n_keys The number of keys.
+ *
+ * @return Status code.
+ *
+ * @relates as_key
+ * @ingroup as_key_object
+ */
+AS_EXTERN as_status
+as_keys_set_digests(as_error* err, as_key* keys, uint32_t n_keys);
+
+/**
+ * @private
+ * Set the digest value of n_keys keys that are stride bytes apart.  Used when keys are
+ * embedded in larger structures such as batch records.
+ */
+as_status
+as_keys_set_digests_stride(as_error* err, void* keys, uint32_t n_keys, size_t stride);
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
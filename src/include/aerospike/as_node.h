@@ -58,10 +58,30 @@ extern "C" {
 #define AS_FEATURES_PEERS          (1 << 5)
 #define AS_FEATURES_REPLICAS       (1 << 6)
 #define AS_FEATURES_CLUSTER_STABLE (1 << 7)
+#define AS_FEATURES_BATCH_ANY      (1 << 8)
+#define AS_FEATURES_PARTITION_SCAN (1 << 9)
 
 #define AS_ADDRESS4_MAX 4
 #define AS_ADDRESS6_MAX 8
 
+#define AS_CONN_CACHE_EMPTY 0
+#define AS_CONN_CACHE_FULL  1
+#define AS_CONN_CACHE_BUSY  2
+
+/**
+ * @private
+ * Connection cache hits/misses are recorded for one in this many requests per thread.
+ * Must be a power of 2.
+ */
+#define AS_CONN_CACHE_SAMPLE 64
+
+/**
+ * Number of latency histogram buckets.  Bucket 0 counts commands that completed in less
+ * than one microsecond.  Bucket i counts commands that completed in [2^(i-1), 2^i)
+ * microseconds.  The last bucket also counts all slower commands.
+ */
+#define AS_LATENCY_BUCKETS 24
+
 /******************************************************************************
  * TYPES
  *****************************************************************************/
@@ -125,8 +145,40 @@ typedef struct as_conn_pool_s {
 	 */
 	uint32_t limit;
 
+	/**
+	 * @private
+	 * Number of connections opened by this pool.
+	 */
+	uint64_t opened;
+
+	/**
+	 * @private
+	 * Number of connections closed by this pool.
+	 */
+	uint64_t closed;
+
 } as_conn_pool;
 
+/**
+ * @private
+ * Lock-free connection cache slot.  Slot ownership is transferred with atomic
+ * compare-and-swap on the state field.
+ */
+typedef struct as_conn_cache_slot_s {
+	/**
+	 * @private
+	 * Cached socket.  Only valid when state is AS_CONN_CACHE_FULL.
+	 */
+	as_socket socket;
+
+	/**
+	 * @private
+	 * Slot state: AS_CONN_CACHE_EMPTY, AS_CONN_CACHE_FULL or AS_CONN_CACHE_BUSY.
+	 */
+	uint32_t state;
+
+} as_conn_cache_slot;
+
 /**
  * @private
  * Connection pool with lock.
@@ -144,8 +196,120 @@ typedef struct as_conn_pool_lock_s {
 	 */
 	as_conn_pool pool;
 
+	/**
+	 * @private
+	 * Lock-free connection cache in front of pool.  Connections in the cache
+	 * are still counted in pool total.
+	 */
+	as_conn_cache_slot* cache;
+
+	/**
+	 * @private
+	 * Sampled number of connection requests satisfied by the cache.  Each thread
+	 * only records one in AS_CONN_CACHE_SAMPLE requests, so command threads do not
+	 * contend on the counter.
+	 */
+	uint64_t cache_hits;
+
+	/**
+	 * @private
+	 * Sampled number of connection requests that had to fall back to the locked pool.
+	 */
+	uint64_t cache_misses;
+
+	/**
+	 * @private
+	 * Number of cache slots.  Zero if cache is disabled.
+	 */
+	uint32_t cache_size;
+
 } as_conn_pool_lock;
 
+/**
+ * Command categories used in node latency histograms.
+ */
+typedef enum as_latency_type_e {
+	AS_LATENCY_TYPE_READ,
+	AS_LATENCY_TYPE_WRITE,
+	AS_LATENCY_TYPE_BATCH,
+	AS_LATENCY_TYPE_SCAN,
+	AS_LATENCY_TYPE_QUERY,
+	AS_LATENCY_TYPE_INFO,
+	AS_LATENCY_TYPE_MAX
+} as_latency_type;
+
+/**
+ * Latency histogram with power of 2 microsecond buckets.
+ */
+typedef struct as_latency_s {
+	/**
+	 * Command counts.  See AS_LATENCY_BUCKETS for bucket ranges.
+	 */
+	uint64_t buckets[AS_LATENCY_BUCKETS];
+
+} as_latency;
+
+/**
+ * Node command metrics.  Counters are updated atomically by all command threads and
+ * event loops without locks.
+ */
+typedef struct as_node_metrics_s {
+	/**
+	 * Latency histogram for each command category.  Latency is measured from the start
+	 * of the last attempt until the server response is received.
+	 */
+	as_latency latency[AS_LATENCY_TYPE_MAX];
+
+	/**
+	 * Command retries after a failed attempt on this node.
+	 */
+	uint64_t retries;
+
+	/**
+	 * Client socket and total timeouts on this node.
+	 */
+	uint64_t client_timeouts;
+
+	/**
+	 * Timeouts returned by this node.
+	 */
+	uint64_t server_timeouts;
+
+	/**
+	 * Write commands that failed after possibly being applied on this node.
+	 */
+	uint64_t in_doubt_writes;
+
+	/**
+	 * Bytes received from this node.
+	 */
+	uint64_t bytes_in;
+
+	/**
+	 * Bytes sent to this node.
+	 */
+	uint64_t bytes_out;
+
+	/**
+	 * Socket peeks skipped on connections taken from a pool when
+	 * as_config.skip_conn_validation is enabled.  Each skipped peek saves one system call.
+	 */
+	uint64_t conn_peeks_skipped;
+
+	/**
+	 * Pooled connections found dead after the per-use peek was skipped.  Includes idle
+	 * connections discarded by the tend thread and connections that failed on first use.
+	 */
+	uint64_t stale_conns;
+
+	/**
+	 * Hedged reads sent to this node because the original node did not start responding
+	 * within the policy hedge_delay.
+	 */
+	uint64_t hedges;
+
+} as_node_metrics;
+
 struct as_cluster_s;
 
 /**
@@ -231,6 +395,12 @@ typedef struct as_node_s {
 	 * Socket used exclusively for cluster tend thread info requests.
 	 */
 	as_socket info_socket;
+
+	/**
+	 * @private
+	 * Command latency histograms and counters.
+	 */
+	as_node_metrics metrics;
 		
 	/**
 	 * @private
@@ -256,12 +426,6 @@ typedef struct as_node_s {
 	 */
 	uint32_t features;
 
-	/**
-	 * @private
-	 * Connection queue iterator.  Not atomic by design.
-	 */
-	uint32_t conn_iter;
-
 	/**
 	 * @private
 	 * Server's generation count for peers.
@@ -359,6 +523,68 @@ typedef struct as_node_info_s {
 
 } as_node_info;
 
+/**
+ * @private
+ * Cluster tend info request for one node.  The tend thread sends info requests to all
+ * nodes before waiting on any response and processes responses as they arrive.
+ */
+typedef struct as_node_tend_s {
+	/**
+	 * @private
+	 * Node being tended.
+	 */
+	as_node* node;
+
+	/**
+	 * @private
+	 * Request buffer while writing.  Response body buffer while reading.
+	 */
+	uint8_t* buf;
+
+	/**
+	 * @private
+	 * Bytes to transfer in current state.
+	 */
+	size_t len;
+
+	/**
+	 * @private
+	 * Bytes transferred in current state.
+	 */
+	size_t pos;
+
+	/**
+	 * @private
+	 * Error details when status is not AEROSPIKE_OK.
+	 */
+	as_error err;
+
+	/**
+	 * @private
+	 * Tend result.
+	 */
+	as_status status;
+
+	/**
+	 * @private
+	 * Response proto header.
+	 */
+	uint8_t header[8];
+
+	/**
+	 * @private
+	 * Request state.
+	 */
+	uint8_t state;
+
+	/**
+	 * @private
+	 * Request is waiting for socket to become writable instead of readable.
+	 */
+	bool want_write;
+
+} as_node_tend;
+
 /******************************************************************************
  * FUNCTIONS
  ******************************************************************************/
@@ -372,6 +598,8 @@ as_conn_pool_init(as_conn_pool* pool, uint32_t size, uint32_t limit)
 {
 	pool->limit = limit;
 	pool->total = 0;
+	pool->opened = 0;
+	pool->closed = 0;
 
 	as_queue_init(&pool->queue, size, limit);
 }
@@ -394,6 +622,7 @@ static inline void
 as_conn_pool_dec(as_conn_pool* pool)
 {
 	pool->total--;
+	pool->closed++;
 }
 
 /**
@@ -408,6 +637,7 @@ as_conn_pool_inc(as_conn_pool* pool)
 	}
 
 	pool->total++;
+	pool->opened++;
 	return true;
 }
 
@@ -530,6 +760,14 @@ as_node_authenticate_connection(struct as_cluster_s* cluster, uint64_t deadline_
 as_status
 as_node_get_connection(as_error* err, as_node* node, uint32_t socket_timeout, uint64_t deadline_ms, as_socket* sock);
 
+/**
+ * @private
+ * Peek all idle sync connections in the node's pools and close the dead ones.
+ * Called by the tend thread when per-use socket peeks are skipped.
+ */
+void
+as_node_validate_connections(as_node* node);
+
 /**
  * @private
  * Close a node's connection and do not put back into pool.
@@ -543,6 +781,13 @@ as_node_close_connection(as_socket* sock) {
 	pthread_mutex_unlock(&pool_lock->lock);
 }
 
+/**
+ * @private
+ * Put connection into lock-free connection cache.  Return false if all cache slots are full.
+ */
+bool
+as_conn_cache_put(as_conn_pool_lock* pool_lock, as_socket* sock);
+
 /**
  * @private
  * Put connection back into pool.
@@ -553,6 +798,9 @@ as_node_put_connection(as_socket* sock, uint32_t max_socket_idle)
 	// Save pool.
 	as_conn_pool_lock* pool_lock = sock->pool_lock;
 
+	// Do not keep large receive buffers on idle connections.
+	as_socket_trim(sock);
+
 	// TLS connections default to 55 seconds.
 	if (max_socket_idle == 0 && sock->ctx) {
 		max_socket_idle = 55;
@@ -566,6 +814,11 @@ as_node_put_connection(as_socket* sock, uint32_t max_socket_idle)
 		sock->idle_check.max_socket_idle = sock->idle_check.last_used = 0;
 	}
 
+	// Put into lock-free cache first. Fall back to pool when cache is full.
+	if (pool_lock->cache_size > 0 && as_conn_cache_put(pool_lock, sock)) {
+		return;
+	}
+
 	// Put into pool.
 	pthread_mutex_lock(&pool_lock->lock);
 	bool status = as_conn_pool_put(&pool_lock->pool, sock);
@@ -600,6 +853,62 @@ as_node_info_destroy(as_node_info* node_info)
 	cf_free(node_info->session_token);
 }
 
+/**
+ * @private
+ * Add command latency in microseconds to node histogram.
+ */
+static inline void
+as_node_add_latency(as_node* node, as_latency_type type, uint64_t elapsed)
+{
+	uint32_t index = 0;
+
+	while (elapsed > 0 && index < AS_LATENCY_BUCKETS - 1) {
+		elapsed >>= 1;
+		index++;
+	}
+	as_incr_uint64(&node->metrics.latency[type].buckets[index]);
+}
+
+/**
+ * @private
+ * Increment client or server timeout count.  Server timeouts have an error message.
+ * Client timeouts do not have a message.
+ */
+static inline void
+as_node_add_timeout(as_node* node, as_error* err)
+{
+	if (err->message[0]) {
+		as_incr_uint64(&node->metrics.server_timeouts);
+	}
+	else {
+		as_incr_uint64(&node->metrics.client_timeouts);
+	}
+}
+
+/**
+ * @private
+ * Add bytes received from node.  Node may be null.
+ */
+static inline void
+as_node_add_bytes_in(as_node* node, uint64_t bytes)
+{
+	if (node) {
+		as_add_uint64(&node->metrics.bytes_in, bytes);
+	}
+}
+
+/**
+ * @private
+ * Add bytes sent to node.  Node may be null.
+ */
+static inline void
+as_node_add_bytes_out(as_node* node, uint64_t bytes)
+{
+	if (node) {
+		as_add_uint64(&node->metrics.bytes_out, bytes);
+	}
+}
+
 /**
  * @private
  * Tell tend thread to perform another node login.
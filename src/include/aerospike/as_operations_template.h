@@ -0,0 +1,308 @@
+/*
+ * Copyright 2008-2018 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+/**
+ * @defgroup as_operations_template_object Operations Template Object
+ *
+ * An `as_operations_template` holds a list of operations that has already been
+ * serialized into wire format.  Executing a template with
+ * `aerospike_key_operate_template()` copies the serialized operations directly into
+ * the command buffer instead of sizing and serializing each bin on every call.
+ *
+ * Scalar operation values (integer, double, string and blob values of write, incr,
+ * append and prepend operations) can be replaced per call through `as_template_args`.
+ * The record ttl and generation can also be replaced per call.  The key and digest
+ * are always supplied per call.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_operations ops;
+ * as_operations_inita(&ops, 3);
+ * as_operations_add_incr(&ops, "count", 1);
+ * as_operations_add_write_str(&ops, "last", "");
+ * as_operations_add_read(&ops, "count");
+ *
+ * as_operations_template tmpl;
+ *
+ * if (as_operations_template_init(&tmpl, &err, &ops) != AEROSPIKE_OK) {
+ * 	   printf("error(%d) %s at [%s:%d]", err.code, err.message, err.file, err.line);
+ * }
+ * as_operations_destroy(&ops);
+ *
+ * as_template_args args;
+ * as_template_args_inita(&args, &tmpl);
+ * as_template_args_set_int64(&args, 0, 5);
+ * as_template_args_set_str(&args, 1, "abc");
+ *
+ * as_record* rec = NULL;
+ * aerospike_key_operate_template(&as, &err, NULL, &key, &tmpl, &args, &rec);
+ * as_record_destroy(rec);
+ *
+ * as_operations_template_destroy(&tmpl);
+ * ~~~~~~~~~~
+ *
+ * A template is immutable after initialization and may be shared by multiple threads.
+ */
+
+#include <aerospike/as_error.h>
+#include <aerospike/as_operations.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Operations serialized once into wire format.
+ *
+ * @ingroup as_operations_template_object
+ */
+typedef struct as_operations_template_s {
+	/**
+	 * @private
+	 * Serialized operations.
+	 */
+	uint8_t* buf;
+
+	/**
+	 * @private
+	 * Offset of each serialized operation in buf.  Contains n_operations + 1 entries
+	 * where the last entry is the total size of buf.
+	 */
+	uint32_t* offsets;
+
+	/**
+	 * Default record time-to-live (expiration) in seconds.  Copied from `as_operations.ttl`.
+	 */
+	uint32_t ttl;
+
+	/**
+	 * Default expected record generation.  Copied from `as_operations.gen`.
+	 */
+	uint16_t gen;
+
+	/**
+	 * Number of operations.
+	 */
+	uint16_t n_operations;
+
+	/**
+	 * @private
+	 * Read attributes derived from operation types.
+	 */
+	uint8_t read_attr;
+
+	/**
+	 * @private
+	 * Write attributes derived from operation types.
+	 */
+	uint8_t write_attr;
+} as_operations_template;
+
+/**
+ * Per call replacement values for an `as_operations_template`.  Values are indexed by
+ * operation position in the original `as_operations`.  Operations without a value
+ * set use the value serialized in the template.
+ *
+ * Values are copied into the command buffer when the command is created, so string
+ * and blob values only need to remain valid for the duration of the execute call.
+ *
+ * @ingroup as_operations_template_object
+ */
+typedef struct as_template_args_s {
+	/**
+	 * @private
+	 * Replacement values indexed by operation position.  AS_UNDEF means not set.
+	 */
+	as_bin_value* values;
+
+	/**
+	 * Record time-to-live (expiration) in seconds.  Defaults to template ttl.
+	 */
+	uint32_t ttl;
+
+	/**
+	 * Expected record generation.  Defaults to template gen.
+	 */
+	uint16_t gen;
+
+	/**
+	 * @private
+	 * Number of entries in values.
+	 */
+	uint16_t n_values;
+
+	/**
+	 * @private
+	 * If true, values was allocated on the heap.
+	 */
+	bool _free;
+} as_template_args;
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * Initialize stack allocated `as_template_args` for a template.  Replacement values
+ * are allocated on the stack.
+ *
+ * @param __args	The `as_template_args *` to initialize.
+ * @param __tmpl	The `as_operations_template *` the arguments will be used with.
+ *
+ * @relates as_template_args
+ * @ingroup as_operations_template_object
+ */
+#define as_template_args_inita(__args, __tmpl) \
+	(__args)->n_values = (__tmpl)->n_operations;\
+	(__args)->values = (as_bin_value*)alloca(sizeof(as_bin_value) * (__args)->n_values);\
+	memset((__args)->values, 0, sizeof(as_bin_value) * (__args)->n_values);\
+	(__args)->ttl = (__tmpl)->ttl;\
+	(__args)->gen = (__tmpl)->gen;\
+	(__args)->_free = false;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Serialize operations into a template.  The operations are not referenced after
+ * this call and may be destroyed.
+ *
+ * @param tmpl		The template to initialize.
+ * @param err		The as_error to be populated if an error occurs.
+ * @param ops		The operations to serialize.
+ *
+ * @return AEROSPIKE_OK if successful. Otherwise an error.
+ *
+ * @relates as_operations_template
+ * @ingroup as_operations_template_object
+ */
+AS_EXTERN as_status
+as_operations_template_init(as_operations_template* tmpl, as_error* err, const as_operations* ops);
+
+/**
+ * Release resources associated with a template.
+ *
+ * @relates as_operations_template
+ * @ingroup as_operations_template_object
+ */
+AS_EXTERN void
+as_operations_template_destroy(as_operations_template* tmpl);
+
+/**
+ * Initialize `as_template_args` for a template.  Replacement values are allocated
+ * on the heap.  Call `as_template_args_destroy()` when done.
+ *
+ * @relates as_template_args
+ * @ingroup as_operations_template_object
+ */
+AS_EXTERN void
+as_template_args_init(as_template_args* args, const as_operations_template* tmpl);
+
+/**
+ * Release resources associated with `as_template_args`.
+ *
+ * @relates as_template_args
+ * @ingroup as_operations_template_object
+ */
+AS_EXTERN void
+as_template_args_destroy(as_template_args* args);
+
+/**
+ * Clear all replacement values.  Template values will be used for every operation.
+ *
+ * @relates as_template_args
+ * @ingroup as_operations_template_object
+ */
+static inline void
+as_template_args_clear(as_template_args* args)
+{
+	memset(args->values, 0, sizeof(as_bin_value) * args->n_values);
+}
+
+/**
+ * Replace value of operation at index with an integer.
+ *
+ * @return true on success. Otherwise index is out of range.
+ *
+ * @relates as_template_args
+ * @ingroup as_operations_template_object
+ */
+AS_EXTERN bool
+as_template_args_set_int64(as_template_args* args, uint16_t index, int64_t value);
+
+/**
+ * Replace value of operation at index with a double.
+ *
+ * @return true on success. Otherwise index is out of range.
+ *
+ * @relates as_template_args
+ * @ingroup as_operations_template_object
+ */
+AS_EXTERN bool
+as_template_args_set_double(as_template_args* args, uint16_t index, double value);
+
+/**
+ * Replace value of operation at index with a null terminated string.  The string
+ * is not copied until the command is created.
+ *
+ * @return true on success. Otherwise index is out of range.
+ *
+ * @relates as_template_args
+ * @ingroup as_operations_template_object
+ */
+AS_EXTERN bool
+as_template_args_set_str(as_template_args* args, uint16_t index, const char* value);
+
+/**
+ * Replace value of operation at index with a blob.  The blob is not copied until
+ * the command is created.
+ *
+ * @return true on success. Otherwise index is out of range.
+ *
+ * @relates as_template_args
+ * @ingroup as_operations_template_object
+ */
+AS_EXTERN bool
+as_template_args_set_raw(as_template_args* args, uint16_t index, const uint8_t* value, uint32_t size);
+
+/**
+ * @private
+ * Return serialized size of template operations with replacement values applied.
+ * Replacement values must be applied to scalar operation values.
+ */
+as_status
+as_operations_template_size(
+	const as_operations_template* tmpl, as_error* err, const as_template_args* args, size_t* size
+	);
+
+/**
+ * @private
+ * Write template operations with replacement values applied.  as_operations_template_size()
+ * must be called first to validate arguments.
+ */
+uint8_t*
+as_operations_template_write(const as_operations_template* tmpl, const as_template_args* args, uint8_t* p);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -0,0 +1,294 @@
+/*
+ * Copyright 2008-2018 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_error.h>
+#include <aerospike/as_key.h>
+#include <aerospike/as_partition.h>
+#include <aerospike/as_std.h>
+#include <citrusleaf/alloc.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+/**
+ * Scan progress of a single partition.
+ *
+ * @ingroup scan_operations
+ */
+typedef struct as_partition_status_s {
+	/**
+	 * Partition id.
+	 */
+	uint16_t part_id;
+
+	/**
+	 * Have all records in the partition been returned.
+	 */
+	bool done;
+
+	/**
+	 * Digest of the last record returned from this partition.  If the partition
+	 * is scanned again, the scan resumes after this digest.
+	 */
+	as_digest digest;
+} as_partition_status;
+
+/**
+ * Reference counted scan progress of a contiguous range of partitions.  This is the
+ * resumable cursor of a partition scan.  It is updated in place while the scan runs and
+ * can be persisted with as_partitions_status_serialize() and restored with
+ * as_partitions_status_deserialize() to resume a scan after a process restart.
+ *
+ * @ingroup scan_operations
+ */
+typedef struct as_partitions_status_s {
+	/**
+	 * @private
+	 * Reference count.
+	 */
+	uint32_t ref_count;
+
+	/**
+	 * First partition id.
+	 */
+	uint16_t part_begin;
+
+	/**
+	 * Number of partitions.
+	 */
+	uint16_t part_count;
+
+	/**
+	 * Have all partitions been scanned.
+	 */
+	bool done;
+
+	/**
+	 * Partition status array of length part_count.
+	 */
+	as_partition_status parts[];
+} as_partitions_status;
+
+/**
+ * Partition filter used in partition scans.  The filter selects the partitions to scan,
+ * and optionally a digest within the first partition to resume after.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_partition_filter pf;
+ * as_partition_filter_set_range(&pf, 0, 1024);
+ *
+ * if (aerospike_scan_partitions(&as, &err, NULL, &scan, &pf, callback, NULL) != AEROSPIKE_OK) {
+ *     // pf.parts_all holds the partitions that still need to be scanned.
+ * }
+ * as_partition_filter_destroy(&pf);
+ * ~~~~~~~~~~
+ *
+ * @ingroup scan_operations
+ */
+typedef struct as_partition_filter_s {
+	/**
+	 * First partition id.
+	 */
+	uint16_t begin;
+
+	/**
+	 * Number of partitions.
+	 */
+	uint16_t count;
+
+	/**
+	 * Resume after this digest.  Only valid when count is 1.
+	 */
+	as_digest digest;
+
+	/**
+	 * Scan progress.  If set before the scan, the scan resumes from this cursor.
+	 * Otherwise, the scan creates the cursor and stores it here.  Release with
+	 * as_partition_filter_destroy().
+	 */
+	as_partitions_status* parts_all;
+} as_partition_filter;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * Reserve reference counted access to partitions status.
+ *
+ * @relates as_partitions_status
+ */
+static inline as_partitions_status*
+as_partitions_status_reserve(as_partitions_status* parts_all)
+{
+	as_incr_uint32(&parts_all->ref_count);
+	return parts_all;
+}
+
+/**
+ * Release reference counted access to partitions status.
+ *
+ * @relates as_partitions_status
+ */
+static inline void
+as_partitions_status_release(as_partitions_status* parts_all)
+{
+	if (as_aaf_uint32(&parts_all->ref_count, -1) == 0) {
+		cf_free(parts_all);
+	}
+}
+
+/**
+ * Serialize partitions status into a heap allocated buffer.  The format is independent
+ * of host byte order.  The returned buffer must be freed with cf_free().
+ *
+ * @param parts_all		The partitions status.
+ * @param size			Returns the size of the buffer.
+ *
+ * @return The buffer.
+ *
+ * @relates as_partitions_status
+ */
+AS_EXTERN uint8_t*
+as_partitions_status_serialize(const as_partitions_status* parts_all, uint32_t* size);
+
+/**
+ * Create partitions status from a buffer returned by as_partitions_status_serialize().
+ * The created status must be released with as_partitions_status_release().
+ *
+ * @param err			Error detail structure that is populated if an error occurs.
+ * @param buf			The serialized partitions status.
+ * @param size			Size of the buffer.
+ * @param parts_all		Returns the partitions status.
+ *
+ * @return AEROSPIKE_OK on success. Otherwise an error occurred.
+ *
+ * @relates as_partitions_status
+ */
+AS_EXTERN as_status
+as_partitions_status_deserialize(
+	as_error* err, const uint8_t* buf, uint32_t size, as_partitions_status** parts_all
+	);
+
+/**
+ * Filter all partitions.
+ *
+ * @relates as_partition_filter
+ */
+static inline void
+as_partition_filter_set_all(as_partition_filter* pf)
+{
+	pf->begin = 0;
+	pf->count = 4096;
+	pf->digest.init = false;
+	pf->parts_all = NULL;
+}
+
+/**
+ * Filter one partition.
+ *
+ * @param pf		The partition filter.
+ * @param part_id	Partition id (0 - 4095).
+ *
+ * @relates as_partition_filter
+ */
+static inline void
+as_partition_filter_set_id(as_partition_filter* pf, uint32_t part_id)
+{
+	pf->begin = part_id;
+	pf->count = 1;
+	pf->digest.init = false;
+	pf->parts_all = NULL;
+}
+
+/**
+ * Return records after the given digest in the digest's partition.
+ *
+ * @param pf		The partition filter.
+ * @param digest	Resume after this digest.
+ *
+ * @relates as_partition_filter
+ */
+static inline void
+as_partition_filter_set_after(as_partition_filter* pf, as_digest* digest)
+{
+	pf->begin = as_partition_getid(digest->value, 4096);
+	pf->count = 1;
+	pf->digest = *digest;
+	pf->parts_all = NULL;
+}
+
+/**
+ * Filter a range of partitions.
+ *
+ * @param pf		The partition filter.
+ * @param begin		First partition id (0 - 4095).
+ * @param count		Number of partitions (1 - 4096).
+ *
+ * @relates as_partition_filter
+ */
+static inline void
+as_partition_filter_set_range(as_partition_filter* pf, uint32_t begin, uint32_t count)
+{
+	pf->begin = begin;
+	pf->count = count;
+	pf->digest.init = false;
+	pf->parts_all = NULL;
+}
+
+/**
+ * Resume a scan from a cursor returned by a previous partition scan or by
+ * as_partitions_status_deserialize().  Partitions already done are not scanned again.
+ *
+ * @param pf			The partition filter.
+ * @param parts_all		The cursor.  The filter holds its own reference.
+ *
+ * @relates as_partition_filter
+ */
+static inline void
+as_partition_filter_set_partitions(as_partition_filter* pf, as_partitions_status* parts_all)
+{
+	pf->begin = parts_all->part_begin;
+	pf->count = parts_all->part_count;
+	pf->digest.init = false;
+	pf->parts_all = as_partitions_status_reserve(parts_all);
+}
+
+/**
+ * Release the cursor held by the partition filter.
+ *
+ * @relates as_partition_filter
+ */
+static inline void
+as_partition_filter_destroy(as_partition_filter* pf)
+{
+	if (pf->parts_all) {
+		as_partitions_status_release(pf->parts_all);
+		pf->parts_all = NULL;
+	}
+}
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
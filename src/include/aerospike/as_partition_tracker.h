@@ -0,0 +1,197 @@
+/*
+ * Copyright 2008-2018 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_partition_filter.h>
+#include <aerospike/as_policy.h>
+#include <aerospike/as_vector.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+struct as_cluster_s;
+struct as_node_s;
+
+/**
+ * @private
+ * Unit of partition scan work.  Partitions are sent to a single node in one command.
+ */
+typedef struct as_node_partitions_s {
+	/**
+	 * @private
+	 * Reserved node that owns the partitions.
+	 */
+	struct as_node_s* node;
+
+	/**
+	 * @private
+	 * Partitions to scan from the beginning.
+	 */
+	as_vector parts_full; // <uint16_t>
+
+	/**
+	 * @private
+	 * Partitions to scan after the last returned digest.
+	 */
+	as_vector parts_partial; // <uint16_t>
+} as_node_partitions;
+
+/**
+ * @private
+ * Tracks partition completion across partition scan iterations.
+ */
+typedef struct as_partition_tracker_s {
+	/**
+	 * @private
+	 * Scan progress.  Updated in place.
+	 */
+	as_partitions_status* parts_all;
+
+	/**
+	 * @private
+	 * Work units assigned for the current iteration.
+	 */
+	as_vector node_parts; // <as_node_partitions>
+
+	/**
+	 * @private
+	 * Scan deadline in milliseconds.  Zero means no deadline.
+	 */
+	uint64_t deadline;
+
+	/**
+	 * @private
+	 * Milliseconds to sleep between iterations.
+	 */
+	uint32_t sleep_between_retries;
+
+	/**
+	 * @private
+	 * Maximum number of retry iterations.
+	 */
+	uint32_t max_retries;
+
+	/**
+	 * @private
+	 * Current iteration.  Starts at 1.
+	 */
+	uint32_t iteration;
+
+	/**
+	 * @private
+	 * Maximum number of work units per iteration.
+	 */
+	uint32_t max_units;
+} as_partition_tracker;
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Initialize partition tracker from partition filter.  If the filter does not contain
+ * a cursor, one is created and stored in the filter.
+ */
+as_status
+as_partition_tracker_init(
+	as_partition_tracker* pt, as_error* err, struct as_cluster_s* cluster,
+	const as_policy_base* policy, as_partition_filter* pf, uint32_t max_units
+	);
+
+/**
+ * @private
+ * Assign partitions that are not done to the nodes that currently own them.
+ */
+as_status
+as_partition_tracker_assign(
+	as_partition_tracker* pt, as_error* err, struct as_cluster_s* cluster, const char* ns
+	);
+
+/**
+ * @private
+ * Record digest of the last record returned from a partition.
+ */
+static inline void
+as_partition_tracker_set_digest(as_partition_tracker* pt, const uint8_t* digest, uint32_t n_partitions)
+{
+	uint32_t part_id = as_partition_getid(digest, n_partitions);
+	as_partitions_status* parts_all = pt->parts_all;
+
+	if (part_id - parts_all->part_begin < parts_all->part_count) {
+		as_partition_status* ps = &parts_all->parts[part_id - parts_all->part_begin];
+		memcpy(ps->digest.value, digest, AS_DIGEST_VALUE_SIZE);
+		ps->digest.init = true;
+	}
+}
+
+/**
+ * @private
+ * Mark partition done if the partition done result code is success.  Unavailable
+ * partitions are left as not done and are reassigned on the next iteration.
+ */
+static inline void
+as_partition_tracker_part_done(as_partition_tracker* pt, uint32_t part_id, uint8_t result_code)
+{
+	as_partitions_status* parts_all = pt->parts_all;
+
+	if (part_id - parts_all->part_begin >= parts_all->part_count) {
+		return;
+	}
+
+	if (result_code == 0) {
+		parts_all->parts[part_id - parts_all->part_begin].done = true;
+	}
+}
+
+/**
+ * @private
+ * Should unit failure be retried on the next iteration instead of failing the scan.
+ */
+bool
+as_partition_tracker_should_retry(as_status status);
+
+/**
+ * @private
+ * Return true if all partitions are done.  Otherwise, return false and populate err
+ * if the scan can not be retried.
+ */
+bool
+as_partition_tracker_is_complete(as_partition_tracker* pt, as_error* err);
+
+/**
+ * @private
+ * Release nodes and partition lists of the current iteration.
+ */
+void
+as_partition_tracker_release(as_partition_tracker* pt);
+
+/**
+ * @private
+ * Release partition tracker.
+ */
+void
+as_partition_tracker_destroy(as_partition_tracker* pt);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
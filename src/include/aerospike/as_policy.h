@@ -43,6 +43,7 @@
  * policy values for a type of operation.
  *
  * - as_policy_batch
+ * - as_policy_batch_write
  * - as_policy_info
  * - as_policy_operate
  * - as_policy_read
@@ -83,6 +84,13 @@ extern "C" {
  */
 #define AS_POLICY_COMPRESSION_THRESHOLD_DEFAULT 0
 
+/**
+ * Default value for compression level.  Same as zlib Z_DEFAULT_COMPRESSION.
+ *
+ * @ingroup client_policies
+ */
+#define AS_POLICY_COMPRESSION_LEVEL_DEFAULT -1
+
 /**
  * Default as_policy_gen value
  *
@@ -403,6 +411,19 @@ typedef struct as_policy_base_s {
 	 */
 	uint32_t sleep_between_retries;
 
+	/**
+	 * Request zlib compressed responses from the server.  Compressed responses are
+	 * inflated by the client before they are parsed.  This reduces network bandwidth at
+	 * the cost of CPU on both client and server.  The server only compresses responses
+	 * that are large enough to benefit.
+	 *
+	 * Used by read, operate, apply, batch, scan and query commands.  Other commands
+	 * ignore this field.  Requires server versions that support compressed responses.
+	 *
+	 * Default: false
+	 */
+	bool compress;
+
 } as_policy_base;
 
 /**
@@ -439,6 +460,28 @@ typedef struct as_policy_read_s {
 	 */
 	bool deserialize;
 
+	/**
+	 * Decode string, geojson and blob bin values in place.  The record passed to the async
+	 * listener points into the response buffer and is only valid until the listener returns.
+	 * Use as_record_copy() to keep the record.  Synchronous commands ignore this field.
+	 * Default: false
+	 */
+	bool borrow_bins;
+
+	/**
+	 * Milliseconds to wait for a response from the first node before sending the same read
+	 * to the next node in the replica sequence.  The first response received is used and the
+	 * other connection is closed.  If neither node responds within socket_timeout of the
+	 * original send, the attempt times out.  Hedging only applies to synchronous reads when
+	 * replica is AS_POLICY_REPLICA_SEQUENCE.  Async reads ignore this field.
+	 *
+	 * Hedging trades extra server load for lower tail latency when a single node is slow.
+	 * The delay should be set near the observed p99 read latency.
+	 *
+	 * Default: 0 (do not hedge reads)
+	 */
+	uint32_t hedge_delay;
+
 	/**
 	 * Force reads to be linearized for server namespaces that support strong consistency mode.
 	 * Default: false
@@ -490,6 +533,14 @@ typedef struct as_policy_write_s {
 	 */
 	uint32_t compression_threshold;
 
+	/**
+	 * zlib compression level (1-9) used when the record size exceeds compression_threshold.
+	 * Lower levels use less client CPU.  Higher levels produce smaller commands.
+	 *
+	 * Default: AS_POLICY_COMPRESSION_LEVEL_DEFAULT (zlib default level)
+	 */
+	int compression_level;
+
 	/**
 	 * If the transaction results in a record deletion, leave a tombstone for the record.
 	 * This prevents deleted records from reappearing after node failures.
@@ -622,6 +673,14 @@ typedef struct as_policy_operate_s {
 	 */
 	bool deserialize;
 
+	/**
+	 * Decode string, geojson and blob bin values in place.  The record passed to the async
+	 * listener points into the response buffer and is only valid until the listener returns.
+	 * Use as_record_copy() to keep the record.  Synchronous commands ignore this field.
+	 * Default: false
+	 */
+	bool borrow_bins;
+
 	/**
 	 * If the transaction results in a record deletion, leave a tombstone for the record.
 	 * This prevents deleted records from reappearing after node failures.
@@ -705,6 +764,29 @@ typedef struct as_policy_batch_s {
 	 */
 	as_policy_consistency_level consistency_level;
 
+	/**
+	 * Replica used when sync batch reads are retried.  Batch node requests are always sent to
+	 * the master first.  When a node request fails with a timeout or connection error and
+	 * base.max_retries is greater than zero, only the keys that did not receive a response
+	 * are regrouped by the node this replica policy selects and resent.  AS_POLICY_REPLICA_SEQUENCE
+	 * alternates between prole and master on each retry.  AS_POLICY_REPLICA_MASTER resends keys
+	 * to their current master.
+	 *
+	 * Default: AS_POLICY_REPLICA_SEQUENCE
+	 */
+	as_policy_replica replica;
+
+	/**
+	 * Milliseconds to wait for a batch node response before sending the same batch node
+	 * request to an alternate node.  The first response received is used and the other
+	 * connection is closed.  A batch node request is only hedged when every key in that
+	 * request has the same prole node, which is common on small clusters.  Hedging is not
+	 * supported by the batch direct protocol.
+	 *
+	 * Default: 0 (do not hedge batch requests)
+	 */
+	uint32_t hedge_delay;
+
 	/**
 	 * Determine if batch commands to each server are run in parallel threads.
 	 *
@@ -769,6 +851,25 @@ typedef struct as_policy_batch_s {
 	 * Default: true
 	 */
 	bool deserialize;
+
+	/**
+	 * Decode string, geojson and blob bin values in place.  Records passed to the
+	 * aerospike_batch_get_xdr() callback point into the response buffer and are only valid
+	 * until the callback returns.  Use as_record_copy() to keep a record.  Batch reads that
+	 * store results in the batch records ignore this field.
+	 * Default: false
+	 */
+	bool borrow_bins;
+
+	/**
+	 * Allocate string, geojson and blob bin values of sync batch reads from memory blocks
+	 * owned by the batch instead of allocating each value separately.  Blocks are released
+	 * together when aerospike_batch_get() callbacks return or when as_batch_read_destroy()
+	 * is called, so records must not be used after that.  Use as_record_copy() to keep
+	 * an individual record or set to false to allocate values individually.
+	 * Default: true
+	 */
+	bool arena_bins;
 	
 	/**
 	 * Force reads to be linearized for server namespaces that support strong consistency mode.
@@ -776,8 +877,67 @@ typedef struct as_policy_batch_s {
 	 */
 	bool linearize_read;
 
+	/**
+	 * Number of response buffers used to read batch results in a separate thread while
+	 * the command thread parses records and runs callbacks.  The reader stops reading when
+	 * all buffers are waiting to be parsed, so a larger value lets the server get further ahead
+	 * of slow callbacks at the cost of one response block of memory per buffer.  Each node
+	 * command creates its own reader thread, so this is only worthwhile for large results.
+	 *
+	 * Default: 0 (read and parse in the command thread)
+	 */
+	uint32_t stream_buffers;
+
 } as_policy_batch;
-	
+
+/**
+ * Batch Write Policy.  These fields apply to each record in a batch write, operate,
+ * remove or apply request.  Timeouts and retries are taken from the accompanying
+ * as_policy_batch.
+ *
+ * @ingroup client_policies
+ */
+typedef struct as_policy_batch_write_s {
+
+	/**
+	 * Specifies the behavior for the key.
+	 */
+	as_policy_key key;
+
+	/**
+	 * Specifies the number of replicas required to be committed successfully when writing
+	 * before returning transaction succeeded.
+	 */
+	as_policy_commit_level commit_level;
+
+	/**
+	 * Specifies the behavior for the generation value.  The generation value itself
+	 * is taken from each record's operations.
+	 */
+	as_policy_gen gen;
+
+	/**
+	 * Specifies the behavior for the existence of the record.
+	 */
+	as_policy_exists exists;
+
+	/**
+	 * The default time-to-live (expiration) of the record in seconds.  This value is
+	 * only used when a record's operations do not specify a ttl.
+	 */
+	uint32_t ttl;
+
+	/**
+	 * If the transaction results in a record deletion, leave a tombstone for the record.
+	 * This prevents deleted records from reappearing after node failures.
+	 * Valid for Aerospike Server Enterprise Edition only.
+	 *
+	 * Default: false (do not tombstone deleted records).
+	 */
+	bool durable_delete;
+
+} as_policy_batch_write;
+
 /**
  * Query Policy
  *
@@ -802,6 +962,41 @@ typedef struct as_policy_query_s {
 	 */
 	bool deserialize;
 
+	/**
+	 * Decode string, geojson and blob bin values in place.  Records passed to the callback
+	 * point into the response buffer and are only valid until the callback returns.
+	 * Use as_record_copy() to keep a record.
+	 * Default: false
+	 */
+	bool borrow_bins;
+
+	/**
+	 * Number of client-side Lua aggregation streams.  When greater than one, node result
+	 * streams are sharded across this many streams, each reduced on its own thread pool
+	 * thread and Lua state.  The partial results are then reduced once more to produce the
+	 * final result.
+	 *
+	 * Only use this when the client-side part of the stream UDF is an associative and
+	 * commutative reduce, with no map or filter after it.  Otherwise, the final step
+	 * would apply those operations twice.  Ignored when the query has no aggregation.
+	 * Limited to one less than as_config.thread_pool_size, so node queries always have a
+	 * thread to run on.
+	 *
+	 * Default: 1 (aggregate all node results in a single stream)
+	 */
+	uint32_t aggregate_threads;
+
+	/**
+	 * Number of response buffers used to read query results in a separate thread while
+	 * the command thread parses records and runs callbacks.  The reader stops reading when
+	 * all buffers are waiting to be parsed, so a larger value lets the server get further ahead
+	 * of slow callbacks at the cost of one response block of memory per buffer.  Each node
+	 * command creates its own reader thread, so this is only worthwhile for large results.
+	 *
+	 * Default: 0 (read and parse in the command thread)
+	 */
+	uint32_t stream_buffers;
+
 } as_policy_query;
 
 /**
@@ -830,6 +1025,25 @@ typedef struct as_policy_scan_s {
 	 */
 	bool durable_delete;
 
+	/**
+	 * Decode string, geojson and blob bin values in place.  Records passed to the callback
+	 * point into the response buffer and are only valid until the callback returns.
+	 * Use as_record_copy() to keep a record.
+	 * Default: false
+	 */
+	bool borrow_bins;
+
+	/**
+	 * Number of response buffers used to read scan results in a separate thread while
+	 * the command thread parses records and runs callbacks.  The reader stops reading when
+	 * all buffers are waiting to be parsed, so a larger value lets the server get further ahead
+	 * of slow callbacks at the cost of one response block of memory per buffer.  Each node
+	 * command creates its own reader thread, so this is only worthwhile for large results.
+	 *
+	 * Default: 0 (read and parse in the command thread)
+	 */
+	uint32_t stream_buffers;
+
 } as_policy_scan;
 
 /**
@@ -909,6 +1123,11 @@ typedef struct as_policies_s {
 	 */
 	as_policy_batch batch;
 
+	/**
+	 * The default batch write policy.
+	 */
+	as_policy_batch_write batch_write;
+
 	/**
 	 * The default scan policy.
 	 */
@@ -950,10 +1169,13 @@ as_policy_read_init(as_policy_read* p)
 	p->base.total_timeout = AS_POLICY_TOTAL_TIMEOUT_DEFAULT;
 	p->base.max_retries = 2;
 	p->base.sleep_between_retries = 0;
+	p->base.compress = false;
 	p->key = AS_POLICY_KEY_DEFAULT;
 	p->replica = AS_POLICY_REPLICA_DEFAULT;
 	p->consistency_level = AS_POLICY_CONSISTENCY_LEVEL_DEFAULT;
 	p->deserialize = true;
+	p->borrow_bins = false;
+	p->hedge_delay = 0;
 	p->linearize_read = false;
 	return p;
 }
@@ -987,12 +1209,14 @@ as_policy_write_init(as_policy_write* p)
 	p->base.total_timeout = AS_POLICY_TOTAL_TIMEOUT_DEFAULT;
 	p->base.max_retries = 0;
 	p->base.sleep_between_retries = 0;
+	p->base.compress = false;
 	p->key = AS_POLICY_KEY_DEFAULT;
 	p->replica = AS_POLICY_REPLICA_DEFAULT;
 	p->commit_level = AS_POLICY_COMMIT_LEVEL_DEFAULT;
 	p->gen = AS_POLICY_GEN_DEFAULT;
 	p->exists = AS_POLICY_EXISTS_DEFAULT;
 	p->compression_threshold = AS_POLICY_COMPRESSION_THRESHOLD_DEFAULT;
+	p->compression_level = AS_POLICY_COMPRESSION_LEVEL_DEFAULT;
 	p->durable_delete = false;
 	return p;
 }
@@ -1026,6 +1250,7 @@ as_policy_operate_init(as_policy_operate* p)
 	p->base.total_timeout = AS_POLICY_TOTAL_TIMEOUT_DEFAULT;
 	p->base.max_retries = 0;
 	p->base.sleep_between_retries = 0;
+	p->base.compress = false;
 	p->key = AS_POLICY_KEY_DEFAULT;
 	p->replica = AS_POLICY_REPLICA_DEFAULT;
 	p->consistency_level = AS_POLICY_CONSISTENCY_LEVEL_DEFAULT;
@@ -1033,6 +1258,7 @@ as_policy_operate_init(as_policy_operate* p)
 	p->gen = AS_POLICY_GEN_DEFAULT;
 	p->exists = AS_POLICY_EXISTS_DEFAULT;
 	p->deserialize = true;
+	p->borrow_bins = false;
 	p->durable_delete = false;
 	p->linearize_read = false;
 	return p;
@@ -1067,6 +1293,7 @@ as_policy_remove_init(as_policy_remove* p)
 	p->base.total_timeout = AS_POLICY_TOTAL_TIMEOUT_DEFAULT;
 	p->base.max_retries = 0;
 	p->base.sleep_between_retries = 0;
+	p->base.compress = false;
 	p->key = AS_POLICY_KEY_DEFAULT;
 	p->replica = AS_POLICY_REPLICA_DEFAULT;
 	p->commit_level = AS_POLICY_COMMIT_LEVEL_DEFAULT;
@@ -1105,6 +1332,7 @@ as_policy_apply_init(as_policy_apply* p)
 	p->base.total_timeout = AS_POLICY_TOTAL_TIMEOUT_DEFAULT;
 	p->base.max_retries = 0;
 	p->base.sleep_between_retries = 0;
+	p->base.compress = false;
 	p->key = AS_POLICY_KEY_DEFAULT;
 	p->replica = AS_POLICY_REPLICA_DEFAULT;
 	p->commit_level = AS_POLICY_COMMIT_LEVEL_DEFAULT;
@@ -1145,13 +1373,19 @@ as_policy_batch_init(as_policy_batch* p)
 	p->base.total_timeout = AS_POLICY_TOTAL_TIMEOUT_DEFAULT;
 	p->base.max_retries = 2;
 	p->base.sleep_between_retries = 0;
+	p->base.compress = false;
 	p->consistency_level = AS_POLICY_CONSISTENCY_LEVEL_ONE;
+	p->replica = AS_POLICY_REPLICA_SEQUENCE;
+	p->hedge_delay = 0;
 	p->concurrent = false;
 	p->use_batch_direct = false;
 	p->allow_inline = true;
 	p->send_set_name = false;
 	p->deserialize = true;
+	p->borrow_bins = false;
+	p->arena_bins = true;
 	p->linearize_read = false;
+	p->stream_buffers = 0;
 	return p;
 }
 
@@ -1169,6 +1403,40 @@ as_policy_batch_copy(const as_policy_batch* src, as_policy_batch* trg)
 	*trg = *src;
 }
 
+/**
+ * Initialize as_policy_batch_write to default values.
+ *
+ * @param p	The policy to initialize.
+ * @return	The initialized policy.
+ *
+ * @relates as_policy_batch_write
+ */
+static inline as_policy_batch_write*
+as_policy_batch_write_init(as_policy_batch_write* p)
+{
+	p->key = AS_POLICY_KEY_DEFAULT;
+	p->commit_level = AS_POLICY_COMMIT_LEVEL_DEFAULT;
+	p->gen = AS_POLICY_GEN_DEFAULT;
+	p->exists = AS_POLICY_EXISTS_DEFAULT;
+	p->ttl = 0; // AS_RECORD_DEFAULT_TTL
+	p->durable_delete = false;
+	return p;
+}
+
+/**
+ * Copy as_policy_batch_write values.
+ *
+ * @param src	The source policy.
+ * @param trg	The target policy.
+ *
+ * @relates as_policy_batch_write
+ */
+static inline void
+as_policy_batch_write_copy(const as_policy_batch_write* src, as_policy_batch_write* trg)
+{
+	*trg = *src;
+}
+
 /**
  * Initialize as_policy_scan to default values.
  *
@@ -1184,8 +1452,11 @@ as_policy_scan_init(as_policy_scan* p)
 	p->base.total_timeout = 0;
 	p->base.max_retries = 0;
 	p->base.sleep_between_retries = 0;
+	p->base.compress = false;
 	p->fail_on_cluster_change = false;
 	p->durable_delete = false;
+	p->borrow_bins = false;
+	p->stream_buffers = 0;
 	return p;
 }
 
@@ -1218,8 +1489,12 @@ as_policy_query_init(as_policy_query* p)
 	p->base.total_timeout = 0;
 	p->base.max_retries = 0;
 	p->base.sleep_between_retries = 0;
+	p->base.compress = false;
 	p->fail_on_cluster_change = false;
 	p->deserialize = true;
+	p->borrow_bins = false;
+	p->aggregate_threads = 1;
+	p->stream_buffers = 0;
 	return p;
 }
 
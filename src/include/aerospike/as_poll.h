@@ -17,6 +17,7 @@
 #pragma once
 
 #if !defined(_MSC_VER)
+#include <poll.h>
 #include <sys/select.h>
 #endif
 
@@ -100,6 +101,117 @@ as_poll_socket(as_poll* poll, as_socket_fd fd, uint32_t timeout, bool read)
 	return rv;
 }
 
+/**
+ * Wait for either of two sockets to become readable.  The poll must be initialized
+ * with the larger of the two fds.  Returns bit 1 if fd1 is readable, bit 2 if fd2
+ * is readable, 0 on timeout and negative on error.
+ */
+static inline int
+as_poll_sockets_read(as_poll* poll, as_socket_fd fd1, as_socket_fd fd2, uint32_t timeout)
+{
+	memset(poll->set, 0, poll->size);
+	FD_SET(fd1 % FD_SETSIZE, &poll->set[fd1 / FD_SETSIZE]);
+	FD_SET(fd2 % FD_SETSIZE, &poll->set[fd2 / FD_SETSIZE]);
+
+	struct timeval tv;
+	struct timeval* tvp;
+
+	if (timeout > 0) {
+		tv.tv_sec = timeout / 1000;
+		tv.tv_usec = (timeout % 1000) * 1000;
+		tvp = &tv;
+	}
+	else {
+		tvp = NULL;
+	}
+
+	as_socket_fd max = (fd1 > fd2)? fd1 : fd2;
+	int rv = select(max + 1, poll->set /*readfd*/, 0 /*writefd*/, 0/*oobfd*/, tvp);
+
+	if (rv <= 0) {
+		return rv;
+	}
+
+	rv = 0;
+
+	if (FD_ISSET(fd1 % FD_SETSIZE, &poll->set[fd1 / FD_SETSIZE])) {
+		rv |= 1;
+	}
+
+	if (FD_ISSET(fd2 % FD_SETSIZE, &poll->set[fd2 / FD_SETSIZE])) {
+		rv |= 2;
+	}
+	return rv ? rv : -2;
+}
+
+/**
+ * Remove all sockets from socket set.
+ */
+static inline void
+as_poll_clear(as_poll* poll)
+{
+	memset(poll->set, 0, poll->size);
+}
+
+/**
+ * Add socket to socket set.  The poll must be initialized with a fd greater than or
+ * equal to this fd.
+ */
+static inline void
+as_poll_add(as_poll* poll, as_socket_fd fd)
+{
+	FD_SET(fd % FD_SETSIZE, &poll->set[fd / FD_SETSIZE]);
+}
+
+/**
+ * Is socket ready after as_poll_sockets().
+ */
+static inline bool
+as_poll_contains(as_poll* poll, as_socket_fd fd)
+{
+	return FD_ISSET(fd % FD_SETSIZE, &poll->set[fd / FD_SETSIZE]);
+}
+
+/**
+ * Wait for any socket in the read set to become readable or any socket in the write set
+ * to become writable.  Both polls must be initialized with max_fd.  Returns number of
+ * ready sockets, 0 on timeout and negative on error.
+ */
+static inline int
+as_poll_sockets(as_poll* rpoll, as_poll* wpoll, as_socket_fd max_fd, uint32_t timeout)
+{
+	struct timeval tv;
+	struct timeval* tvp;
+
+	if (timeout > 0) {
+		tv.tv_sec = timeout / 1000;
+		tv.tv_usec = (timeout % 1000) * 1000;
+		tvp = &tv;
+	}
+	else {
+		tvp = NULL;
+	}
+
+	return select(max_fd + 1, rpoll->set /*readfd*/, wpoll->set /*writefd*/, 0/*oobfd*/, tvp);
+}
+
+/**
+ * Wait for a single socket to become readable or writable.  Unlike as_poll_socket(),
+ * the cost does not depend on the fd number and nothing needs to be initialized.
+ * Returns positive when ready, 0 on timeout and -1 on error.
+ */
+static inline int
+as_poll_wait(as_socket_fd fd, uint32_t timeout, bool read)
+{
+	struct pollfd pfd;
+	pfd.fd = fd;
+	pfd.events = read ? POLLIN : POLLOUT;
+	pfd.revents = 0;
+
+	// Error and hangup events are reported as ready so the next read/write returns the error.
+	return poll(&pfd, 1, (timeout > 0)? (int)timeout : -1);
+}
+
 static inline void
 as_poll_destroy(as_poll* poll)
 {
@@ -148,6 +260,86 @@ as_poll_socket(as_poll* poll, as_socket_fd fd, uint32_t timeout, bool read)
 	return rv;
 }
 
+static inline int
+as_poll_wait(as_socket_fd fd, uint32_t timeout, bool read)
+{
+	as_poll poll;
+	return as_poll_socket(&poll, fd, timeout, read);
+}
+
+static inline int
+as_poll_sockets_read(as_poll* poll, as_socket_fd fd1, as_socket_fd fd2, uint32_t timeout)
+{
+	FD_ZERO(&poll->set);
+	FD_SET(fd1, &poll->set);
+	FD_SET(fd2, &poll->set);
+
+	struct timeval tv;
+	struct timeval* tvp;
+
+	if (timeout > 0) {
+		tv.tv_sec = timeout / 1000;
+		tv.tv_usec = (timeout % 1000) * 1000;
+		tvp = &tv;
+	}
+	else {
+		tvp = NULL;
+	}
+
+	int rv = select(0, &poll->set /*readfd*/, 0 /*writefd*/, 0/*oobfd*/, tvp);
+
+	if (rv <= 0) {
+		return rv;
+	}
+
+	rv = 0;
+
+	if (FD_ISSET(fd1, &poll->set)) {
+		rv |= 1;
+	}
+
+	if (FD_ISSET(fd2, &poll->set)) {
+		rv |= 2;
+	}
+	return rv ? rv : -2;
+}
+
+static inline void
+as_poll_clear(as_poll* poll)
+{
+	FD_ZERO(&poll->set);
+}
+
+static inline void
+as_poll_add(as_poll* poll, as_socket_fd fd)
+{
+	FD_SET(fd, &poll->set);
+}
+
+static inline bool
+as_poll_contains(as_poll* poll, as_socket_fd fd)
+{
+	return FD_ISSET(fd, &poll->set);
+}
+
+static inline int
+as_poll_sockets(as_poll* rpoll, as_poll* wpoll, as_socket_fd max_fd, uint32_t timeout)
+{
+	struct timeval tv;
+	struct timeval* tvp;
+
+	if (timeout > 0) {
+		tv.tv_sec = timeout / 1000;
+		tv.tv_usec = (timeout % 1000) * 1000;
+		tvp = &tv;
+	}
+	else {
+		tvp = NULL;
+	}
+
+	return select(0, &rpoll->set /*readfd*/, &wpoll->set /*writefd*/, 0/*oobfd*/, tvp);
+}
+
 #define as_poll_destroy(_poll)
 
 #endif
@@ -255,7 +255,8 @@ typedef struct as_record_s {
 	(__rec)->bins._free = false;\
 	(__rec)->bins.capacity = (__nbins);\
 	(__rec)->bins.size = 0;\
-	(__rec)->bins.entries = (as_bin*) alloca(sizeof(as_bin) * (__nbins));
+	(__rec)->bins.entries = (as_bin*) alloca(as_bins_alloc_size(__nbins));\
+	as_bins_index_init(&(__rec)->bins);
 
 /******************************************************************************
  * FUNCTIONS
@@ -315,6 +316,28 @@ as_record_init(as_record* rec, uint16_t nbins);
 AS_EXTERN void
 as_record_destroy(as_record* rec);
 
+/**
+ * Create a new as_record on the heap with copies of the given record's key and bin values.
+ * Use this to keep a record whose bin values were borrowed from a response buffer
+ * (see `borrow_bins` in read, batch, scan and query policies) beyond the callback.
+ *
+ * ~~~~~~~~~~{.c}
+ * as_record* copy = as_record_copy(rec);
+ * ...
+ * as_record_destroy(copy);
+ * ~~~~~~~~~~
+ *
+ * List and map values are shared by reference count.
+ *
+ * @param rec	The record to copy.
+ *
+ * @return a pointer to the new as_record if successful, otherwise NULL.
+ *
+ * @relates as_record
+ */
+AS_EXTERN as_record*
+as_record_copy(const as_record* rec);
+
 /**
  * Get the number of bins in the record.
  *
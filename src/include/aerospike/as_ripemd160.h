@@ -0,0 +1,69 @@
+/*
+ * Copyright 2008-2018 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#pragma once
+
+#include <aerospike/as_std.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Number of messages digested together by as_ripemd160_lanes().
+ */
+#define AS_RIPEMD160_LANES 8
+
+/**
+ * @private
+ * Size of each lane buffer.  Holds the message and its padding in at most two blocks.
+ */
+#define AS_RIPEMD160_LANE_SIZE 128
+
+/**
+ * @private
+ * Maximum message size that fits in a lane buffer after padding.
+ */
+#define AS_RIPEMD160_LANE_MAX (AS_RIPEMD160_LANE_SIZE - 9)
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+/**
+ * @private
+ * Compute RIPEMD-160 digests of up to AS_RIPEMD160_LANES messages at once.  Message i is
+ * stored at the start of lanes[i] and is lens[i] bytes long, which must not exceed
+ * AS_RIPEMD160_LANE_MAX.  Lane buffers are padded in place.  The 20 byte digest of
+ * message i is written to digests[i].
+ *
+ * The messages are digested in parallel, one message per vector lane, on compilers
+ * that support vector extensions.  On x86-64 Linux, AVX2 is used when the CPU supports it.
+ * Other builds digest each message separately.
+ */
+void
+as_ripemd160_lanes(
+	uint8_t lanes[][AS_RIPEMD160_LANE_SIZE], const uint32_t* lens, uint32_t n, uint8_t* const* digests
+	);
+
+#ifdef __cplusplus
+} // end extern "C"
+#endif
@@ -43,9 +43,10 @@ typedef struct as_node_shm_s {
 		
 	/**
 	 * @private
-	 * Lightweight node read/write lock.
+	 * Node sequence lock.  Odd while the tend master is updating the node.
+	 * Readers copy the node and retry if the sequence was odd or changed.
 	 */
-	as_swlock lock;
+	uint32_t seq;
 	
 	/**
 	 * @private
@@ -103,9 +104,10 @@ typedef struct as_partition_shm_s {
 
 	/**
 	 * @private
-	 * Pad to 8 byte boundary.
+	 * Partition sequence lock.  Odd while the tend master is updating master/prole.
+	 * Readers load master/prole and retry if the sequence was odd or changed.
 	 */
-	uint32_t pad;
+	uint32_t seq;
 } as_partition_shm;
 
 /**
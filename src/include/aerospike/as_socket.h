@@ -27,16 +27,21 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <errno.h>
+#include <limits.h>
 
 #define as_socket_fd int
 #define as_socket_data_t void
 #define as_socket_size_t size_t
 #define AS_CONNECTING EINPROGRESS
 #define AS_WOULDBLOCK EWOULDBLOCK
+#define AS_EINTR EINTR
 #define as_close(_fd) close((_fd))
 #define as_last_error() errno
 
+typedef struct iovec as_iovec;
+
 #if defined(__APPLE__)
 #define SOL_TCP IPPROTO_TCP
 #define MSG_NOSIGNAL 0
@@ -46,9 +51,34 @@
 #define as_socket_fd SOCKET
 #define AS_CONNECTING WSAEWOULDBLOCK
 #define AS_WOULDBLOCK WSAEWOULDBLOCK
+#define AS_EINTR WSAEINTR
 #define SHUT_RDWR SD_BOTH
 #define as_close(_fd) closesocket((_fd))
 #define as_last_error() WSAGetLastError()
+
+typedef struct as_iovec_s {
+	void* iov_base;
+	size_t iov_len;
+} as_iovec;
+#endif
+
+/**
+ * @private
+ * Default size of the sync socket receive buffer.
+ */
+#define AS_SOCKET_RBUF_SIZE (1024 * 16)
+
+/**
+ * @private
+ * Receive buffers larger than this size are released when the connection is returned to
+ * its pool, or when a later read on the same command needs less space.
+ */
+#define AS_SOCKET_RBUF_MAX (1024 * 1024)
+
+#if defined(IOV_MAX)
+#define AS_IOV_MAX IOV_MAX
+#else
+#define AS_IOV_MAX 1024
 #endif
 
 #ifdef __cplusplus
@@ -92,6 +122,15 @@ typedef struct as_socket_s {
 	as_tls_context* ctx;
 	const char* tls_name;
 	struct ssl_st* ssl;
+	uint8_t* rbuf;          // Sync receive buffer.  Allocated on first read.
+	uint32_t rbuf_capacity;
+	uint32_t rbuf_offset;   // Next unconsumed byte.
+	uint32_t rbuf_len;      // End of received bytes.
+	uint8_t* zbuf;          // Inflated compressed response.  Allocated on first compressed response.
+	uint32_t zbuf_capacity;
+	uint32_t zbuf_offset;   // Next unconsumed inflated byte.
+	uint32_t zbuf_len;      // End of inflated bytes.
+	bool unvalidated;       // Taken from pool without peek and nothing sent or received yet.
 } as_socket;
 
 /**
@@ -177,6 +216,14 @@ as_socket_create_and_connect(as_socket* sock, as_error* err, struct sockaddr* ad
 void
 as_socket_close(as_socket* sock);
 
+/**
+ * @private
+ * Release consumed receive buffers larger than AS_SOCKET_RBUF_MAX, so idle pooled
+ * connections do not hold memory used by a previous large response.
+ */
+void
+as_socket_trim(as_socket* sock);
+
 /**
  * @private
  * Create error message for socket error.
@@ -205,14 +252,16 @@ as_socket_validate_fd(as_socket_fd fd);
 
 /**
  * @private
- * Peek for socket connection status.
+ * Validate pooled socket before reuse.  The socket is rejected if it has unconsumed
+ * response bytes or has been idle longer than its maximum idle time.  If peek is true,
+ * also peek for socket connection status.
  *
- * @return   0 : socket is connected, but no data available.
+ * @return   0 : socket is connected (or assumed connected when peek is false), but no data available.
  * 		> 0 : byte size of data available.
  * 		< 0 : socket is invalid.
  */
 int
-as_socket_validate(as_socket* sock);
+as_socket_validate(as_socket* sock, bool peek);
 
 /**
  * @private
@@ -235,6 +284,18 @@ as_socket_write_deadline(
 	uint32_t socket_timeout, uint64_t deadline
 	);
 
+/**
+ * @private
+ * Write socket data from multiple buffers with future deadline in milliseconds.
+ * Buffers are sent in order as one contiguous stream.  The iov array is not modified.
+ * If deadline is zero, do not set deadline.
+ */
+as_status
+as_socket_writev_deadline(
+	as_error* err, as_socket* sock, struct as_node_s* node, const as_iovec* iov, uint32_t n_iov,
+	uint32_t socket_timeout, uint64_t deadline
+	);
+
 /**
  * @private
  * Read socket data with future deadline in milliseconds.
@@ -246,6 +307,27 @@ as_socket_read_deadline(
 	uint32_t socket_timeout, uint64_t deadline
 	);
 
+/**
+ * @private
+ * Return socket buffer with room for len inflated response bytes.  Socket reads are
+ * served from this buffer after zbuf_len is set, until all inflated bytes are consumed.
+ */
+uint8_t*
+as_socket_zbuf_prepare(as_socket* sock, uint32_t len);
+
+/**
+ * @private
+ * Read buf_len bytes into the socket receive buffer and return a pointer to them.
+ * The pointer is only valid until the next read on this socket.  This avoids allocating
+ * a buffer for every proto block and copying the block into it.
+ * If deadline is zero, do not set deadline.
+ */
+as_status
+as_socket_read_view(
+	as_error* err, as_socket* sock, struct as_node_s* node, size_t buf_len,
+	uint32_t socket_timeout, uint64_t deadline, uint8_t** view
+	);
+
 #ifdef __cplusplus
 } // end extern "C"
 #endif
@@ -32,6 +32,11 @@ typedef enum as_status_e {
 	/***************************************************************************
 	 * Client Errors
 	 **************************************************************************/
+	/**
+	 * No response was received from the server for this batch record.
+	 */
+	AEROSPIKE_NO_RESPONSE = -12,
+
 	/**
 	 * Async command delay queue is full.
 	 */
@@ -128,15 +128,17 @@ as_bins_init(as_bins* bins, uint16_t capacity)
 {
 	if ( !bins ) return bins;
 
-	as_bin * entries = (as_bin *) cf_malloc(sizeof(as_bin) * capacity);
+	as_bin * entries = (as_bin *) cf_malloc(as_bins_alloc_size(capacity));
 	if ( entries ) {
 		bins->_free = true;
 		bins->capacity = capacity;
 		bins->size = 0;
 		bins->entries = entries;
+		as_bins_index_init(bins);
 	}
 	else {
 		bins->_free = false;
+		bins->_index = false;
 		bins->capacity = 0;
 		bins->size = 0;
 		bins->entries = NULL;
@@ -154,6 +156,7 @@ as_bins_destroy(as_bins* bins)
 		cf_free(bins->entries);
 	}
 
+	bins->_index = false;
 	bins->capacity = 0;
 	bins->size = 0;
 	bins->entries = NULL;
@@ -166,5 +169,44 @@ as_bins_append(as_bins* bins, as_bin_name name, as_bin_value* value)
 	if ( bins->size >= bins->capacity ) return false;
 	as_bin_init(&bins->entries[bins->size], name, value);
 	bins->size++;
+	as_bins_index_update(bins);
 	return true;
 }
+
+void
+as_bins_index_update(as_bins* bins)
+{
+	// Each slot holds the upper 16 bits of the name hash and the bin index + 1.
+	// Zero marks an empty slot.
+	if (! bins->_index || ! bins->entries) {
+		return;
+	}
+
+	uint32_t* count = (uint32_t*)(bins->entries + bins->capacity);
+	uint32_t* slots = count + 1;
+	uint32_t mask = as_bins_index_slots(bins->capacity) - 1;
+
+	if (*count > bins->size) {
+		// Bins were reset without clearing index.
+		*count = 0;
+	}
+
+	if (*count == bins->size) {
+		return;
+	}
+
+	if (*count == 0) {
+		memset(slots, 0, sizeof(uint32_t) * (mask + 1));
+	}
+
+	for (uint32_t i = *count; i < bins->size; i++) {
+		uint32_t hash = as_bins_name_hash(bins->entries[i].name);
+		uint32_t pos = hash & mask;
+
+		while (slots[pos]) {
+			pos = (pos + 1) & mask;
+		}
+		slots[pos] = (hash & 0xFFFF0000) | (i + 1);
+	}
+	*count = bins->size;
+}
@@ -46,7 +46,8 @@
 	(__bins)->entries = (as_bin*) alloca(sizeof(as_bin) * (__capacity));\
 	(__bins)->capacity = (__capacity);\
 	(__bins)->size = 0;\
-	(__bins)->_free = false;
+	(__bins)->_free = false;\
+	(__bins)->_index = false;
 
 /******************************************************************************
  * as_bin FUNCTIONS
@@ -16,15 +16,19 @@
  */
 #include <aerospike/aerospike.h>
 #include <aerospike/aerospike_batch.h>
+#include <aerospike/as_arraylist.h>
 #include <aerospike/as_async.h>
 #include <aerospike/as_command.h>
 #include <aerospike/as_error.h>
 #include <aerospike/as_key.h>
 #include <aerospike/as_list.h>
 #include <aerospike/as_log_macros.h>
+#include <aerospike/as_msgpack.h>
 #include <aerospike/as_operations.h>
 #include <aerospike/as_policy.h>
 #include <aerospike/as_record.h>
+#include <aerospike/as_serializer.h>
+#include <aerospike/as_sleep.h>
 #include <aerospike/as_socket.h>
 #include <aerospike/as_status.h>
 #include <aerospike/as_thread_pool.h>
@@ -32,28 +36,47 @@
 #include <citrusleaf/cf_clock.h>
 #include <citrusleaf/cf_digest.h>
 
+/************************************************************************
+ * 	MACROS
+ ************************************************************************/
+
+// Batch index field flags.
+#define AS_BATCH_ALLOW_INLINE 0x1
+#define AS_BATCH_RESPOND_ALL_KEYS 0x4
+
+// Batch write record types.
+#define AS_BATCH_MSG_REPEAT 0x1
+#define AS_BATCH_MSG_INFO 0x2
+#define AS_BATCH_MSG_GEN 0x4
+#define AS_BATCH_MSG_TTL 0x8
+
 /************************************************************************
  * 	TYPES
  ************************************************************************/
 
 typedef struct as_batch_node_s {
 	as_node* node;
+	as_node* hedge_node;
 	as_vector offsets;
 } as_batch_node;
 
 typedef struct as_batch_task_s {
 	as_node* node;
+	as_node* hedge_node;
 	as_vector offsets;
 	
 	as_cluster* cluster;
 	const as_policy_batch* policy;
+	const as_policy_batch_write* policy_write; // aerospike_batch_write()
 	as_error* err;
 	cf_queue* complete_q;
 	uint32_t* error_mutex;
-	as_vector* records;     // New aerospike_batch_read()
+	as_vector* records;     // New aerospike_batch_read() and aerospike_batch_write()
 	const char* ns;         // Old aerospike_batch_get()
 	as_key* keys;           // Old aerospike_batch_get()
 	as_batch_read* results; // Old aerospike_batch_get()
+	as_arena* arena;        // Holds bin values when policy arena_bins is true.
+	uint8_t* done;          // Keys that received a response.  Null when failed keys are not regrouped.
 	void* udata;            // XDR
 	as_batch_callback_xdr callback_xdr; // XDR
 	const char** bins;      // Old aerospike_batch_get()
@@ -64,6 +87,7 @@ typedef struct as_batch_task_s {
 
 	uint8_t read_attr;      // Old aerospike_batch_get()
 	bool use_batch_records;
+	bool use_write_records;
 	bool use_new_batch;
 } as_batch_task;
 
@@ -78,6 +102,23 @@ typedef struct {
 	as_async_batch_listener listener;
 } as_async_batch_executor;
 
+typedef struct {
+	as_event_executor executor;
+	as_batch_write_records* records;
+	as_async_batch_write_listener listener;
+} as_async_batch_write_executor;
+
+typedef struct as_batch_write_attr_s {
+	uint32_t generation;
+	uint32_t ttl;
+	uint16_t n_fields;
+	uint16_t n_ops;
+	uint8_t read_attr;
+	uint8_t write_attr;
+	uint8_t info_attr;
+	bool repeat;
+} as_batch_write_attr;
+
 typedef struct as_async_batch_command {
 	as_event_command command;
 	uint8_t space[];
@@ -111,12 +152,24 @@ as_batch_parse_fields(uint8_t* p, uint32_t n_fields, uint8_t** digest)
 }
 
 static inline as_status
-as_batch_parse_record(uint8_t** pp, as_error* err, as_msg* msg, as_record* rec, bool deserialize)
+as_batch_parse_record(
+	uint8_t** pp, as_error* err, as_msg* msg, as_record* rec, bool deserialize, bool borrow,
+	as_arena* arena
+	)
 {
-	as_record_init(rec, msg->n_ops);
+	if (arena && msg->n_ops > 0) {
+		// Bins array is released with the arena.
+		as_record_init(rec, 0);
+		rec->bins.entries = as_arena_alloc(arena, as_bins_alloc_size(msg->n_ops));
+		rec->bins.capacity = msg->n_ops;
+		as_bins_index_init(&rec->bins);
+	}
+	else {
+		as_record_init(rec, msg->n_ops);
+	}
 	rec->gen = msg->generation;
 	rec->ttl = cf_server_void_time_to_ttl(msg->record_ttl);
-	return as_command_parse_bins(pp, err, rec, msg->n_ops, deserialize);
+	return as_command_parse_bins(pp, err, rec, msg->n_ops, deserialize, borrow, arena);
 }
 
 static void
@@ -126,8 +179,15 @@ as_batch_complete_async(as_event_executor* executor)
 	e->listener(executor->err, e->records, executor->udata, executor->event_loop);
 }
 
+static void
+as_batch_complete_write_async(as_event_executor* executor)
+{
+	as_async_batch_write_executor* e = (as_async_batch_write_executor*)executor;
+	e->listener(executor->err, e->records, executor->udata, executor->event_loop);
+}
+
 static bool
-as_batch_async_skip_records(as_event_command* cmd)
+as_batch_async_skip_records(as_event_command* cmd, bool write_records)
 {
 	uint8_t* p = cmd->buf;
 	uint8_t* end = p + cmd->len;
@@ -136,7 +196,10 @@ as_batch_async_skip_records(as_event_command* cmd)
 		as_msg* msg = (as_msg*)p;
 		as_msg_swap_header_from_be(msg);
 		
-		if (msg->result_code && msg->result_code != AEROSPIKE_ERR_RECORD_NOT_FOUND) {
+		// Batch write records have their own result codes.
+		// Only the last message contains the batch command result.
+		if (msg->result_code && msg->result_code != AEROSPIKE_ERR_RECORD_NOT_FOUND &&
+			(! write_records || (msg->info3 & AS_MSG_INFO3_LAST))) {
 			as_error err;
 			as_error_set_message(&err, msg->result_code, as_error_string(msg->result_code));
 			as_event_response_error(cmd, &err);
@@ -163,7 +226,7 @@ as_batch_async_parse_records(as_event_command* cmd)
 	if (! executor->executor.valid) {
 		// An error has already been returned to the user and records have been deleted.
 		// Skip over remaining socket data so it's fully read and can be reused.
-		return as_batch_async_skip_records(cmd);
+		return as_batch_async_skip_records(cmd, false);
 	}
 	
 	as_error err;
@@ -204,7 +267,7 @@ as_batch_async_parse_records(as_event_command* cmd)
 			record->result = msg->result_code;
 			
 			if (msg->result_code == AEROSPIKE_OK) {
-				as_status status = as_batch_parse_record(&p, &err, msg, &record->record, cmd->deserialize);
+				as_status status = as_batch_parse_record(&p, &err, msg, &record->record, cmd->deserialize, false, NULL);
 
 				if (status != AEROSPIKE_OK) {
 					as_event_response_error(cmd, &err);
@@ -223,6 +286,129 @@ as_batch_async_parse_records(as_event_command* cmd)
 	return false;
 }
 
+static inline as_status
+as_batch_parse_write_record(uint8_t** pp, as_error* err, as_msg* msg, as_batch_write_record* record, bool deserialize)
+{
+	if (record->result != AEROSPIKE_NO_RESPONSE) {
+		// Record was already parsed by a previous attempt of the same command.
+		as_record_destroy(&record->record);
+	}
+	record->result = msg->result_code;
+
+	// Bins are also parsed on error because UDF failures return the error in a "FAILURE" bin.
+	return as_batch_parse_record(pp, err, msg, &record->record, deserialize, false, NULL);
+}
+
+static bool
+as_batch_async_parse_write_records(as_event_command* cmd)
+{
+	as_async_batch_write_executor* executor = cmd->udata;  // udata is overloaded to contain executor.
+
+	if (! executor->executor.valid) {
+		// An error has already been returned to the user.
+		// Skip over remaining socket data so it's fully read and can be reused.
+		return as_batch_async_skip_records(cmd, true);
+	}
+
+	as_error err;
+	as_vector* records = &executor->records->list;
+	uint8_t* p = cmd->buf;
+	uint8_t* end = p + cmd->len;
+
+	while (p < end) {
+		as_msg* msg = (as_msg*)p;
+		as_msg_swap_header_from_be(msg);
+		p += sizeof(as_msg);
+
+		if (msg->info3 & AS_MSG_INFO3_LAST) {
+			if (msg->result_code) {
+				as_error_set_message(&err, msg->result_code, as_error_string(msg->result_code));
+				as_event_response_error(cmd, &err);
+				return true;
+			}
+			as_event_batch_complete(cmd);
+			return true;
+		}
+
+		uint32_t offset = msg->transaction_ttl; // overloaded to contain batch index
+
+		uint8_t* digest = 0;
+		p = as_batch_parse_fields(p, msg->n_fields, &digest);
+
+		if (offset >= records->size) {
+			as_error_update(&err, AEROSPIKE_ERR_CLIENT, "Batch index %u >= batch size: %u", offset, records->size);
+			as_event_response_error(cmd, &err);
+			return true;
+		}
+
+		as_batch_write_record* record = as_vector_get(records, offset);
+
+		if (digest && memcmp(digest, record->key.digest.value, AS_DIGEST_VALUE_SIZE) == 0) {
+			as_status status = as_batch_parse_write_record(&p, &err, msg, record, cmd->deserialize);
+
+			if (status != AEROSPIKE_OK) {
+				as_event_response_error(cmd, &err);
+				return true;
+			}
+		}
+		else {
+			char digest_string[64];
+			cf_digest_string((cf_digest*)digest, digest_string);
+			as_error_update(&err, AEROSPIKE_ERR_CLIENT, "Unexpected batch key returned: %s,%u", digest_string, offset);
+			as_event_response_error(cmd, &err);
+			return true;
+		}
+	}
+	return false;
+}
+
+static as_status
+as_batch_parse_write_records(as_error* err, uint8_t* buf, size_t size, as_batch_task* task)
+{
+	bool deserialize = task->policy->deserialize;
+
+	uint8_t* p = buf;
+	uint8_t* end = buf + size;
+
+	while (p < end) {
+		as_msg* msg = (as_msg*)p;
+		as_msg_swap_header_from_be(msg);
+		p += sizeof(as_msg);
+
+		if (msg->info3 & AS_MSG_INFO3_LAST) {
+			if (msg->result_code) {
+				return as_error_set_message(err, msg->result_code, as_error_string(msg->result_code));
+			}
+			return AEROSPIKE_NO_MORE_RECORDS;
+		}
+
+		uint32_t offset = msg->transaction_ttl;  // overloaded to contain batch index
+
+		if (offset >= task->n_keys) {
+			return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Batch index %u >= batch size: %u", offset, task->n_keys);
+		}
+
+		uint8_t* digest = 0;
+		p = as_batch_parse_fields(p, msg->n_fields, &digest);
+
+		as_batch_write_record* record = as_vector_get(task->records, offset);
+
+		if (digest && memcmp(digest, record->key.digest.value, AS_DIGEST_VALUE_SIZE) == 0) {
+			as_status status = as_batch_parse_write_record(&p, err, msg, record, deserialize);
+
+			if (status != AEROSPIKE_OK) {
+				return status;
+			}
+		}
+		else {
+			char digest_string[64];
+			cf_digest_string((cf_digest*)digest, digest_string);
+			return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Unexpected batch key returned: %s,%u", digest_string, offset);
+		}
+	}
+	return AEROSPIKE_OK;
+}
+
 static as_status
 as_batch_parse_records(as_error* err, uint8_t* buf, size_t size, as_batch_task* task)
 {
@@ -266,7 +452,8 @@ as_batch_parse_records(as_error* err, uint8_t* buf, size_t size, as_batch_task*
 				record->result = msg->result_code;
 				
 				if (msg->result_code == AEROSPIKE_OK) {
-					as_status status = as_batch_parse_record(&p, err, msg, &record->record, deserialize);
+					as_status status = as_batch_parse_record(&p, err, msg, &record->record, deserialize, false,
+																	  task->arena);
 
 					if (status != AEROSPIKE_OK) {
 						return status;
@@ -285,7 +472,8 @@ as_batch_parse_records(as_error* err, uint8_t* buf, size_t size, as_batch_task*
 				if (task->callback_xdr) {
 					if (msg->result_code == AEROSPIKE_OK) {
 						as_record rec;
-						as_status status = as_batch_parse_record(&p, err, msg, &rec, deserialize);
+						as_status status = as_batch_parse_record(&p, err, msg, &rec, deserialize,
+																					   task->policy->borrow_bins, NULL);
 
 						if (status != AEROSPIKE_OK) {
 							as_record_destroy(&rec);
@@ -305,7 +493,8 @@ as_batch_parse_records(as_error* err, uint8_t* buf, size_t size, as_batch_task*
 					result->result = msg->result_code;
 					
 					if (msg->result_code == AEROSPIKE_OK) {
-						as_status status = as_batch_parse_record(&p, err, msg, &result->record, deserialize);
+						as_status status = as_batch_parse_record(&p, err, msg, &result->record, deserialize, false,
+																		  task->arena);
 
 						if (status != AEROSPIKE_OK) {
 							return status;
@@ -319,22 +508,42 @@ as_batch_parse_records(as_error* err, uint8_t* buf, size_t size, as_batch_task*
 				return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Unexpected batch key returned: %s,%s,%u,%u", task->ns, digest_string, task->index, offset);
 			}
 		}
+
+		if (task->done) {
+			task->done[offset] = 1;
+		}
 	}
 	return AEROSPIKE_OK;
 }
 
+static as_status
+as_batch_parse_stream(as_error* err, uint8_t* buf, size_t size, void* udata)
+{
+	as_batch_task* task = udata;
+
+	if (task->use_write_records) {
+		return as_batch_parse_write_records(err, buf, size, task);
+	}
+	return as_batch_parse_records(err, buf, size, task);
+}
+
 static as_status
 as_batch_parse(as_error* err, as_socket* sock, as_node* node, uint32_t socket_timeout, uint64_t deadline_ms, void* udata)
 {
 	as_batch_task* task = udata;
+
+	if (task->policy->stream_buffers > 0) {
+		// Per-record result codes do not end a batch response.
+		return as_command_parse_stream(err, sock, node, socket_timeout, deadline_ms,
+			task->policy->stream_buffers, false, as_batch_parse_stream, task);
+	}
+
 	as_status status = AEROSPIKE_OK;
-	uint8_t* buf = 0;
-	size_t capacity = 0;
 	
 	while (true) {
 		// Read header
 		as_proto proto;
-		status = as_socket_read_deadline(err, sock, node, (uint8_t*)&proto, sizeof(as_proto), socket_timeout, deadline_ms);
+		status = as_command_read_proto(err, sock, node, (uint8_t*)&proto, sizeof(as_proto), socket_timeout, deadline_ms);
 		
 		if (status) {
 			break;
@@ -343,21 +552,20 @@ as_batch_parse(as_error* err, as_socket* sock, as_node* node, uint32_t socket_ti
 		size_t size = proto.sz;
 		
 		if (size > 0) {
-			// Prepare buffer
-			if (size > capacity) {
-				as_command_free(buf, capacity);
-				capacity = size;
-				buf = as_command_init(capacity);
-			}
-			
-			// Read remaining message bytes in group
-			status = as_socket_read_deadline(err, sock, node, buf, size, socket_timeout, deadline_ms);
+			// Read remaining message bytes in group directly from the socket receive buffer.
+			uint8_t* buf;
+			status = as_socket_read_view(err, sock, node, size, socket_timeout, deadline_ms, &buf);
 			
 			if (status) {
 				break;
 			}
 			
-			status = as_batch_parse_records(err, buf, size, task);
+			if (task->use_write_records) {
+				status = as_batch_parse_write_records(err, buf, size, task);
+			}
+			else {
+				status = as_batch_parse_records(err, buf, size, task);
+			}
 			
 			if (status != AEROSPIKE_OK) {
 				if (status == AEROSPIKE_NO_MORE_RECORDS) {
@@ -367,7 +575,6 @@ as_batch_parse(as_error* err, as_socket* sock, as_node* node, uint32_t socket_ti
 			}
 		}
 	}
-	as_command_free(buf, capacity);
 	return status;
 }
 
@@ -419,6 +626,8 @@ as_batch_index_records_write(as_vector* records, as_vector* offsets, const as_po
 		read_attr |= AS_MSG_INFO1_CONSISTENCY_ALL;
 	}
 
+	read_attr |= as_command_compress_attr(&policy->base);
+
 	uint32_t n_offsets = offsets->size;
 	uint8_t* p = as_command_write_header_read(cmd, read_attr | AS_MSG_INFO1_BATCH_INDEX,
 					policy->consistency_level, policy->linearize_read, policy->base.total_timeout, 1, 0);
@@ -502,6 +711,9 @@ as_batch_index_records_execute(as_batch_task* task)
 
 	as_command_node cn;
 	cn.node = task->node;
+	cn.hedge_node = task->hedge_node;
+	cn.hedge_delay = task->hedge_node ? policy->hedge_delay : 0;
+	cn.latency_type = AS_LATENCY_TYPE_BATCH;
 
 	as_error err;
 	as_error_init(&err);
@@ -519,71 +731,401 @@ as_batch_index_records_execute(as_batch_task* task)
 	return status;
 }
 
-static as_status
-as_batch_index_execute(as_batch_task* task)
+static inline bool
+as_batch_write_repeat(
+	const as_policy_batch_write* policy, as_batch_write_record* prev, as_batch_write_record* record
+	)
 {
-	const as_policy_batch* policy = task->policy;
+	// The user key differs for every record, so records that send the key can not be repeated.
+	if (! prev || policy->key == AS_POLICY_KEY_SEND || prev->type != record->type ||
+		strcmp(prev->key.ns, record->key.ns) != 0 || strcmp(prev->key.set, record->key.set) != 0) {
+		return false;
+	}
 
-	// Calculate size of bin names.
-	uint16_t field_count = policy->send_set_name ? 2 : 1;
-	size_t bin_name_size = 0;
-	
-	if (task->n_bins) {
-		for (uint32_t i = 0; i < task->n_bins; i++) {
-			bin_name_size += as_command_string_operation_size(task->bins[i]);
+	switch (record->type) {
+		case AS_BATCH_WRITE_OPERATE:
+			return prev->ops == record->ops;
+
+		case AS_BATCH_WRITE_REMOVE:
+			return true;
+
+		case AS_BATCH_WRITE_APPLY:
+			return prev->arglist == record->arglist && strcmp(prev->module, record->module) == 0 &&
+				strcmp(prev->function, record->function) == 0;
+	}
+	return false;
+}
+
+static void
+as_batch_write_attr_init(
+	as_batch_write_attr* attr, const as_policy_batch_write* policy, as_batch_write_record* record,
+	uint8_t read_attr, uint8_t write_attr
+	)
+{
+	uint8_t info_attr = 0;
+	uint32_t generation = 0;
+	uint32_t ttl = policy->ttl;
+
+	if (record->type == AS_BATCH_WRITE_OPERATE) {
+		switch (policy->exists) {
+			case AS_POLICY_EXISTS_IGNORE:
+				break;
+
+			case AS_POLICY_EXISTS_UPDATE:
+				info_attr |= AS_MSG_INFO3_UPDATE_ONLY;
+				break;
+
+			case AS_POLICY_EXISTS_CREATE_OR_REPLACE:
+				info_attr |= AS_MSG_INFO3_CREATE_OR_REPLACE;
+				break;
+
+			case AS_POLICY_EXISTS_REPLACE:
+				info_attr |= AS_MSG_INFO3_REPLACE_ONLY;
+				break;
+
+			case AS_POLICY_EXISTS_CREATE:
+				write_attr |= AS_MSG_INFO2_CREATE_ONLY;
+				break;
+		}
+
+		switch (policy->gen) {
+			case AS_POLICY_GEN_IGNORE:
+				break;
+
+			case AS_POLICY_GEN_EQ:
+				generation = record->ops->gen;
+				write_attr |= AS_MSG_INFO2_GENERATION;
+				break;
+
+			case AS_POLICY_GEN_GT:
+				generation = record->ops->gen;
+				write_attr |= AS_MSG_INFO2_GENERATION_GT;
+				break;
+
+			default:
+				break;
+		}
+
+		if (record->ops->ttl) {
+			ttl = record->ops->ttl;
 		}
 	}
-	
-	// Estimate buffer size.
-	size_t size = AS_HEADER_SIZE + AS_FIELD_HEADER_SIZE + 5;
-	as_key* prev = 0;
-	uint32_t n_offsets = task->offsets.size;
-	
+
+	if (policy->commit_level == AS_POLICY_COMMIT_LEVEL_MASTER) {
+		info_attr |= AS_MSG_INFO3_COMMIT_MASTER;
+	}
+
+	if (policy->durable_delete && (write_attr & AS_MSG_INFO2_WRITE)) {
+		write_attr |= AS_MSG_INFO2_DURABLE_DELETE;
+	}
+
+	attr->generation = generation;
+	attr->ttl = ttl;
+	attr->read_attr = read_attr;
+	attr->write_attr = write_attr;
+	attr->info_attr = info_attr;
+}
+
+static size_t
+as_batch_write_records_size(
+	as_vector* records, as_vector* offsets, const as_policy_batch_write* policy, as_vector* attrs,
+	as_vector* buffers
+	)
+{
+	// Estimate buffer size.  Attributes are saved for each offset and list/map values
+	// are serialized in order, so as_batch_write_records_write() does not repeat the work.
+	size_t size = AS_HEADER_SIZE + AS_FIELD_HEADER_SIZE + sizeof(uint32_t) + 1;
+	as_batch_write_record* prev = 0;
+	uint32_t n_offsets = offsets->size;
+
 	for (uint32_t i = 0; i < n_offsets; i++) {
-		uint32_t offset = *(uint32_t*)as_vector_get(&task->offsets, i);
-		as_key* key = &task->keys[offset];
-		
-		size += 24;  // digest + int count.
+		uint32_t offset = *(uint32_t*)as_vector_get(offsets, i);
+		as_batch_write_record* record = as_vector_get(records, offset);
+		as_batch_write_attr* attr = as_vector_reserve(attrs);
 
-		if (prev && strcmp(prev->ns, key->ns) == 0 && (! policy->send_set_name || strcmp(prev->set, key->set) == 0)) {
-			// Can set repeat previous namespace/bin names to save space.
+		size += AS_DIGEST_VALUE_SIZE + sizeof(uint32_t);
+
+		if (as_batch_write_repeat(policy, prev, record)) {
+			// Can repeat previous namespace/set/write command to save space.
+			attr->repeat = true;
 			size++;
+			continue;
 		}
-		else {
-			// Estimate full header, namespace and bin names.
-			size += as_command_string_field_size(key->ns) + 6;
-			
-			if (policy->send_set_name) {
-				size += as_command_string_field_size(key->set);
-			}
-			size += bin_name_size;
-			prev = key;
+
+		// Estimate full header, namespace and set.
+		size += 14;
+		size += as_command_string_field_size(record->key.ns);
+		size += as_command_string_field_size(record->key.set);
+		attr->n_fields = 2;
+
+		if (policy->key == AS_POLICY_KEY_SEND && record->key.valuep) {
+			size += as_command_user_key_size(&record->key);
+			attr->n_fields++;
 		}
-	}
 
-	if (policy->consistency_level == AS_POLICY_CONSISTENCY_LEVEL_ALL) {
-		task->read_attr |= AS_MSG_INFO1_CONSISTENCY_ALL;
+		uint8_t read_attr = 0;
+		uint8_t write_attr = 0;
+
+		switch (record->type) {
+			case AS_BATCH_WRITE_OPERATE: {
+				uint32_t n_operations = record->ops->binops.size;
+				uint32_t start = buffers->size;
+
+				for (uint32_t j = 0; j < n_operations; j++) {
+					as_vector_reserve(buffers);
+				}
+				size += as_command_operate_set_attr(record->ops, as_vector_get(buffers, start),
+													&read_attr, &write_attr);
+				attr->n_ops = (uint16_t)n_operations;
+				break;
+			}
+
+			case AS_BATCH_WRITE_REMOVE:
+				write_attr = AS_MSG_INFO2_WRITE | AS_MSG_INFO2_DELETE;
+				break;
+
+			case AS_BATCH_WRITE_APPLY: {
+				as_list* arglist = record->arglist;
+				as_arraylist empty;
+
+				if (! arglist) {
+					as_arraylist_inita(&empty, 0);
+					arglist = (as_list*)&empty;
+				}
+
+				as_buffer* args = as_vector_reserve(buffers);
+				as_serializer ser;
+				as_msgpack_init(&ser);
+				as_serializer_serialize(&ser, (as_val*)arglist, args);
+				as_serializer_destroy(&ser);
+
+				size += as_command_string_field_size(record->module);
+				size += as_command_string_field_size(record->function);
+				size += as_command_field_size(args->size);
+				attr->n_fields += 3;
+				write_attr = AS_MSG_INFO2_WRITE;
+				break;
+			}
+		}
+		as_batch_write_attr_init(attr, policy, record, read_attr, write_attr);
+		prev = record;
 	}
+	return size;
+}
 
-	// Write command
-	uint8_t* cmd = as_command_init(size);
-	uint8_t* p = as_command_write_header_read(cmd, task->read_attr | AS_MSG_INFO1_BATCH_INDEX,
-					policy->consistency_level, policy->linearize_read, policy->base.total_timeout, 1, 0);
+static size_t
+as_batch_write_records_write(
+	as_vector* records, as_vector* offsets, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_vector* attrs, as_vector* buffers, uint8_t* cmd
+	)
+{
+	uint32_t n_offsets = offsets->size;
+	uint8_t* p = as_command_write_header_read(cmd,
+					AS_MSG_INFO1_BATCH_INDEX | as_command_compress_attr(&policy->base),
+					AS_POLICY_CONSISTENCY_LEVEL_ONE, false, policy->base.total_timeout, 1, 0);
 	uint8_t* field_size_ptr = p;
-	p = as_command_write_field_header(p, policy->send_set_name ? AS_FIELD_BATCH_INDEX_WITH_SET : AS_FIELD_BATCH_INDEX, 0);  // Need to update size at end
+	p = as_command_write_field_header(p, AS_FIELD_BATCH_INDEX, 0);  // Need to update size at end
 	*(uint32_t*)p = cf_swap_to_be32(n_offsets);
 	p += sizeof(uint32_t);
-	*p++ = policy->allow_inline? 1 : 0;
-	
-	prev = 0;
-	
+	*p++ = AS_BATCH_RESPOND_ALL_KEYS | (policy->allow_inline? AS_BATCH_ALLOW_INLINE : 0);
+
+	uint32_t buffer_index = 0;
+
 	for (uint32_t i = 0; i < n_offsets; i++) {
-		uint32_t offset = *(uint32_t*)as_vector_get(&task->offsets, i);
+		uint32_t offset = *(uint32_t*)as_vector_get(offsets, i);
 		*(uint32_t*)p = cf_swap_to_be32(offset);
 		p += sizeof(uint32_t);
-		
-		as_key* key = &task->keys[offset];
-		memcpy(p, key->digest.value, AS_DIGEST_VALUE_SIZE);
+
+		as_batch_write_record* record = as_vector_get(records, offset);
+		memcpy(p, record->key.digest.value, AS_DIGEST_VALUE_SIZE);
+		p += AS_DIGEST_VALUE_SIZE;
+
+		as_batch_write_attr* attr = as_vector_get(attrs, i);
+
+		if (attr->repeat) {
+			// Can repeat previous namespace/set/write command to save space.
+			*p++ = AS_BATCH_MSG_REPEAT;
+			continue;
+		}
+
+		// Write full header, namespace, set and write command.
+		*p++ = AS_BATCH_MSG_INFO | AS_BATCH_MSG_GEN | AS_BATCH_MSG_TTL;
+		*p++ = attr->read_attr;
+		*p++ = attr->write_attr;
+		*p++ = attr->info_attr;
+		*(uint16_t*)p = cf_swap_to_be16((uint16_t)attr->generation);
+		p += sizeof(uint16_t);
+		*(uint32_t*)p = cf_swap_to_be32(attr->ttl);
+		p += sizeof(uint32_t);
+		*(uint16_t*)p = cf_swap_to_be16(attr->n_fields);
+		p += sizeof(uint16_t);
+		*(uint16_t*)p = cf_swap_to_be16(attr->n_ops);
+		p += sizeof(uint16_t);
+		p = as_command_write_field_string(p, AS_FIELD_NAMESPACE, record->key.ns);
+		p = as_command_write_field_string(p, AS_FIELD_SETNAME, record->key.set);
+
+		if (policy_write->key == AS_POLICY_KEY_SEND && record->key.valuep) {
+			p = as_command_write_user_key(p, &record->key);
+		}
+
+		switch (record->type) {
+			case AS_BATCH_WRITE_OPERATE: {
+				for (uint32_t j = 0; j < attr->n_ops; j++) {
+					as_binop* op = &record->ops->binops.entries[j];
+					p = as_command_write_bin(p, op->op, &op->bin, as_vector_get(buffers, buffer_index++));
+				}
+				break;
+			}
+
+			case AS_BATCH_WRITE_REMOVE:
+				break;
+
+			case AS_BATCH_WRITE_APPLY: {
+				as_buffer* args = as_vector_get(buffers, buffer_index++);
+				p = as_command_write_field_string(p, AS_FIELD_UDF_PACKAGE_NAME, record->module);
+				p = as_command_write_field_string(p, AS_FIELD_UDF_FUNCTION, record->function);
+				p = as_command_write_field_buffer(p, AS_FIELD_UDF_ARGLIST, args);
+				as_buffer_destroy(args);
+				break;
+			}
+		}
+	}
+	// Write real field size.
+	size_t size = p - field_size_ptr - 4;
+	*(uint32_t*)field_size_ptr = cf_swap_to_be32((uint32_t)size);
+
+	return as_command_write_end(cmd, p);
+}
+
+static void
+as_batch_write_records_set_error(as_vector* records, as_vector* offsets, as_error* err)
+{
+	// Records that did not receive a response share the node command error.
+	uint32_t n_offsets = offsets->size;
+
+	for (uint32_t i = 0; i < n_offsets; i++) {
+		uint32_t offset = *(uint32_t*)as_vector_get(offsets, i);
+		as_batch_write_record* record = as_vector_get(records, offset);
+
+		if (record->result == AEROSPIKE_NO_RESPONSE) {
+			record->result = err->code;
+			record->in_doubt = err->in_doubt;
+		}
+	}
+}
+
+static as_status
+as_batch_write_records_execute(as_batch_task* task)
+{
+	const as_policy_batch* policy = task->policy;
+	as_vector attrs;
+	as_vector buffers;
+	as_vector_init(&attrs, sizeof(as_batch_write_attr), task->offsets.size);
+	as_vector_init(&buffers, sizeof(as_buffer), 16);
+
+	// Estimate buffer size.
+	size_t size = as_batch_write_records_size(task->records, &task->offsets, task->policy_write,
+											  &attrs, &buffers);
+
+	// Write command
+	uint8_t* cmd = as_command_init(size);
+	size = as_batch_write_records_write(task->records, &task->offsets, policy, task->policy_write,
+										&attrs, &buffers, cmd);
+
+	as_vector_destroy(&attrs);
+	as_vector_destroy(&buffers);
+
+	// Writes are only sent to the master and are never hedged.
+	as_command_node cn;
+	cn.node = task->node;
+	cn.hedge_node = NULL;
+	cn.hedge_delay = 0;
+	cn.latency_type = AS_LATENCY_TYPE_BATCH;
+
+	as_error err;
+	as_error_init(&err);
+
+	as_status status = as_command_execute(task->cluster, &err, &policy->base, &cn, cmd, size, as_batch_parse, task, false);
+
+	as_command_free(cmd, size);
+
+	if (status) {
+		as_batch_write_records_set_error(task->records, &task->offsets, &err);
+
+		// Copy error to main error only once.
+		if (as_fas_uint32(task->error_mutex, 1) == 0) {
+			as_error_copy(task->err, &err);
+		}
+	}
+	return status;
+}
+
+static as_status
+as_batch_index_execute(as_batch_task* task)
+{
+	const as_policy_batch* policy = task->policy;
+
+	// Calculate size of bin names.
+	uint16_t field_count = policy->send_set_name ? 2 : 1;
+	size_t bin_name_size = 0;
+	
+	if (task->n_bins) {
+		for (uint32_t i = 0; i < task->n_bins; i++) {
+			bin_name_size += as_command_string_operation_size(task->bins[i]);
+		}
+	}
+	
+	// Estimate buffer size.
+	size_t size = AS_HEADER_SIZE + AS_FIELD_HEADER_SIZE + 5;
+	as_key* prev = 0;
+	uint32_t n_offsets = task->offsets.size;
+	
+	for (uint32_t i = 0; i < n_offsets; i++) {
+		uint32_t offset = *(uint32_t*)as_vector_get(&task->offsets, i);
+		as_key* key = &task->keys[offset];
+		
+		size += 24;  // digest + int count.
+
+		if (prev && strcmp(prev->ns, key->ns) == 0 && (! policy->send_set_name || strcmp(prev->set, key->set) == 0)) {
+			// Can set repeat previous namespace/bin names to save space.
+			size++;
+		}
+		else {
+			// Estimate full header, namespace and bin names.
+			size += as_command_string_field_size(key->ns) + 6;
+			
+			if (policy->send_set_name) {
+				size += as_command_string_field_size(key->set);
+			}
+			size += bin_name_size;
+			prev = key;
+		}
+	}
+
+	if (policy->consistency_level == AS_POLICY_CONSISTENCY_LEVEL_ALL) {
+		task->read_attr |= AS_MSG_INFO1_CONSISTENCY_ALL;
+	}
+
+	// Write command
+	uint8_t* cmd = as_command_init(size);
+	uint8_t* p = as_command_write_header_read(cmd,
+					task->read_attr | AS_MSG_INFO1_BATCH_INDEX | as_command_compress_attr(&policy->base),
+					policy->consistency_level, policy->linearize_read, policy->base.total_timeout, 1, 0);
+	uint8_t* field_size_ptr = p;
+	p = as_command_write_field_header(p, policy->send_set_name ? AS_FIELD_BATCH_INDEX_WITH_SET : AS_FIELD_BATCH_INDEX, 0);  // Need to update size at end
+	*(uint32_t*)p = cf_swap_to_be32(n_offsets);
+	p += sizeof(uint32_t);
+	*p++ = policy->allow_inline? 1 : 0;
+	
+	prev = 0;
+	
+	for (uint32_t i = 0; i < n_offsets; i++) {
+		uint32_t offset = *(uint32_t*)as_vector_get(&task->offsets, i);
+		*(uint32_t*)p = cf_swap_to_be32(offset);
+		p += sizeof(uint32_t);
+		
+		as_key* key = &task->keys[offset];
+		memcpy(p, key->digest.value, AS_DIGEST_VALUE_SIZE);
 		p += AS_DIGEST_VALUE_SIZE;
 		
 		if (prev && strcmp(prev->ns, key->ns) == 0 && (! policy->send_set_name || strcmp(prev->set, key->set) == 0)) {
@@ -620,6 +1162,9 @@ as_batch_index_execute(as_batch_task* task)
 	
 	as_command_node cn;
 	cn.node = task->node;
+	cn.hedge_node = task->hedge_node;
+	cn.hedge_delay = task->hedge_node ? policy->hedge_delay : 0;
+	cn.latency_type = AS_LATENCY_TYPE_BATCH;
 	
 	as_error err;
 	as_error_init(&err);
@@ -656,7 +1201,8 @@ as_batch_direct_execute(as_batch_task* task)
 	}
 	
 	uint8_t* cmd = as_command_init(size);
-	uint8_t* p = as_command_write_header_read(cmd, task->read_attr, policy->consistency_level,
+	uint8_t* p = as_command_write_header_read(cmd,
+					task->read_attr | as_command_compress_attr(&policy->base), policy->consistency_level,
 					policy->linearize_read, policy->base.total_timeout, 2, task->n_bins);
 	p = as_command_write_field_string(p, AS_FIELD_NAMESPACE, task->ns);
 	p = as_command_write_field_header(p, AS_FIELD_DIGEST_ARRAY, byte_size);
@@ -678,6 +1224,9 @@ as_batch_direct_execute(as_batch_task* task)
 	
 	as_command_node cn;
 	cn.node = task->node;
+	cn.hedge_node = task->hedge_node;
+	cn.hedge_delay = task->hedge_node ? policy->hedge_delay : 0;
+	cn.latency_type = AS_LATENCY_TYPE_BATCH;
 	
 	as_error err;
 	as_error_init(&err);
@@ -702,7 +1251,11 @@ as_batch_command_execute(as_batch_task* task)
 	
 	if (task->use_new_batch) {
 		// New batch protocol
-		if (task->use_batch_records) {
+		if (task->use_write_records) {
+			// Use as_batch_write_records referenced in aerospike_batch_write().
+			status = as_batch_write_records_execute(task);
+		}
+		else if (task->use_batch_records) {
 			// Use as_batch_read_records referenced in aerospike_batch_read().
 			status = as_batch_index_records_execute(task);
 		}
@@ -719,6 +1272,16 @@ as_batch_command_execute(as_batch_task* task)
 	return status;
 }
 
+static inline void
+as_batch_task_arena_init(as_batch_task* task, as_arena* arena)
+{
+	as_arena_init(arena);
+
+	if (task->arena) {
+		task->arena = arena;
+	}
+}
+
 static void
 as_batch_worker(void* data)
 {
@@ -745,6 +1308,43 @@ as_batch_node_find(as_batch_node* batch_nodes, uint32_t n_batch_nodes, as_node*
 	return 0;
 }
 
+static void
+as_batch_set_hedge_node(as_cluster* cluster, as_batch_node* batch_node, const as_key* key, bool new_node)
+{
+	// A batch node request can only be hedged when all keys in that request have the same
+	// prole.  Otherwise, the alternate node would not hold all the requested records.
+	if (! new_node && ! batch_node->hedge_node) {
+		return;
+	}
+
+	as_error err;
+	as_node* prole;
+
+	if (as_cluster_get_node(cluster, &err, key->ns, key->digest.value, AS_POLICY_REPLICA_SEQUENCE,
+							false, &prole) != AEROSPIKE_OK) {
+		prole = NULL;
+	}
+	else if (prole == batch_node->node) {
+		// Partition does not have a prole.
+		as_node_release(prole);
+		prole = NULL;
+	}
+
+	if (new_node) {
+		batch_node->hedge_node = prole;  // Transfer node
+		return;
+	}
+
+	if (prole != batch_node->hedge_node) {
+		as_node_release(batch_node->hedge_node);
+		batch_node->hedge_node = NULL;
+	}
+
+	if (prole) {
+		as_node_release(prole);
+	}
+}
+
 static void
 as_batch_release_nodes(as_batch_node* batch_nodes, uint32_t n_batch_nodes)
 {
@@ -752,11 +1352,251 @@ as_batch_release_nodes(as_batch_node* batch_nodes, uint32_t n_batch_nodes)
 	
 	for (uint32_t i = 0; i < n_batch_nodes; i++) {
 		as_node_release(batch_node->node);
+
+		if (batch_node->hedge_node) {
+			as_node_release(batch_node->hedge_node);
+		}
 		as_vector_destroy(&batch_node->offsets);
 		batch_node++;
 	}
 }
 
+static inline bool
+as_batch_can_regroup(as_batch_task* task, as_status status)
+{
+	if (! task->done) {
+		return false;
+	}
+
+	// Node failures that do not depend on the keys sent.
+	switch (status) {
+		case AEROSPIKE_ERR_TIMEOUT:
+		case AEROSPIKE_ERR_CONNECTION:
+		case AEROSPIKE_ERR_NO_MORE_CONNECTIONS:
+		case AEROSPIKE_ERR_INVALID_NODE:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static inline as_key*
+as_batch_task_key(as_batch_task* task, uint32_t offset)
+{
+	if (task->use_batch_records) {
+		as_batch_read_record* record = as_vector_get(task->records, offset);
+		return &record->key;
+	}
+	return &task->keys[offset];
+}
+
+static as_status
+as_batch_execute_nodes(as_batch_task* task, as_batch_node* batch_nodes, uint32_t n_batch_nodes)
+{
+	const as_policy_batch* policy = task->policy;
+	as_status status = AEROSPIKE_OK;
+
+	if (policy->concurrent && n_batch_nodes > 1) {
+		// Run batch requests in parallel in separate threads.
+		task->complete_q = cf_queue_create(sizeof(as_batch_complete_task), true);
+		
+		uint32_t n_wait_nodes = n_batch_nodes;
+
+		// Arenas are not thread safe, so each node task fills its own arena.
+		as_arena* node_arenas = alloca(sizeof(as_arena) * n_batch_nodes);
+		
+		// Run task for each node.
+		for (uint32_t i = 0; i < n_batch_nodes; i++) {
+			// Stack allocate task for each node.  It should be fine since the task
+			// only needs to be valid within this function.
+			as_batch_task* task_node = alloca(sizeof(as_batch_task));
+			memcpy(task_node, task, sizeof(as_batch_task));
+			as_batch_task_arena_init(task_node, &node_arenas[i]);
+			
+			as_batch_node* batch_node = &batch_nodes[i];
+			task_node->use_new_batch = task->use_batch_records || as_batch_use_new(policy, batch_node->node);
+			task_node->node = batch_node->node;
+			task_node->hedge_node = batch_node->hedge_node;
+			memcpy(&task_node->offsets, &batch_node->offsets, sizeof(as_vector));
+			
+			int rc = as_thread_pool_queue_task(&task->cluster->thread_pool, as_batch_worker, task_node);
+			
+			if (rc) {
+				// Thread could not be added. Abort entire batch.
+				if (as_fas_uint32(task->error_mutex, 1) == 0) {
+					status = as_error_update(task->err, AEROSPIKE_ERR_CLIENT, "Failed to add batch thread: %d", rc);
+				}
+				
+				// Reset node count to threads that were run.
+				n_wait_nodes = i;
+				break;
+			}
+		}
+		
+		// Wait for tasks to complete.
+		for (uint32_t i = 0; i < n_wait_nodes; i++) {
+			as_batch_complete_task complete;
+			cf_queue_pop(task->complete_q, &complete, CF_QUEUE_FOREVER);
+			
+			// Prefer errors that can not be fixed by regrouping keys.
+			if (complete.result != AEROSPIKE_OK &&
+				(status == AEROSPIKE_OK || as_batch_can_regroup(task, status))) {
+				status = complete.result;
+			}
+		}
+		
+		// Release temporary queue.
+		cf_queue_destroy(task->complete_q);
+
+		if (task->arena) {
+			for (uint32_t i = 0; i < n_wait_nodes; i++) {
+				as_arena_move(task->arena, &node_arenas[i]);
+			}
+		}
+	}
+	else {
+		// Run batch requests sequentially in same thread.
+		for (uint32_t i = 0; i < n_batch_nodes; i++) {
+			as_batch_node* batch_node = &batch_nodes[i];
+			
+			task->use_new_batch = task->use_batch_records || as_batch_use_new(policy, batch_node->node);
+			task->node = batch_node->node;
+			task->hedge_node = batch_node->hedge_node;
+			task->index = 0;
+			memcpy(&task->offsets, &batch_node->offsets, sizeof(as_vector));
+
+			as_status s = as_batch_command_execute(task);
+
+			if (s != AEROSPIKE_OK) {
+				status = s;
+
+				// Keys of the remaining nodes are still worth sending when the failed
+				// node's keys can be regrouped later.
+				if (! as_batch_can_regroup(task, s)) {
+					break;
+				}
+			}
+		}
+	}
+	return status;
+}
+
+static inline uint64_t
+as_batch_deadline(const as_policy_batch* policy)
+{
+	return policy->base.total_timeout > 0 ? cf_getms() + policy->base.total_timeout : 0;
+}
+
+static inline void
+as_batch_regroup_init(
+	as_batch_task* task, const as_policy_batch* policy, as_policy_batch* policy_node, uint32_t n_keys
+	)
+{
+	if (policy->base.max_retries == 0) {
+		return;
+	}
+
+	// Node commands are not retried individually.  Instead, keys of failed node commands
+	// are regrouped by their current replica node and retried together.
+	task->done = cf_calloc(n_keys, sizeof(uint8_t));
+	as_policy_batch_copy(policy, policy_node);
+	policy_node->base.max_retries = 0;
+	task->policy = policy_node;
+}
+
+static as_status
+as_batch_regroup(
+	as_batch_task* task, const as_policy_batch* policy, as_policy_batch* policy_node,
+	uint64_t deadline_ms, as_status status
+	)
+{
+	as_cluster* cluster = task->cluster;
+	bool master = true;
+
+	for (uint32_t iteration = 1; as_batch_can_regroup(task, status) && iteration <= policy->base.max_retries;
+		 iteration++) {
+		if (deadline_ms > 0) {
+			// Check for total timeout.
+			int64_t remaining = deadline_ms - cf_getms() - policy->base.sleep_between_retries;
+
+			if (remaining <= 0) {
+				break;
+			}
+			policy_node->base.total_timeout = (uint32_t)remaining;
+		}
+
+		if (policy->base.sleep_between_retries > 0) {
+			as_sleep(policy->base.sleep_between_retries);
+		}
+
+		// Alternate between master and prole.  AS_POLICY_REPLICA_MASTER always uses master.
+		master = !master;
+
+		as_nodes* nodes = as_nodes_reserve(cluster);
+		uint32_t n_nodes = nodes->size;
+
+		if (n_nodes == 0) {
+			as_nodes_release(nodes);
+			break;
+		}
+
+		as_batch_node* batch_nodes = cf_malloc(sizeof(as_batch_node) * n_nodes);
+		uint32_t n_batch_nodes = 0;
+		as_error err;
+
+		// Keys that already received a response are not sent again.
+		for (uint32_t i = 0; i < task->n_keys; i++) {
+			if (task->done[i]) {
+				continue;
+			}
+
+			as_key* key = as_batch_task_key(task, i);
+			as_node* node;
+
+			status = as_cluster_get_node(cluster, &err, key->ns, key->digest.value, policy->replica,
+										 master, &node);
+
+			if (status != AEROSPIKE_OK) {
+				as_error_copy(task->err, &err);
+				break;
+			}
+
+			as_batch_node* batch_node = as_batch_node_find(batch_nodes, n_batch_nodes, node);
+
+			if (batch_node) {
+				// Release duplicate node
+				as_node_release(node);
+			}
+			else if (n_batch_nodes < n_nodes) {
+				// Add batch node.
+				batch_node = &batch_nodes[n_batch_nodes++];
+				batch_node->node = node;  // Transfer node
+				batch_node->hedge_node = NULL;
+				as_vector_init(&batch_node->offsets, sizeof(uint32_t), 10);
+			}
+			else {
+				// Node was added to the cluster after nodes were reserved.
+				as_node_release(node);
+				status = as_error_set_message(task->err, AEROSPIKE_ERR_CLUSTER_CHANGE,
+											  "Cluster changed during batch retry");
+				break;
+			}
+			as_vector_append(&batch_node->offsets, &i);
+		}
+		as_nodes_release(nodes);
+
+		if (status == AEROSPIKE_OK) {
+			// Errors from the previous attempt are replaced by errors from this attempt.
+			as_error_reset(task->err);
+			*task->error_mutex = 0;
+			status = as_batch_execute_nodes(task, batch_nodes, n_batch_nodes);
+		}
+		as_batch_release_nodes(batch_nodes, n_batch_nodes);
+		cf_free(batch_nodes);
+	}
+	return status;
+}
+
 static as_status
 as_batch_execute(
 	aerospike* as, as_error* err, const as_policy_batch* policy, const as_batch* batch,
@@ -776,6 +1616,8 @@ as_batch_execute(
 		callback(0, 0, udata);
 		return AEROSPIKE_OK;
 	}
+
+	uint64_t deadline_ms = as_batch_deadline(policy);
 	
 	as_cluster* cluster = as->cluster;
 	as_nodes* nodes = as_nodes_reserve(cluster);
@@ -792,7 +1634,12 @@ as_batch_execute(
 	as_batch_node* batch_nodes = alloca(sizeof(as_batch_node) * n_nodes);
 	char* ns = batch->keys.entries[0].ns;
 	uint32_t n_batch_nodes = 0;
-	as_status status = AEROSPIKE_OK;
+	as_status status = as_keys_set_digests(err, batch->keys.entries, n_keys);
+	
+	if (status != AEROSPIKE_OK) {
+		as_nodes_release(nodes);
+		return status;
+	}
 	
 	// Create initial key capacity for each node as average + 25%.
 	uint32_t offsets_capacity = n_keys / n_nodes;
@@ -841,6 +1688,7 @@ as_batch_execute(
 		}
 		
 		as_batch_node* batch_node = as_batch_node_find(batch_nodes, n_batch_nodes, node);
+		bool new_node = (batch_node == NULL);
 		
 		if (batch_node) {
 			// Release duplicate node
@@ -850,94 +1698,59 @@ as_batch_execute(
 			// Add batch node.
 			batch_node = &batch_nodes[n_batch_nodes++];
 			batch_node->node = node;  // Transfer node
+			batch_node->hedge_node = NULL;
 			as_vector_inita(&batch_node->offsets, sizeof(uint32_t), offsets_capacity);
 		}
-		as_vector_append(&batch_node->offsets, &i);
-	}
-	as_nodes_release(nodes);
-	
-	uint32_t error_mutex = 0;
-	
-	// Initialize task.
-	as_batch_task task;
-	memset(&task, 0, sizeof(as_batch_task));
-	task.cluster = cluster;
-	task.policy = policy;
-	task.ns = ns;
-	task.err = err;
-	task.results = results;
-	task.error_mutex = &error_mutex;
-	task.n_keys = n_keys;
-	task.bins = bins;
-	task.n_bins = n_bins;
-	task.keys = batch->keys.entries;
-	task.index = 0;
-	task.read_attr = read_attr;
-	task.use_batch_records = false;
-	task.udata = udata;
-	task.callback_xdr = callback_xdr;
-
-	if (policy->concurrent && n_batch_nodes > 1) {
-		// Run batch requests in parallel in separate threads.
-		task.complete_q = cf_queue_create(sizeof(as_batch_complete_task), true);
-		
-		uint32_t n_wait_nodes = n_batch_nodes;
-		
-		// Run task for each node.
-		for (uint32_t i = 0; i < n_batch_nodes; i++) {
-			// Stack allocate task for each node.  It should be fine since the task
-			// only needs to be valid within this function.
-			as_batch_task* task_node = alloca(sizeof(as_batch_task));
-			memcpy(task_node, &task, sizeof(as_batch_task));
-			
-			as_batch_node* batch_node = &batch_nodes[i];
-			task_node->use_new_batch = as_batch_use_new(policy, batch_node->node);
-			task_node->node = batch_node->node;
-			memcpy(&task_node->offsets, &batch_node->offsets, sizeof(as_vector));
-			
-			int rc = as_thread_pool_queue_task(&cluster->thread_pool, as_batch_worker, task_node);
-			
-			if (rc) {
-				// Thread could not be added. Abort entire batch.
-				if (as_fas_uint32(task.error_mutex, 1) == 0) {
-					status = as_error_update(task.err, AEROSPIKE_ERR_CLIENT, "Failed to add batch thread: %d", rc);
-				}
-				
-				// Reset node count to threads that were run.
-				n_wait_nodes = i;
-				break;
-			}
-		}
-		
-		// Wait for tasks to complete.
-		for (uint32_t i = 0; i < n_wait_nodes; i++) {
-			as_batch_complete_task complete;
-			cf_queue_pop(task.complete_q, &complete, CF_QUEUE_FOREVER);
-			
-			if (complete.result != AEROSPIKE_OK && status == AEROSPIKE_OK) {
-				status = complete.result;
-			}
-		}
-		
-		// Release temporary queue.
-		cf_queue_destroy(task.complete_q);
-	}
-	else {
-		// Run batch requests sequentially in same thread.
-		for (uint32_t i = 0; status == AEROSPIKE_OK && i < n_batch_nodes; i++) {
-			as_batch_node* batch_node = &batch_nodes[i];
-			
-			task.use_new_batch = as_batch_use_new(policy, batch_node->node);
-			task.node = batch_node->node;
-			task.index = 0;
-			memcpy(&task.offsets, &batch_node->offsets, sizeof(as_vector));
-			status = as_batch_command_execute(&task);
-		}
+		as_vector_append(&batch_node->offsets, &i);
+
+		if (policy->hedge_delay > 0 && as_batch_use_new(policy, node)) {
+			as_batch_set_hedge_node(cluster, batch_node, key, new_node);
+		}
+	}
+	as_nodes_release(nodes);
+	
+	uint32_t error_mutex = 0;
+	
+	// Initialize task.
+	as_batch_task task;
+	memset(&task, 0, sizeof(as_batch_task));
+	task.cluster = cluster;
+	task.policy = policy;
+	task.ns = ns;
+	task.err = err;
+	task.results = results;
+	task.error_mutex = &error_mutex;
+	task.n_keys = n_keys;
+	task.bins = bins;
+	task.n_bins = n_bins;
+	task.keys = batch->keys.entries;
+	task.index = 0;
+	task.read_attr = read_attr;
+	task.use_batch_records = false;
+	task.udata = udata;
+	task.callback_xdr = callback_xdr;
+
+	// Bin values only need to live until the callback returns.
+	as_arena arena;
+	as_arena_init(&arena);
+
+	if (callback && policy->arena_bins) {
+		task.arena = &arena;
 	}
+
+	as_policy_batch policy_node;
+	as_batch_regroup_init(&task, policy, &policy_node, n_keys);
+
+	status = as_batch_execute_nodes(&task, batch_nodes, n_batch_nodes);
 			
 	// Release each node.
 	as_batch_release_nodes(batch_nodes, n_batch_nodes);
 
+	if (task.done) {
+		status = as_batch_regroup(&task, policy, &policy_node, deadline_ms, status);
+		cf_free(task.done);
+	}
+
 	// Call user defined function with results.
 	if (callback) {
 		callback(task.results, n_keys, udata);
@@ -949,133 +1762,132 @@ as_batch_execute(
 			}
 		}
 	}
+	as_arena_destroy(&arena);
 	return status;
 }
 
 static as_status
-as_batch_read_execute_sync(
-	as_cluster* cluster, as_error* err, const as_policy_batch* policy, as_vector* records,
+as_batch_records_execute_sync(
+	as_cluster* cluster, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_vector* records, as_arena* arena,
 	uint32_t n_keys, uint32_t n_batch_nodes, as_batch_node* batch_nodes
 	)
 {
 	as_status status = AEROSPIKE_OK;
 	uint32_t error_mutex = 0;
+	uint64_t deadline_ms = as_batch_deadline(policy);
 
 	// Initialize task.
 	as_batch_task task;
 	memset(&task, 0, sizeof(as_batch_task));
 	task.cluster = cluster;
 	task.policy = policy;
+	task.policy_write = policy_write;
 	task.err = err;
 	task.records = records;
 	task.error_mutex = &error_mutex;
 	task.n_keys = n_keys;
-	task.use_batch_records = true;
+	task.use_write_records = policy_write != NULL;
+	task.use_batch_records = ! task.use_write_records;
 
-	if (policy->concurrent && n_batch_nodes > 1) {
-		// Run batch requests in parallel in separate threads.
-		task.complete_q = cf_queue_create(sizeof(as_batch_complete_task), true);
-		
-		uint32_t n_wait_nodes = n_batch_nodes;
-		
-		// Run task for each node.
-		for (uint32_t i = 0; i < n_batch_nodes; i++) {
-			// Stack allocate task for each node.  It should be fine since the task
-			// only needs to be valid within this function.
-			as_batch_task* task_node = alloca(sizeof(as_batch_task));
-			memcpy(task_node, &task, sizeof(as_batch_task));
-			
-			as_batch_node* batch_node = &batch_nodes[i];
-			task_node->use_new_batch = true;
-			task_node->node = batch_node->node;
-			memcpy(&task_node->offsets, &batch_node->offsets, sizeof(as_vector));
-			
-			int rc = as_thread_pool_queue_task(&cluster->thread_pool, as_batch_worker, task_node);
-			
-			if (rc) {
-				// Thread could not be added. Abort entire batch.
-				if (as_fas_uint32(task.error_mutex, 1) == 0) {
-					status = as_error_update(task.err, AEROSPIKE_ERR_CLIENT, "Failed to add batch thread: %d", rc);
-				}
-				
-				// Reset node count to threads that were run.
-				n_wait_nodes = i;
-				break;
-			}
-		}
-		
-		// Wait for tasks to complete.
-		for (uint32_t i = 0; i < n_wait_nodes; i++) {
-			as_batch_complete_task complete;
-			cf_queue_pop(task.complete_q, &complete, CF_QUEUE_FOREVER);
-			
-			if (complete.result != AEROSPIKE_OK && status == AEROSPIKE_OK) {
-				status = complete.result;
-			}
-		}
-		
-		// Release temporary queue.
-		cf_queue_destroy(task.complete_q);
+	if (task.use_batch_records && policy->arena_bins) {
+		task.arena = arena;
 	}
-	else {
-		// Run batch requests sequentially in same thread.
-		for (uint32_t i = 0; status == AEROSPIKE_OK && i < n_batch_nodes; i++) {
-			as_batch_node* batch_node = &batch_nodes[i];
-			
-			task.use_new_batch = true;
-			task.node = batch_node->node;
-			memcpy(&task.offsets, &batch_node->offsets, sizeof(as_vector));
-			status = as_batch_command_execute(&task);
-		}
+
+	// Batch writes are not regrouped because a timed out write may have been applied.
+	as_policy_batch policy_node;
+
+	if (task.use_batch_records) {
+		as_batch_regroup_init(&task, policy, &policy_node, n_keys);
 	}
+
+	status = as_batch_execute_nodes(&task, batch_nodes, n_batch_nodes);
 	
 	// Release each node.
 	as_batch_release_nodes(batch_nodes, n_batch_nodes);
+
+	if (task.done) {
+		status = as_batch_regroup(&task, policy, &policy_node, deadline_ms, status);
+		cf_free(task.done);
+	}
 	return status;
 }
 
+static as_event_command*
+as_batch_async_command_create(
+	as_cluster* cluster, const as_policy_batch* policy, as_node* node, as_event_executor* executor,
+	as_event_parse_results_fn parse_results, size_t size
+	)
+{
+	// Allocate enough memory to cover, then, round up memory size in 8KB increments to reduce
+	// fragmentation and to allow socket read to reuse buffer.
+	size_t s = (sizeof(as_async_batch_command) + size + AS_AUTHENTICATION_MAX_SIZE + 8191) & ~8191;
+	as_event_command* cmd = cf_malloc(s);
+	cmd->total_deadline = policy->base.total_timeout;
+	cmd->socket_timeout = policy->base.socket_timeout;
+	cmd->max_retries = policy->base.max_retries;
+	cmd->iteration = 0;
+	cmd->replica = AS_POLICY_REPLICA_MASTER;
+	cmd->event_loop = executor->event_loop;
+	cmd->cluster = cluster;
+	cmd->node = node;
+	cmd->partition = NULL;
+	cmd->udata = executor;  // Overload udata to be the executor.
+	cmd->parse_results = parse_results;
+	cmd->pipe_listener = NULL;
+	cmd->buf = ((as_async_batch_command*)cmd)->space;
+	cmd->iov = NULL;
+	cmd->write_len = (uint32_t)size;
+	cmd->read_capacity = (uint32_t)(s - size - sizeof(as_async_batch_command));
+	cmd->type = AS_ASYNC_TYPE_BATCH;
+	cmd->state = AS_ASYNC_STATE_UNREGISTERED;
+	cmd->flags = AS_ASYNC_FLAGS_MASTER;
+	cmd->deserialize = policy->deserialize;
+	cmd->borrow = false;
+	return cmd;
+}
+
 static as_status
-as_batch_read_execute_async(
-	as_cluster* cluster, as_error* err, const as_policy_batch* policy, as_vector* records, uint32_t n_batch_nodes,
-	as_batch_node* batch_nodes, as_async_batch_executor* executor
+as_batch_records_execute_async(
+	as_cluster* cluster, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_vector* records, uint32_t n_batch_nodes,
+	as_batch_node* batch_nodes, as_event_executor* exec
 	)
 {
-	as_event_executor* exec = &executor->executor;
 	exec->max_concurrent = exec->max = exec->queued = n_batch_nodes;
 	
 	as_status status = AEROSPIKE_OK;
 	
 	for (uint32_t i = 0; i < n_batch_nodes; i++) {
 		as_batch_node* batch_node = &batch_nodes[i];
-		
-		// Estimate buffer size.
-		size_t size = as_batch_index_records_size(records, &batch_node->offsets, policy->send_set_name);
-		
-		// Allocate enough memory to cover, then, round up memory size in 8KB increments to reduce
-		// fragmentation and to allow socket read to reuse buffer.
-		size_t s = (sizeof(as_async_batch_command) + size + AS_AUTHENTICATION_MAX_SIZE + 8191) & ~8191;
-		as_event_command* cmd = cf_malloc(s);
-		cmd->total_deadline = policy->base.total_timeout;
-		cmd->socket_timeout = policy->base.socket_timeout;
-		cmd->max_retries = policy->base.max_retries;
-		cmd->iteration = 0;
-		cmd->replica = AS_POLICY_REPLICA_MASTER;
-		cmd->event_loop = exec->event_loop;
-		cmd->cluster = cluster;
-		cmd->node = batch_node->node;
-		cmd->partition = NULL;
-		cmd->udata = executor;  // Overload udata to be the executor.
-		cmd->parse_results = as_batch_async_parse_records;
-		cmd->pipe_listener = NULL;
-		cmd->buf = ((as_async_batch_command*)cmd)->space;
-		cmd->write_len = (uint32_t)size;
-		cmd->read_capacity = (uint32_t)(s - size - sizeof(as_async_batch_command));
-		cmd->type = AS_ASYNC_TYPE_BATCH;
-		cmd->state = AS_ASYNC_STATE_UNREGISTERED;
-		cmd->flags = AS_ASYNC_FLAGS_MASTER;
-		cmd->deserialize = policy->deserialize;
-		cmd->len = (uint32_t)as_batch_index_records_write(records, &batch_node->offsets, policy, cmd->buf);
-		
+		as_event_command* cmd;
+
+		if (policy_write) {
+			as_vector attrs;
+			as_vector buffers;
+			as_vector_init(&attrs, sizeof(as_batch_write_attr), batch_node->offsets.size);
+			as_vector_init(&buffers, sizeof(as_buffer), 16);
+
+			// Estimate buffer size.
+			size_t size = as_batch_write_records_size(records, &batch_node->offsets, policy_write,
+													  &attrs, &buffers);
+
+			cmd = as_batch_async_command_create(cluster, policy, batch_node->node, exec,
+												as_batch_async_parse_write_records, size);
+			cmd->len = (uint32_t)as_batch_write_records_write(records, &batch_node->offsets, policy,
+															  policy_write, &attrs, &buffers, cmd->buf);
+			as_vector_destroy(&attrs);
+			as_vector_destroy(&buffers);
+		}
+		else {
+			// Estimate buffer size.
+			size_t size = as_batch_index_records_size(records, &batch_node->offsets, policy->send_set_name);
+
+			cmd = as_batch_async_command_create(cluster, policy, batch_node->node, exec,
+												as_batch_async_parse_records, size);
+			cmd->len = (uint32_t)as_batch_index_records_write(records, &batch_node->offsets, policy, cmd->buf);
+		}
+
 		status = as_event_command_execute(cmd, err);
 		
 		if (status != AEROSPIKE_OK) {
@@ -1095,8 +1907,8 @@ as_batch_read_execute_async(
 }
 
 static void
-as_batch_read_cleanup(
-	as_async_batch_executor* async_executor, as_nodes* nodes, as_batch_node* batch_nodes,
+as_batch_records_cleanup(
+	as_event_executor* async_executor, as_nodes* nodes, as_batch_node* batch_nodes,
 	uint32_t n_batch_nodes
 	)
 {
@@ -1111,17 +1923,27 @@ as_batch_read_cleanup(
 }
 
 static as_status
-as_batch_read_execute(
-	aerospike* as, as_error* err, const as_policy_batch* policy, as_batch_read_records* records,
-	as_async_batch_executor* async_executor
+as_batch_records_execute(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_vector* list, as_arena* arena,
+	as_event_executor* async_executor
 	)
 {
+	as_policy_batch policy_local;
+
 	if (! policy) {
-		policy = &as->config.policies.batch;
+		if (policy_write) {
+			// Write commands should not retry by default.
+			as_policy_batch_copy(&as->config.policies.batch, &policy_local);
+			policy_local.base.max_retries = 0;
+			policy = &policy_local;
+		}
+		else {
+			policy = &as->config.policies.batch;
+		}
 	}
 	
-	as_vector* list = &records->list;
-	uint32_t n_keys = records->list.size;
+	uint32_t n_keys = list->size;
 	
 	if (n_keys == 0) {
 		return AEROSPIKE_OK;
@@ -1132,13 +1954,23 @@ as_batch_read_execute(
 	uint32_t n_nodes = nodes->size;
 	
 	if (n_nodes == 0) {
-		as_batch_read_cleanup(async_executor, nodes, NULL, 0);
+		as_batch_records_cleanup(async_executor, nodes, NULL, 0);
 		return as_error_set_message(err, AEROSPIKE_ERR_SERVER, "Batch command failed because cluster is empty.");
 	}
 	
 	as_batch_node* batch_nodes = alloca(sizeof(as_batch_node) * n_nodes);
 	uint32_t n_batch_nodes = 0;
-	as_status status = AEROSPIKE_OK;
+	
+	// Compute digests up front so short keys are digested several at a time.
+	as_key* first = policy_write ?
+		&((as_batch_write_record*)as_vector_get(list, 0))->key :
+		&((as_batch_read_record*)as_vector_get(list, 0))->key;
+	as_status status = as_keys_set_digests_stride(err, first, n_keys, list->item_size);
+	
+	if (status != AEROSPIKE_OK) {
+		as_batch_records_cleanup(async_executor, nodes, NULL, 0);
+		return status;
+	}
 	
 	// Create initial key capacity for each node as average + 25%.
 	uint32_t offsets_capacity = n_keys / n_nodes;
@@ -1151,16 +1983,35 @@ as_batch_read_execute(
 	
 	// Map keys to server nodes.
 	for (uint32_t i = 0; i < n_keys; i++) {
-		as_batch_read_record* record = as_vector_get(list, i);
-		as_key* key = &record->key;
-		
-		record->result = AEROSPIKE_ERR_RECORD_NOT_FOUND;
-		as_record_init(&record->record, 0);
+		as_key* key;
+
+		if (policy_write) {
+			as_batch_write_record* record = as_vector_get(list, i);
+			key = &record->key;
+
+			record->result = AEROSPIKE_NO_RESPONSE;
+			record->in_doubt = false;
+			as_record_init(&record->record, 0);
+
+			if ((record->type == AS_BATCH_WRITE_OPERATE &&
+				 (! record->ops || record->ops->binops.size == 0)) ||
+				(record->type == AS_BATCH_WRITE_APPLY && (! record->module || ! record->function))) {
+				as_batch_records_cleanup(async_executor, nodes, batch_nodes, n_batch_nodes);
+				return as_error_update(err, AEROSPIKE_ERR_PARAM, "Batch write record %u is missing operations or UDF", i);
+			}
+		}
+		else {
+			as_batch_read_record* record = as_vector_get(list, i);
+			key = &record->key;
+
+			record->result = AEROSPIKE_ERR_RECORD_NOT_FOUND;
+			as_record_init(&record->record, 0);
+		}
 		
 		status = as_key_set_digest(err, key);
 		
 		if (status != AEROSPIKE_OK) {
-			as_batch_read_cleanup(async_executor, nodes, batch_nodes, n_batch_nodes);
+			as_batch_records_cleanup(async_executor, nodes, batch_nodes, n_batch_nodes);
 			return status;
 		}
 		
@@ -1168,16 +2019,24 @@ as_batch_read_execute(
 		status = as_cluster_get_node(cluster, err, key->ns, key->digest.value, AS_POLICY_REPLICA_MASTER, false, &node);
 
 		if (status != AEROSPIKE_OK) {
-			as_batch_read_cleanup(async_executor, nodes, batch_nodes, n_batch_nodes);
+			as_batch_records_cleanup(async_executor, nodes, batch_nodes, n_batch_nodes);
 			return status;
 		}
 
-		if (! as_batch_use_new(policy, node)) {
-			as_batch_read_cleanup(async_executor, nodes, batch_nodes, n_batch_nodes);
+		if (policy_write) {
+			if (! (node->features & AS_FEATURES_BATCH_ANY)) {
+				as_node_release(node);
+				as_batch_records_cleanup(async_executor, nodes, batch_nodes, n_batch_nodes);
+				return as_error_set_message(err, AEROSPIKE_ERR_UNSUPPORTED_FEATURE, "aerospike_batch_write() requires a server that supports batch writes.");
+			}
+		}
+		else if (! as_batch_use_new(policy, node)) {
+			as_batch_records_cleanup(async_executor, nodes, batch_nodes, n_batch_nodes);
 			return as_error_set_message(err, AEROSPIKE_ERR_UNSUPPORTED_FEATURE, "aerospike_batch_read() requires a server that supports new batch index protocol.");
 		}
 		
 		as_batch_node* batch_node = as_batch_node_find(batch_nodes, n_batch_nodes, node);
+		bool new_node = (batch_node == NULL);
 		
 		if (batch_node) {
 			// Release duplicate node
@@ -1187,6 +2046,7 @@ as_batch_read_execute(
 			// Add batch node.
 			batch_node = &batch_nodes[n_batch_nodes++];
 			batch_node->node = node;  // Transfer node
+			batch_node->hedge_node = NULL;
 			
 			if (n_keys <= 5000) {
 				// All keys and offsets should fit on stack.
@@ -1198,14 +2058,74 @@ as_batch_read_execute(
 			}
 		}
 		as_vector_append(&batch_node->offsets, &i);
+
+		// Async batch commands are bound to a single node, so only sync batches are hedged.
+		// Writes are never hedged.
+		if (policy->hedge_delay > 0 && ! async_executor && ! policy_write) {
+			as_batch_set_hedge_node(cluster, batch_node, key, new_node);
+		}
 	}
 	as_nodes_release(nodes);
 	
 	if (async_executor) {
-		return as_batch_read_execute_async(cluster, err, policy, list, n_batch_nodes, batch_nodes, async_executor);
+		return as_batch_records_execute_async(cluster, err, policy, policy_write, list, n_batch_nodes,
+											  batch_nodes, async_executor);
 	}
 	
-	return as_batch_read_execute_sync(cluster, err, policy, list, n_keys, n_batch_nodes, batch_nodes);
+	return as_batch_records_execute_sync(cluster, err, policy, policy_write, list, arena, n_keys,
+										 n_batch_nodes, batch_nodes);
+}
+
+static void
+as_batch_executor_init(
+	as_event_executor* exec, as_event_executor_complete_fn complete_fn, void* udata,
+	as_event_loop* event_loop
+	)
+{
+	pthread_mutex_init(&exec->lock, NULL);
+	exec->commands = 0;
+	exec->event_loop = as_event_assign(event_loop);
+	exec->complete_fn = complete_fn;
+	exec->udata = udata;
+	exec->err = NULL;
+	exec->ns = NULL;
+	exec->cluster_key = 0;
+	exec->max_concurrent = 0;
+	exec->max = 0;
+	exec->count = 0;
+	exec->queued = 0;
+	exec->notify = true;
+	exec->valid = true;
+}
+
+static as_status
+as_batch_write_execute_async(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_batch_write_records* records,
+	as_async_batch_write_listener listener, void* udata, as_event_loop* event_loop
+	)
+{
+	as_error_reset(err);
+
+	// Check for empty batch.
+	if (records->list.size == 0) {
+		listener(0, records, udata, event_loop);
+		return AEROSPIKE_OK;
+	}
+
+	if (! policy_write) {
+		policy_write = &as->config.policies.batch_write;
+	}
+
+	// Batch will be split up into a command for each node.
+	// Allocate batch data shared by each command.
+	as_async_batch_write_executor* executor = cf_malloc(sizeof(as_async_batch_write_executor));
+	as_event_executor* exec = &executor->executor;
+	as_batch_executor_init(exec, as_batch_complete_write_async, udata, event_loop);
+	executor->records = records;
+	executor->listener = listener;
+
+	return as_batch_records_execute(as, err, policy, policy_write, &records->list, NULL, exec);
 }
 
 /******************************************************************************
@@ -1238,7 +2158,7 @@ aerospike_batch_read(
 	)
 {
 	as_error_reset(err);
-	return as_batch_read_execute(as, err, policy, records, 0);
+	return as_batch_records_execute(as, err, policy, NULL, &records->list, &records->arena, NULL);
 }
 
 as_status
@@ -1259,24 +2179,11 @@ aerospike_batch_read_async(
 	// Allocate batch data shared by each command.
 	as_async_batch_executor* executor = cf_malloc(sizeof(as_async_batch_executor));
 	as_event_executor* exec = &executor->executor;
-	pthread_mutex_init(&exec->lock, NULL);
-	exec->commands = 0;
-	exec->event_loop = as_event_assign(event_loop);
-	exec->complete_fn = as_batch_complete_async;
-	exec->udata = udata;
-	exec->err = NULL;
-	exec->ns = NULL;
-	exec->cluster_key = 0;
-	exec->max_concurrent = 0;
-	exec->max = 0;
-	exec->count = 0;
-	exec->queued = 0;
-	exec->notify = true;
-	exec->valid = true;
+	as_batch_executor_init(exec, as_batch_complete_async, udata, event_loop);
 	executor->records = records;
 	executor->listener = listener;
 	
-	return as_batch_read_execute(as, err, policy, records, executor);
+	return as_batch_records_execute(as, err, policy, NULL, &records->list, NULL, exec);
 }
 
 /**
@@ -1299,7 +2206,12 @@ as_batch_read_destroy(as_batch_read_records* records)
 			as_record_destroy(&record->record);
 		}
 	}
+	as_arena_destroy(&records->arena);
 	as_vector_destroy(list);
+
+	if (records->_free) {
+		cf_free(records);
+	}
 }
 
 /**
@@ -1351,3 +2263,159 @@ aerospike_batch_exists(
 {
 	return as_batch_execute(as, err, policy, batch, AS_MSG_INFO1_READ | AS_MSG_INFO1_GET_NOBINDATA, 0, 0, callback, 0, udata);
 }
+
+/**
+ * Destroy keys and records in record list.  It's the responsility of the caller to
+ * destroy `as_batch_write_record.ops` and `as_batch_write_record.arglist` when necessary.
+ */
+void
+as_batch_write_destroy(as_batch_write_records* records)
+{
+	as_vector* list = &records->list;
+
+	for (uint32_t i = 0; i < list->size; i++) {
+		as_batch_write_record* record = as_vector_get(list, i);
+
+		// Destroy key.
+		as_key_destroy(&record->key);
+
+		// Destroy record if a response was received.  Bins can be returned on error.
+		if (record->result != AEROSPIKE_NO_RESPONSE) {
+			as_record_destroy(&record->record);
+		}
+	}
+	as_vector_destroy(list);
+}
+
+/**
+ * Write multiple records with a different write command for each record.
+ */
+as_status
+aerospike_batch_write(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_batch_write_records* records
+	)
+{
+	as_error_reset(err);
+
+	if (! policy_write) {
+		policy_write = &as->config.policies.batch_write;
+	}
+	return as_batch_records_execute(as, err, policy, policy_write, &records->list, NULL, NULL);
+}
+
+/**
+ * Asynchronously write multiple records with a different write command for each record.
+ */
+as_status
+aerospike_batch_write_async(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_batch_write_records* records,
+	as_async_batch_write_listener listener, void* udata, as_event_loop* event_loop
+	)
+{
+	return as_batch_write_execute_async(as, err, policy, policy_write, records, listener, udata, event_loop);
+}
+
+static void
+as_batch_write_set_type(
+	as_batch_write_records* records, as_batch_write_type type, const as_operations* ops,
+	const char* module, const char* function, as_list* arglist
+	)
+{
+	as_vector* list = &records->list;
+
+	for (uint32_t i = 0; i < list->size; i++) {
+		as_batch_write_record* record = as_vector_get(list, i);
+		record->type = type;
+		record->ops = (as_operations*)ops;
+		record->module = module;
+		record->function = function;
+		record->arglist = arglist;
+	}
+}
+
+/**
+ * Apply the same operations to multiple records.
+ */
+as_status
+aerospike_batch_operate(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_batch_write_records* records,
+	const as_operations* ops
+	)
+{
+	as_batch_write_set_type(records, AS_BATCH_WRITE_OPERATE, ops, NULL, NULL, NULL);
+	return aerospike_batch_write(as, err, policy, policy_write, records);
+}
+
+/**
+ * Asynchronously apply the same operations to multiple records.
+ */
+as_status
+aerospike_batch_operate_async(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_batch_write_records* records,
+	const as_operations* ops, as_async_batch_write_listener listener, void* udata,
+	as_event_loop* event_loop
+	)
+{
+	as_batch_write_set_type(records, AS_BATCH_WRITE_OPERATE, ops, NULL, NULL, NULL);
+	return as_batch_write_execute_async(as, err, policy, policy_write, records, listener, udata, event_loop);
+}
+
+/**
+ * Delete multiple records.
+ */
+as_status
+aerospike_batch_remove(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_batch_write_records* records
+	)
+{
+	as_batch_write_set_type(records, AS_BATCH_WRITE_REMOVE, NULL, NULL, NULL, NULL);
+	return aerospike_batch_write(as, err, policy, policy_write, records);
+}
+
+/**
+ * Asynchronously delete multiple records.
+ */
+as_status
+aerospike_batch_remove_async(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_batch_write_records* records,
+	as_async_batch_write_listener listener, void* udata, as_event_loop* event_loop
+	)
+{
+	as_batch_write_set_type(records, AS_BATCH_WRITE_REMOVE, NULL, NULL, NULL, NULL);
+	return as_batch_write_execute_async(as, err, policy, policy_write, records, listener, udata, event_loop);
+}
+
+/**
+ * Apply the same user defined function to multiple records.
+ */
+as_status
+aerospike_batch_apply(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_batch_write_records* records,
+	const char* module, const char* function, as_list* arglist
+	)
+{
+	as_batch_write_set_type(records, AS_BATCH_WRITE_APPLY, NULL, module, function, arglist);
+	return aerospike_batch_write(as, err, policy, policy_write, records);
+}
+
+/**
+ * Asynchronously apply the same user defined function to multiple records.
+ */
+as_status
+aerospike_batch_apply_async(
+	aerospike* as, as_error* err, const as_policy_batch* policy,
+	const as_policy_batch_write* policy_write, as_batch_write_records* records,
+	const char* module, const char* function, as_list* arglist,
+	as_async_batch_write_listener listener, void* udata, as_event_loop* event_loop
+	)
+{
+	as_batch_write_set_type(records, AS_BATCH_WRITE_APPLY, NULL, module, function, arglist);
+	return as_batch_write_execute_async(as, err, policy, policy_write, records, listener, udata, event_loop);
+}
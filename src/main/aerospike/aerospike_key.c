@@ -27,6 +27,7 @@
 #include <aerospike/as_log.h>
 #include <aerospike/as_msgpack.h>
 #include <aerospike/as_operations.h>
+#include <aerospike/as_operations_template.h>
 #include <aerospike/as_partition.h>
 #include <aerospike/as_policy.h>
 #include <aerospike/as_random.h>
@@ -44,13 +45,24 @@
 
 static inline void
 as_command_node_init(
-	as_command_node* cn, const char* ns, const uint8_t* digest, as_policy_replica replica
+	as_command_node* cn, const char* ns, const uint8_t* digest, as_policy_replica replica,
+	as_latency_type latency_type
 	)
 {
 	cn->node = 0;
 	cn->ns = ns;
 	cn->digest = digest;
 	cn->replica = replica;
+	cn->hedge_node = NULL;
+	cn->hedge_delay = 0;
+	cn->latency_type = latency_type;
+}
+
+static inline uint32_t
+as_read_hedge_delay(const as_policy_read* policy)
+{
+	// Hedged reads require a node sequence to choose the alternate node.
+	return (policy->replica == AS_POLICY_REPLICA_SEQUENCE)? policy->hedge_delay : 0;
 }
 
 static as_status
@@ -120,14 +132,16 @@ aerospike_key_get(
 	size_t size = as_command_key_size(policy->key, key, &n_fields);
 		
 	uint8_t* cmd = as_command_init(size);
-	uint8_t* p = as_command_write_header_read(cmd, AS_MSG_INFO1_READ | AS_MSG_INFO1_GET_ALL,
+	uint8_t* p = as_command_write_header_read(cmd,
+		AS_MSG_INFO1_READ | AS_MSG_INFO1_GET_ALL | as_command_compress_attr(&policy->base),
 		policy->consistency_level, policy->linearize_read, policy->base.total_timeout, n_fields, 0);
 
 	p = as_command_write_key(p, policy->key, key);
 	size = as_command_write_end(cmd, p);
 	
 	as_command_node cn;
-	as_command_node_init(&cn, key->ns, key->digest.value, policy->replica);
+	as_command_node_init(&cn, key->ns, key->digest.value, policy->replica, AS_LATENCY_TYPE_READ);
+	cn.hedge_delay = as_read_hedge_delay(policy);
 
 	as_command_parse_result_data data;
 	data.record = rec;
@@ -165,7 +179,10 @@ aerospike_key_get_async(
 		as->cluster, &policy->base, policy->replica, partition, policy->deserialize, flags,
 		listener, udata, event_loop, pipe_listener, size, as_event_command_parse_result);
 
-	uint8_t* p = as_command_write_header_read(cmd->buf, AS_MSG_INFO1_READ | AS_MSG_INFO1_GET_ALL,
+	cmd->borrow = policy->borrow_bins;
+
+	uint8_t* p = as_command_write_header_read(cmd->buf,
+		AS_MSG_INFO1_READ | AS_MSG_INFO1_GET_ALL | as_command_compress_attr(&policy->base),
 		policy->consistency_level, policy->linearize_read, policy->base.total_timeout, n_fields, 0);
 
 	p = as_command_write_key(p, policy->key, key);
@@ -204,7 +221,8 @@ aerospike_key_select(
 	}
 	
 	uint8_t* cmd = as_command_init(size);
-	uint8_t* p = as_command_write_header_read(cmd, AS_MSG_INFO1_READ, policy->consistency_level,
+	uint8_t* p = as_command_write_header_read(cmd,
+		AS_MSG_INFO1_READ | as_command_compress_attr(&policy->base), policy->consistency_level,
 		policy->linearize_read, policy->base.total_timeout, n_fields, nvalues);
 
 	p = as_command_write_key(p, policy->key, key);
@@ -215,7 +233,8 @@ aerospike_key_select(
 	size = as_command_write_end(cmd, p);
 
 	as_command_node cn;
-	as_command_node_init(&cn, key->ns, key->digest.value, policy->replica);
+	as_command_node_init(&cn, key->ns, key->digest.value, policy->replica, AS_LATENCY_TYPE_READ);
+	cn.hedge_delay = as_read_hedge_delay(policy);
 	
 	as_command_parse_result_data data;
 	data.record = rec;
@@ -261,7 +280,10 @@ aerospike_key_select_async(
 		as->cluster, &policy->base, policy->replica, partition, policy->deserialize, flags,
 		listener, udata, event_loop, pipe_listener, size, as_event_command_parse_result);
 
-	uint8_t* p = as_command_write_header_read(cmd->buf, AS_MSG_INFO1_READ, policy->consistency_level,
+	cmd->borrow = policy->borrow_bins;
+
+	uint8_t* p = as_command_write_header_read(cmd->buf,
+		AS_MSG_INFO1_READ | as_command_compress_attr(&policy->base), policy->consistency_level,
 		policy->linearize_read, policy->base.total_timeout, n_fields, nvalues);
 
 	p = as_command_write_key(p, policy->key, key);
@@ -301,7 +323,8 @@ aerospike_key_exists(
 	size = as_command_write_end(cmd, p);
 
 	as_command_node cn;
-	as_command_node_init(&cn, key->ns, key->digest.value, policy->replica);
+	as_command_node_init(&cn, key->ns, key->digest.value, policy->replica, AS_LATENCY_TYPE_READ);
+	cn.hedge_delay = as_read_hedge_delay(policy);
 	
 	as_proto_msg msg;
 	status = as_command_execute(as->cluster, err, &policy->base, &cn, cmd, size, as_command_parse_header, &msg, true);
@@ -360,6 +383,51 @@ aerospike_key_exists_async(
 	return as_event_command_execute(cmd, err);
 }
 
+static as_status
+as_put_iov(
+	aerospike* as, as_error* err, const as_policy_write* policy, const as_key* key, as_record* rec,
+	as_buffer* buffers, size_t scratch_size, uint32_t n_zero_copy, uint16_t n_fields
+	)
+{
+	// Header, key and small bins are written to scratch buffer.  Large values are sent in place.
+	as_bin* bins = rec->bins.entries;
+	uint32_t n_bins = rec->bins.size;
+	uint32_t n_iov = n_zero_copy * 2 + 1;
+	as_iovec* iov = (as_iovec*)alloca(sizeof(as_iovec) * n_iov);
+	uint8_t* cmd = as_command_init(scratch_size);
+
+	as_command_iov ci;
+	as_command_iov_init(&ci, iov, NULL, cmd);
+
+	uint8_t* p = as_command_write_header(cmd, 0, AS_MSG_INFO2_WRITE, policy->commit_level, 0, false,
+					policy->exists, policy->gen, rec->gen, rec->ttl, policy->base.total_timeout, n_fields,
+					n_bins, policy->durable_delete);
+
+	p = as_command_write_key(p, policy->key, key);
+
+#if defined(USE_SYSTEMTAP)
+	uint64_t task_id = as_random_get_uint64();
+	p = as_command_write_field_uint64(p, AS_FIELD_TASK_ID, task_id);
+#endif
+
+	for (uint32_t i = 0; i < n_bins; i++) {
+		p = as_command_write_bin_iov(&ci, p, AS_OPERATOR_WRITE, &bins[i], &buffers[i]);
+	}
+	as_command_iov_end(&ci, p);
+
+	as_command_node cn;
+	as_command_node_init(&cn, key->ns, key->digest.value, AS_POLICY_REPLICA_MASTER, AS_LATENCY_TYPE_WRITE);
+	as_proto_msg msg;
+
+	AEROSPIKE_PUT_EXECUTE_STARTING(task_id);
+	as_status status = as_command_execute_iov(as->cluster, err, &policy->base, &cn, ci.iov, ci.n_iov,
+											  as_command_parse_header, &msg, false);
+	AEROSPIKE_PUT_EXECUTE_FINISHED(task_id);
+
+	as_command_free(cmd, scratch_size);
+	return status;
+}
+
 as_status
 aerospike_key_put(
 	aerospike* as, as_error* err, const as_policy_write* policy, const as_key* key, as_record* rec
@@ -395,6 +463,26 @@ aerospike_key_put(
 		size += as_command_bin_size(&bins[i], &buffers[i]);
 	}
 
+	if (policy->compression_threshold == 0 || (size <= policy->compression_threshold)) {
+		// Large string/blob values can be sent in place when the command is not compressed.
+		size_t zero_copy_size = 0;
+		uint32_t n_zero_copy = 0;
+
+		for (uint32_t i = 0; i < n_bins; i++) {
+			size_t s = as_command_zero_copy_size(&bins[i], false);
+
+			if (s > 0) {
+				zero_copy_size += s;
+				n_zero_copy++;
+			}
+		}
+
+		if (n_zero_copy > 0) {
+			return as_put_iov(as, err, policy, key, rec, buffers, size - zero_copy_size,
+							  n_zero_copy, n_fields);
+		}
+	}
+
 	uint8_t* cmd = as_command_init(size);
 	uint8_t* p = as_command_write_header(cmd, 0, AS_MSG_INFO2_WRITE, policy->commit_level, 0, false,
 					policy->exists, policy->gen, rec->gen, rec->ttl, policy->base.total_timeout, n_fields,
@@ -413,7 +501,7 @@ aerospike_key_put(
 	size = as_command_write_end(cmd, p);
 
 	as_command_node cn;
-	as_command_node_init(&cn, key->ns, key->digest.value, AS_POLICY_REPLICA_MASTER);
+	as_command_node_init(&cn, key->ns, key->digest.value, AS_POLICY_REPLICA_MASTER, AS_LATENCY_TYPE_WRITE);
 	as_proto_msg msg;
 	
 	if (policy->compression_threshold == 0 || (size <= policy->compression_threshold)) {
@@ -426,7 +514,8 @@ aerospike_key_put(
 		// Send compressed command.
 		size_t comp_size = as_command_compress_max_size(size);
 		uint8_t* comp_cmd = as_command_init(comp_size);
-		status = as_command_compress(err, cmd, size, comp_cmd, &comp_size);
+		status = as_command_compress(as->cluster, err, cmd, size, comp_cmd, &comp_size,
+			policy->compression_level);
 		
 		if (status == AEROSPIKE_OK) {
 			AEROSPIKE_PUT_EXECUTE_STARTING(task_id);
@@ -471,6 +560,58 @@ aerospike_key_put_async_ex(
 	}
 	
 	if (policy->compression_threshold == 0 || (size <= policy->compression_threshold)) {
+		// Large string/blob values that the command can reserve are sent in place.
+		size_t zero_copy_size = 0;
+		uint32_t n_zero_copy = 0;
+
+		for (uint32_t i = 0; i < n_bins; i++) {
+			size_t s = as_command_zero_copy_size(&bins[i], true);
+
+			if (s > 0) {
+				zero_copy_size += s;
+				n_zero_copy++;
+			}
+		}
+
+		if (n_zero_copy > 0) {
+			as_event_command* cmd = as_async_write_command_create(
+					as->cluster, &policy->base, policy->replica, partition, flags, listener, udata,
+					event_loop, pipe_listener, size - zero_copy_size, as_event_command_parse_header);
+
+			as_event_iov* ei = as_event_iov_create(n_zero_copy * 2 + 1, n_zero_copy);
+			as_command_iov ci;
+			as_command_iov_init(&ci, ei->iov, ei->vals, cmd->buf);
+
+			uint8_t* p = as_command_write_header(cmd->buf, 0, AS_MSG_INFO2_WRITE, policy->commit_level, 0,
+					false, policy->exists, policy->gen, rec->gen, rec->ttl, policy->base.total_timeout,
+					n_fields, n_bins, policy->durable_delete);
+
+			p = as_command_write_key(p, policy->key, key);
+
+			for (uint32_t i = 0; i < n_bins; i++) {
+				p = as_command_write_bin_iov(&ci, p, AS_OPERATOR_WRITE, &bins[i], &buffers[i]);
+			}
+			as_command_iov_end(&ci, p);
+
+			// The write buffer length is the scratch buffer, so the auth and read buffers
+			// that follow it are placed correctly.
+			cmd->write_len = (uint32_t)(p - cmd->buf);
+			ei->n_iov = ci.n_iov;
+			ei->n_vals = ci.n_vals;
+			ei->len = (uint32_t)ci.len;
+			cmd->iov = ei;
+
+			if (length != NULL) {
+				*length = size;
+			}
+
+			if (comp_length != NULL) {
+				*comp_length = size;
+			}
+
+			return as_event_command_execute(cmd, err);
+		}
+
 		// Send uncompressed command.
 		as_event_command* cmd = as_async_write_command_create(
 				as->cluster, &policy->base, policy->replica, partition, flags, listener, udata,
@@ -520,7 +661,8 @@ aerospike_key_put_async_ex(
 				event_loop, pipe_listener, comp_size, as_event_command_parse_header);
 
 		// Compress buffer and execute.
-		status = as_command_compress(err, cmd, size, comp_cmd->buf, &comp_size);
+		status = as_command_compress(as->cluster, err, cmd, size, comp_cmd->buf, &comp_size,
+			policy->compression_level);
 		as_command_free(cmd, size);
 		
 		if (status == AEROSPIKE_OK) {
@@ -582,7 +724,7 @@ aerospike_key_remove(
 	size = as_command_write_end(cmd, p);
 
 	as_command_node cn;
-	as_command_node_init(&cn, key->ns, key->digest.value, AS_POLICY_REPLICA_MASTER);
+	as_command_node_init(&cn, key->ns, key->digest.value, AS_POLICY_REPLICA_MASTER, AS_LATENCY_TYPE_WRITE);
 	
 	as_proto_msg msg;
 	status = as_command_execute(as->cluster, err, &policy->base, &cn, cmd, size, as_command_parse_header, &msg, false);
@@ -642,49 +784,6 @@ aerospike_key_remove_async(
 	return aerospike_key_remove_async_ex(as, err, policy, key, listener, udata, event_loop, pipe_listener, NULL);
 }
 
-static size_t
-as_operate_set_attr(const as_operations* ops, as_buffer* buffers, uint8_t* rattr, uint8_t* wattr)
-{
-	size_t size = 0;
-	uint32_t n_operations = ops->binops.size;
-	uint8_t read_attr = 0;
-	uint8_t write_attr = 0;
-	bool respond_all_ops = false;
-	
-	for (uint32_t i = 0; i < n_operations; i++) {
-		as_binop* op = &ops->binops.entries[i];
-		
-		switch (op->op)	{
-			case AS_OPERATOR_MAP_READ:
-				// Map operations require respond_all_ops to be true.
-				respond_all_ops = true;
-				op->op = AS_OPERATOR_CDT_READ;
-				// Fall through to read.
-			case AS_OPERATOR_CDT_READ:
-			case AS_OPERATOR_READ:
-				read_attr |= AS_MSG_INFO1_READ;
-				break;
-				
-			case AS_OPERATOR_MAP_MODIFY:
-				// Map operations require respond_all_ops to be true.
-				respond_all_ops = true;
-				op->op = AS_OPERATOR_CDT_MODIFY;
-				// Fall through to write.
-			default:
-				write_attr |= AS_MSG_INFO2_WRITE;
-				break;
-		}
-		size += as_command_bin_size(&op->bin, &buffers[i]);
-	}
-	
-	if (respond_all_ops) {
-		write_attr |= AS_MSG_INFO2_RESPOND_ALL_OPS;
-	}
-	*rattr = read_attr;
-	*wattr = write_attr;
-	return size;
-}
-
 as_status
 aerospike_key_operate(
 	aerospike* as, as_error* err, const as_policy_operate* policy, const as_key* key,
@@ -710,7 +809,7 @@ aerospike_key_operate(
 
 	uint8_t read_attr;
 	uint8_t write_attr;
-	size_t size = as_operate_set_attr(ops, buffers, &read_attr, &write_attr);
+	size_t size = as_command_operate_set_attr(ops, buffers, &read_attr, &write_attr);
 	
 	as_policy_operate policy_local;
 
@@ -731,7 +830,8 @@ aerospike_key_operate(
 	size += as_command_key_size(policy->key, key, &n_fields);
 
 	uint8_t* cmd = as_command_init(size);
-	uint8_t* p = as_command_write_header(cmd, read_attr, write_attr, policy->commit_level,
+	uint8_t* p = as_command_write_header(cmd,
+		read_attr | as_command_compress_attr(&policy->base), write_attr, policy->commit_level,
 				policy->consistency_level, policy->linearize_read, policy->exists,
 				policy->gen, ops->gen, ops->ttl, policy->base.total_timeout, n_fields, n_operations,
 				policy->durable_delete);
@@ -746,7 +846,8 @@ aerospike_key_operate(
 	size = as_command_write_end(cmd, p);
 
 	as_command_node cn;
-	as_command_node_init(&cn, key->ns, key->digest.value, write_attr ? AS_POLICY_REPLICA_MASTER : policy->replica);
+	as_command_node_init(&cn, key->ns, key->digest.value, write_attr ? AS_POLICY_REPLICA_MASTER : policy->replica,
+						 write_attr ? AS_LATENCY_TYPE_WRITE : AS_LATENCY_TYPE_READ);
 	
 	as_command_parse_result_data data;
 	data.record = rec;
@@ -775,7 +876,7 @@ aerospike_key_operate_async(
 	
 	uint8_t read_attr;
 	uint8_t write_attr;
-	size_t size = as_operate_set_attr(ops, buffers, &read_attr, &write_attr);
+	size_t size = as_command_operate_set_attr(ops, buffers, &read_attr, &write_attr);
 
 	as_policy_operate policy_local;
 
@@ -814,7 +915,10 @@ aerospike_key_operate_async(
 		as->cluster, &policy->base, policy->replica, partition, policy->deserialize, flags,
 		listener, udata, event_loop, pipe_listener, size, as_event_command_parse_result);
 
-	uint8_t* p = as_command_write_header(cmd->buf, read_attr, write_attr, policy->commit_level,
+	cmd->borrow = policy->borrow_bins;
+
+	uint8_t* p = as_command_write_header(cmd->buf,
+		read_attr | as_command_compress_attr(&policy->base), write_attr, policy->commit_level,
 		policy->consistency_level, policy->linearize_read, policy->exists, policy->gen,
 		ops->gen, ops->ttl, policy->base.total_timeout, n_fields, n_operations,
 		policy->durable_delete);
@@ -829,6 +933,132 @@ aerospike_key_operate_async(
 	return as_event_command_execute(cmd, err);
 }
 
+static inline const as_policy_operate*
+as_operate_template_policy(aerospike* as, const as_operations_template* tmpl, as_policy_operate* policy_local)
+{
+	if (tmpl->write_attr & AS_MSG_INFO2_WRITE) {
+		// Write operations should not retry by default.
+		return &as->config.policies.operate;
+	}
+
+	// Read operations should retry by default.
+	as_policy_operate_copy(&as->config.policies.operate, policy_local);
+	policy_local->base.max_retries = 2;
+	return policy_local;
+}
+
+as_status
+aerospike_key_operate_template(
+	aerospike* as, as_error* err, const as_policy_operate* policy, const as_key* key,
+	const as_operations_template* tmpl, const as_template_args* args, as_record** rec
+	)
+{
+	as_error_reset(err);
+
+	as_status status = as_key_set_digest(err, (as_key*)key);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	size_t size;
+	status = as_operations_template_size(tmpl, err, args, &size);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	as_policy_operate policy_local;
+
+	if (! policy) {
+		policy = as_operate_template_policy(as, tmpl, &policy_local);
+	}
+
+	uint16_t n_fields;
+	size += as_command_key_size(policy->key, key, &n_fields);
+
+	uint32_t ttl = args ? args->ttl : tmpl->ttl;
+	uint16_t gen = args ? args->gen : tmpl->gen;
+
+	uint8_t* cmd = as_command_init(size);
+	uint8_t* p = as_command_write_header(cmd,
+		tmpl->read_attr | as_command_compress_attr(&policy->base), tmpl->write_attr, policy->commit_level,
+				policy->consistency_level, policy->linearize_read, policy->exists,
+				policy->gen, gen, ttl, policy->base.total_timeout, n_fields, tmpl->n_operations,
+				policy->durable_delete);
+
+	p = as_command_write_key(p, policy->key, key);
+	p = as_operations_template_write(tmpl, args, p);
+	size = as_command_write_end(cmd, p);
+
+	uint8_t write_attr = tmpl->write_attr;
+
+	as_command_node cn;
+	as_command_node_init(&cn, key->ns, key->digest.value, write_attr ? AS_POLICY_REPLICA_MASTER : policy->replica,
+						 write_attr ? AS_LATENCY_TYPE_WRITE : AS_LATENCY_TYPE_READ);
+
+	as_command_parse_result_data data;
+	data.record = rec;
+	data.deserialize = policy->deserialize;
+
+	status = as_command_execute(as->cluster, err, &policy->base, &cn, cmd, size, as_command_parse_result, &data, false);
+
+	as_command_free(cmd, size);
+	return status;
+}
+
+as_status
+aerospike_key_operate_template_async(
+	aerospike* as, as_error* err, const as_policy_operate* policy, const as_key* key,
+	const as_operations_template* tmpl, const as_template_args* args,
+	as_async_record_listener listener, void* udata, as_event_loop* event_loop, as_pipe_listener pipe_listener
+	)
+{
+	size_t size;
+	as_status status = as_operations_template_size(tmpl, err, args, &size);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	as_policy_operate policy_local;
+
+	if (! policy) {
+		policy = as_operate_template_policy(as, tmpl, &policy_local);
+	}
+
+	uint16_t n_fields;
+	size += as_command_key_size(policy->key, key, &n_fields);
+
+	void* partition;
+	uint8_t flags = AS_ASYNC_FLAGS_MASTER;
+	status = as_event_command_init(as->cluster, err, key, &partition, &flags);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	as_event_command* cmd = as_async_record_command_create(
+		as->cluster, &policy->base, policy->replica, partition, policy->deserialize, flags,
+		listener, udata, event_loop, pipe_listener, size, as_event_command_parse_result);
+
+	cmd->borrow = policy->borrow_bins;
+
+	uint32_t ttl = args ? args->ttl : tmpl->ttl;
+	uint16_t gen = args ? args->gen : tmpl->gen;
+
+	uint8_t* p = as_command_write_header(cmd->buf,
+		tmpl->read_attr | as_command_compress_attr(&policy->base), tmpl->write_attr,
+		policy->commit_level, policy->consistency_level, policy->linearize_read, policy->exists,
+		policy->gen, gen, ttl, policy->base.total_timeout, n_fields, tmpl->n_operations,
+		policy->durable_delete);
+
+	p = as_command_write_key(p, policy->key, key);
+	p = as_operations_template_write(tmpl, args, p);
+	cmd->write_len = (uint32_t)as_command_write_end(cmd->buf, p);
+	return as_event_command_execute(cmd, err);
+}
+
 as_status
 aerospike_key_apply(
 	aerospike* as, as_error* err, const as_policy_apply* policy, const as_key* key,
@@ -861,8 +1091,8 @@ aerospike_key_apply(
 	n_fields += 3;
 
 	uint8_t* cmd = as_command_init(size);
-	uint8_t* p = as_command_write_header(cmd, 0, AS_MSG_INFO2_WRITE, policy->commit_level, 0,
-		policy->linearize_read, 0, policy->gen, policy->gen_value, policy->ttl,
+	uint8_t* p = as_command_write_header(cmd, as_command_compress_attr(&policy->base), AS_MSG_INFO2_WRITE,
+		policy->commit_level, 0, policy->linearize_read, 0, policy->gen, policy->gen_value, policy->ttl,
 		policy->base.total_timeout, n_fields, 0, policy->durable_delete);
 
 	p = as_command_write_key(p, policy->key, key);
@@ -872,7 +1102,7 @@ aerospike_key_apply(
 	size = as_command_write_end(cmd, p);
 	
 	as_command_node cn;
-	as_command_node_init(&cn, key->ns, key->digest.value, AS_POLICY_REPLICA_MASTER);
+	as_command_node_init(&cn, key->ns, key->digest.value, AS_POLICY_REPLICA_MASTER, AS_LATENCY_TYPE_WRITE);
 	
 	status = as_command_execute(as->cluster, err, &policy->base, &cn, cmd, size, as_command_parse_success_failure, result, false);
 	
@@ -919,8 +1149,8 @@ aerospike_key_apply_async(
 		as->cluster, &policy->base, policy->replica, partition, flags, listener, udata,
 		event_loop, pipe_listener, size, as_event_command_parse_success_failure);
 
-	uint8_t* p = as_command_write_header(cmd->buf, 0, AS_MSG_INFO2_WRITE, policy->commit_level, 0,
-		policy->linearize_read, 0, policy->gen, policy->gen_value, policy->ttl,
+	uint8_t* p = as_command_write_header(cmd->buf, as_command_compress_attr(&policy->base), AS_MSG_INFO2_WRITE,
+		policy->commit_level, 0, policy->linearize_read, 0, policy->gen, policy->gen_value, policy->ttl,
 		policy->base.total_timeout, n_fields, 0, policy->durable_delete);
 
 	p = as_command_write_key(p, policy->key, key);
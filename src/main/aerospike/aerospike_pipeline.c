@@ -0,0 +1,784 @@
+/*
+ * Copyright 2008-2018 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/aerospike_pipeline.h>
+#include <aerospike/as_cluster.h>
+#include <aerospike/as_command.h>
+#include <aerospike/as_node.h>
+#include <aerospike/as_sleep.h>
+#include <aerospike/as_socket.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_clock.h>
+#include <string.h>
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct as_pipeline_command_s {
+	as_policy_base policy;
+	as_command_parse_result_data data;
+	as_proto_msg msg;
+	as_parse_results_fn parse_results_fn;
+	size_t offset;  // Offset of serialized command in pipeline buf.
+	size_t size;
+	as_node* node;  // Target node in current round.
+	uint64_t deadline_ms;
+	uint32_t socket_timeout;
+	uint32_t total_timeout;
+	uint32_t iteration;
+	uint32_t sent;
+	as_policy_replica replica;
+	as_latency_type latency_type;
+	as_status status;
+	uint8_t digest[AS_DIGEST_VALUE_SIZE];
+	as_namespace ns;
+	bool is_read;
+	bool has_record;  // Parse record into data.  Otherwise, parse header into msg.
+	bool compressed;
+	bool master;
+	bool retry;  // Failed in current round and may be retried.
+	bool stale;  // Not sent or failed on stale connection.  Retry without counting an iteration.
+} as_pipeline_command;
+
+typedef struct as_pipeline_node_s {
+	as_node* node;
+	as_socket socket;
+	as_vector cmds;  // Command indexes in queue order.
+	uint64_t begin;  // Time the current window was written.
+	uint32_t sent;
+	uint32_t read;
+	bool open;
+} as_pipeline_node;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static uint8_t*
+as_pipeline_buf_reserve(as_pipeline* pipeline, size_t size)
+{
+	size_t need = pipeline->buf_size + size;
+
+	if (need > pipeline->buf_capacity) {
+		size_t capacity = pipeline->buf_capacity * 2;
+
+		if (capacity < need) {
+			capacity = need;
+		}
+
+		if (capacity < AS_STACK_BUF_SIZE) {
+			capacity = AS_STACK_BUF_SIZE;
+		}
+		pipeline->buf = cf_realloc(pipeline->buf, capacity);
+		pipeline->buf_capacity = capacity;
+	}
+	return pipeline->buf + pipeline->buf_size;
+}
+
+static as_pipeline_command*
+as_pipeline_add(
+	as_pipeline* pipeline, const as_policy_base* policy, const as_key* key, as_policy_replica replica,
+	as_latency_type latency_type, bool is_read, size_t size
+	)
+{
+	as_pipeline_command* pc = as_vector_reserve(&pipeline->commands);
+	pc->policy = *policy;
+	pc->offset = pipeline->buf_size;
+	pc->size = size;
+	pc->replica = replica;
+	pc->latency_type = latency_type;
+	pc->is_read = is_read;
+	memcpy(pc->digest, key->digest.value, AS_DIGEST_VALUE_SIZE);
+	strcpy(pc->ns, key->ns);
+	pipeline->buf_size += size;
+	return pc;
+}
+
+static inline as_pipeline_command*
+as_pipeline_node_command(as_pipeline* pipeline, as_pipeline_node* pn, uint32_t i)
+{
+	uint32_t index = *(uint32_t*)as_vector_get(&pn->cmds, i);
+	return as_vector_get(&pipeline->commands, index);
+}
+
+static void
+as_pipeline_timeouts(
+	as_pipeline* pipeline, as_pipeline_node* pn, uint32_t begin, uint32_t end,
+	uint32_t* socket_timeout, uint64_t* deadline_ms
+	)
+{
+	// Use the shortest timeouts of commands that share a connection operation.
+	uint32_t st = 0;
+	uint64_t dl = 0;
+
+	for (uint32_t i = begin; i < end; i++) {
+		as_pipeline_command* pc = as_pipeline_node_command(pipeline, pn, i);
+
+		if (pc->socket_timeout > 0 && (st == 0 || pc->socket_timeout < st)) {
+			st = pc->socket_timeout;
+		}
+
+		if (pc->deadline_ms > 0 && (dl == 0 || pc->deadline_ms < dl)) {
+			dl = pc->deadline_ms;
+		}
+	}
+	*socket_timeout = st;
+	*deadline_ms = dl;
+}
+
+static void
+as_pipeline_complete(
+	as_pipeline* pipeline, uint32_t index, as_status status, as_error* cmd_err, as_error* err,
+	uint32_t* first
+	)
+{
+	as_pipeline_command* pc = as_vector_get(&pipeline->commands, index);
+	as_pipeline_result* result = as_vector_get(&pipeline->results, index);
+
+	pc->retry = false;
+	result->status = status;
+
+	if (status == AEROSPIKE_OK) {
+		result->in_doubt = false;
+		return;
+	}
+
+	cmd_err->code = status;
+	as_error_set_in_doubt(cmd_err, pc->is_read, pc->sent);
+	result->in_doubt = cmd_err->in_doubt;
+
+	if (pc->node && cmd_err->in_doubt) {
+		as_incr_uint64(&pc->node->metrics.in_doubt_writes);
+	}
+
+	if (index < *first) {
+		*first = index;
+		as_error_copy(err, cmd_err);
+	}
+}
+
+static void
+as_pipeline_node_retry(
+	as_pipeline* pipeline, as_pipeline_node* pn, uint32_t begin, uint32_t end, as_status status
+	)
+{
+	// Commands in [begin, end) count an iteration.  Later commands were not attempted and
+	// are retried without penalty.
+	for (uint32_t i = begin; i < pn->cmds.size; i++) {
+		as_pipeline_command* pc = as_pipeline_node_command(pipeline, pn, i);
+		pc->status = status;
+		pc->retry = true;
+		pc->stale = i >= end;
+
+		if (pc->stale) {
+			continue;
+		}
+
+		// Alternate between master and prole on socket errors or database reads.
+		// Timeouts are not a good indicator of impending data migration.
+		if (status != AEROSPIKE_ERR_TIMEOUT || pc->is_read) {
+			pc->master = !pc->master;
+		}
+	}
+}
+
+static void
+as_pipeline_node_read(as_pipeline* pipeline, as_pipeline_node* pn, as_error* err, uint32_t* first)
+{
+	as_error cmd_err;
+	as_error_init(&cmd_err);
+
+	while (pn->read < pn->sent) {
+		uint32_t index = *(uint32_t*)as_vector_get(&pn->cmds, pn->read);
+		as_pipeline_command* pc = as_vector_get(&pipeline->commands, index);
+		void* udata = pc->has_record ? (void*)&pc->data : (void*)&pc->msg;
+
+		as_status status = pc->parse_results_fn(&cmd_err, &pn->socket, pn->node, pc->socket_timeout,
+			pc->deadline_ms, udata);
+
+		switch (status) {
+			case AEROSPIKE_OK:
+				as_node_add_latency(pn->node, pc->latency_type, cf_getus() - pn->begin);
+				as_pipeline_complete(pipeline, index, status, &cmd_err, err, first);
+				break;
+
+			case AEROSPIKE_ERR_CONNECTION:
+			case AEROSPIKE_ERR_TIMEOUT: {
+				// Remaining responses on this connection are lost.  Commands in [read, sent)
+				// were sent and count an iteration.  Later commands were not sent.
+				as_node_close_connection(&pn->socket);
+				pn->open = false;
+
+				if (status == AEROSPIKE_ERR_TIMEOUT) {
+					as_node_add_timeout(pn->node, &cmd_err);
+				}
+				as_pipeline_node_retry(pipeline, pn, pn->read, pn->sent, status);
+				return;
+			}
+
+			case AEROSPIKE_NOT_AUTHENTICATED:
+			case AEROSPIKE_ERR_TLS_ERROR:
+			case AEROSPIKE_ERR_QUERY_ABORTED:
+			case AEROSPIKE_ERR_SCAN_ABORTED:
+			case AEROSPIKE_ERR_CLIENT_ABORT:
+			case AEROSPIKE_ERR_CLIENT:
+				// Command fails without retry.  Remaining commands are retried on a new connection.
+				as_node_close_connection(&pn->socket);
+				pn->open = false;
+				as_pipeline_complete(pipeline, index, status, &cmd_err, err, first);
+				as_pipeline_node_retry(pipeline, pn, pn->read + 1, pn->sent, AEROSPIKE_ERR_CONNECTION);
+				return;
+
+			default:
+				// Server returned an error, so the command did complete.
+				as_node_add_latency(pn->node, pc->latency_type, cf_getus() - pn->begin);
+				as_pipeline_complete(pipeline, index, status, &cmd_err, err, first);
+				break;
+		}
+		pn->read++;
+	}
+}
+
+static void
+as_pipeline_execute(as_pipeline* pipeline, as_vector* nodes, as_error* err, uint32_t* first)
+{
+	as_cluster* cluster = pipeline->as->cluster;
+	uint32_t window = (pipeline->window > 0)? pipeline->window : AS_PIPELINE_WINDOW_DEFAULT;
+	as_iovec* iov = cf_malloc(sizeof(as_iovec) * window);
+	uint32_t socket_timeout;
+	uint64_t deadline_ms;
+	as_error cmd_err;
+	as_error_init(&cmd_err);
+
+	// Open one connection per node.
+	for (uint32_t i = 0; i < nodes->size; i++) {
+		as_pipeline_node* pn = as_vector_get(nodes, i);
+
+		as_pipeline_timeouts(pipeline, pn, 0, pn->cmds.size, &socket_timeout, &deadline_ms);
+
+		as_status status = as_node_get_connection(&cmd_err, pn->node, socket_timeout, deadline_ms,
+			&pn->socket);
+
+		if (status != AEROSPIKE_OK) {
+			as_pipeline_node_retry(pipeline, pn, 0, pn->cmds.size, status);
+			continue;
+		}
+		pn->open = true;
+	}
+
+	bool active = true;
+
+	while (active) {
+		// Write next window of commands on each connection.  Commands to different nodes
+		// are in flight at the same time.
+		for (uint32_t i = 0; i < nodes->size; i++) {
+			as_pipeline_node* pn = as_vector_get(nodes, i);
+
+			if (! pn->open || pn->sent == pn->cmds.size) {
+				continue;
+			}
+
+			uint32_t end = pn->sent + window;
+
+			if (end > pn->cmds.size) {
+				end = pn->cmds.size;
+			}
+
+			for (uint32_t j = pn->sent; j < end; j++) {
+				as_pipeline_command* pc = as_pipeline_node_command(pipeline, pn, j);
+				iov[j - pn->sent].iov_base = pipeline->buf + pc->offset;
+				iov[j - pn->sent].iov_len = pc->size;
+			}
+
+			as_pipeline_timeouts(pipeline, pn, pn->sent, end, &socket_timeout, &deadline_ms);
+
+			pn->begin = cf_getus();
+
+			as_status status = as_socket_writev_deadline(&cmd_err, &pn->socket, pn->node, iov,
+				end - pn->sent, socket_timeout, deadline_ms);
+
+			if (status != AEROSPIKE_OK) {
+				// Close socket to flush out possible garbage.  Do not put back in pool.
+				bool stale = status == AEROSPIKE_ERR_CONNECTION && pn->socket.unvalidated;
+				as_node_close_connection(&pn->socket);
+				pn->open = false;
+
+				if (stale) {
+					as_incr_uint64(&pn->node->metrics.stale_conns);
+				}
+
+				// The window is retried without penalty when the connection was stale.
+				as_pipeline_node_retry(pipeline, pn, pn->read, stale ? pn->sent : end, status);
+				continue;
+			}
+
+			for (uint32_t j = pn->sent; j < end; j++) {
+				as_pipeline_node_command(pipeline, pn, j)->sent++;
+			}
+			pn->sent = end;
+		}
+
+		// Read responses to the window in order.
+		active = false;
+
+		for (uint32_t i = 0; i < nodes->size; i++) {
+			as_pipeline_node* pn = as_vector_get(nodes, i);
+
+			if (! pn->open) {
+				continue;
+			}
+
+			as_pipeline_node_read(pipeline, pn, err, first);
+
+			if (pn->open && pn->read < pn->cmds.size) {
+				active = true;
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < nodes->size; i++) {
+		as_pipeline_node* pn = as_vector_get(nodes, i);
+
+		if (pn->open) {
+			as_node_put_connection(&pn->socket, cluster->max_socket_idle);
+			pn->open = false;
+		}
+	}
+	cf_free(iov);
+}
+
+static void
+as_pipeline_map(
+	as_pipeline* pipeline, as_vector* nodes, uint32_t* pending, uint32_t n_pending, as_error* err,
+	uint32_t* first
+	)
+{
+	as_cluster* cluster = pipeline->as->cluster;
+	as_error cmd_err;
+	as_error_init(&cmd_err);
+
+	for (uint32_t i = 0; i < n_pending; i++) {
+		uint32_t index = pending[i];
+		as_pipeline_command* pc = as_vector_get(&pipeline->commands, index);
+		as_node* node;
+
+		pc->node = NULL;
+
+		as_status status = as_cluster_get_node(cluster, &cmd_err, pc->ns, pc->digest, pc->replica,
+			pc->master, &node);
+
+		if (status != AEROSPIKE_OK) {
+			// Invalid namespace or there are no active nodes.  It's not worth retrying.
+			as_pipeline_complete(pipeline, index, status, &cmd_err, err, first);
+			continue;
+		}
+
+		as_pipeline_node* pn = NULL;
+
+		for (uint32_t j = 0; j < nodes->size; j++) {
+			as_pipeline_node* p = as_vector_get(nodes, j);
+
+			if (p->node == node) {
+				pn = p;
+				break;
+			}
+		}
+
+		if (pn) {
+			// Node is already reserved by its group.
+			as_node_release(node);
+		}
+		else {
+			pn = as_vector_reserve(nodes);
+			pn->node = node;
+			as_vector_init(&pn->cmds, sizeof(uint32_t), 64);
+		}
+		pc->node = node;
+		as_vector_append(&pn->cmds, &index);
+	}
+}
+
+static uint32_t
+as_pipeline_retries(
+	as_pipeline* pipeline, uint32_t* pending, uint32_t n_pending, as_error* err, uint32_t* first,
+	uint32_t* sleep
+	)
+{
+	as_error cmd_err;
+	uint32_t n_retry = 0;
+
+	*sleep = 0;
+
+	for (uint32_t i = 0; i < n_pending; i++) {
+		uint32_t index = pending[i];
+		as_pipeline_command* pc = as_vector_get(&pipeline->commands, index);
+
+		if (! pc->retry) {
+			continue;
+		}
+
+		pc->retry = false;
+
+		as_error_init(&cmd_err);
+
+		if (pc->stale) {
+			// Pooled connection was closed while idle or command was not sent.  Retry without
+			// counting an iteration, unless the total timeout has been reached.
+			pc->stale = false;
+
+			if (pc->deadline_ms == 0 || cf_getms() < pc->deadline_ms) {
+				pending[n_retry++] = index;
+				continue;
+			}
+
+			as_error_update(&cmd_err, AEROSPIKE_ERR_TIMEOUT,
+				"Client timeout: socket=%u total=%u iterations=%u lastNode=%s",
+				pc->policy.socket_timeout, pc->policy.total_timeout, pc->iteration,
+				as_node_get_address_string(pc->node));
+			as_pipeline_complete(pipeline, index, AEROSPIKE_ERR_TIMEOUT, &cmd_err, err, first);
+			continue;
+		}
+
+		// Check if max retries reached.
+		bool done = ++pc->iteration > pc->policy.max_retries;
+
+		if (! done && pc->deadline_ms > 0) {
+			// Check for total timeout.
+			int64_t remaining = pc->deadline_ms - cf_getms() - pc->policy.sleep_between_retries;
+
+			if (remaining <= 0) {
+				done = true;
+			}
+			else if (remaining < pc->total_timeout) {
+				pc->total_timeout = (uint32_t)remaining;
+
+				if (! pc->compressed) {
+					// Reset timeout in send buffer (destined for server).
+					*(uint32_t*)(pipeline->buf + pc->offset + 22) = cf_swap_to_be32(pc->total_timeout);
+				}
+
+				if (pc->socket_timeout > pc->total_timeout) {
+					pc->socket_timeout = pc->total_timeout;
+				}
+			}
+		}
+
+		if (done) {
+			if (pc->status == AEROSPIKE_ERR_TIMEOUT) {
+				as_error_update(&cmd_err, AEROSPIKE_ERR_TIMEOUT,
+					"Client timeout: socket=%u total=%u iterations=%u lastNode=%s",
+					pc->policy.socket_timeout, pc->policy.total_timeout, pc->iteration,
+					as_node_get_address_string(pc->node));
+			}
+			else {
+				as_error_update(&cmd_err, pc->status, "Pipeline command failed: iterations=%u lastNode=%s",
+					pc->iteration, as_node_get_address_string(pc->node));
+			}
+			as_pipeline_complete(pipeline, index, pc->status, &cmd_err, err, first);
+			continue;
+		}
+
+		as_incr_uint64(&pc->node->metrics.retries);
+
+		if (pc->policy.sleep_between_retries > *sleep) {
+			*sleep = pc->policy.sleep_between_retries;
+		}
+		pending[n_retry++] = index;
+	}
+	return n_retry;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+void
+aerospike_pipeline_begin(aerospike* as, as_pipeline* pipeline)
+{
+	pipeline->as = as;
+	as_vector_init(&pipeline->commands, sizeof(as_pipeline_command), 32);
+	as_vector_init(&pipeline->results, sizeof(as_pipeline_result), 32);
+	pipeline->buf = NULL;
+	pipeline->buf_size = 0;
+	pipeline->buf_capacity = 0;
+	pipeline->window = AS_PIPELINE_WINDOW_DEFAULT;
+}
+
+as_status
+aerospike_pipeline_get(
+	as_pipeline* pipeline, as_error* err, const as_policy_read* policy, const as_key* key,
+	as_record** rec
+	)
+{
+	as_error_reset(err);
+
+	if (! policy) {
+		policy = &pipeline->as->config.policies.read;
+	}
+
+	as_status status = as_key_set_digest(err, (as_key*)key);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	uint16_t n_fields;
+	size_t size = as_command_key_size(policy->key, key, &n_fields);
+
+	uint8_t* cmd = as_pipeline_buf_reserve(pipeline, size);
+	uint8_t* p = as_command_write_header_read(cmd,
+		AS_MSG_INFO1_READ | AS_MSG_INFO1_GET_ALL | as_command_compress_attr(&policy->base),
+		policy->consistency_level, policy->linearize_read, policy->base.total_timeout, n_fields, 0);
+
+	p = as_command_write_key(p, policy->key, key);
+	size = as_command_write_end(cmd, p);
+
+	as_pipeline_command* pc = as_pipeline_add(pipeline, &policy->base, key, policy->replica,
+		AS_LATENCY_TYPE_READ, true, size);
+
+	pc->parse_results_fn = as_command_parse_result;
+	pc->data.record = rec;
+	pc->data.deserialize = policy->deserialize;
+	pc->has_record = true;
+	return AEROSPIKE_OK;
+}
+
+as_status
+aerospike_pipeline_put(
+	as_pipeline* pipeline, as_error* err, const as_policy_write* policy, const as_key* key,
+	as_record* rec
+	)
+{
+	as_error_reset(err);
+
+	if (! policy) {
+		policy = &pipeline->as->config.policies.write;
+	}
+
+	as_status status = as_key_set_digest(err, (as_key*)key);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	as_bin* bins = rec->bins.entries;
+	uint32_t n_bins = rec->bins.size;
+	as_buffer* buffers = (as_buffer*)alloca(sizeof(as_buffer) * n_bins);
+
+	uint16_t n_fields;
+	size_t size = as_command_key_size(policy->key, key, &n_fields);
+
+	memset(buffers, 0, sizeof(as_buffer) * n_bins);
+
+	for (uint32_t i = 0; i < n_bins; i++) {
+		size += as_command_bin_size(&bins[i], &buffers[i]);
+	}
+
+	bool compress = policy->compression_threshold > 0 && size > policy->compression_threshold;
+	uint8_t* cmd = compress ? as_command_init(size) : as_pipeline_buf_reserve(pipeline, size);
+	uint8_t* p = as_command_write_header(cmd, 0, AS_MSG_INFO2_WRITE, policy->commit_level, 0, false,
+					policy->exists, policy->gen, rec->gen, rec->ttl, policy->base.total_timeout, n_fields,
+					n_bins, policy->durable_delete);
+
+	p = as_command_write_key(p, policy->key, key);
+
+	for (uint32_t i = 0; i < n_bins; i++) {
+		p = as_command_write_bin(p, AS_OPERATOR_WRITE, &bins[i], &buffers[i]);
+	}
+	size = as_command_write_end(cmd, p);
+
+	if (compress) {
+		size_t comp_size = as_command_compress_max_size(size);
+		uint8_t* comp_cmd = as_pipeline_buf_reserve(pipeline, comp_size);
+
+		status = as_command_compress(pipeline->as->cluster, err, cmd, size, comp_cmd, &comp_size,
+			policy->compression_level);
+		as_command_free(cmd, size);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+		size = comp_size;
+	}
+
+	as_pipeline_command* pc = as_pipeline_add(pipeline, &policy->base, key, AS_POLICY_REPLICA_MASTER,
+		AS_LATENCY_TYPE_WRITE, false, size);
+
+	pc->parse_results_fn = as_command_parse_header;
+	pc->compressed = compress;
+	return AEROSPIKE_OK;
+}
+
+as_status
+aerospike_pipeline_operate(
+	as_pipeline* pipeline, as_error* err, const as_policy_operate* policy, const as_key* key,
+	const as_operations* ops, as_record** rec
+	)
+{
+	as_error_reset(err);
+
+	as_status status = as_key_set_digest(err, (as_key*)key);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	uint32_t n_operations = ops->binops.size;
+
+	if (n_operations == 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM, "No operations defined");
+	}
+
+	as_buffer* buffers = (as_buffer*)alloca(sizeof(as_buffer) * n_operations);
+	memset(buffers, 0, sizeof(as_buffer) * n_operations);
+
+	uint8_t read_attr;
+	uint8_t write_attr;
+	size_t size = as_command_operate_set_attr(ops, buffers, &read_attr, &write_attr);
+
+	as_policy_operate policy_local;
+
+	if (! policy) {
+		if (write_attr & AS_MSG_INFO2_WRITE) {
+			// Write operations should not retry by default.
+			policy = &pipeline->as->config.policies.operate;
+		}
+		else {
+			// Read operations should retry by default.
+			as_policy_operate_copy(&pipeline->as->config.policies.operate, &policy_local);
+			policy_local.base.max_retries = 2;
+			policy = &policy_local;
+		}
+	}
+
+	uint16_t n_fields;
+	size += as_command_key_size(policy->key, key, &n_fields);
+
+	uint8_t* cmd = as_pipeline_buf_reserve(pipeline, size);
+	uint8_t* p = as_command_write_header(cmd,
+		read_attr | as_command_compress_attr(&policy->base), write_attr, policy->commit_level,
+				policy->consistency_level, policy->linearize_read, policy->exists,
+				policy->gen, ops->gen, ops->ttl, policy->base.total_timeout, n_fields, n_operations,
+				policy->durable_delete);
+
+	p = as_command_write_key(p, policy->key, key);
+
+	for (uint32_t i = 0; i < n_operations; i++) {
+		as_binop* op = &ops->binops.entries[i];
+		p = as_command_write_bin(p, op->op, &op->bin, &buffers[i]);
+	}
+
+	size = as_command_write_end(cmd, p);
+
+	bool is_read = !(write_attr & AS_MSG_INFO2_WRITE);
+
+	as_pipeline_command* pc = as_pipeline_add(pipeline, &policy->base, key,
+		write_attr ? AS_POLICY_REPLICA_MASTER : policy->replica,
+		write_attr ? AS_LATENCY_TYPE_WRITE : AS_LATENCY_TYPE_READ, is_read, size);
+
+	pc->parse_results_fn = as_command_parse_result;
+	pc->data.record = rec;
+	pc->data.deserialize = policy->deserialize;
+	pc->has_record = true;
+	return AEROSPIKE_OK;
+}
+
+as_status
+aerospike_pipeline_flush(as_pipeline* pipeline, as_error* err)
+{
+	as_error_reset(err);
+
+	uint32_t n_cmds = pipeline->commands.size;
+
+	as_vector_clear(&pipeline->results);
+
+	for (uint32_t i = 0; i < n_cmds; i++) {
+		as_pipeline_result* result = as_vector_reserve(&pipeline->results);
+		result->status = AEROSPIKE_NO_RESPONSE;
+	}
+
+	if (n_cmds == 0) {
+		return AEROSPIKE_OK;
+	}
+
+	uint32_t* pending = cf_malloc(sizeof(uint32_t) * n_cmds);
+	uint64_t now = cf_getms();
+
+	for (uint32_t i = 0; i < n_cmds; i++) {
+		as_pipeline_command* pc = as_vector_get(&pipeline->commands, i);
+
+		pc->deadline_ms = 0;
+		pc->socket_timeout = pc->policy.socket_timeout;
+		pc->total_timeout = pc->policy.total_timeout;
+
+		if (pc->total_timeout > 0) {
+			pc->deadline_ms = now + pc->total_timeout;
+
+			if (pc->socket_timeout == 0 || pc->socket_timeout > pc->total_timeout) {
+				pc->socket_timeout = pc->total_timeout;
+			}
+		}
+		pc->master = true;
+		pending[i] = i;
+	}
+
+	uint32_t n_pending = n_cmds;
+	uint32_t first = n_cmds;  // Index of first failed command.
+	as_vector nodes;
+	as_vector_inita(&nodes, sizeof(as_pipeline_node), 16);
+
+	// Execute commands until all commands have completed.  Each round maps remaining
+	// commands to nodes, so retries can switch replicas.
+	while (n_pending > 0) {
+		as_pipeline_map(pipeline, &nodes, pending, n_pending, err, &first);
+		as_pipeline_execute(pipeline, &nodes, err, &first);
+
+		uint32_t sleep;
+		n_pending = as_pipeline_retries(pipeline, pending, n_pending, err, &first, &sleep);
+
+		for (uint32_t i = 0; i < nodes.size; i++) {
+			as_pipeline_node* pn = as_vector_get(&nodes, i);
+			as_vector_destroy(&pn->cmds);
+			as_node_release(pn->node);
+		}
+		as_vector_clear(&nodes);
+
+		if (n_pending > 0 && sleep > 0) {
+			// Sleep before trying again.
+			as_sleep(sleep);
+		}
+	}
+
+	as_vector_destroy(&nodes);
+	cf_free(pending);
+
+	// Queue is empty for the next batch of commands.  Results remain until the next flush.
+	as_vector_clear(&pipeline->commands);
+	pipeline->buf_size = 0;
+	return (first < n_cmds)? err->code : AEROSPIKE_OK;
+}
+
+void
+aerospike_pipeline_end(as_pipeline* pipeline)
+{
+	as_vector_destroy(&pipeline->commands);
+	as_vector_destroy(&pipeline->results);
+	cf_free(pipeline->buf);
+	pipeline->buf = NULL;
+	pipeline->buf_size = 0;
+	pipeline->buf_capacity = 0;
+}
@@ -49,6 +49,8 @@ typedef struct as_query_user_callback_s {
 	void* udata;
 } as_query_user_callback;
 
+struct as_query_shard_s;
+
 typedef struct as_query_task_s {
 	as_node* node;
 	
@@ -62,6 +64,8 @@ typedef struct as_query_task_s {
 	as_error* err;
 	cf_queue* input_queue;
 	cf_queue* complete_q;
+	struct as_query_shard_s* shards;
+	uint32_t n_shards;
 	uint64_t task_id;
 	uint64_t cluster_key;
 
@@ -79,6 +83,12 @@ typedef struct as_query_task_aggr_s {
 	cf_queue* complete_q;
 } as_query_task_aggr;
 
+typedef struct as_query_shard_s {
+	cf_queue* input_queue;
+	as_stream input_stream;
+	as_query_task_aggr task_aggr;
+} as_query_shard;
+
 typedef struct as_query_complete_task_s {
 	as_node* node;
 	uint64_t task_id;
@@ -169,6 +179,26 @@ as_query_aggregate_callback(const as_val* v, void* udata)
     return status? false : true;
 }
 
+// This callback will populate the combine stream with partial aggregation results.
+static bool
+as_query_partial_callback(const as_val* v, void* udata)
+{
+	// The output stream destroys the value after this callback returns.
+	as_val_reserve((as_val*)v);
+	return as_query_aggregate_callback(v, udata);
+}
+
+static void
+as_query_queue_destroy(cf_queue* queue)
+{
+	as_val* val = NULL;
+
+	while (cf_queue_pop(queue, &val, CF_QUEUE_NOWAIT) == CF_QUEUE_OK) {
+		as_val_destroy(val);
+	}
+	cf_queue_destroy(queue);
+}
+
 static int
 as_output_stream_destroy(as_stream* s)
 {
@@ -206,7 +236,7 @@ as_query_parse_record_async(as_event_command* cmd, uint8_t** pp, as_msg* msg, as
 	rec.ttl = cf_server_void_time_to_ttl(msg->record_ttl);
 	*pp = as_command_parse_key(*pp, msg->n_fields, &rec.key);
 
-	as_status status = as_command_parse_bins(pp, err, &rec, msg->n_ops, cmd->deserialize);
+	as_status status = as_command_parse_bins(pp, err, &rec, msg->n_ops, cmd->deserialize, cmd->borrow, NULL);
 
 	if (status != AEROSPIKE_OK) {
 		as_record_destroy(&rec);
@@ -308,7 +338,8 @@ as_query_parse_record(uint8_t** pp, as_msg* msg, as_query_task* task, as_error*
 
 		AEROSPIKE_QUERY_RECPARSE_BINS(task->task_id, task->node->name);
 
-		as_status status = as_command_parse_bins(pp, err, &rec, msg->n_ops, task->query_policy->deserialize);
+		as_status status = as_command_parse_bins(pp, err, &rec, msg->n_ops, task->query_policy->deserialize,
+														 task->query_policy->borrow_bins, NULL);
 
 		AEROSPIKE_QUERY_RECPARSE_FINISHED(task->task_id, task->node->name);
 
@@ -387,18 +418,28 @@ as_query_parse_records(uint8_t* buf, size_t size, as_query_task* task, as_error*
 	return AEROSPIKE_OK;
 }
 
+static as_status
+as_query_parse_stream(as_error* err, uint8_t* buf, size_t size, void* udata)
+{
+	return as_query_parse_records(buf, size, udata, err);
+}
+
 static as_status
 as_query_parse(as_error* err, as_socket* sock, as_node* node, uint32_t socket_timeout, uint64_t deadline_ms, void* udata)
 {
 	as_query_task* task = udata;
+
+	if (task->query_policy && task->query_policy->stream_buffers > 0) {
+		return as_command_parse_stream(err, sock, node, socket_timeout, deadline_ms,
+			task->query_policy->stream_buffers, true, as_query_parse_stream, task);
+	}
+
 	as_status status = AEROSPIKE_OK;
-	uint8_t* buf = 0;
-	size_t capacity = 0;
 	
 	while (true) {
 		// Read header
 		as_proto proto;
-		status = as_socket_read_deadline(err, sock, node, (uint8_t*)&proto, sizeof(as_proto), socket_timeout, deadline_ms);
+		status = as_command_read_proto(err, sock, node, (uint8_t*)&proto, sizeof(as_proto), socket_timeout, deadline_ms);
 		
 		if (status) {
 			break;
@@ -407,15 +448,9 @@ as_query_parse(as_error* err, as_socket* sock, as_node* node, uint32_t socket_ti
 		size_t size = proto.sz;
 		
 		if (size > 0) {
-			// Prepare buffer
-			if (size > capacity) {
-				as_command_free(buf, capacity);
-				capacity = size;
-				buf = as_command_init(capacity);
-			}
-			
-			// Read remaining message bytes in group
-			status = as_socket_read_deadline(err, sock, node, buf, size, socket_timeout, deadline_ms);
+			// Read remaining message bytes in group directly from the socket receive buffer.
+			uint8_t* buf;
+			status = as_socket_read_view(err, sock, node, size, socket_timeout, deadline_ms, &buf);
 			
 			if (status) {
 				break;
@@ -431,7 +466,6 @@ as_query_parse(as_error* err, as_socket* sock, as_node* node, uint32_t socket_ti
 			}
 		}
 	}
-	as_command_free(buf, capacity);
 	return status;
 }
 
@@ -440,6 +474,9 @@ as_query_command_execute(as_query_task* task)
 {
 	as_command_node cn;
 	cn.node = task->node;
+	cn.hedge_node = NULL;
+	cn.hedge_delay = 0;
+	cn.latency_type = AS_LATENCY_TYPE_QUERY;
 	
 	AEROSPIKE_QUERY_COMMAND_EXECUTE(task->task_id, task->node->name);
 
@@ -742,6 +779,7 @@ as_query_command_init(
 	
 	if (query_policy) {
 		uint8_t read_attr = (query->no_bins)? AS_MSG_INFO1_READ | AS_MSG_INFO1_GET_NOBINDATA : AS_MSG_INFO1_READ;
+		read_attr |= as_command_compress_attr(&query_policy->base);
 		p = as_command_write_header_read(cmd, read_attr, AS_POLICY_CONSISTENCY_LEVEL_ONE, false,
 				timeout, n_fields, n_ops);
 	}
@@ -878,6 +916,20 @@ as_query_command_init(
 	return as_command_write_end(cmd, p);
 }
 
+static void
+as_query_complete(as_query_task* task)
+{
+	if (task->n_shards > 0) {
+		// End each aggregation shard stream.
+		for (uint32_t i = 0; i < task->n_shards; i++) {
+			task->callback(NULL, &task->shards[i].input_stream);
+		}
+	}
+	else if (task->callback) {
+		task->callback(NULL, task->udata);
+	}
+}
+
 static as_status
 as_query_execute(as_query_task* task, const as_query* query, as_nodes* nodes, uint32_t n_nodes, uint8_t query_type)
 {
@@ -887,6 +939,8 @@ as_query_execute(as_query_task* task, const as_query* query, as_nodes* nodes, ui
 		status = as_query_validate_begin(task->err, nodes->array[0], query->ns, &task->cluster_key);
 
 		if (status) {
+			// Aggregation threads wait for the end of stream.
+			as_query_complete(task);
 			return status;
 		}
 	}
@@ -920,6 +974,13 @@ as_query_execute(as_query_task* task, const as_query* query, as_nodes* nodes, ui
 		as_query_task* task_node = alloca(sizeof(as_query_task));
 		memcpy(task_node, task, sizeof(as_query_task));
 		task_node->node = nodes->array[i];
+
+		if (task->n_shards > 0) {
+			// Assign node results to an aggregation shard.
+			as_query_shard* shard = &task->shards[i % task->n_shards];
+			task_node->input_queue = shard->input_queue;
+			task_node->udata = &shard->input_stream;
+		}
 		
 		// If the thread pool size is > 0 farm out the tasks to the pool, otherwise run in current thread.
 		if (thread_pool_size > 0) {
@@ -965,9 +1026,7 @@ as_query_execute(as_query_task* task, const as_query* query, as_nodes* nodes, ui
 	}
 	
 	// Make the callback that signals completion.
-	if (task->callback) {
-		task->callback(NULL, task->udata);
-	}
+	as_query_complete(task);
 	
 	// Release temporary queue.
 	cf_queue_destroy(task->complete_q);
@@ -1034,6 +1093,104 @@ as_query_aggregate(void* data)
 	cf_queue_push(task->complete_q, &status);
 }
 
+static as_status
+as_query_aggregate_parallel(
+	as_cluster* cluster, as_error* err, as_query_task* task, const as_query* query, as_nodes* nodes,
+	uint32_t n_shards, aerospike_query_foreach_callback callback, void* udata
+	)
+{
+	// Partial results of each shard are written to the combine stream.
+	cf_queue* combine_queue = cf_queue_create(sizeof(void*), true);
+	as_stream combine_stream;
+	as_stream_init(&combine_stream, combine_queue, &input_stream_hooks);
+
+	as_query_user_callback partial_data;
+	partial_data.callback = as_query_partial_callback;
+	partial_data.udata = &combine_stream;
+
+	cf_queue* complete_q = cf_queue_create(sizeof(as_status), true);
+	as_query_shard* shards = cf_malloc(sizeof(as_query_shard) * n_shards);
+
+	for (uint32_t i = 0; i < n_shards; i++) {
+		as_query_shard* shard = &shards[i];
+		shard->input_queue = cf_queue_create(sizeof(void*), true);
+		as_stream_init(&shard->input_stream, shard->input_queue, &input_stream_hooks);
+		shard->task_aggr.query = query;
+		shard->task_aggr.input_stream = &shard->input_stream;
+		shard->task_aggr.callback_data = &partial_data;
+		shard->task_aggr.error_mutex = task->error_mutex;
+		shard->task_aggr.err = err;
+		shard->task_aggr.complete_q = complete_q;
+	}
+
+	// Run lua aggregation for each shard in separate threads.  Each running aggregation
+	// acquires its own lua state from the mod-lua state cache.
+	as_status status = AEROSPIKE_OK;
+	uint32_t n_started = 0;
+
+	for (uint32_t i = 0; i < n_shards; i++) {
+		int rc = as_thread_pool_queue_task(&cluster->thread_pool, as_query_aggregate, &shards[i].task_aggr);
+
+		if (rc) {
+			status = as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to add aggregate thread: %d", rc);
+			break;
+		}
+		n_started++;
+	}
+
+	if (status == AEROSPIKE_OK) {
+		task->callback = as_query_aggregate_callback;
+		task->shards = shards;
+		task->n_shards = n_shards;
+		task->input_queue = shards[0].input_queue;
+		status = as_query_execute(task, query, nodes, nodes->size, QUERY_FOREGROUND);
+	}
+	else {
+		// End streams of aggregations that were started.
+		for (uint32_t i = 0; i < n_started; i++) {
+			as_query_aggregate_callback(NULL, &shards[i].input_stream);
+		}
+	}
+
+	// Wait for shard aggregation threads to finish.
+	for (uint32_t i = 0; i < n_started; i++) {
+		as_status complete_status = AEROSPIKE_OK;
+		cf_queue_pop(complete_q, &complete_status, CF_QUEUE_FOREVER);
+
+		if (complete_status != AEROSPIKE_OK && status == AEROSPIKE_OK) {
+			status = complete_status;
+		}
+	}
+
+	if (status == AEROSPIKE_OK) {
+		// Reduce partial results into the user callback in this thread.
+		as_query_aggregate_callback(NULL, &combine_stream);
+
+		as_query_user_callback callback_data;
+		callback_data.callback = callback;
+		callback_data.udata = udata;
+
+		as_query_task_aggr task_combine;
+		task_combine.query = query;
+		task_combine.input_stream = &combine_stream;
+		task_combine.callback_data = &callback_data;
+		task_combine.error_mutex = task->error_mutex;
+		task_combine.err = err;
+		task_combine.complete_q = complete_q;
+
+		as_query_aggregate(&task_combine);
+		cf_queue_pop(complete_q, &status, CF_QUEUE_FOREVER);
+	}
+
+	for (uint32_t i = 0; i < n_shards; i++) {
+		as_query_queue_destroy(shards[i].input_queue);
+	}
+	cf_free(shards);
+	as_query_queue_destroy(combine_queue);
+	cf_queue_destroy(complete_q);
+	return status;
+}
+
 /******************************************************************************
  * FUNCTIONS
  *****************************************************************************/
@@ -1079,6 +1236,8 @@ aerospike_query_foreach(
 		.err = err,
 		.input_queue = 0,
 		.complete_q = 0,
+		.shards = NULL,
+		.n_shards = 0,
 		.task_id = as_random_get_uint64(),
 		.cluster_key = 0,
 		.cmd = 0,
@@ -1088,7 +1247,23 @@ aerospike_query_foreach(
 	
 	AEROSPIKE_QUERY_FOREACH_STARTING(task.task_id);
 
-	if (query->apply.function[0]) {
+	uint32_t n_shards = (policy->aggregate_threads < n_nodes) ? policy->aggregate_threads : n_nodes;
+
+	// Each shard blocks a thread pool thread while waiting for input.  Leave at least one
+	// pool thread for the node query tasks that produce the input, so shards can't starve
+	// them and deadlock.
+	uint32_t thread_pool_size = cluster->thread_pool.thread_size;
+	uint32_t max_shards = (thread_pool_size > 0) ? thread_pool_size - 1 : 0;
+
+	if (n_shards > max_shards) {
+		n_shards = max_shards;
+	}
+
+	if (query->apply.function[0] && n_shards > 1) {
+		// Query with aggregation sharded across multiple lua streams.
+		status = as_query_aggregate_parallel(cluster, err, &task, query, nodes, n_shards, callback, udata);
+	}
+	else if (query->apply.function[0]) {
 		// Query with aggregation.
 		task.input_queue = cf_queue_create(sizeof(void*), true);
 		
@@ -1132,11 +1307,7 @@ aerospike_query_foreach(
 		cf_queue_destroy(task_aggr.complete_q);
 		
 		// Empty input queue.
-        as_val* val = NULL;
-        while (cf_queue_pop(task.input_queue, &val, CF_QUEUE_NOWAIT) == CF_QUEUE_OK) {
-            as_val_destroy(val);
-        }
-        cf_queue_destroy(task.input_queue);
+		as_query_queue_destroy(task.input_queue);
 	}
 	else {
 		// Normal query without aggregation.
@@ -1240,12 +1411,14 @@ aerospike_query_async(
 		cmd->parse_results = as_query_parse_records_async;
 		cmd->pipe_listener = NULL;
 		cmd->buf = ((as_async_query_command*)cmd)->space;
+		cmd->iov = NULL;
 		cmd->write_len = (uint32_t)size;
 		cmd->read_capacity = (uint32_t)(s - size - sizeof(as_async_query_command));
 		cmd->type = AS_ASYNC_TYPE_QUERY;
 		cmd->state = AS_ASYNC_STATE_UNREGISTERED;
 		cmd->flags = AS_ASYNC_FLAGS_MASTER;
 		cmd->deserialize = policy->deserialize;
+		cmd->borrow = policy->borrow_bins;
 		memcpy(cmd->buf, cmd_buf, size);
 		exec->commands[i] = cmd;
 	}
@@ -1333,6 +1506,8 @@ aerospike_query_background(
 		.err = err,
 		.input_queue = 0,
 		.complete_q = 0,
+		.shards = NULL,
+		.n_shards = 0,
 		.task_id = task_id,
 		.cluster_key = 0,
 		.cmd = 0,
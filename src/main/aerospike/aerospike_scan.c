@@ -21,10 +21,13 @@
 #include <aerospike/as_job.h>
 #include <aerospike/as_key.h>
 #include <aerospike/as_log.h>
+#include <aerospike/as_log_macros.h>
 #include <aerospike/as_msgpack.h>
+#include <aerospike/as_partition_tracker.h>
 #include <aerospike/as_query_validate.h>
 #include <aerospike/as_random.h>
 #include <aerospike/as_serializer.h>
+#include <aerospike/as_sleep.h>
 #include <aerospike/as_socket.h>
 #include <aerospike/as_thread_pool.h>
 #include <citrusleaf/cf_clock.h>
@@ -45,6 +48,8 @@ typedef struct as_scan_task_s {
 	as_error* err;
 	cf_queue* complete_q;
 	uint32_t* error_mutex;
+	as_partition_tracker* pt;
+	as_node_partitions* np;
 	uint64_t task_id;
 	uint64_t cluster_key;
 
@@ -89,7 +94,7 @@ as_scan_parse_record_async(as_event_command* cmd, uint8_t** pp, as_msg* msg, as_
 	rec.ttl = cf_server_void_time_to_ttl(msg->record_ttl);
 	*pp = as_command_parse_key(*pp, msg->n_fields, &rec.key);
 
-	as_status status = as_command_parse_bins(pp, err, &rec, msg->n_ops, cmd->deserialize);
+	as_status status = as_command_parse_bins(pp, err, &rec, msg->n_ops, cmd->deserialize, cmd->borrow, NULL);
 
 	if (status != AEROSPIKE_OK) {
 		as_record_destroy(&rec);
@@ -151,6 +156,23 @@ as_scan_parse_records_async(as_event_command* cmd)
 	return false;
 }
 
+static void
+as_scan_partitions_done(as_scan_task* task)
+{
+	as_partitions_status* parts_all = task->pt->parts_all;
+	as_node_partitions* np = task->np;
+
+	for (uint32_t i = 0; i < np->parts_full.size; i++) {
+		uint16_t part_id = *(uint16_t*)as_vector_get(&np->parts_full, i);
+		parts_all->parts[part_id - parts_all->part_begin].done = true;
+	}
+
+	for (uint32_t i = 0; i < np->parts_partial.size; i++) {
+		uint16_t part_id = *(uint16_t*)as_vector_get(&np->parts_partial, i);
+		parts_all->parts[part_id - parts_all->part_begin].done = true;
+	}
+}
+
 static as_status
 as_scan_parse_record(uint8_t** pp, as_msg* msg, as_scan_task* task, as_error* err)
 {
@@ -161,7 +183,8 @@ as_scan_parse_record(uint8_t** pp, as_msg* msg, as_scan_task* task, as_error* er
 	rec.ttl = cf_server_void_time_to_ttl(msg->record_ttl);
 	*pp = as_command_parse_key(*pp, msg->n_fields, &rec.key);
 
-	as_status status = as_command_parse_bins(pp, err, &rec, msg->n_ops, task->scan->deserialize_list_map);
+	as_status status = as_command_parse_bins(pp, err, &rec, msg->n_ops, task->scan->deserialize_list_map,
+												 task->policy->borrow_bins, NULL);
 
 	if (status != AEROSPIKE_OK) {
 		as_record_destroy(&rec);
@@ -173,6 +196,10 @@ as_scan_parse_record(uint8_t** pp, as_msg* msg, as_scan_task* task, as_error* er
 	if (task->callback) {
 		rv = task->callback((as_val*)&rec, task->udata);
 	}
+
+	if (rv && task->pt) {
+		as_partition_tracker_set_digest(task->pt, rec.key.digest.value, task->cluster->n_partitions);
+	}
 	as_record_destroy(&rec);
 	return rv ? AEROSPIKE_OK : AEROSPIKE_ERR_CLIENT_ABORT;
 }
@@ -188,6 +215,19 @@ as_scan_parse_records(uint8_t* buf, size_t size, as_scan_task* task, as_error* e
 		as_msg* msg = (as_msg*)p;
 		as_msg_swap_header_from_be(msg);
 		
+		if (msg->info3 & AS_MSG_INFO3_PARTITION_DONE) {
+			// Partition scan sends one of these for each partition. The partition id
+			// is in the generation field and a non-zero result code means the node
+			// could not scan the partition.
+			if (task->pt) {
+				as_partition_tracker_part_done(task->pt, msg->generation, msg->result_code);
+			}
+			p += sizeof(as_msg);
+			p = as_command_ignore_fields(p, msg->n_fields);
+			p = as_command_ignore_bins(p, msg->n_ops);
+			continue;
+		}
+
 		if (msg->result_code) {
 			// Special case - if we scan a set name that doesn't exist on a
 			// node, it will return "not found" - we unify this with the
@@ -195,6 +235,10 @@ as_scan_parse_records(uint8_t* buf, size_t size, as_scan_task* task, as_error* e
 			// We are sending "no more records back" to the caller which will
 			// send OK to the main worker thread.
 			if (msg->result_code == AEROSPIKE_ERR_RECORD_NOT_FOUND) {
+				if (task->np) {
+					// The set does not exist on the node that owns these partitions.
+					as_scan_partitions_done(task);
+				}
 				return AEROSPIKE_NO_MORE_RECORDS;
 			}
 			return as_error_set_message(err, msg->result_code, as_error_string(msg->result_code));
@@ -219,18 +263,28 @@ as_scan_parse_records(uint8_t* buf, size_t size, as_scan_task* task, as_error* e
 	return AEROSPIKE_OK;
 }
 
+static as_status
+as_scan_parse_stream(as_error* err, uint8_t* buf, size_t size, void* udata)
+{
+	return as_scan_parse_records(buf, size, udata, err);
+}
+
 static as_status
 as_scan_parse(as_error* err, as_socket* sock, as_node* node, uint32_t socket_timeout, uint64_t deadline_ms, void* udata)
 {
 	as_scan_task* task = udata;
+
+	if (task->policy->stream_buffers > 0) {
+		return as_command_parse_stream(err, sock, node, socket_timeout, deadline_ms,
+			task->policy->stream_buffers, true, as_scan_parse_stream, task);
+	}
+
 	as_status status = AEROSPIKE_OK;
-	uint8_t* buf = 0;
-	size_t capacity = 0;
 	
 	while (true) {
 		// Read header
 		as_proto proto;
-		status = as_socket_read_deadline(err, sock, node, (uint8_t*)&proto, sizeof(as_proto), socket_timeout, deadline_ms);
+		status = as_command_read_proto(err, sock, node, (uint8_t*)&proto, sizeof(as_proto), socket_timeout, deadline_ms);
 		
 		if (status) {
 			break;
@@ -239,15 +293,9 @@ as_scan_parse(as_error* err, as_socket* sock, as_node* node, uint32_t socket_tim
 		size_t size = proto.sz;
 		
 		if (size > 0) {
-			// Prepare buffer
-			if (size > capacity) {
-				as_command_free(buf, capacity);
-				capacity = size;
-				buf = as_command_init(capacity);
-			}
-			
-			// Read remaining message bytes in group
-			status = as_socket_read_deadline(err, sock, node, buf, size, socket_timeout, deadline_ms);
+			// Read remaining message bytes in group directly from the socket receive buffer.
+			uint8_t* buf;
+			status = as_socket_read_view(err, sock, node, size, socket_timeout, deadline_ms, &buf);
 			
 			if (status) {
 				break;
@@ -263,7 +311,6 @@ as_scan_parse(as_error* err, as_socket* sock, as_node* node, uint32_t socket_tim
 			}
 		}
 	}
-	as_command_free(buf, capacity);
 	return status;
 }
 
@@ -272,6 +319,9 @@ as_scan_command_execute(as_scan_task* task)
 {
 	as_command_node cn;
 	cn.node = task->node;
+	cn.hedge_node = NULL;
+	cn.hedge_delay = 0;
+	cn.latency_type = AS_LATENCY_TYPE_SCAN;
 	
 	as_error err;
 	as_error_init(&err);
@@ -318,6 +368,50 @@ as_scan_command_execute(as_scan_task* task)
 	return status;
 }
 
+static as_status
+as_scan_partition_command_execute(as_scan_task* task)
+{
+	as_command_node cn;
+	cn.node = task->np->node;
+	cn.hedge_node = NULL;
+	cn.hedge_delay = 0;
+	cn.latency_type = AS_LATENCY_TYPE_SCAN;
+
+	as_error err;
+	as_error_init(&err);
+
+	// Partitions that fail are retried by the partition tracker against their current
+	// owner, so the command itself is only sent once.
+	as_policy_base policy = task->policy->base;
+	policy.max_retries = 0;
+
+	if (task->pt->deadline) {
+		uint64_t now = cf_getms();
+
+		policy.total_timeout = (task->pt->deadline > now) ? (uint32_t)(task->pt->deadline - now) : 1;
+	}
+
+	as_status status = as_command_execute(task->cluster, &err, &policy, &cn, task->cmd, task->cmd_size,
+										  as_scan_parse, task, true);
+
+	if (status) {
+		if (as_partition_tracker_should_retry(status)) {
+			as_log_debug("Partition scan on node %s failed: %d %s", task->np->node->name, err.code,
+						 err.message);
+			return AEROSPIKE_OK;
+		}
+
+		// Set main error only once.
+		if (as_fas_uint32(task->error_mutex, 1) == 0) {
+			// Don't set error when user aborts scan.
+			if (status != AEROSPIKE_ERR_CLIENT_ABORT) {
+				as_error_copy(task->err, &err);
+			}
+		}
+	}
+	return status;
+}
+
 static void
 as_scan_worker(void* data)
 {
@@ -328,7 +422,8 @@ as_scan_worker(void* data)
 	complete_task.task_id = task->task_id;
 
 	if (as_load_uint32(task->error_mutex) == 0) {
-		complete_task.result = as_scan_command_execute(task);
+		complete_task.result = task->np ? as_scan_partition_command_execute(task) :
+										  as_scan_command_execute(task);
 	}
 	else {
 		complete_task.result = AEROSPIKE_ERR_SCAN_ABORTED;
@@ -338,7 +433,10 @@ as_scan_worker(void* data)
 }
 
 static size_t
-as_scan_command_size(const as_scan* scan, uint16_t* fields, as_buffer* argbuffer, uint32_t* predexp_sz)
+as_scan_command_size(
+	const as_scan* scan, as_node_partitions* np, uint16_t* fields, as_buffer* argbuffer,
+	uint32_t* predexp_sz
+	)
 {
 	// Build Command.  It's okay to share command across threads because scan does not have retries.
 	// If retries were allowed, the timeout field in the command would change on retry which
@@ -368,6 +466,19 @@ as_scan_command_size(const as_scan* scan, uint16_t* fields, as_buffer* argbuffer
 	// Estimate taskId size.
 	size += as_command_field_size(8);
 	n_fields++;
+
+	// Estimate partition sizes.
+	if (np) {
+		if (np->parts_full.size > 0) {
+			size += as_command_field_size(np->parts_full.size * sizeof(uint16_t));
+			n_fields++;
+		}
+
+		if (np->parts_partial.size > 0) {
+			size += as_command_field_size(np->parts_partial.size * AS_DIGEST_VALUE_SIZE);
+			n_fields++;
+		}
+	}
 	
 	// Estimate background function size.
 	as_buffer_init(argbuffer);
@@ -412,7 +523,8 @@ as_scan_command_size(const as_scan* scan, uint16_t* fields, as_buffer* argbuffer
 
 static size_t
 as_scan_command_init(uint8_t* cmd, const as_policy_scan* policy, const as_scan* scan,
-uint64_t task_id, uint16_t n_fields, as_buffer* argbuffer, uint32_t predexp_size)
+uint64_t task_id, as_partition_tracker* pt, as_node_partitions* np, uint16_t n_fields,
+as_buffer* argbuffer, uint32_t predexp_size)
 {
 	uint8_t* p;
 	
@@ -424,6 +536,7 @@ uint64_t task_id, uint16_t n_fields, as_buffer* argbuffer, uint32_t predexp_size
 	}
 	else {
 		uint8_t read_attr = (scan->no_bins)? AS_MSG_INFO1_READ | AS_MSG_INFO1_GET_NOBINDATA : AS_MSG_INFO1_READ;
+		read_attr |= as_command_compress_attr(&policy->base);
 		p = as_command_write_header_read(cmd, read_attr, AS_POLICY_CONSISTENCY_LEVEL_ONE, false,
 			policy->base.total_timeout, n_fields, scan->select.size);
 	}
@@ -454,6 +567,33 @@ uint64_t task_id, uint16_t n_fields, as_buffer* argbuffer, uint32_t predexp_size
 
 	// Write taskId field
 	p = as_command_write_field_uint64(p, AS_FIELD_TASK_ID, task_id);
+
+	// Write partitions to scan.  Partition ids are little endian on the wire.
+	if (np) {
+		if (np->parts_full.size > 0) {
+			p = as_command_write_field_header(p, AS_FIELD_PID_ARRAY, np->parts_full.size * sizeof(uint16_t));
+
+			for (uint32_t i = 0; i < np->parts_full.size; i++) {
+				uint16_t part_id = *(uint16_t*)as_vector_get(&np->parts_full, i);
+				*(uint16_t*)p = cf_swap_to_le16(part_id);
+				p += sizeof(uint16_t);
+			}
+		}
+
+		if (np->parts_partial.size > 0) {
+			as_partitions_status* parts_all = pt->parts_all;
+
+			p = as_command_write_field_header(p, AS_FIELD_PID_DIGEST_ARRAY,
+											  np->parts_partial.size * AS_DIGEST_VALUE_SIZE);
+
+			for (uint32_t i = 0; i < np->parts_partial.size; i++) {
+				uint16_t part_id = *(uint16_t*)as_vector_get(&np->parts_partial, i);
+				as_partition_status* ps = &parts_all->parts[part_id - parts_all->part_begin];
+				memcpy(p, ps->digest.value, AS_DIGEST_VALUE_SIZE);
+				p += AS_DIGEST_VALUE_SIZE;
+			}
+		}
+	}
 	
 	// Write background function
 	if (scan->apply_each.function[0]) {
@@ -540,9 +680,9 @@ as_scan_generic(
 	as_buffer argbuffer;
 	uint16_t n_fields = 0;
 	uint32_t predexp_sz = 0;
-	size_t size = as_scan_command_size(scan, &n_fields, &argbuffer, &predexp_sz);
+	size_t size = as_scan_command_size(scan, NULL, &n_fields, &argbuffer, &predexp_sz);
 	uint8_t* cmd = as_command_init(size);
-	size = as_scan_command_init(cmd, policy, scan, task_id, n_fields, &argbuffer, predexp_sz);
+	size = as_scan_command_init(cmd, policy, scan, task_id, NULL, NULL, n_fields, &argbuffer, predexp_sz);
 	
 	// Initialize task.
 	uint32_t error_mutex = 0;
@@ -554,6 +694,8 @@ as_scan_generic(
 	task.udata = udata;
 	task.err = err;
 	task.error_mutex = &error_mutex;
+	task.pt = NULL;
+	task.np = NULL;
 	task.task_id = task_id;
 	task.cluster_key = cluster_key;
 	task.cmd = cmd;
@@ -636,6 +778,183 @@ as_scan_generic(
 	return status;
 }
 
+static as_status
+as_scan_partition_execute(
+	as_cluster* cluster, as_partition_tracker* pt, as_scan_task* task, bool concurrent
+	)
+{
+	uint32_t n_units = pt->node_parts.size;
+	as_scan_task* tasks = cf_malloc(sizeof(as_scan_task) * n_units);
+
+	// Each work unit scans a different set of partitions, so each unit needs its own
+	// command and task id.
+	for (uint32_t i = 0; i < n_units; i++) {
+		as_scan_task* t = &tasks[i];
+		memcpy(t, task, sizeof(as_scan_task));
+		t->np = as_vector_get(&pt->node_parts, i);
+		t->node = t->np->node;
+		t->task_id = as_random_get_uint64();
+
+		as_buffer argbuffer;
+		uint16_t n_fields = 0;
+		uint32_t predexp_sz = 0;
+		size_t size = as_scan_command_size(t->scan, t->np, &n_fields, &argbuffer, &predexp_sz);
+		t->cmd = as_command_init(size);
+		t->cmd_size = as_scan_command_init(t->cmd, t->policy, t->scan, t->task_id, pt, t->np,
+										   n_fields, &argbuffer, predexp_sz);
+	}
+
+	as_status status = AEROSPIKE_OK;
+
+	if (concurrent) {
+		uint32_t n_wait = n_units;
+		task->complete_q = cf_queue_create(sizeof(as_scan_complete_task), true);
+
+		for (uint32_t i = 0; i < n_units; i++) {
+			tasks[i].complete_q = task->complete_q;
+
+			int rc = as_thread_pool_queue_task(&cluster->thread_pool, as_scan_worker, &tasks[i]);
+
+			if (rc) {
+				// Thread could not be added. Abort entire scan.
+				if (as_fas_uint32(task->error_mutex, 1) == 0) {
+					status = as_error_update(task->err, AEROSPIKE_ERR_CLIENT, "Failed to add scan thread: %d", rc);
+				}
+
+				// Reset unit count to threads that were run.
+				n_wait = i;
+				break;
+			}
+		}
+
+		// Wait for tasks to complete.
+		for (uint32_t i = 0; i < n_wait; i++) {
+			as_scan_complete_task complete;
+			cf_queue_pop(task->complete_q, &complete, CF_QUEUE_FOREVER);
+
+			if (complete.result != AEROSPIKE_OK && status == AEROSPIKE_OK) {
+				status = complete.result;
+			}
+		}
+
+		cf_queue_destroy(task->complete_q);
+		task->complete_q = 0;
+	}
+	else {
+		// Run work units in series.
+		for (uint32_t i = 0; i < n_units && status == AEROSPIKE_OK; i++) {
+			status = as_scan_partition_command_execute(&tasks[i]);
+		}
+	}
+
+	for (uint32_t i = 0; i < n_units; i++) {
+		as_command_free(tasks[i].cmd, tasks[i].cmd_size);
+	}
+	cf_free(tasks);
+	return status;
+}
+
+static as_status
+as_scan_partitions(
+	aerospike* as, as_error* err, const as_policy_scan* policy, const as_scan* scan,
+	as_partition_filter* pf, aerospike_scan_foreach_callback callback, void* udata
+	)
+{
+	as_cluster* cluster = as->cluster;
+	as_nodes* nodes = as_nodes_reserve(cluster);
+	uint32_t n_nodes = nodes->size;
+
+	if (n_nodes == 0) {
+		as_nodes_release(nodes);
+		return as_error_set_message(err, AEROSPIKE_ERR_SERVER, "Scan command failed because cluster is empty.");
+	}
+
+	for (uint32_t i = 0; i < n_nodes; i++) {
+		as_node* node = nodes->array[i];
+
+		if (! (node->features & AS_FEATURES_PARTITION_SCAN)) {
+			as_status status = as_error_update(err, AEROSPIKE_ERR_UNSUPPORTED_FEATURE,
+											   "Node %s does not support partition scans", node->name);
+			as_nodes_release(nodes);
+			return status;
+		}
+	}
+	as_nodes_release(nodes);
+
+	// Split partitions into enough work units to keep the scan thread pool busy.
+	uint32_t max_units = n_nodes;
+
+	if (scan->concurrent && cluster->thread_pool.thread_size > max_units) {
+		max_units = cluster->thread_pool.thread_size;
+	}
+
+	as_partition_tracker pt;
+	as_status status = as_partition_tracker_init(&pt, err, cluster, &policy->base, pf, max_units);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	uint32_t error_mutex = 0;
+	as_scan_task task;
+	task.node = NULL;
+	task.cluster = cluster;
+	task.policy = policy;
+	task.scan = scan;
+	task.callback = callback;
+	task.udata = udata;
+	task.err = err;
+	task.complete_q = 0;
+	task.error_mutex = &error_mutex;
+	task.pt = &pt;
+	task.np = NULL;
+	task.task_id = 0;
+	task.cluster_key = 0;
+	task.cmd = NULL;
+	task.cmd_size = 0;
+	task.first = true;
+
+	while (true) {
+		status = as_partition_tracker_assign(&pt, err, cluster, scan->ns);
+
+		if (status != AEROSPIKE_OK) {
+			break;
+		}
+
+		status = as_scan_partition_execute(cluster, &pt, &task, scan->concurrent);
+		as_partition_tracker_release(&pt);
+
+		if (status != AEROSPIKE_OK) {
+			break;
+		}
+
+		if (as_partition_tracker_is_complete(&pt, err)) {
+			break;
+		}
+
+		if (err->code != AEROSPIKE_OK) {
+			status = err->code;
+			break;
+		}
+
+		if (pt.sleep_between_retries > 0) {
+			as_sleep(pt.sleep_between_retries);
+		}
+	}
+	as_partition_tracker_destroy(&pt);
+
+	// If user aborts scan, command is considered successful.
+	if (status == AEROSPIKE_ERR_CLIENT_ABORT) {
+		status = AEROSPIKE_OK;
+	}
+
+	// If completely successful, make the callback that signals completion.
+	if (callback && status == AEROSPIKE_OK) {
+		callback(NULL, udata);
+	}
+	return status;
+}
+
 static as_status
 as_scan_async(
 	aerospike* as, as_error* err, const as_policy_scan* policy, const as_scan* scan, uint64_t* scan_id,
@@ -685,9 +1004,9 @@ as_scan_async(
 	as_buffer argbuffer;
 	uint16_t n_fields = 0;
 	uint32_t predexp_sz = 0;
-	size_t size = as_scan_command_size(scan, &n_fields, &argbuffer, &predexp_sz);
+	size_t size = as_scan_command_size(scan, NULL, &n_fields, &argbuffer, &predexp_sz);
 	uint8_t* cmd_buf = as_command_init(size);
-	size = as_scan_command_init(cmd_buf, policy, scan, task_id, n_fields, &argbuffer, predexp_sz);
+	size = as_scan_command_init(cmd_buf, policy, scan, task_id, NULL, NULL, n_fields, &argbuffer, predexp_sz);
 	
 	// Allocate enough memory to cover, then, round up memory size in 8KB increments to allow socket
 	// read to reuse buffer.
@@ -709,12 +1028,14 @@ as_scan_async(
 		cmd->parse_results = as_scan_parse_records_async;
 		cmd->pipe_listener = NULL;
 		cmd->buf = ((as_async_scan_command*)cmd)->space;
+		cmd->iov = NULL;
 		cmd->write_len = (uint32_t)size;
 		cmd->read_capacity = (uint32_t)(s - size - sizeof(as_async_scan_command));
 		cmd->type = AS_ASYNC_TYPE_SCAN;
 		cmd->state = AS_ASYNC_STATE_UNREGISTERED;
 		cmd->flags = AS_ASYNC_FLAGS_MASTER;
 		cmd->deserialize = scan->deserialize_list_map;
+		cmd->borrow = policy->borrow_bins;
 		memcpy(cmd->buf, cmd_buf, size);
 		exec->commands[i] = cmd;
 	}
@@ -835,9 +1156,9 @@ aerospike_scan_node(
 	as_buffer argbuffer;
 	uint16_t n_fields = 0;
 	uint32_t predexp_sz = 0;
-	size_t size = as_scan_command_size(scan, &n_fields, &argbuffer, &predexp_sz);
+	size_t size = as_scan_command_size(scan, NULL, &n_fields, &argbuffer, &predexp_sz);
 	uint8_t* cmd = as_command_init(size);
-	size = as_scan_command_init(cmd, policy, scan, task_id, n_fields, &argbuffer, predexp_sz);
+	size = as_scan_command_init(cmd, policy, scan, task_id, NULL, NULL, n_fields, &argbuffer, predexp_sz);
 	
 	// Initialize task.
 	uint32_t error_mutex = 0;
@@ -851,6 +1172,8 @@ aerospike_scan_node(
 	task.err = err;
 	task.complete_q = 0;
 	task.error_mutex = &error_mutex;
+	task.pt = NULL;
+	task.np = NULL;
 	task.task_id = task_id;
 	task.cluster_key = cluster_key;
 	task.cmd = cmd;
@@ -873,6 +1196,20 @@ aerospike_scan_node(
 	return status;
 }
 
+as_status
+aerospike_scan_partitions(
+	aerospike* as, as_error* err, const as_policy_scan* policy, const as_scan* scan,
+	as_partition_filter* pf, aerospike_scan_foreach_callback callback, void* udata
+	)
+{
+	as_error_reset(err);
+
+	if (! policy) {
+		policy = &as->config.policies.scan;
+	}
+	return as_scan_partitions(as, err, policy, scan, pf, callback, udata);
+}
+
 as_status
 aerospike_scan_async(
 	aerospike* as, as_error* err, const as_policy_scan* policy, const as_scan* scan, uint64_t* scan_id,
@@ -34,6 +34,8 @@ as_sum_init(as_conn_stats* stats)
 {
 	stats->in_pool = 0;
 	stats->in_use = 0;
+	stats->opened = 0;
+	stats->closed = 0;
 }
 
 static inline void
@@ -53,6 +55,25 @@ as_sum_no_lock(as_conn_pool* pool, as_conn_stats* stats)
 		tmp = 0;
 	}
 	stats->in_use += tmp;
+	stats->opened += pool->opened;
+	stats->closed += pool->closed;
+}
+
+static void
+as_metrics_copy(as_node_metrics* src, as_node_metrics* trg, bool reset)
+{
+	// Metrics are a flat array of counters.
+	uint64_t* s = (uint64_t*)src;
+	uint64_t* t = (uint64_t*)trg;
+	uint32_t max = sizeof(as_node_metrics) / sizeof(uint64_t);
+
+	for (uint32_t i = 0; i < max; i++) {
+		uint64_t v = reset ? as_fas_uint64(&s[i], 0) : as_load_uint64(&s[i]);
+
+		if (t) {
+			t[i] = v;
+		}
+	}
 }
 
 /******************************************************************************
@@ -72,6 +93,10 @@ aerospike_cluster_stats(as_cluster* cluster, as_cluster_stats* stats)
 
 	// cf_queue applies locks, so we are safe here.
 	stats->thread_pool_queued_tasks = cf_queue_sz(cluster->thread_pool.dispatch_queue);
+	stats->tend_duration = as_load_uint64(&cluster->tend_duration);
+	stats->tend_count = as_load_uint64(&cluster->tend_count);
+	as_compress_stats_copy(&cluster->compress_stats, &stats->compress, false);
+	as_compress_stats_copy(&cluster->inflate_stats, &stats->inflate, false);
 	as_nodes_release(nodes);
 }
 
@@ -96,6 +121,8 @@ aerospike_node_stats(as_node* node, as_node_stats* stats)
 	as_sum_init(&stats->sync);
 	as_sum_init(&stats->async);
 	as_sum_init(&stats->pipeline);
+	stats->conn_cache_hits = 0;
+	stats->conn_cache_misses = 0;
 
 	uint32_t max = node->cluster->conn_pools_per_node;
 
@@ -103,11 +130,32 @@ aerospike_node_stats(as_node* node, as_node_stats* stats)
 	for (uint32_t i = 0; i < max; i++) {
 		as_conn_pool_lock* pool_lock = &node->conn_pool_locks[i];
 
+		// Connections in lock-free cache are counted in pool total.
+		uint32_t in_cache = 0;
+
+		for (uint32_t j = 0; j < pool_lock->cache_size; j++) {
+			as_conn_cache_slot* slot = &pool_lock->cache[j];
+
+			if (as_load_uint32(&slot->state) == AS_CONN_CACHE_FULL) {
+				in_cache++;
+			}
+		}
+		stats->conn_cache_hits += as_load_uint64(&pool_lock->cache_hits);
+		stats->conn_cache_misses += as_load_uint64(&pool_lock->cache_misses);
+
 		pthread_mutex_lock(&pool_lock->lock);
 		uint32_t in_pool = as_queue_size(&pool_lock->pool.queue);
 		uint32_t total = pool_lock->pool.total;
+		stats->sync.opened += pool_lock->pool.opened;
+		stats->sync.closed += pool_lock->pool.closed;
 		pthread_mutex_unlock(&pool_lock->lock);
 
+		in_pool += in_cache;
+
+		// Timing issues may cause cache count to exceed total. Adjust.
+		if (in_pool > total) {
+			in_pool = total;
+		}
 		stats->sync.in_pool += in_pool;
 		stats->sync.in_use += total - in_pool;
 	}
@@ -122,5 +170,27 @@ aerospike_node_stats(as_node* node, as_node_stats* stats)
 			as_sum_no_lock(&node->pipe_conn_pools[i], &stats->pipeline);
 		}
 	}
+
+	// Command metrics snapshot.
+	as_metrics_copy(&node->metrics, &stats->metrics, false);
 }
 
+void
+aerospike_node_metrics_reset(as_node* node, as_node_metrics* metrics)
+{
+	as_metrics_copy(&node->metrics, metrics, true);
+}
+
+void
+aerospike_cluster_metrics_reset(as_cluster* cluster)
+{
+	as_nodes* nodes = as_nodes_reserve(cluster);
+
+	for (uint32_t i = 0; i < nodes->size; i++) {
+		aerospike_node_metrics_reset(nodes->array[i], NULL);
+	}
+	as_nodes_release(nodes);
+
+	as_compress_stats_copy(&cluster->compress_stats, NULL, true);
+	as_compress_stats_copy(&cluster->inflate_stats, NULL, true);
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2008-2018 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_arena.h>
+#include <citrusleaf/alloc.h>
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+void*
+as_arena_alloc(as_arena* arena, size_t size)
+{
+	size = (size + 7) & ~(size_t)7;
+
+	as_arena_block* head = arena->head;
+
+	if (head && head->capacity - head->used >= size) {
+		void* p = head->data + head->used;
+		head->used += (uint32_t)size;
+		return p;
+	}
+
+	if (size > AS_ARENA_BLOCK_SIZE / 4) {
+		// Large allocations get their own block, so the current block can still
+		// be used for small allocations.
+		as_arena_block* block = cf_malloc(sizeof(as_arena_block) + size);
+		block->capacity = (uint32_t)size;
+		block->used = (uint32_t)size;
+
+		if (head) {
+			block->next = head->next;
+			head->next = block;
+		}
+		else {
+			block->next = NULL;
+			arena->head = block;
+		}
+		return block->data;
+	}
+
+	as_arena_block* block = cf_malloc(sizeof(as_arena_block) + AS_ARENA_BLOCK_SIZE);
+	block->next = head;
+	block->capacity = AS_ARENA_BLOCK_SIZE;
+	block->used = (uint32_t)size;
+	arena->head = block;
+	return block->data;
+}
+
+void
+as_arena_move(as_arena* dst, as_arena* src)
+{
+	as_arena_block* head = src->head;
+
+	if (! head) {
+		return;
+	}
+
+	// Append dst blocks after the last src block so the src head remains
+	// available for further allocations.
+	as_arena_block* tail = head;
+
+	while (tail->next) {
+		tail = tail->next;
+	}
+	tail->next = dst->head;
+	dst->head = head;
+	src->head = NULL;
+}
+
+void
+as_arena_destroy(as_arena* arena)
+{
+	as_arena_block* block = arena->head;
+
+	while (block) {
+		as_arena_block* next = block->next;
+		cf_free(block);
+		block = next;
+	}
+	arena->head = NULL;
+}
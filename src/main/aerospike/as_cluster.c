@@ -44,14 +44,14 @@ uint32_t as_cluster_count = 0;
  * Function declarations
  *****************************************************************************/
 
-as_status
-as_node_refresh(as_cluster* cluster, as_error* err, as_node* node, as_peers* peers);
+void
+as_node_refresh(as_cluster* cluster, as_node_tend* tends, uint32_t n_tends, as_peers* peers);
 
-as_status
-as_node_refresh_peers(as_cluster* cluster, as_error* err, as_node* node, as_peers* peers);
+void
+as_node_refresh_peers(as_cluster* cluster, as_node_tend* tends, uint32_t n_tends, as_peers* peers);
 
-as_status
-as_node_refresh_partitions(as_cluster* cluster, as_error* err, as_node* node, as_peers* peers);
+void
+as_node_refresh_partitions(as_cluster* cluster, as_node_tend* tends, uint32_t n_tends, as_peers* peers);
 
 /******************************************************************************
  * Functions
@@ -474,8 +474,8 @@ as_cluster_gc(as_vector* /* <as_gc_item> */ vector)
 /**
  * Check health of all nodes in the cluster.
  */
-as_status
-as_cluster_tend(as_cluster* cluster, as_error* err, bool enable_seed_warnings)
+static as_status
+as_cluster_tend_nodes(as_cluster* cluster, as_error* err, bool enable_seed_warnings)
 {
 	// All node additions/deletions are performed in tend thread.
 	// Garbage collect data structures released in previous tend.
@@ -522,28 +522,37 @@ as_cluster_tend(as_cluster* cluster, as_error* err, bool enable_seed_warnings)
 		}
 	}
 	
-	// Refresh all known nodes.
-	as_error error_local;
+	// Refresh all known nodes.  Info requests are sent to all nodes at once, so an
+	// unresponsive node does not delay the refresh of other nodes.
+	as_node_tend* tends = cf_malloc(sizeof(as_node_tend) * nodes->size);
+	uint32_t n_tends = 0;
 	uint32_t refresh_count = 0;
 	
 	for (uint32_t i = 0; i < nodes->size; i++) {
 		as_node* node = nodes->array[i];
 		
 		if (node->active) {
-			as_status status = as_node_refresh(cluster, &error_local, node, &peers);
-			
-			if (status == AEROSPIKE_OK) {
-				node->failures = 0;
-				refresh_count++;
-			}
-			else {
-				// Use info level so aql doesn't see message by default.
-				as_log_info("Node %s refresh failed: %s %s", node->name, as_error_string(status), error_local.message);
-				if (peers.use_peers) {
-					peers.gen_changed = true;
-				}
-				node->failures++;
+			tends[n_tends++].node = node;
+		}
+	}
+
+	as_node_refresh(cluster, tends, n_tends, &peers);
+
+	for (uint32_t i = 0; i < n_tends; i++) {
+		as_node_tend* tend = &tends[i];
+		as_node* node = tend->node;
+
+		if (tend->status == AEROSPIKE_OK) {
+			node->failures = 0;
+			refresh_count++;
+		}
+		else {
+			// Use info level so aql doesn't see message by default.
+			as_log_info("Node %s refresh failed: %s %s", node->name, as_error_string(tend->status), tend->err.message);
+			if (peers.use_peers) {
+				peers.gen_changed = true;
 			}
+			node->failures++;
 		}
 	}
 	
@@ -551,25 +560,35 @@ as_cluster_tend(as_cluster* cluster, as_error* err, bool enable_seed_warnings)
 	if (peers.gen_changed) {
 		// Refresh peers for all nodes that responded the first time even if only one node's peers changed.
 		refresh_count = 0;
+		n_tends = 0;
 
 		for (uint32_t i = 0; i < nodes->size; i++) {
 			as_node* node = nodes->array[i];
 			
 			if (node->failures == 0 && node->active) {
-				as_status status = as_node_refresh_peers(cluster, &error_local, node, &peers);
-				
-				if (status == AEROSPIKE_OK) {
-					refresh_count++;
-				}
-				else {
-					as_log_warn("Node %s peers refresh failed: %s %s", node->name, as_error_string(status), error_local.message);
-					node->failures++;
-				}
+				tends[n_tends++].node = node;
+			}
+		}
+
+		as_node_refresh_peers(cluster, tends, n_tends, &peers);
+
+		for (uint32_t i = 0; i < n_tends; i++) {
+			as_node_tend* tend = &tends[i];
+			as_node* node = tend->node;
+
+			if (tend->status == AEROSPIKE_OK) {
+				refresh_count++;
+			}
+			else {
+				as_log_warn("Node %s peers refresh failed: %s %s", node->name, as_error_string(tend->status), tend->err.message);
+				node->failures++;
 			}
 		}
 	}
 	
 	// Refresh partition map when necessary.
+	n_tends = 0;
+
 	for (uint32_t i = 0; i < nodes->size; i++) {
 		as_node* node = nodes->array[i];
 		
@@ -577,14 +596,30 @@ as_cluster_tend(as_cluster* cluster, as_error* err, bool enable_seed_warnings)
 		// Unchecked, such a node can dominate the partition map and cause all other
 		// nodes to be dropped.
 		if (node->partition_changed && node->failures == 0 && node->active && (node->peers_count > 0 || refresh_count == 1)) {
-			as_status status = as_node_refresh_partitions(cluster, &error_local, node, &peers);
-			
-			if (status != AEROSPIKE_OK) {
-				as_log_warn("Node %s partition refresh failed: %s %s", node->name, as_error_string(status), error_local.message);
-				node->failures++;
+			tends[n_tends++].node = node;
+		}
+	}
+
+	if (n_tends > 0) {
+		as_node_refresh_partitions(cluster, tends, n_tends, &peers);
+
+		for (uint32_t i = 0; i < n_tends; i++) {
+			as_node_tend* tend = &tends[i];
+
+			if (tend->status != AEROSPIKE_OK) {
+				as_log_warn("Node %s partition refresh failed: %s %s", tend->node->name, as_error_string(tend->status), tend->err.message);
+				tend->node->failures++;
 			}
 		}
 	}
+	cf_free(tends);
+
+	if (cluster->skip_conn_validation) {
+		// Commands do not peek pooled connections, so discard dead idle connections here.
+		for (uint32_t i = 0; i < nodes->size; i++) {
+			as_node_validate_connections(nodes->array[i]);
+		}
+	}
 
 	if (peers.gen_changed || ! peers.use_peers) {
 		// Handle nodes changes determined from refreshes.
@@ -616,6 +651,20 @@ as_cluster_tend(as_cluster* cluster, as_error* err, bool enable_seed_warnings)
 	return AEROSPIKE_OK;
 }
 
+/**
+ * Tend cluster and record tend duration.
+ */
+as_status
+as_cluster_tend(as_cluster* cluster, as_error* err, bool enable_seed_warnings)
+{
+	uint64_t begin = cf_getus();
+	as_status status = as_cluster_tend_nodes(cluster, err, enable_seed_warnings);
+
+	as_store_uint64(&cluster->tend_duration, cf_getus() - begin);
+	as_incr_uint64(&cluster->tend_count);
+	return status;
+}
+
 /**
  * Tend the cluster until it has stabilized and return control.
  * This helps avoid initial database request timeout issues when
@@ -1014,7 +1063,9 @@ as_cluster_create(as_config* config, as_error* err, as_cluster** cluster_out)
 	cluster->async_max_conns_per_node = config->async_max_conns_per_node;
 	cluster->pipe_max_conns_per_node = config->pipe_max_conns_per_node;;
 	cluster->conn_pools_per_node = config->conn_pools_per_node;
+	cluster->conn_cache_size = (config->conn_cache_size > 256) ? 256 : config->conn_cache_size;
 	cluster->use_services_alternate = config->use_services_alternate;
+	cluster->skip_conn_validation = config->skip_conn_validation;
 
 	// Initialize seed hosts.  Round initial capacity up to multiple of 16.
 	as_vector* src = config->hosts;
@@ -16,10 +16,12 @@
  */
 #include <aerospike/as_command.h>
 #include <aerospike/as_cluster.h>
+#include <aerospike/as_compress.h>
 #include <aerospike/as_event.h>
 #include <aerospike/as_key.h>
 #include <aerospike/as_log_macros.h>
 #include <aerospike/as_msgpack.h>
+#include <aerospike/as_poll.h>
 #include <aerospike/as_record.h>
 #include <aerospike/as_serializer.h>
 #include <aerospike/as_sleep.h>
@@ -35,7 +37,7 @@
  * FUNCTIONS
  *****************************************************************************/
 
-static size_t
+size_t
 as_command_user_key_size(const as_key* key)
 {
 	size_t size = AS_FIELD_HEADER_SIZE + 1;  // Add 1 for key's value type.
@@ -128,6 +130,47 @@ as_command_value_size(as_val* val, as_buffer* buffer)
 	}
 }
 
+size_t
+as_command_operate_set_attr(const as_operations* ops, as_buffer* buffers, uint8_t* rattr, uint8_t* wattr)
+{
+	size_t size = 0;
+	uint32_t n_operations = ops->binops.size;
+	uint8_t read_attr = 0;
+	uint8_t write_attr = 0;
+	bool respond_all_ops = false;
+	
+	for (uint32_t i = 0; i < n_operations; i++) {
+		as_binop* op = &ops->binops.entries[i];
+		
+		switch (op->op)	{
+			case AS_OPERATOR_MAP_READ:
+				// Map operations require respond_all_ops to be true.
+				respond_all_ops = true;
+				// Fall through to read.
+			case AS_OPERATOR_CDT_READ:
+			case AS_OPERATOR_READ:
+				read_attr |= AS_MSG_INFO1_READ;
+				break;
+				
+			case AS_OPERATOR_MAP_MODIFY:
+				// Map operations require respond_all_ops to be true.
+				respond_all_ops = true;
+				// Fall through to write.
+			default:
+				write_attr |= AS_MSG_INFO2_WRITE;
+				break;
+		}
+		size += as_command_bin_size(&op->bin, &buffers[i]);
+	}
+	
+	if (respond_all_ops) {
+		write_attr |= AS_MSG_INFO2_RESPOND_ALL_OPS;
+	}
+	*rattr = read_attr;
+	*wattr = write_attr;
+	return size;
+}
+
 uint8_t*
 as_command_write_header(uint8_t* cmd, uint8_t read_attr, uint8_t write_attr,
 	as_policy_commit_level commit_level, as_policy_consistency_level consistency,
@@ -209,7 +252,7 @@ as_command_write_header(uint8_t* cmd, uint8_t read_attr, uint8_t write_attr,
 	return cmd + AS_HEADER_SIZE;
 }
 
-static uint8_t*
+uint8_t*
 as_command_write_user_key(uint8_t* begin, const as_key* key)
 {
 	uint8_t* p = begin + AS_FIELD_HEADER_SIZE;
@@ -382,6 +425,15 @@ as_command_write_bin(uint8_t* begin, uint8_t operation_type, const as_bin* bin,
 			break;
 		}
 	}
+	// Map operations are sent as generic CDT operations.  The operations themselves
+	// are not modified, so they can be encoded more than once.
+	if (operation_type == AS_OPERATOR_MAP_READ) {
+		operation_type = AS_OPERATOR_CDT_READ;
+	}
+	else if (operation_type == AS_OPERATOR_MAP_MODIFY) {
+		operation_type = AS_OPERATOR_CDT_MODIFY;
+	}
+
 	*(uint32_t*)begin = cf_swap_to_be32(name_len + val_len + 4);
 	begin += 4;
 	*begin++ = operation_type;
@@ -391,6 +443,116 @@ as_command_write_bin(uint8_t* begin, uint8_t operation_type, const as_bin* bin,
 	return p;
 }
 
+size_t
+as_command_zero_copy_size(const as_bin* bin, bool retain)
+{
+	as_val* val = (as_val*)bin->valuep;
+	size_t size;
+	bool owned;
+
+	switch (val->type) {
+		case AS_STRING: {
+			as_string* v = as_string_fromval(val);
+			size = v->len;
+			owned = v->free;
+			break;
+		}
+		case AS_BYTES: {
+			as_bytes* v = as_bytes_fromval(val);
+			size = v->size;
+			owned = v->free;
+			break;
+		}
+		default:
+			return 0;
+	}
+
+	if (size < AS_COMMAND_ZERO_COPY_MIN) {
+		return 0;
+	}
+
+	// Retained values are reserved by the command.  The value and its data must both
+	// be heap allocated, so they survive the caller destroying its record.
+	if (retain && ! (val->free && owned)) {
+		return 0;
+	}
+	return size;
+}
+
+static inline void
+as_command_iov_add(as_command_iov* ci, void* buf, size_t len)
+{
+	ci->iov[ci->n_iov].iov_base = buf;
+	ci->iov[ci->n_iov].iov_len = len;
+	ci->n_iov++;
+	ci->len += len;
+}
+
+uint8_t*
+as_command_write_bin_iov(
+	as_command_iov* ci, uint8_t* begin, uint8_t operation_type, const as_bin* bin, as_buffer* buffer
+	)
+{
+	size_t size = as_command_zero_copy_size(bin, ci->vals != NULL);
+
+	if (size == 0) {
+		return as_command_write_bin(begin, operation_type, bin, buffer);
+	}
+
+	uint8_t* p = begin + AS_OPERATION_HEADER_SIZE;
+	const char* name = bin->name;
+
+	// Copy string, but do not transfer null byte.
+	while (*name) {
+		*p++ = *name++;
+	}
+	uint8_t name_len = (uint8_t)(p - begin - AS_OPERATION_HEADER_SIZE);
+	as_val* val = (as_val*)bin->valuep;
+	uint8_t* value;
+	uint8_t val_type;
+
+	if (val->type == AS_STRING) {
+		value = (uint8_t*)as_string_fromval(val)->value;
+		val_type = AS_BYTES_STRING;
+	}
+	else {
+		as_bytes* v = as_bytes_fromval(val);
+		value = v->value;
+		val_type = v->type;
+	}
+
+	*(uint32_t*)begin = cf_swap_to_be32(name_len + (uint32_t)size + 4);
+	begin += 4;
+	*begin++ = operation_type;
+	*begin++ = val_type;
+	*begin++ = 0;
+	*begin++ = name_len;
+
+	// Close current scratch segment, reference value and resume scratch after bin name.
+	as_command_iov_add(ci, ci->begin, p - ci->begin);
+	as_command_iov_add(ci, value, size);
+
+	if (ci->vals) {
+		ci->vals[ci->n_vals++] = as_val_reserve(val);
+	}
+	ci->begin = p;
+	return p;
+}
+
+size_t
+as_command_iov_end(as_command_iov* ci, uint8_t* end)
+{
+	if (end > ci->begin) {
+		as_command_iov_add(ci, ci->begin, end - ci->begin);
+		ci->begin = end;
+	}
+
+	uint64_t len = ci->len;
+	uint64_t proto = (len - 8) | ((uint64_t)AS_MESSAGE_VERSION << 56) | ((uint64_t)AS_MESSAGE_TYPE << 48);
+	*(uint64_t*)ci->iov[0].iov_base = cf_swap_to_be64(proto);
+	return ci->len;
+}
+
 size_t
 as_command_compress_max_size(size_t cmd_sz)
 {
@@ -398,11 +560,15 @@ as_command_compress_max_size(size_t cmd_sz)
 }
 
 as_status
-as_command_compress(as_error* err, uint8_t* cmd, size_t cmd_sz, uint8_t* compressed_cmd, size_t* compressed_size)
+as_command_compress(
+	as_cluster* cluster, as_error* err, uint8_t* cmd, size_t cmd_sz, uint8_t* compressed_cmd,
+	size_t* compressed_size, int level
+	)
 {
+	uint64_t begin = cf_getus();
 	*compressed_size -= sizeof(as_compressed_proto);
-	int ret_val = compress2(compressed_cmd + sizeof(as_compressed_proto), (uLongf*)compressed_size,
-							cmd, (uLong)cmd_sz, Z_DEFAULT_COMPRESSION);
+	int ret_val = as_compress_deflate(compressed_cmd + sizeof(as_compressed_proto), compressed_size,
+									  cmd, cmd_sz, level);
 	
 	if (ret_val) {
 		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Compress failed: %d", ret_val);
@@ -414,7 +580,300 @@ as_command_compress(as_error* err, uint8_t* cmd, size_t cmd_sz, uint8_t* compres
 	
 	// Adjust the compressed size to include the header size
 	*compressed_size += sizeof(as_compressed_proto);
+	as_compress_stats_add(&cluster->compress_stats, cmd_sz, *compressed_size, begin);
+	return AEROSPIKE_OK;
+}
+
+as_status
+as_command_inflate(
+	as_cluster* cluster, as_error* err, const uint8_t* body, size_t body_len, uint8_t* out,
+	size_t out_len
+	)
+{
+	if (body_len < sizeof(uint64_t) || as_command_compressed_size(body) != out_len) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Invalid compressed proto size: %zu", body_len);
+	}
+
+	uint64_t begin = cf_getus();
+	size_t len = out_len;
+	int ret_val = as_compress_inflate(out, &len, body + sizeof(uint64_t), body_len - sizeof(uint64_t));
+
+	if (ret_val != Z_OK || len != out_len) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Inflate failed: %d", ret_val);
+	}
+
+	as_compress_stats_add(&cluster->inflate_stats, out_len, body_len, begin);
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_command_read_inflate(
+	as_error* err, as_socket* sock, as_node* node, size_t size, uint32_t socket_timeout,
+	uint64_t deadline_ms
+	)
+{
+	// Compressed proto body: uncompressed size(8) followed by the zlib stream.
+	if (size < sizeof(uint64_t)) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Invalid compressed proto size: %zu", size);
+	}
+
+	uint8_t usize_buf[sizeof(uint64_t)];
+	as_status status = as_socket_read_deadline(err, sock, node, usize_buf, sizeof(usize_buf),
+		socket_timeout, deadline_ms);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	uint64_t usize = as_command_compressed_size(usize_buf);
+
+	if (usize < sizeof(as_proto) || usize > UINT32_MAX) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Invalid uncompressed proto size: %" PRIu64,
+			usize);
+	}
+
+	// The thread's inflate stream is reused, so inflate state is not allocated per response.
+	z_stream* strm = as_compress_inflater();
+
+	if (! strm) {
+		return as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "Inflate init failed");
+	}
+
+	uint64_t begin = cf_getus();
+	size_t zip_bytes = size;
+	int ret_val = Z_OK;
+
+	strm->next_out = as_socket_zbuf_prepare(sock, (uint32_t)usize);
+	strm->avail_out = (uInt)usize;
+	size -= sizeof(uint64_t);
+
+	while (size > 0) {
+		// Inflate each chunk as it is received instead of buffering the whole block.
+		size_t len = (size < AS_SOCKET_RBUF_SIZE)? size : AS_SOCKET_RBUF_SIZE;
+		uint8_t* in;
+
+		status = as_socket_read_view(err, sock, node, len, socket_timeout, deadline_ms, &in);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+
+		strm->next_in = in;
+		strm->avail_in = (uInt)len;
+		ret_val = inflate(strm, Z_NO_FLUSH);
+		size -= len;
+
+		if (ret_val != Z_OK) {
+			break;
+		}
+	}
+
+	if (ret_val != Z_STREAM_END || size > 0 || strm->total_out != usize) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Inflate failed: %d", ret_val);
+	}
+
+	sock->zbuf_len = (uint32_t)usize;
+	as_compress_stats_add(&node->cluster->inflate_stats, usize, zip_bytes, begin);
+	return AEROSPIKE_OK;
+}
+
+as_status
+as_command_read_proto(
+	as_error* err, as_socket* sock, as_node* node, uint8_t* buf, size_t len,
+	uint32_t socket_timeout, uint64_t deadline_ms
+	)
+{
+	as_status status = as_socket_read_deadline(err, sock, node, buf, sizeof(as_proto), socket_timeout,
+		deadline_ms);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	as_proto* proto = (as_proto*)buf;
+
+	if (proto->type == AS_COMPRESSED_MESSAGE_TYPE) {
+		if (sock->zbuf_offset != sock->zbuf_len) {
+			return as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "Nested compressed proto");
+		}
+
+		as_proto_swap_from_be(proto);
+		status = as_command_read_inflate(err, sock, node, proto->sz, socket_timeout, deadline_ms);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+
+		// Read uncompressed proto header from the inflated buffer.
+		status = as_socket_read_deadline(err, sock, node, buf, sizeof(as_proto), socket_timeout,
+			deadline_ms);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+	}
+
+	if (len > sizeof(as_proto)) {
+		status = as_socket_read_deadline(err, sock, node, buf + sizeof(as_proto),
+			len - sizeof(as_proto), socket_timeout, deadline_ms);
+	}
+	return status;
+}
+
+static inline void
+as_command_set_in_doubt(as_error* err, as_node* node, bool is_read, uint32_t command_sent_counter)
+{
+	as_error_set_in_doubt(err, is_read, command_sent_counter);
+
+	if (err->in_doubt) {
+		as_incr_uint64(&node->metrics.in_doubt_writes);
+	}
+}
+
+static inline uint32_t
+as_command_wait_timeout(uint32_t timeout, uint64_t deadline_ms)
+{
+	if (deadline_ms > 0) {
+		uint64_t now = cf_getms();
+
+		if (now >= deadline_ms) {
+			return 0;
+		}
+
+		uint64_t remaining = deadline_ms - now;
+
+		if (timeout == 0 || remaining < timeout) {
+			timeout = (uint32_t)remaining;
+		}
+	}
+	return timeout;
+}
+
+static as_status
+as_command_hedge(
+	as_cluster* cluster, as_error* err, as_command_node* cn, bool master, as_iovec* iov,
+	uint32_t n_iov, uint32_t socket_timeout, uint64_t deadline_ms, as_node** node,
+	bool* release_node, as_socket* socket
+	)
+{
+	// TLS sockets may already have buffered data, so select() is not a reliable
+	// indicator of an arriving response.
+	if (socket->ctx) {
+		return AEROSPIKE_OK;
+	}
+
+	uint32_t hedge_delay = cn->hedge_delay;
+
+	if (socket_timeout > 0 && hedge_delay >= socket_timeout) {
+		// Attempt would time out before hedge is sent.
+		return AEROSPIKE_OK;
+	}
+
+	if (as_command_wait_timeout(hedge_delay, deadline_ms) < hedge_delay) {
+		// Command would time out before hedge is sent.
+		return AEROSPIKE_OK;
+	}
+
+	as_poll poll;
+	as_poll_init(&poll, socket->fd);
+	int rv = as_poll_socket(&poll, socket->fd, hedge_delay, true);
+	as_poll_destroy(&poll);
+
+	if (rv != 0) {
+		// Response has started to arrive or an error occurred.  Let parser handle it.
+		return AEROSPIKE_OK;
+	}
+
+	// Response is late.  Send same command to alternate node.
+	as_error hedge_err;
+	as_error_init(&hedge_err);
+
+	as_node* hedge_node;
+	bool release_hedge;
+
+	if (cn->node) {
+		hedge_node = cn->hedge_node;
+		release_hedge = false;
+
+		if (! hedge_node) {
+			return AEROSPIKE_OK;
+		}
+	}
+	else {
+		if (as_cluster_get_node(cluster, &hedge_err, cn->ns, cn->digest, cn->replica, !master,
+								&hedge_node)) {
+			return AEROSPIKE_OK;
+		}
+		release_hedge = true;
+	}
+
+	as_socket hedge_socket;
+	as_status status = AEROSPIKE_OK;
+
+	if (hedge_node == *node ||
+		as_node_get_connection(&hedge_err, hedge_node, socket_timeout, deadline_ms, &hedge_socket)) {
+		goto Release;
+	}
+
+	if (hedge_socket.ctx ||
+		as_socket_writev_deadline(&hedge_err, &hedge_socket, hedge_node, iov, n_iov,
+								  socket_timeout, deadline_ms)) {
+		as_node_close_connection(&hedge_socket);
+		goto Release;
+	}
+	as_incr_uint64(&hedge_node->metrics.hedges);
+
+	// Wait for either node until the original attempt's socket timeout expires.
+	uint32_t timeout = (socket_timeout > 0)? socket_timeout - hedge_delay : 0;
+
+	if (deadline_ms > 0) {
+		timeout = as_command_wait_timeout(timeout, deadline_ms);
+	}
+
+	if (timeout == 0 && (socket_timeout > 0 || deadline_ms > 0)) {
+		rv = 0;
+	}
+	else {
+		as_socket_fd max_fd = (socket->fd > hedge_socket.fd)? socket->fd : hedge_socket.fd;
+
+		as_poll_init(&poll, max_fd);
+		rv = as_poll_sockets_read(&poll, socket->fd, hedge_socket.fd, timeout);
+		as_poll_destroy(&poll);
+	}
+
+	if (rv == 0) {
+		// Neither node responded.  Do not set error string to avoid affecting performance.
+		as_node_close_connection(&hedge_socket);
+		err->code = AEROSPIKE_ERR_TIMEOUT;
+		err->message[0] = 0;
+		status = AEROSPIKE_ERR_TIMEOUT;
+		goto Release;
+	}
+
+	if (rv < 0 || (rv & 1)) {
+		// Original node responded first or poll failed.  Continue with original node.
+		// The hedge connection has an unread response, so it can't be put back in pool.
+		as_node_close_connection(&hedge_socket);
+		goto Release;
+	}
+
+	// Hedge node responded first.  Close original connection and switch to hedge node.
+	as_log_debug("Hedge node %s responded before %s", hedge_node->name, (*node)->name);
+	as_node_close_connection(socket);
+
+	if (*release_node) {
+		as_node_release(*node);
+	}
+	*socket = hedge_socket;
+	*node = hedge_node;
+	*release_node = release_hedge;
 	return AEROSPIKE_OK;
+
+Release:
+	if (release_hedge) {
+		as_node_release(hedge_node);
+	}
+	return status;
 }
 
 as_status
@@ -423,6 +882,20 @@ as_command_execute(
 	uint8_t* command, size_t command_len, as_parse_results_fn parse_results_fn, void* parse_results_data,
 	bool is_read
 )
+{
+	as_iovec iov;
+	iov.iov_base = command;
+	iov.iov_len = command_len;
+	return as_command_execute_iov(cluster, err, policy, cn, &iov, 1, parse_results_fn,
+								  parse_results_data, is_read);
+}
+
+as_status
+as_command_execute_iov(
+	as_cluster* cluster, as_error* err, const as_policy_base* policy, as_command_node* cn,
+	as_iovec* iov, uint32_t n_iov, as_parse_results_fn parse_results_fn, void* parse_results_data,
+	bool is_read
+)
 {
 	as_node* node;
 	uint64_t deadline_ms = 0;
@@ -430,6 +903,7 @@ as_command_execute(
 	uint32_t total_timeout = policy->total_timeout;
 	uint32_t iteration = 0;
 	uint32_t command_sent_counter = 0;
+	uint64_t begin;
 	as_status status;
 	bool master = true;
 	bool release_node;
@@ -463,6 +937,8 @@ as_command_execute(
 			release_node = true;
 		}
 
+		begin = cf_getus();
+
 		as_socket socket;
 		status = as_node_get_connection(err, node, socket_timeout, deadline_ms, &socket);
 		
@@ -472,13 +948,17 @@ as_command_execute(
 		}
 		
 		// Send command.
-		status = as_socket_write_deadline(err, &socket, node, command, command_len, socket_timeout, deadline_ms);
+		status = as_socket_writev_deadline(err, &socket, node, iov, n_iov, socket_timeout, deadline_ms);
 		
 		if (status) {
 			// Socket errors are considered temporary anomalies.  Retry.
 			// Close socket to flush out possible garbage.	Do not put back in pool.
 			as_node_close_connection(&socket);
 
+			if (status == AEROSPIKE_ERR_CONNECTION && socket.unvalidated) {
+				goto Stale;
+			}
+
 			// Alternate between master and prole on socket errors or database reads.
 			// Timeouts are not a good indicator of impending data migration.
 			if (status != AEROSPIKE_ERR_TIMEOUT || is_read) {
@@ -488,10 +968,26 @@ as_command_execute(
 		}
 		command_sent_counter++;
 
+		if (cn->hedge_delay > 0 && iteration == 0) {
+			// Send read to alternate node if original node is slow to respond.
+			status = as_command_hedge(cluster, err, cn, master, iov, n_iov, socket_timeout,
+									  deadline_ms, &node, &release_node, &socket);
+
+			if (status) {
+				// Neither node responded within the socket timeout.  Hedged commands are
+				// reads, so alternate between master and prole.
+				as_node_close_connection(&socket);
+				master = !master;
+				goto Retry;
+			}
+		}
+
 		// Parse results returned by server.
 		status = parse_results_fn(err, &socket, node, socket_timeout, deadline_ms, parse_results_data);
 		
 		if (status == AEROSPIKE_OK) {
+			as_node_add_latency(node, cn->latency_type, cf_getus() - begin);
+
 			// Reset error code if retry had occurred.
 			if (iteration > 0) {
 				as_error_reset(err);
@@ -524,14 +1020,16 @@ as_command_execute(
 				case AEROSPIKE_ERR_CLIENT_ABORT:
 				case AEROSPIKE_ERR_CLIENT:
 					as_node_close_connection(&socket);
+					as_command_set_in_doubt(err, node, is_read, command_sent_counter);
 					if (release_node) {
 						as_node_release(node);
 					}
-					as_error_set_in_doubt(err, is_read, command_sent_counter);
 					return status;
 				
 				default:
-					as_error_set_in_doubt(err, is_read, command_sent_counter);
+					// Server returned an error, so the command did complete.
+					as_node_add_latency(node, cn->latency_type, cf_getus() - begin);
+					as_command_set_in_doubt(err, node, is_read, command_sent_counter);
 					break;
 			}
 		}
@@ -545,7 +1043,29 @@ as_command_execute(
 		}
 		return status;
 
+Stale:
+		// Pooled connection was used without a peek and the command write failed before
+		// any bytes were sent.  The server most likely closed it while idle and has not
+		// seen the command, so retry on another connection without counting against
+		// max_retries.  Failures after bytes were sent use the normal retry path, so
+		// writes are never resent without a retry and in_doubt accounting.
+		as_incr_uint64(&node->metrics.stale_conns);
+
+		if (deadline_ms > 0 && cf_getms() >= deadline_ms) {
+			break;
+		}
+		as_error_reset(err);
+
+		if (release_node) {
+			as_node_release(node);
+		}
+		continue;
+
 Retry:
+		if (err->code == AEROSPIKE_ERR_TIMEOUT) {
+			as_node_add_timeout(node, err);
+		}
+
 		// Check if max retries reached.
 		if (++iteration > policy->max_retries) {
 			break;
@@ -562,7 +1082,7 @@ Retry:
 			if (remaining < total_timeout) {
 				total_timeout = (uint32_t)remaining;
 				// Reset timeout in send buffer (destined for server).
-				*(uint32_t*)(command + 22) = cf_swap_to_be32(total_timeout);
+				*(uint32_t*)((uint8_t*)iov[0].iov_base + 22) = cf_swap_to_be32(total_timeout);
 
 				if (socket_timeout > total_timeout) {
 					socket_timeout = total_timeout;
@@ -571,6 +1091,8 @@ Retry:
 		}
 
 		// Prepare for retry.
+		as_incr_uint64(&node->metrics.retries);
+
 		if (release_node) {
 			as_node_release(node);
 		}
@@ -591,19 +1113,386 @@ Retry:
 			type, policy->socket_timeout, policy->total_timeout, iteration, as_node_get_address_string(node));
 	}
 
+	as_command_set_in_doubt(err, node, is_read, command_sent_counter);
+
 	if (release_node) {
 		as_node_release(node);
 	}
-	as_error_set_in_doubt(err, is_read, command_sent_counter);
 	return err->code;
 }
 
+typedef struct as_stream_buffer_s {
+	uint8_t* data;
+	size_t capacity;
+	size_t size;
+} as_stream_buffer;
+
+typedef struct as_command_stream_s {
+	pthread_mutex_t lock;
+	pthread_cond_t not_empty;
+	pthread_cond_t not_full;
+	as_stream_buffer* buffers;
+	uint32_t capacity;
+	uint32_t head;   // Next block to parse.
+	uint32_t tail;   // Next block to read.
+	uint32_t count;  // Blocks read, but not parsed.
+	as_socket* sock;
+	as_node* node;
+	uint32_t socket_timeout;
+	uint64_t deadline_ms;
+	as_error err;      // Reader error.
+	as_status status;  // Reader status.
+	bool stop_on_error;
+	bool done;  // Reader has exited.
+	bool stop;  // Parser has exited.  Reader should exit too.
+} as_command_stream;
+
+static bool
+as_command_stream_end(uint8_t* buf, size_t size, bool stop_on_error)
+{
+	// Walk message headers without swapping them.  The parser swaps them later.
+	uint8_t* p = buf;
+	uint8_t* end = buf + size;
+
+	while (p < end) {
+		as_msg* msg = (as_msg*)p;
+
+		if (msg->info3 & AS_MSG_INFO3_LAST) {
+			return true;
+		}
+
+		if (stop_on_error && msg->result_code && ! (msg->info3 & AS_MSG_INFO3_PARTITION_DONE)) {
+			return true;
+		}
+		p += sizeof(as_msg);
+		p = as_command_ignore_fields(p, cf_swap_from_be16(msg->n_fields));
+		p = as_command_ignore_bins(p, cf_swap_from_be16(msg->n_ops));
+	}
+	return false;
+}
+
+static void
+as_command_stream_read(as_command_stream* s)
+{
+	as_status status = AEROSPIKE_OK;
+
+	while (true) {
+		// Wait for a free buffer.  The server is paced by the parser here.
+		pthread_mutex_lock(&s->lock);
+
+		while (s->count == s->capacity && ! s->stop) {
+			pthread_cond_wait(&s->not_full, &s->lock);
+		}
+
+		if (s->stop) {
+			pthread_mutex_unlock(&s->lock);
+			break;
+		}
+
+		// The parser does not access the tail buffer until it is published.
+		as_stream_buffer* b = &s->buffers[s->tail];
+		pthread_mutex_unlock(&s->lock);
+
+		as_proto proto;
+		status = as_command_read_proto(&s->err, s->sock, s->node, (uint8_t*)&proto, sizeof(as_proto),
+									   s->socket_timeout, s->deadline_ms);
+
+		if (status) {
+			break;
+		}
+		as_proto_swap_from_be(&proto);
+		size_t size = proto.sz;
+
+		if (size == 0) {
+			continue;
+		}
+
+		if (size > b->capacity) {
+			cf_free(b->data);
+			b->data = cf_malloc(size);
+			b->capacity = size;
+		}
+
+		status = as_socket_read_deadline(&s->err, s->sock, s->node, b->data, size, s->socket_timeout,
+										 s->deadline_ms);
+
+		if (status) {
+			break;
+		}
+		b->size = size;
+		bool end = as_command_stream_end(b->data, size, s->stop_on_error);
+
+		// Publish the last block and the end of the stream together, so the parser never
+		// sees the last block without also seeing that the reader is done.
+		pthread_mutex_lock(&s->lock);
+		s->tail = (s->tail + 1) % s->capacity;
+		s->count++;
+
+		if (end) {
+			s->status = AEROSPIKE_OK;
+			s->done = true;
+		}
+		pthread_cond_signal(&s->not_empty);
+		pthread_mutex_unlock(&s->lock);
+
+		if (end) {
+			return;
+		}
+	}
+
+	pthread_mutex_lock(&s->lock);
+	s->status = status;
+	s->done = true;
+	pthread_cond_signal(&s->not_empty);
+	pthread_mutex_unlock(&s->lock);
+}
+
+/**
+ * Stream reader thread owned by one parsing thread.  The thread is created on the first
+ * streamed response and reused until the owning thread exits, so each node command does
+ * not create a thread and the reader's decompression stream is kept.
+ */
+typedef struct as_stream_reader_s {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	as_command_stream* stream;  // Current stream.  Reset to NULL when the reader is finished with it.
+	bool busy;      // Accessed by owning thread only.
+	bool shutdown;
+} as_stream_reader;
+
+static pthread_key_t as_stream_reader_key;
+static pthread_once_t as_stream_reader_once = PTHREAD_ONCE_INIT;
+
+static void*
+as_stream_reader_run(void* udata)
+{
+	as_stream_reader* r = udata;
+
+	pthread_mutex_lock(&r->lock);
+
+	while (true) {
+		while (! r->stream && ! r->shutdown) {
+			pthread_cond_wait(&r->cond, &r->lock);
+		}
+
+		if (! r->stream) {
+			break;
+		}
+
+		as_command_stream* s = r->stream;
+		pthread_mutex_unlock(&r->lock);
+
+		as_command_stream_read(s);
+
+		pthread_mutex_lock(&r->lock);
+		r->stream = NULL;
+		pthread_cond_signal(&r->cond);
+	}
+	pthread_mutex_unlock(&r->lock);
+	return NULL;
+}
+
+static as_stream_reader*
+as_stream_reader_create(void)
+{
+	as_stream_reader* r = cf_malloc(sizeof(as_stream_reader));
+	pthread_mutex_init(&r->lock, NULL);
+	pthread_cond_init(&r->cond, NULL);
+	r->stream = NULL;
+	r->busy = false;
+	r->shutdown = false;
+
+	if (pthread_create(&r->thread, NULL, as_stream_reader_run, r) != 0) {
+		pthread_cond_destroy(&r->cond);
+		pthread_mutex_destroy(&r->lock);
+		cf_free(r);
+		return NULL;
+	}
+	return r;
+}
+
+static void
+as_stream_reader_destroy(void* udata)
+{
+	as_stream_reader* r = udata;
+
+	pthread_mutex_lock(&r->lock);
+	r->shutdown = true;
+	pthread_cond_signal(&r->cond);
+	pthread_mutex_unlock(&r->lock);
+
+	pthread_join(r->thread, NULL);
+	pthread_cond_destroy(&r->cond);
+	pthread_mutex_destroy(&r->lock);
+	cf_free(r);
+}
+
+static void
+as_stream_reader_key_init(void)
+{
+	pthread_key_create(&as_stream_reader_key, as_stream_reader_destroy);
+}
+
+static as_stream_reader*
+as_stream_reader_get(void)
+{
+	pthread_once(&as_stream_reader_once, as_stream_reader_key_init);
+
+	as_stream_reader* r = pthread_getspecific(as_stream_reader_key);
+
+	if (! r) {
+		r = as_stream_reader_create();
+
+		if (r) {
+			pthread_setspecific(as_stream_reader_key, r);
+		}
+		return r;
+	}
+
+	if (r->busy) {
+		// A parse callback started another streamed command on this thread.  Use a
+		// temporary reader for the nested command.
+		return as_stream_reader_create();
+	}
+	return r;
+}
+
+static void
+as_stream_reader_start(as_stream_reader* r, as_command_stream* s)
+{
+	r->busy = true;
+
+	pthread_mutex_lock(&r->lock);
+	r->stream = s;
+	pthread_cond_signal(&r->cond);
+	pthread_mutex_unlock(&r->lock);
+}
+
+static void
+as_stream_reader_finish(as_stream_reader* r)
+{
+	// Wait until the reader no longer references the stream.
+	pthread_mutex_lock(&r->lock);
+
+	while (r->stream) {
+		pthread_cond_wait(&r->cond, &r->lock);
+	}
+	pthread_mutex_unlock(&r->lock);
+
+	r->busy = false;
+
+	if (r != pthread_getspecific(as_stream_reader_key)) {
+		as_stream_reader_destroy(r);
+	}
+}
+
+as_status
+as_command_parse_stream(
+	as_error* err, as_socket* sock, as_node* node, uint32_t socket_timeout, uint64_t deadline_ms,
+	uint32_t n_buffers, bool stop_on_error, as_parse_records_fn parse_records_fn, void* user_data
+	)
+{
+	as_command_stream s;
+	pthread_mutex_init(&s.lock, NULL);
+	pthread_cond_init(&s.not_empty, NULL);
+	pthread_cond_init(&s.not_full, NULL);
+	s.buffers = cf_calloc(n_buffers, sizeof(as_stream_buffer));
+	s.capacity = n_buffers;
+	s.head = 0;
+	s.tail = 0;
+	s.count = 0;
+	s.sock = sock;
+	s.node = node;
+	s.socket_timeout = socket_timeout;
+	s.deadline_ms = deadline_ms;
+	as_error_init(&s.err);
+	s.status = AEROSPIKE_OK;
+	s.stop_on_error = stop_on_error;
+	s.done = false;
+	s.stop = false;
+
+	as_status status;
+	as_stream_reader* reader = as_stream_reader_get();
+
+	if (! reader) {
+		status = as_error_update(err, AEROSPIKE_ERR_CLIENT, "Failed to create stream reader thread");
+		goto Destroy;
+	}
+	as_stream_reader_start(reader, &s);
+
+	while (true) {
+		pthread_mutex_lock(&s.lock);
+
+		while (s.count == 0 && ! s.done) {
+			pthread_cond_wait(&s.not_empty, &s.lock);
+		}
+
+		if (s.count == 0) {
+			// Reader has exited and all blocks are parsed.
+			pthread_mutex_unlock(&s.lock);
+			status = s.status;
+
+			if (status) {
+				as_error_copy(err, &s.err);
+			}
+			break;
+		}
+
+		as_stream_buffer* b = &s.buffers[s.head];
+		pthread_mutex_unlock(&s.lock);
+
+		status = parse_records_fn(err, b->data, b->size, user_data);
+
+		pthread_mutex_lock(&s.lock);
+		s.head = (s.head + 1) % s.capacity;
+		s.count--;
+		pthread_cond_signal(&s.not_full);
+		pthread_mutex_unlock(&s.lock);
+
+		if (status != AEROSPIKE_OK) {
+			if (status == AEROSPIKE_NO_MORE_RECORDS) {
+				status = AEROSPIKE_OK;
+			}
+			break;
+		}
+	}
+
+	pthread_mutex_lock(&s.lock);
+	bool done = s.done;
+	s.stop = true;
+	pthread_cond_signal(&s.not_full);
+	pthread_mutex_unlock(&s.lock);
+
+	if (! done) {
+		// Parser stopped before the reader found the end of the response.  The reader may be
+		// waiting on the socket, so wake it up.  The socket can not be reused.
+		shutdown(sock->fd, SHUT_RDWR);
+
+		if (status == AEROSPIKE_OK) {
+			status = as_error_update(err, AEROSPIKE_ERR_CLIENT,
+				"Response parsing ended before the last message was read");
+		}
+	}
+	as_stream_reader_finish(reader);
+
+Destroy:
+	for (uint32_t i = 0; i < n_buffers; i++) {
+		cf_free(s.buffers[i].data);
+	}
+	cf_free(s.buffers);
+	pthread_cond_destroy(&s.not_full);
+	pthread_cond_destroy(&s.not_empty);
+	pthread_mutex_destroy(&s.lock);
+	return status;
+}
+
 as_status
 as_command_parse_header(as_error* err, as_socket* sock, as_node* node, uint32_t socket_timeout, uint64_t deadline_ms, void* user_data)
 {
 	// Read header
 	as_proto_msg* msg = user_data;
-	as_status status = as_socket_read_deadline(err, sock, node, (uint8_t*)msg, sizeof(as_proto_msg), socket_timeout, deadline_ms);
+	as_status status = as_command_read_proto(err, sock, node, (uint8_t*)msg, sizeof(as_proto_msg), socket_timeout, deadline_ms);
 	
 	if (status) {
 		return status;
@@ -964,14 +1853,38 @@ abort_record_memory(as_error* err, as_record* rec, size_t size)
 	return as_error_update(err, AEROSPIKE_ERR_CLIENT, "malloc failure: %zu", size);
 }
 
+static inline char*
+as_command_borrow_string(uint8_t* p, size_t size)
+{
+	// Shift string back one byte into header/name space that has already been parsed,
+	// so the string can be null terminated without touching the next bin.
+	char* v = (char*)p - 1;
+	memmove(v, p, size);
+	v[size] = 0;
+	return v;
+}
+
+static inline void*
+as_command_value_alloc(as_arena* arena, size_t size)
+{
+	return arena ? as_arena_alloc(arena, size) : cf_malloc(size);
+}
+
 as_status
-as_command_parse_bins(uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bins, bool deserialize)
+as_command_parse_bins(
+	uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bins, bool deserialize, bool borrow,
+	as_arena* arena
+	)
 {
+	// Arena values are released with the arena, not with the record.
+	bool free = arena == NULL;
+
 	uint8_t* p = *pp;
 	as_bin* bin = rec->bins.entries;
 
 	// Reset size in case we are reusing a record.
 	rec->bins.size = 0;
+	as_bins_index_clear(&rec->bins);
 
 	// Parse bins
 	for (uint32_t i = 0; i < n_bins; i++, bin++) {
@@ -1008,14 +1921,21 @@ as_command_parse_bins(uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bi
 				break;
 			}
 			case AS_BYTES_STRING: {
-				char* value = cf_malloc(value_size + 1);
+				if (borrow) {
+					char* value = as_command_borrow_string(p, value_size);
+					as_string_init_wlen((as_string*)&bin->value, value, value_size, false);
+					bin->valuep = &bin->value;
+					break;
+				}
+
+				char* value = as_command_value_alloc(arena, value_size + 1);
 
 				if (! value) {
 					return abort_record_memory(err, rec, value_size + 1);
 				}
 				memcpy(value, p, value_size);
 				value[value_size] = 0;
-				as_string_init_wlen((as_string*)&bin->value, (char*)value, value_size, true);
+				as_string_init_wlen((as_string*)&bin->value, (char*)value, value_size, free);
 				bin->valuep = &bin->value;
 				break;
 			}
@@ -1034,7 +1954,15 @@ as_command_parse_bins(uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bi
 
 				// Use the json bytes.
 				size_t jsonsz = value_size - 1 - 2 - (ncells * sizeof(uint64_t));
-				char* v = cf_malloc(jsonsz + 1);
+
+				if (borrow) {
+					char* v = as_command_borrow_string(ptr, jsonsz);
+					as_geojson_init_wlen((as_geojson*)&bin->value, v, jsonsz, false);
+					bin->valuep = &bin->value;
+					break;
+				}
+
+				char* v = as_command_value_alloc(arena, jsonsz + 1);
 
 				if (! v) {
 					return abort_record_memory(err, rec, jsonsz + 1);
@@ -1042,7 +1970,7 @@ as_command_parse_bins(uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bi
 				memcpy(v, ptr, jsonsz);
 				v[jsonsz] = 0;
 				as_geojson_init_wlen((as_geojson*)&bin->value,
-									 (char*)v, jsonsz, true);
+									 (char*)v, jsonsz, free);
 				bin->valuep = &bin->value;
 				break;
 			}
@@ -1066,27 +1994,39 @@ as_command_parse_bins(uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bi
 					}
 					bin->valuep = (as_bin_value*)value;
 				}
+				else if (borrow) {
+					as_bytes_init_wrap((as_bytes*)&bin->value, p, value_size, false);
+					bin->value.bytes.type = (as_bytes_type)type;
+					bin->valuep = &bin->value;
+				}
 				else {
-					void* value = cf_malloc(value_size);
+					void* value = as_command_value_alloc(arena, value_size);
 
 					if (! value) {
 						return abort_record_memory(err, rec, value_size);
 					}
 					memcpy(value, p, value_size);
-					as_bytes_init_wrap((as_bytes*)&bin->value, value, value_size, true);
+					as_bytes_init_wrap((as_bytes*)&bin->value, value, value_size, free);
 					bin->value.bytes.type = (as_bytes_type)type;
 					bin->valuep = &bin->value;
 				}
 				break;
 			}
 			default: {
-				void* value = cf_malloc(value_size);
+				if (borrow) {
+					as_bytes_init_wrap((as_bytes*)&bin->value, p, value_size, false);
+					bin->value.bytes.type = (as_bytes_type)type;
+					bin->valuep = &bin->value;
+					break;
+				}
+
+				void* value = as_command_value_alloc(arena, value_size);
 
 				if (! value) {
 					return abort_record_memory(err, rec, value_size);
 				}
 				memcpy(value, p, value_size);
-				as_bytes_init_wrap((as_bytes*)&bin->value, value, value_size, true);
+				as_bytes_init_wrap((as_bytes*)&bin->value, value, value_size, free);
 				bin->value.bytes.type = (as_bytes_type)type;
 				bin->valuep = &bin->value;
 				break;
@@ -1095,6 +2035,7 @@ as_command_parse_bins(uint8_t** pp, as_error* err, as_record* rec, uint32_t n_bi
 		rec->bins.size++;
 		p += value_size;
 	}
+	as_bins_index_update(&rec->bins);
 	*pp = p;
 	return AEROSPIKE_OK;
 }
@@ -1104,7 +2045,7 @@ as_command_parse_result(as_error* err, as_socket* sock, as_node* node, uint32_t
 {
 	// Read header
 	as_proto_msg msg;
-	as_status status = as_socket_read_deadline(err, sock, node, (uint8_t*)&msg, sizeof(as_proto_msg), socket_timeout, deadline_ms);
+	as_status status = as_command_read_proto(err, sock, node, (uint8_t*)&msg, sizeof(as_proto_msg), socket_timeout, deadline_ms);
 	
 	if (status) {
 		return status;
@@ -1116,12 +2057,10 @@ as_command_parse_result(as_error* err, as_socket* sock, as_node* node, uint32_t
 	uint8_t* buf = 0;
 	
 	if (size > 0) {
-		// Read remaining message bytes.
-		buf = as_command_init(size);
-		status = as_socket_read_deadline(err, sock, node, buf, size, socket_timeout, deadline_ms);
+		// Read remaining message bytes.  The view is valid until the next socket read.
+		status = as_socket_read_view(err, sock, node, size, socket_timeout, deadline_ms, &buf);
 		
 		if (status) {
-			as_command_free(buf, size);
 			return status;
 		}
 	}
@@ -1150,8 +2089,9 @@ as_command_parse_result(as_error* err, as_socket* sock, as_node* node, uint32_t
 						}
 						rec->bins.capacity = msg.m.n_ops;
 						rec->bins.size = 0;
-						rec->bins.entries = cf_malloc(sizeof(as_bin) * msg.m.n_ops);
+						rec->bins.entries = cf_malloc(as_bins_alloc_size(msg.m.n_ops));
 						rec->bins._free = true;
+						as_bins_index_init(&rec->bins);
 					}
 					free_on_error = false;
 				}
@@ -1164,7 +2104,7 @@ as_command_parse_result(as_error* err, as_socket* sock, as_node* node, uint32_t
 				rec->ttl = cf_server_void_time_to_ttl(msg.m.record_ttl);
 				
 				uint8_t* p = as_command_ignore_fields(buf, msg.m.n_fields);
-				status = as_command_parse_bins(&p, err, rec, msg.m.n_ops, data->deserialize);
+				status = as_command_parse_bins(&p, err, rec, msg.m.n_ops, data->deserialize, false, NULL);
 
 				if (status != AEROSPIKE_OK && free_on_error) {
 					as_record_destroy(rec);
@@ -1182,7 +2122,6 @@ as_command_parse_result(as_error* err, as_socket* sock, as_node* node, uint32_t
 			as_error_update(err, status, "%s %s", as_node_get_address_string(node), as_error_string(status));
 			break;
 	}
-	as_command_free(buf, size);
 	return status;
 }
 
@@ -1191,7 +2130,7 @@ as_command_parse_success_failure(as_error* err, as_socket* sock, as_node* node,
 {
 	// Read header
 	as_proto_msg msg;
-	as_status status = as_socket_read_deadline(err, sock, node, (uint8_t*)&msg, sizeof(as_proto_msg), socket_timeout, deadline_ms);
+	as_status status = as_command_read_proto(err, sock, node, (uint8_t*)&msg, sizeof(as_proto_msg), socket_timeout, deadline_ms);
 	
 	if (status) {
 		return status;
@@ -1203,12 +2142,10 @@ as_command_parse_success_failure(as_error* err, as_socket* sock, as_node* node,
 	uint8_t* buf = 0;
 	
 	if (size > 0) {
-		// Read remaining message bytes.
-		buf = as_command_init(size);
-		status = as_socket_read_deadline(err, sock, node, buf, size, socket_timeout, deadline_ms);
+		// Read remaining message bytes.  The view is valid until the next socket read.
+		status = as_socket_read_view(err, sock, node, size, socket_timeout, deadline_ms, &buf);
 		
 		if (status) {
-			as_command_free(buf, size);
 			return status;
 		}
 	}
@@ -1246,6 +2183,5 @@ as_command_parse_success_failure(as_error* err, as_socket* sock, as_node* node,
 			}
 			break;
 	}
-	as_command_free(buf, size);
 	return status;
 }
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2008-2018 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_compress.h>
+#include <aerospike/as_atomic.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_clock.h>
+#include <pthread.h>
+#include <string.h>
+#include <zlib.h>
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+// Per-thread zlib streams.  Event loops run on their own threads, so each event loop
+// also gets its own streams.
+typedef struct as_compress_ctx_s {
+	z_stream deflater;
+	z_stream inflater;
+	int level;
+	bool deflater_init;
+	bool inflater_init;
+} as_compress_ctx;
+
+/******************************************************************************
+ * STATIC VARIABLES
+ *****************************************************************************/
+
+static pthread_key_t as_compress_key;
+static pthread_once_t as_compress_once = PTHREAD_ONCE_INIT;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static void
+as_compress_ctx_destroy(void* udata)
+{
+	as_compress_ctx* ctx = udata;
+
+	if (ctx->deflater_init) {
+		deflateEnd(&ctx->deflater);
+	}
+
+	if (ctx->inflater_init) {
+		inflateEnd(&ctx->inflater);
+	}
+	cf_free(ctx);
+}
+
+static void
+as_compress_key_init(void)
+{
+	// Streams are released when their thread exits.
+	pthread_key_create(&as_compress_key, as_compress_ctx_destroy);
+}
+
+static as_compress_ctx*
+as_compress_ctx_get(void)
+{
+	pthread_once(&as_compress_once, as_compress_key_init);
+
+	as_compress_ctx* ctx = pthread_getspecific(as_compress_key);
+
+	if (! ctx) {
+		ctx = cf_malloc(sizeof(as_compress_ctx));
+		memset(ctx, 0, sizeof(as_compress_ctx));
+		pthread_setspecific(as_compress_key, ctx);
+	}
+	return ctx;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+int
+as_compress_deflate(uint8_t* out, size_t* out_len, const uint8_t* in, size_t in_len, int level)
+{
+	as_compress_ctx* ctx = as_compress_ctx_get();
+	z_stream* strm = &ctx->deflater;
+	int rv;
+
+	if (! ctx->deflater_init) {
+		rv = deflateInit(strm, level);
+
+		if (rv != Z_OK) {
+			return rv;
+		}
+		ctx->deflater_init = true;
+		ctx->level = level;
+	}
+	else {
+		rv = deflateReset(strm);
+
+		if (rv != Z_OK) {
+			return rv;
+		}
+
+		if (level != ctx->level) {
+			// No input has been written since reset, so parameters change immediately.
+			rv = deflateParams(strm, level, Z_DEFAULT_STRATEGY);
+
+			if (rv != Z_OK) {
+				return rv;
+			}
+			ctx->level = level;
+		}
+	}
+
+	strm->next_in = (Bytef*)in;
+	strm->avail_in = (uInt)in_len;
+	strm->next_out = out;
+	strm->avail_out = (uInt)*out_len;
+
+	rv = deflate(strm, Z_FINISH);
+
+	if (rv != Z_STREAM_END) {
+		return (rv == Z_OK)? Z_BUF_ERROR : rv;
+	}
+
+	*out_len = strm->total_out;
+	return Z_OK;
+}
+
+struct z_stream_s*
+as_compress_inflater(void)
+{
+	as_compress_ctx* ctx = as_compress_ctx_get();
+	z_stream* strm = &ctx->inflater;
+
+	if (! ctx->inflater_init) {
+		if (inflateInit(strm) != Z_OK) {
+			return NULL;
+		}
+		ctx->inflater_init = true;
+	}
+	else if (inflateReset(strm) != Z_OK) {
+		return NULL;
+	}
+	return strm;
+}
+
+int
+as_compress_inflate(uint8_t* out, size_t* out_len, const uint8_t* in, size_t in_len)
+{
+	z_stream* strm = as_compress_inflater();
+
+	if (! strm) {
+		return Z_MEM_ERROR;
+	}
+
+	strm->next_in = (Bytef*)in;
+	strm->avail_in = (uInt)in_len;
+	strm->next_out = out;
+	strm->avail_out = (uInt)*out_len;
+
+	int rv = inflate(strm, Z_FINISH);
+
+	if (rv != Z_STREAM_END) {
+		return (rv == Z_OK)? Z_DATA_ERROR : rv;
+	}
+
+	*out_len = strm->total_out;
+	return Z_OK;
+}
+
+void
+as_compress_stats_add(as_compress_stats* stats, size_t raw_bytes, size_t zip_bytes, uint64_t begin)
+{
+	as_incr_uint64(&stats->count);
+	as_faa_uint64(&stats->raw_bytes, raw_bytes);
+	as_faa_uint64(&stats->zip_bytes, zip_bytes);
+	as_faa_uint64(&stats->usec, cf_getus() - begin);
+}
+
+void
+as_compress_stats_copy(as_compress_stats* src, as_compress_stats* trg, bool reset)
+{
+	// Statistics are a flat array of counters.
+	uint64_t* s = (uint64_t*)src;
+	uint64_t* t = (uint64_t*)trg;
+	uint32_t max = sizeof(as_compress_stats) / sizeof(uint64_t);
+
+	for (uint32_t i = 0; i < max; i++) {
+		uint64_t v = reset ? as_fas_uint64(&s[i], 0) : as_load_uint64(&s[i]);
+
+		if (t) {
+			t[i] = v;
+		}
+	}
+}
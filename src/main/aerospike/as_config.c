@@ -41,6 +41,7 @@ as_config_init(as_config* c)
 	c->async_max_conns_per_node = 300;
 	c->pipe_max_conns_per_node = 64;
 	c->conn_pools_per_node = 1;
+	c->conn_cache_size = 8;
 	c->conn_timeout_ms = 1000;
 	c->login_timeout_ms = 5000;
 	c->max_socket_idle = 0;
@@ -53,6 +54,7 @@ as_config_init(as_config* c)
 	c->auth_mode = AS_AUTH_INTERNAL;
 	c->fail_if_not_connected = true;
 	c->use_services_alternate = false;
+	c->skip_conn_validation = false;
 	c->use_shm = false;
 	c->shm_key = 0xA7000000;
 	c->shm_max_nodes = 16;
@@ -33,6 +33,7 @@ as_error_string(as_status status)
 		CASE_ASSIGN(AEROSPIKE_OK);
 		CASE_ASSIGN(AEROSPIKE_QUERY_END);
 
+		CASE_ASSIGN(AEROSPIKE_NO_RESPONSE);
 		CASE_ASSIGN(AEROSPIKE_ERR_ASYNC_QUEUE_FULL);
 		CASE_ASSIGN(AEROSPIKE_ERR_CONNECTION);
 		CASE_ASSIGN(AEROSPIKE_ERR_TLS_ERROR);
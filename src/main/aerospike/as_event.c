@@ -67,8 +67,20 @@ as_event_validate_policy(as_error* err, as_policy_event* policy)
 static void
 as_event_initialize_loop(as_policy_event* policy, as_event_loop* event_loop, uint32_t index)
 {
+	as_event_ring* ring = cf_malloc(sizeof(as_event_ring));
+	ring->tail = 0;
+	ring->head = 0;
+
+	for (uint32_t i = 0; i < AS_EVENT_RING_SIZE; i++) {
+		ring->slots[i].seq = i;
+	}
+	event_loop->ring = ring;
 	pthread_mutex_init(&event_loop->lock, 0);
 	as_queue_init(&event_loop->queue, sizeof(as_event_commander), AS_EVENT_QUEUE_INITIAL_CAPACITY);
+	event_loop->overflow = 0;
+	event_loop->wakeup_pending = 0;
+	event_loop->zbuf = NULL;
+	event_loop->zbuf_capacity = 0;
 
 	if (policy->max_commands_in_process > 0) {
 		as_queue_init(&event_loop->delay_queue, sizeof(as_event_command*), policy->queue_initial_capacity);
@@ -342,6 +354,176 @@ as_event_destroy_loops()
  * PRIVATE FUNCTIONS
  *****************************************************************************/
 
+static inline bool
+as_event_ring_push(as_event_ring* ring, const as_event_commander* cmd)
+{
+	as_event_ring_slot* slot;
+	uint32_t pos = as_load_uint32(&ring->tail);
+
+	while (true) {
+		slot = &ring->slots[pos & AS_EVENT_RING_MASK];
+		int32_t diff = (int32_t)(as_load_uint32(&slot->seq) - pos);
+
+		if (diff == 0) {
+			// Slot is free.  Claim it.
+			if (as_cas_uint32(&ring->tail, pos, pos + 1)) {
+				break;
+			}
+		}
+		else if (diff < 0) {
+			// Ring is full.
+			return false;
+		}
+		pos = as_load_uint32(&ring->tail);
+	}
+
+	// Do not write command until the consumer's release of this slot is visible.
+	as_fence_acquire();
+	slot->cmd = *cmd;
+
+	// Publish slot to consumer after command is fully written.
+	as_fence_store();
+	as_store_uint32(&slot->seq, pos + 1);
+	return true;
+}
+
+static inline bool
+as_event_ring_pop(as_event_ring* ring, as_event_commander* cmd)
+{
+	// Only called from event loop thread.
+	uint32_t head = ring->head;
+	as_event_ring_slot* slot = &ring->slots[head & AS_EVENT_RING_MASK];
+
+	if (as_load_uint32(&slot->seq) != head + 1) {
+		// Empty or producer has claimed slot but not published it yet.
+		return false;
+	}
+
+	// Do not read command before its published sequence.
+	as_fence_acquire();
+	*cmd = slot->cmd;
+
+	// Release slot for the next lap after command has been copied out.
+	as_fence_release();
+	as_store_uint32(&slot->seq, head + AS_EVENT_RING_SIZE);
+	ring->head = head + 1;
+	return true;
+}
+
+static bool
+as_event_queue_push(as_event_loop* event_loop, const as_event_commander* cmd)
+{
+	// Use overflow queue while it holds commands, so commands from the same thread stay in order.
+	if (as_load_uint32(&event_loop->overflow) == 0 && as_event_ring_push(event_loop->ring, cmd)) {
+		return true;
+	}
+
+	pthread_mutex_lock(&event_loop->lock);
+	bool queued = as_queue_push(&event_loop->queue, cmd);
+
+	if (queued) {
+		as_store_uint32(&event_loop->overflow, event_loop->overflow + 1);
+	}
+	pthread_mutex_unlock(&event_loop->lock);
+	return queued;
+}
+
+uint32_t
+as_event_execute_batch(as_event_loop* event_loop, const as_event_commander* cmds, uint32_t n_cmds)
+{
+	uint32_t i = 0;
+
+	while (i < n_cmds && as_event_queue_push(event_loop, &cmds[i])) {
+		i++;
+	}
+
+	if (i == 0) {
+		return 0;
+	}
+
+	// Only send wakeup when the event loop may be waiting.  The event loop clears
+	// wakeup_pending before it processes the queue.
+	as_fence_memory();
+
+	if (as_load_uint32(&event_loop->wakeup_pending) == 0 &&
+		as_cas_uint32(&event_loop->wakeup_pending, 0, 1)) {
+		as_event_send_wakeup(event_loop);
+	}
+	return i;
+}
+
+bool
+as_event_execute(as_event_loop* event_loop, as_event_executable executable, void* udata)
+{
+	// Send command through queue so it can be executed in event loop thread.
+	as_event_commander qcmd = {.executable = executable, .udata = udata};
+	return as_event_execute_batch(event_loop, &qcmd, 1) == 1;
+}
+
+bool
+as_event_process_queue(as_event_loop* event_loop)
+{
+	// Clear wakeup flag first.  Commands queued after this point will send a new wakeup.
+	as_fas_uint32(&event_loop->wakeup_pending, 0);
+
+	// Only process original size of queue.  Recursive pre-registration errors can
+	// result in new commands being added while the loop is in process.  If we process
+	// them, we could end up in an infinite loop.
+	as_event_ring* ring = event_loop->ring;
+	uint32_t size = as_load_uint32(&ring->tail) - ring->head;
+	as_event_commander cmd;
+
+	for (uint32_t i = 0; i < size; i++) {
+		if (! as_event_ring_pop(ring, &cmd)) {
+			// Producer has not published the slot yet.  It will send another wakeup.
+			break;
+		}
+
+		if (! cmd.executable) {
+			// Received stop signal.
+			return false;
+		}
+		cmd.executable(cmd.udata);
+	}
+
+	if (as_load_uint32(&event_loop->overflow) == 0) {
+		return true;
+	}
+
+	pthread_mutex_lock(&event_loop->lock);
+	size = as_queue_size(&event_loop->queue);
+	bool status = as_queue_pop(&event_loop->queue, &cmd);
+
+	if (status) {
+		as_store_uint32(&event_loop->overflow, event_loop->overflow - 1);
+	}
+	pthread_mutex_unlock(&event_loop->lock);
+
+	uint32_t i = 0;
+
+	while (status) {
+		if (! cmd.executable) {
+			// Received stop signal.
+			return false;
+		}
+		cmd.executable(cmd.udata);
+
+		if (++i < size) {
+			pthread_mutex_lock(&event_loop->lock);
+			status = as_queue_pop(&event_loop->queue, &cmd);
+
+			if (status) {
+				as_store_uint32(&event_loop->overflow, event_loop->overflow - 1);
+			}
+			pthread_mutex_unlock(&event_loop->lock);
+		}
+		else {
+			break;
+		}
+	}
+	return true;
+}
+
 static void as_event_command_execute_in_loop(as_event_command* cmd);
 static void as_event_command_begin(as_event_command* cmd);
 
@@ -353,6 +535,10 @@ as_event_command_execute(as_event_command* cmd, as_error* err)
 	cmd->buf += cmd->write_len;
 	cmd->command_sent_counter = 0;
 	cmd->conn = NULL;
+#if defined(AS_USE_LIBURING)
+	cmd->ops = 0;
+	cmd->released = false;
+#endif
 
 	as_event_loop* event_loop = cmd->event_loop;
 
@@ -375,6 +561,10 @@ as_event_command_execute(as_event_command* cmd, as_error* err)
 			if (cmd->node) {
 				as_node_release(cmd->node);
 			}
+
+			if (cmd->iov) {
+				as_event_iov_destroy(cmd->iov);
+			}
 			cf_free(cmd);
 			return as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "Failed to queue command");
 		}
@@ -531,6 +721,7 @@ static void
 as_event_command_begin(as_event_command* cmd)
 {
 	cmd->state = AS_ASYNC_STATE_CONNECT;
+	cmd->begin = cf_getus();
 
 	if (cmd->partition) {
 		// If in retry, need to release node from prior attempt.
@@ -564,13 +755,21 @@ as_event_command_begin(as_event_command* cmd)
 
 	as_conn_pool* pool = &cmd->node->async_conn_pools[cmd->event_loop->index];
 	as_async_connection* conn;
+	bool peek = ! cmd->cluster->skip_conn_validation;
+
+	cmd->conn_unvalidated = false;
 
 	// Find connection.
 	while (as_conn_pool_get(pool, &conn)) {
 		// Verify that socket is active and receive buffer is empty.
-		int len = as_event_validate_connection(&conn->base);
+		int len = as_event_validate_connection(&conn->base, peek);
 
 		if (len == 0) {
+			if (! peek) {
+				// Dead connection is detected on first use instead.
+				cmd->conn_unvalidated = true;
+				as_incr_uint64(&cmd->node->metrics.conn_peeks_skipped);
+			}
 			conn->cmd = cmd;
 			cmd->conn = (as_event_connection*)conn;
 			cmd->event_loop->errors = 0;  // Reset errors on valid connection.
@@ -643,12 +842,14 @@ as_event_socket_timeout(as_event_command* cmd)
 		return;
 	}
 
+	// Node should not be null at this point.
+	as_incr_uint64(&cmd->node->metrics.client_timeouts);
+
 	if (cmd->pipe_listener) {
 		as_pipe_timeout(cmd, true);
 		return;
 	}
 
-	// Node should not be null at this point.
 	as_event_connection_timeout(cmd, &cmd->node->async_conn_pools[cmd->event_loop->index]);
 
 	// Attempt retry.
@@ -678,12 +879,14 @@ as_event_total_timeout(as_event_command* cmd)
 		return;
 	}
 
+	// Node should not be null at this point.
+	as_incr_uint64(&cmd->node->metrics.client_timeouts);
+
 	if (cmd->pipe_listener) {
 		as_pipe_timeout(cmd, false);
 		return;
 	}
 
-	// Node should not be null at this point.
 	as_event_connection_timeout(cmd, &cmd->node->async_conn_pools[cmd->event_loop->index]);
 
 	as_error err;
@@ -692,14 +895,9 @@ as_event_total_timeout(as_event_command* cmd)
 	as_event_error_callback(cmd, &err);
 }
 
-bool
-as_event_command_retry(as_event_command* cmd, bool alternate)
+static bool
+as_event_command_next_attempt(as_event_command* cmd, bool alternate)
 {
-	// Check max retries.
-	if (++(cmd->iteration) > cmd->max_retries) {
-		return false;
-	}
-
 	if (cmd->total_deadline > 0) {
 		// Check total timeout.
 		uint64_t now = cf_getms();
@@ -726,6 +924,10 @@ as_event_command_retry(as_event_command* cmd, bool alternate)
 		as_event_repeat_socket_timer(cmd);
 	}
 
+	if (cmd->node) {
+		as_incr_uint64(&cmd->node->metrics.retries);
+	}
+
 	if (alternate) {
 		cmd->flags ^= AS_ASYNC_FLAGS_MASTER;  // Alternate between master and prole.
 	}
@@ -738,6 +940,36 @@ as_event_command_retry(as_event_command* cmd, bool alternate)
 	return as_event_execute(cmd->event_loop, (as_event_executable)as_event_command_begin, cmd);
 }
 
+bool
+as_event_command_retry(as_event_command* cmd, bool alternate)
+{
+	// Check max retries.
+	if (++(cmd->iteration) > cmd->max_retries) {
+		return false;
+	}
+	return as_event_command_next_attempt(cmd, alternate);
+}
+
+bool
+as_event_command_retry_stale(as_event_command* cmd)
+{
+	// A pooled connection that was used without a peek and was closed by the server while
+	// idle is only treated as stale when the write failed before any command bytes were
+	// sent.  Once bytes are sent, the server may have executed the command, so use the
+	// normal retry path that counts iterations and in doubt writes.
+	bool stale = cmd->state == AS_ASYNC_STATE_COMMAND_WRITE && cmd->pos == 0;
+
+	cmd->conn_unvalidated = false;
+
+	if (! stale) {
+		return as_event_command_retry(cmd, true);
+	}
+
+	// Retry on another connection without counting against max_retries.
+	as_incr_uint64(&cmd->node->metrics.stale_conns);
+	return as_event_command_next_attempt(cmd, false);
+}
+
 static inline void
 as_event_put_connection(as_event_command* cmd, as_conn_pool* pool)
 {
@@ -748,9 +980,28 @@ as_event_put_connection(as_event_command* cmd, as_conn_pool* pool)
 	}
 }
 
+static inline as_latency_type
+as_event_latency_type(as_event_command* cmd)
+{
+	switch (cmd->type) {
+		case AS_ASYNC_TYPE_BATCH:
+			return AS_LATENCY_TYPE_BATCH;
+		case AS_ASYNC_TYPE_SCAN:
+			return AS_LATENCY_TYPE_SCAN;
+		case AS_ASYNC_TYPE_QUERY:
+			return AS_LATENCY_TYPE_QUERY;
+		case AS_ASYNC_TYPE_INFO:
+			return AS_LATENCY_TYPE_INFO;
+		default:
+			return (cmd->flags & AS_ASYNC_FLAGS_READ)? AS_LATENCY_TYPE_READ : AS_LATENCY_TYPE_WRITE;
+	}
+}
+
 static inline void
 as_event_response_complete(as_event_command* cmd)
 {
+	as_node_add_latency(cmd->node, as_event_latency_type(cmd), cf_getus() - cmd->begin);
+
 	if (cmd->pipe_listener != NULL) {
 		as_pipe_response_complete(cmd);
 		return;
@@ -915,6 +1166,10 @@ as_event_notify_error(as_event_command* cmd, as_error* err)
 {
 	as_error_set_in_doubt(err, cmd->flags & AS_ASYNC_FLAGS_READ, cmd->command_sent_counter);
 
+	if (err->in_doubt && cmd->node) {
+		as_incr_uint64(&cmd->node->metrics.in_doubt_writes);
+	}
+
 	switch (cmd->type) {
 		case AS_ASYNC_TYPE_WRITE:
 			((as_async_write_command*)cmd)->listener(err, cmd->udata, cmd->event_loop);
@@ -977,6 +1232,13 @@ as_event_socket_error(as_event_command* cmd, as_error* err)
 void
 as_event_response_error(as_event_command* cmd, as_error* err)
 {
+	// Server sent back error, so the command did complete.
+	as_node_add_latency(cmd->node, as_event_latency_type(cmd), cf_getus() - cmd->begin);
+
+	if (err->code == AEROSPIKE_ERR_TIMEOUT) {
+		as_incr_uint64(&cmd->node->metrics.server_timeouts);
+	}
+
 	if (cmd->pipe_listener != NULL) {
 		as_pipe_response_error(cmd, err);
 		return;
@@ -1011,6 +1273,72 @@ as_event_response_error(as_event_command* cmd, as_error* err)
 	as_event_error_callback(cmd, err);
 }
 
+bool
+as_event_command_inflate(as_event_command* cmd)
+{
+	as_error err;
+	uint64_t usize = (cmd->len >= sizeof(uint64_t))? as_command_compressed_size(cmd->buf) : 0;
+
+	if (usize < sizeof(as_proto) + sizeof(as_msg) || usize > UINT32_MAX) {
+		as_error_update(&err, AEROSPIKE_ERR_CLIENT, "Invalid uncompressed proto size: %" PRIu64, usize);
+		as_event_parse_error(cmd, &err);
+		return false;
+	}
+
+	// Move the compressed block to the event loop's scratch buffer, so the block can be
+	// inflated into the command buffer.  Both buffers are only grown when too small.
+	as_event_loop* event_loop = cmd->event_loop;
+
+	if (cmd->len > event_loop->zbuf_capacity) {
+		cf_free(event_loop->zbuf);
+		event_loop->zbuf = cf_malloc(cmd->len);
+		event_loop->zbuf_capacity = cmd->len;
+	}
+	memcpy(event_loop->zbuf, cmd->buf, cmd->len);
+
+	if (usize > cmd->read_capacity) {
+		if (cmd->flags & AS_ASYNC_FLAGS_FREE_BUF) {
+			cf_free(cmd->buf);
+		}
+		cmd->buf = cf_malloc(usize);
+		cmd->read_capacity = (uint32_t)usize;
+		cmd->flags |= AS_ASYNC_FLAGS_FREE_BUF;
+	}
+
+	as_status status = as_command_inflate(cmd->cluster, &err, event_loop->zbuf, cmd->len, cmd->buf,
+		usize);
+
+	if (event_loop->zbuf_capacity > AS_SOCKET_RBUF_MAX) {
+		// Do not hold memory used by an unusually large block.
+		cf_free(event_loop->zbuf);
+		event_loop->zbuf = NULL;
+		event_loop->zbuf_capacity = 0;
+	}
+
+	if (status != AEROSPIKE_OK) {
+		as_event_parse_error(cmd, &err);
+		return false;
+	}
+
+	// A compressed block holds one uncompressed proto message.
+	as_proto* proto = (as_proto*)cmd->buf;
+	as_proto_swap_from_be(proto);
+	size_t size = proto->sz;
+
+	if (proto->type != AS_MESSAGE_TYPE || size != usize - sizeof(as_proto)) {
+		as_error_update(&err, AEROSPIKE_ERR_CLIENT, "Invalid inflated proto: type=%u size=%zu",
+			(uint32_t)proto->type, size);
+		as_event_parse_error(cmd, &err);
+		return false;
+	}
+
+	// Replace compressed body with uncompressed body.
+	memmove(cmd->buf, cmd->buf + sizeof(as_proto), size);
+	cmd->len = (uint32_t)size;
+	cmd->compressed = false;
+	return true;
+}
+
 bool
 as_event_command_parse_header(as_event_command* cmd)
 {
@@ -1053,7 +1381,7 @@ as_event_command_parse_result(as_event_command* cmd)
 			rec.ttl = cf_server_void_time_to_ttl(msg->record_ttl);
 			
 			p = as_command_ignore_fields(p, msg->n_fields);
-			status = as_command_parse_bins(&p, &err, &rec, msg->n_ops, cmd->deserialize);
+			status = as_command_parse_bins(&p, &err, &rec, msg->n_ops, cmd->deserialize, cmd->borrow, NULL);
 
 			if (status == AEROSPIKE_OK) {
 				as_event_response_complete(cmd);
@@ -1164,6 +1492,10 @@ as_event_command_free(as_event_command* cmd)
 	if (cmd->flags & AS_ASYNC_FLAGS_FREE_BUF) {
 		cf_free(cmd->buf);
 	}
+
+	if (cmd->iov) {
+		as_event_iov_destroy(cmd->iov);
+	}
 	cf_free(cmd);
 
 	if (event_loop->max_commands_in_process > 0 && ! event_loop->using_delay_queue) {
@@ -19,6 +19,7 @@
 #include <aerospike/as_admin.h>
 #include <aerospike/as_async.h>
 #include <aerospike/as_atomic.h>
+#include <aerospike/as_command.h>
 #include <aerospike/as_log_macros.h>
 #include <aerospike/as_pipe.h>
 #include <aerospike/as_proto.h>
@@ -59,35 +60,11 @@ as_ev_close_loop(as_event_loop* event_loop)
 static void
 as_ev_wakeup(struct ev_loop* loop, ev_async* wakeup, int revents)
 {
-	// Read command pointers from queue.
 	as_event_loop* event_loop = wakeup->data;
-	as_event_commander cmd;
-	uint32_t i = 0;
-
-	// Only process original size of queue.  Recursive pre-registration errors can
-	// result in new commands being added while the loop is in process.  If we process
-	// them, we could end up in an infinite loop.
-	pthread_mutex_lock(&event_loop->lock);
-	uint32_t size = as_queue_size(&event_loop->queue);
-	bool status = as_queue_pop(&event_loop->queue, &cmd);
-	pthread_mutex_unlock(&event_loop->lock);
-
-	while (status) {
-		if (! cmd.executable) {
-			// Received stop signal.
-			as_ev_close_loop(event_loop);
-			return;
-		}
-		cmd.executable(cmd.udata);
 
-		if (++i < size) {
-			pthread_mutex_lock(&event_loop->lock);
-			status = as_queue_pop(&event_loop->queue, &cmd);
-			pthread_mutex_unlock(&event_loop->lock);
-		}
-		else {
-			break;
-		}
+	if (! as_event_process_queue(event_loop)) {
+		// Received stop signal.
+		as_ev_close_loop(event_loop);
 	}
 }
 
@@ -129,19 +106,10 @@ as_event_register_external_loop(as_event_loop* event_loop)
 	as_ev_init_loop(event_loop);
 }
 
-bool
-as_event_execute(as_event_loop* event_loop, as_event_executable executable, void* udata)
+void
+as_event_send_wakeup(as_event_loop* event_loop)
 {
-	// Send command through queue so it can be executed in event loop thread.
-	pthread_mutex_lock(&event_loop->lock);
-	as_event_commander qcmd = {.executable = executable, .udata = udata};
-	bool queued = as_queue_push(&event_loop->queue, &qcmd);
-	pthread_mutex_unlock(&event_loop->lock);
-
-	if (queued) {
-		ev_async_send(event_loop->loop, &event_loop->wakeup);
-	}
-	return queued;
+	ev_async_send(event_loop->loop, &event_loop->wakeup);
 }
 
 static inline void
@@ -194,11 +162,11 @@ as_ev_watch_read(as_event_command* cmd)
 static int
 as_ev_write(as_event_command* cmd)
 {
-	uint8_t* buf = (uint8_t*)cmd + cmd->write_offset;
-
 	if (cmd->conn->socket.ctx) {
 		do {
-			int rv = as_tls_write_once(&cmd->conn->socket, buf + cmd->pos, cmd->len - cmd->pos);
+			uint32_t size;
+			uint8_t* buf = as_event_write_segment(cmd, &size);
+			int rv = as_tls_write_once(&cmd->conn->socket, buf, size);
 			if (rv > 0) {
 				as_ev_watch_write(cmd);
 				cmd->pos += rv;
@@ -230,11 +198,7 @@ as_ev_write(as_event_command* cmd)
 		ssize_t bytes;
 	
 		do {
-#if defined(__linux__)
-			bytes = send(fd, buf + cmd->pos, cmd->len - cmd->pos, MSG_NOSIGNAL);
-#else
-			bytes = write(fd, buf + cmd->pos, cmd->len - cmd->pos);
-#endif
+			bytes = as_event_send(cmd, fd);
 			if (bytes > 0) {
 				cmd->pos += bytes;
 				continue;
@@ -347,12 +311,14 @@ as_ev_read(as_event_command* cmd)
 		} while (cmd->pos < cmd->len);
 	}
 	
+	as_node_add_bytes_in(cmd->node, cmd->len);
 	return AS_EVENT_READ_COMPLETE;
 }
 
 static inline void
 as_ev_command_read_start(as_event_command* cmd)
 {
+	as_node_add_bytes_out(cmd->node, cmd->len);
 	cmd->command_sent_counter++;
 	cmd->len = sizeof(as_proto);
 	cmd->pos = 0;
@@ -394,6 +360,7 @@ as_ev_command_peek_block(as_event_command* cmd)
 	
 	as_proto* proto = (as_proto*)cmd->buf;
 	as_proto_swap_from_be(proto);
+	cmd->compressed = proto->type == AS_COMPRESSED_MESSAGE_TYPE;
 	size_t size = proto->sz;
 	
 	cmd->len = (uint32_t)size;
@@ -408,7 +375,7 @@ as_ev_command_peek_block(as_event_command* cmd)
 			return rv;
 		}
 
-		if (! cmd->parse_results(cmd)) {
+		if (! as_event_command_parse_results(cmd)) {
 			// We did not finish after all. Prepare to read next header.
 			cmd->len = sizeof(as_proto);
 			cmd->pos = 0;
@@ -489,6 +456,7 @@ as_ev_command_read(as_event_command* cmd)
 		
 		as_proto* proto = (as_proto*)cmd->buf;
 		as_proto_swap_from_be(proto);
+		cmd->compressed = proto->type == AS_COMPRESSED_MESSAGE_TYPE;
 		size_t size = proto->sz;
 		
 		cmd->len = (uint32_t)size;
@@ -511,7 +479,7 @@ as_ev_command_read(as_event_command* cmd)
 		return rv;
 	}
 
-	if (! cmd->parse_results(cmd)) {
+	if (! as_event_command_parse_results(cmd)) {
 		// Batch, scan, query is not finished.
 		return as_ev_command_peek_block(cmd);
 	}
@@ -19,6 +19,7 @@
 #include <aerospike/as_admin.h>
 #include <aerospike/as_async.h>
 #include <aerospike/as_atomic.h>
+#include <aerospike/as_command.h>
 #include <aerospike/as_log_macros.h>
 #include <aerospike/as_pipe.h>
 #include <aerospike/as_proto.h>
@@ -67,35 +68,11 @@ as_event_close_loop(as_event_loop* event_loop)
 static void
 as_event_wakeup(evutil_socket_t socket, short revents, void* udata)
 {
-	// Read command pointers from queue.
 	as_event_loop* event_loop = udata;
-	as_event_commander cmd;
-	uint32_t i = 0;
-
-	// Only process original size of queue.  Recursive pre-registration errors can
-	// result in new commands being added while the loop is in process.  If we process
-	// them, we could end up in an infinite loop.
-	pthread_mutex_lock(&event_loop->lock);
-	uint32_t size = as_queue_size(&event_loop->queue);
-	bool status = as_queue_pop(&event_loop->queue, &cmd);
-	pthread_mutex_unlock(&event_loop->lock);
-
-	while (status) {
-		if (! cmd.executable) {
-			// Received stop signal.
-			as_event_close_loop(event_loop);
-			return;
-		}
-		cmd.executable(cmd.udata);
 
-		if (++i < size) {
-			pthread_mutex_lock(&event_loop->lock);
-			status = as_queue_pop(&event_loop->queue, &cmd);
-			pthread_mutex_unlock(&event_loop->lock);
-		}
-		else {
-			break;
-		}
+	if (! as_event_process_queue(event_loop)) {
+		// Received stop signal.
+		as_event_close_loop(event_loop);
 	}
 }
 
@@ -190,23 +167,14 @@ as_event_register_external_loop(as_event_loop* event_loop)
 	as_event_init_loop(event_loop);
 }
 
-bool
-as_event_execute(as_event_loop* event_loop, as_event_executable executable, void* udata)
+void
+as_event_send_wakeup(as_event_loop* event_loop)
 {
-	// Send command through queue so it can be executed in event loop thread.
-	pthread_mutex_lock(&event_loop->lock);
-	as_event_commander qcmd = {.executable = executable, .udata = udata};
-	bool queued = as_queue_push(&event_loop->queue, &qcmd);
-	pthread_mutex_unlock(&event_loop->lock);
-
-	if (queued) {
-		if (! evtimer_pending(&event_loop->wakeup, NULL)) {
-			event_del(&event_loop->wakeup);
-			evtimer_add(&event_loop->wakeup, &as_immediate_tv);
-		}
-		//event_active(&event_loop->wakeup, 0, 0);
+	if (! evtimer_pending(&event_loop->wakeup, NULL)) {
+		event_del(&event_loop->wakeup);
+		evtimer_add(&event_loop->wakeup, &as_immediate_tv);
 	}
-	return queued;
+	//event_active(&event_loop->wakeup, 0, 0);
 }
 
 static inline void
@@ -257,11 +225,11 @@ as_event_watch_read(as_event_command* cmd)
 static int
 as_event_write(as_event_command* cmd)
 {
-	uint8_t* buf = (uint8_t*)cmd + cmd->write_offset;
-
 	if (cmd->conn->socket.ctx) {
 		do {
-			int rv = as_tls_write_once(&cmd->conn->socket, buf + cmd->pos, cmd->len - cmd->pos);
+			uint32_t size;
+			uint8_t* buf = as_event_write_segment(cmd, &size);
+			int rv = as_tls_write_once(&cmd->conn->socket, buf, size);
 			if (rv > 0) {
 				as_event_watch_write(cmd);
 				cmd->pos += rv;
@@ -292,13 +260,7 @@ as_event_write(as_event_command* cmd)
 		as_socket_fd fd = cmd->conn->socket.fd;
 	
 		do {
-#if defined(__linux__)
-			int bytes = (int)send(fd, buf + cmd->pos, cmd->len - cmd->pos, MSG_NOSIGNAL);
-#elif defined(_MSC_VER)
-			int bytes = send(fd, buf + cmd->pos, cmd->len - cmd->pos, 0);
-#else
-			int bytes = (int)write(fd, buf + cmd->pos, cmd->len - cmd->pos);
-#endif
+			int bytes = as_event_send(cmd, fd);
 			if (bytes > 0) {
 				cmd->pos += bytes;
 				continue;
@@ -414,12 +376,14 @@ as_event_read(as_event_command* cmd)
 		} while (cmd->pos < cmd->len);
 	}
 	
+	as_node_add_bytes_in(cmd->node, cmd->len);
 	return AS_EVENT_READ_COMPLETE;
 }
 
 static inline void
 as_event_command_read_start(as_event_command* cmd)
 {
+	as_node_add_bytes_out(cmd->node, cmd->len);
 	cmd->command_sent_counter++;
 	cmd->len = sizeof(as_proto);
 	cmd->pos = 0;
@@ -461,6 +425,7 @@ as_event_command_peek_block(as_event_command* cmd)
 	
 	as_proto* proto = (as_proto*)cmd->buf;
 	as_proto_swap_from_be(proto);
+	cmd->compressed = proto->type == AS_COMPRESSED_MESSAGE_TYPE;
 	size_t size = proto->sz;
 	
 	cmd->len = (uint32_t)size;
@@ -475,7 +440,7 @@ as_event_command_peek_block(as_event_command* cmd)
 			return rv;
 		}
 
-		if (! cmd->parse_results(cmd)) {
+		if (! as_event_command_parse_results(cmd)) {
 			// We did not finish after all. Prepare to read next header.
 			cmd->len = sizeof(as_proto);
 			cmd->pos = 0;
@@ -556,6 +521,7 @@ as_event_command_read(as_event_command* cmd)
 		
 		as_proto* proto = (as_proto*)cmd->buf;
 		as_proto_swap_from_be(proto);
+		cmd->compressed = proto->type == AS_COMPRESSED_MESSAGE_TYPE;
 		size_t size = proto->sz;
 		
 		cmd->len = (uint32_t)size;
@@ -578,7 +544,7 @@ as_event_command_read(as_event_command* cmd)
 		return rv;
 	}
 
-	if (! cmd->parse_results(cmd)) {
+	if (! as_event_command_parse_results(cmd)) {
 		// Batch, scan, query is not finished.
 		return as_event_command_peek_block(cmd);
 	}
@@ -34,10 +34,9 @@ as_event_register_external_loop(as_event_loop* event_loop)
 {
 }
 
-bool
-as_event_execute(as_event_loop* event_loop, as_event_executable executable, void* udata)
+void
+as_event_send_wakeup(as_event_loop* event_loop)
 {
-	return false;
 }
 
 void
@@ -0,0 +1,1506 @@
+/*
+ * Copyright 2008-2018 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_event.h>
+#include <aerospike/as_event_internal.h>
+#include <aerospike/as_admin.h>
+#include <aerospike/as_async.h>
+#include <aerospike/as_atomic.h>
+#include <aerospike/as_command.h>
+#include <aerospike/as_log_macros.h>
+#include <aerospike/as_pipe.h>
+#include <aerospike/as_proto.h>
+#include <aerospike/as_socket.h>
+#include <aerospike/as_status.h>
+#include <aerospike/as_tls.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <citrusleaf/cf_clock.h>
+
+/******************************************************************************
+ * GLOBALS
+ *****************************************************************************/
+
+extern int as_event_send_buffer_size;
+extern int as_event_recv_buffer_size;
+extern bool as_event_threads_created;
+
+/******************************************************************************
+ * LIBURING FUNCTIONS
+ *****************************************************************************/
+
+#if defined(AS_USE_LIBURING)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// Submission queue size.  Requests beyond this size are flushed to the kernel early.
+#define AS_URING_ENTRIES 1024
+
+// Request types are stored in the low bits of request user data.  The high bits hold
+// the event loop (wakeup) or connection pointer.  Zero user data is ignored.
+#define AS_URING_WAKEUP 1
+#define AS_URING_CONNECT 2
+#define AS_URING_WRITE 3
+#define AS_URING_READ 4
+#define AS_URING_POLL 5
+#define AS_URING_TYPE_MASK 7
+
+#define AS_EVENT_WRITE_COMPLETE 0
+#define AS_EVENT_WRITE_INCOMPLETE 1
+#define AS_EVENT_WRITE_ERROR 2
+
+#define AS_EVENT_READ_COMPLETE 3
+#define AS_EVENT_READ_INCOMPLETE 4
+#define AS_EVENT_READ_ERROR 5
+
+#define AS_EVENT_TLS_NEED_READ 6
+#define AS_EVENT_TLS_NEED_WRITE 7
+
+#define AS_EVENT_COMMAND_DONE 8
+
+static bool as_uring_complete(as_event_loop* event_loop, uint64_t data, int res);
+
+static inline void*
+as_uring_data(void* ptr, int type)
+{
+	return (void*)((uintptr_t)ptr | type);
+}
+
+static struct io_uring_sqe*
+as_uring_get_sqe(as_event_loop* event_loop)
+{
+	struct io_uring* ring = event_loop->loop;
+	struct io_uring_sqe* sqe = io_uring_get_sqe(ring);
+
+	if (! sqe) {
+		// Submission queue is full.  Flush queued requests to the kernel and try again.
+		int rv = io_uring_submit(ring);
+
+		if (rv < 0) {
+			as_log_error("io_uring submit failed: %d", rv);
+			return NULL;
+		}
+		sqe = io_uring_get_sqe(ring);
+	}
+	return sqe;
+}
+
+static bool
+as_uring_set_blocking(as_socket_fd fd, bool blocking)
+{
+	int flags = fcntl(fd, F_GETFL, 0);
+
+	if (flags < 0) {
+		return false;
+	}
+
+	flags = blocking ? flags & ~O_NONBLOCK : flags | O_NONBLOCK;
+	return fcntl(fd, F_SETFL, flags) == 0;
+}
+
+/**
+ * Plain async connections submit connects, writes and reads directly to the ring.
+ * TLS and pipeline connections need readiness notification because TLS may read when
+ * writing (and vice versa) and pipeline connections read and write concurrently.  These
+ * connections submit poll requests and perform non-blocking I/O when the socket is ready.
+ */
+static inline bool
+as_uring_poll_mode(as_event_connection* conn)
+{
+	return conn->pipeline || conn->socket.ctx;
+}
+
+/******************************************************************************
+ * TIMERS
+ *****************************************************************************/
+
+static inline void
+as_uring_timer_set(as_event_loop* event_loop, uint32_t i, as_event_command* cmd)
+{
+	event_loop->timers[i] = cmd;
+	cmd->timer.index = i;
+}
+
+static void
+as_uring_timer_up(as_event_loop* event_loop, uint32_t i)
+{
+	as_event_command** timers = event_loop->timers;
+	as_event_command* cmd = timers[i];
+
+	while (i > 0) {
+		uint32_t parent = (i - 1) / 2;
+
+		if (timers[parent]->timer.expire <= cmd->timer.expire) {
+			break;
+		}
+		as_uring_timer_set(event_loop, i, timers[parent]);
+		i = parent;
+	}
+	as_uring_timer_set(event_loop, i, cmd);
+}
+
+static void
+as_uring_timer_down(as_event_loop* event_loop, uint32_t i)
+{
+	as_event_command** timers = event_loop->timers;
+	as_event_command* cmd = timers[i];
+	uint32_t size = event_loop->timers_size;
+
+	while (true) {
+		uint32_t child = i * 2 + 1;
+
+		if (child >= size) {
+			break;
+		}
+
+		if (child + 1 < size && timers[child + 1]->timer.expire < timers[child]->timer.expire) {
+			child++;
+		}
+
+		if (cmd->timer.expire <= timers[child]->timer.expire) {
+			break;
+		}
+		as_uring_timer_set(event_loop, i, timers[child]);
+		i = child;
+	}
+	as_uring_timer_set(event_loop, i, cmd);
+}
+
+static void
+as_uring_timer_insert(as_event_loop* event_loop, as_event_command* cmd)
+{
+	if (event_loop->timers_size == event_loop->timers_capacity) {
+		event_loop->timers_capacity = event_loop->timers_capacity ?
+			event_loop->timers_capacity * 2 : AS_EVENT_QUEUE_INITIAL_CAPACITY;
+		event_loop->timers = cf_realloc(event_loop->timers,
+			sizeof(as_event_command*) * event_loop->timers_capacity);
+	}
+
+	uint32_t i = event_loop->timers_size++;
+	event_loop->timers[i] = cmd;
+	as_uring_timer_up(event_loop, i);
+}
+
+static void
+as_uring_timer_remove(as_event_loop* event_loop, as_event_command* cmd)
+{
+	uint32_t i = cmd->timer.index;
+	uint32_t last = --event_loop->timers_size;
+
+	cmd->timer.index = AS_URING_TIMER_STOPPED;
+
+	if (i != last) {
+		// Move last timer into the hole and restore heap order.
+		as_event_command* moved = event_loop->timers[last];
+		as_uring_timer_set(event_loop, i, moved);
+		as_uring_timer_up(event_loop, i);
+		as_uring_timer_down(event_loop, moved->timer.index);
+	}
+}
+
+void
+as_uring_timer_start(as_event_command* cmd, uint64_t timeout, uint32_t repeat, as_uring_timer_fn callback)
+{
+	as_event_loop* event_loop = cmd->event_loop;
+
+	if (cmd->timer.index != AS_URING_TIMER_STOPPED) {
+		as_uring_timer_remove(event_loop, cmd);
+	}
+
+	cmd->timer.expire = cf_getms() + timeout;
+	cmd->timer.repeat = repeat;
+	cmd->timer.callback = callback;
+	as_uring_timer_insert(event_loop, cmd);
+}
+
+void
+as_uring_timer_stop(as_event_command* cmd)
+{
+	if (cmd->timer.index != AS_URING_TIMER_STOPPED) {
+		as_uring_timer_remove(cmd->event_loop, cmd);
+	}
+}
+
+static void
+as_uring_process_timers(as_event_loop* event_loop)
+{
+	uint64_t now = cf_getms();
+
+	while (event_loop->timers_size > 0) {
+		as_event_command* cmd = event_loop->timers[0];
+
+		if (cmd->timer.expire > now) {
+			break;
+		}
+
+		as_uring_timer_remove(event_loop, cmd);
+
+		if (cmd->timer.repeat > 0) {
+			// Repeating timers are rearmed before the callback, so the callback can stop
+			// or restart them.
+			cmd->timer.expire = now + cmd->timer.repeat;
+			as_uring_timer_insert(event_loop, cmd);
+		}
+		cmd->timer.callback(cmd);
+	}
+}
+
+/******************************************************************************
+ * EVENT LOOP
+ *****************************************************************************/
+
+static bool
+as_uring_wakeup_submit(as_event_loop* event_loop)
+{
+	struct io_uring_sqe* sqe = as_uring_get_sqe(event_loop);
+
+	if (! sqe) {
+		return false;
+	}
+
+	io_uring_prep_read(sqe, event_loop->wakeup, &event_loop->wakeup_value, sizeof(uint64_t), 0);
+	io_uring_sqe_set_data(sqe, as_uring_data(event_loop, AS_URING_WAKEUP));
+	return true;
+}
+
+static void
+as_uring_close_loop(as_event_loop* event_loop)
+{
+	close(event_loop->wakeup);
+	event_loop->wakeup = -1;
+	cf_free(event_loop->timers);
+	event_loop->timers = NULL;
+	event_loop->timers_size = 0;
+	event_loop->timers_capacity = 0;
+
+	// Cleanup event loop resources.
+	as_event_loop_destroy(event_loop);
+}
+
+static bool
+as_uring_wakeup(as_event_loop* event_loop)
+{
+	if (! as_event_process_queue(event_loop)) {
+		// Received stop signal.
+		as_uring_close_loop(event_loop);
+		return false;
+	}
+
+	if (! as_uring_wakeup_submit(event_loop)) {
+		as_log_error("Failed to rearm io_uring wakeup");
+	}
+	return true;
+}
+
+bool
+as_event_uring_run_once(as_event_loop* event_loop)
+{
+	struct io_uring* ring = event_loop->loop;
+	struct __kernel_timespec ts;
+	struct __kernel_timespec* wait = NULL;
+
+	if (event_loop->timers_size > 0) {
+		// Wait no longer than the nearest command timer.
+		uint64_t now = cf_getms();
+		uint64_t expire = event_loop->timers[0]->timer.expire;
+		uint64_t ms = (expire > now)? expire - now : 0;
+
+		ts.tv_sec = (long long)(ms / 1000);
+		ts.tv_nsec = (long long)((ms % 1000) * 1000 * 1000);
+		wait = &ts;
+	}
+
+	// Submit all requests queued since the last iteration and wait for completions
+	// in a single system call.
+	struct io_uring_cqe* cqe;
+	int rv = io_uring_submit_and_wait_timeout(ring, &cqe, 1, wait, NULL);
+
+	if (rv < 0 && rv != -ETIME && rv != -EINTR) {
+		as_log_error("io_uring wait failed: %d", rv);
+	}
+
+	while (io_uring_peek_cqe(ring, &cqe) == 0) {
+		uint64_t data = cqe->user_data;
+		int res = cqe->res;
+
+		// Release completion entry before the callback, which may submit new requests.
+		io_uring_cqe_seen(ring, cqe);
+
+		if (data && ! as_uring_complete(event_loop, data, res)) {
+			// Event loop has been closed.
+			return false;
+		}
+	}
+
+	as_uring_process_timers(event_loop);
+	return true;
+}
+
+static void*
+as_uring_worker(void* udata)
+{
+	as_event_loop* event_loop = udata;
+	struct io_uring* ring = event_loop->loop;
+
+	while (as_event_uring_run_once(event_loop)) {
+	}
+
+	io_uring_queue_exit(ring);
+	cf_free(ring);
+	as_tls_thread_cleanup();
+	return NULL;
+}
+
+static bool
+as_uring_init_loop(as_event_loop* event_loop)
+{
+	event_loop->timers = NULL;
+	event_loop->timers_size = 0;
+	event_loop->timers_capacity = 0;
+	event_loop->wakeup_value = 0;
+
+	// The wakeup eventfd must block, so the ring waits on it instead of failing the read.
+	event_loop->wakeup = eventfd(0, EFD_CLOEXEC);
+
+	if (event_loop->wakeup < 0) {
+		return false;
+	}
+
+	if (! as_uring_wakeup_submit(event_loop)) {
+		close(event_loop->wakeup);
+		event_loop->wakeup = -1;
+		return false;
+	}
+	return true;
+}
+
+bool
+as_event_create_loop(as_event_loop* event_loop)
+{
+	struct io_uring* ring = cf_malloc(sizeof(struct io_uring));
+
+	if (io_uring_queue_init(AS_URING_ENTRIES, ring, 0) < 0) {
+		cf_free(ring);
+		return false;
+	}
+	event_loop->loop = ring;
+
+	if (! as_uring_init_loop(event_loop)) {
+		io_uring_queue_exit(ring);
+		cf_free(ring);
+		event_loop->loop = NULL;
+		return false;
+	}
+
+	return pthread_create(&event_loop->thread, NULL, as_uring_worker, event_loop) == 0;
+}
+
+void
+as_event_register_external_loop(as_event_loop* event_loop)
+{
+	// This method is only called when user sets an external event loop.
+	if (! as_uring_init_loop(event_loop)) {
+		as_log_error("Failed to initialize io_uring event loop %u", event_loop->index);
+	}
+}
+
+void
+as_event_send_wakeup(as_event_loop* event_loop)
+{
+	uint64_t value = 1;
+
+	if (write(event_loop->wakeup, &value, sizeof(value)) < 0) {
+		as_log_error("Event loop wakeup failed: %d", errno);
+	}
+}
+
+/******************************************************************************
+ * POLL MODE
+ *****************************************************************************/
+
+static void
+as_uring_poll_submit(as_event_loop* event_loop, as_event_connection* conn)
+{
+	struct io_uring_sqe* sqe = as_uring_get_sqe(event_loop);
+
+	if (! sqe) {
+		// Command will eventually time out.
+		return;
+	}
+
+	io_uring_prep_poll_add(sqe, conn->socket.fd, (unsigned)conn->watching);
+	io_uring_sqe_set_data(sqe, as_uring_data(conn, AS_URING_POLL));
+	conn->polled = (uint16_t)conn->watching;
+	conn->pending++;
+}
+
+static void
+as_uring_poll_cancel(as_event_loop* event_loop, as_event_connection* conn)
+{
+	struct io_uring_sqe* sqe = as_uring_get_sqe(event_loop);
+
+	if (! sqe) {
+		return;
+	}
+
+	// Cancel completion is ignored.  The canceled poll completes with -ECANCELED.
+	io_uring_prep_cancel(sqe, as_uring_data(conn, AS_URING_POLL), 0);
+	io_uring_sqe_set_data(sqe, NULL);
+}
+
+static void
+as_uring_watch(as_event_command* cmd, int watch)
+{
+	as_event_connection* conn = cmd->conn;
+	conn->watching = watch;
+
+	// Skip if we're already polling the right stuff.
+	if (conn->polled == watch) {
+		return;
+	}
+
+	if (conn->polled) {
+		// Poll requests can't be modified.  Cancel the outstanding poll and submit the
+		// new mask when the cancel completes.
+		as_uring_poll_cancel(cmd->event_loop, conn);
+		return;
+	}
+	as_uring_poll_submit(cmd->event_loop, conn);
+}
+
+static inline void
+as_uring_watch_write(as_event_command* cmd)
+{
+	as_uring_watch(cmd, cmd->pipe_listener != NULL ? POLLOUT | POLLIN : POLLOUT);
+}
+
+static inline void
+as_uring_watch_read(as_event_command* cmd)
+{
+	as_uring_watch(cmd, POLLIN);
+}
+
+void
+as_uring_stop_watcher(as_event_loop* event_loop, as_event_connection* conn)
+{
+	if (! as_uring_poll_mode(conn)) {
+		// Direct requests are only outstanding when the connection is about to be closed.
+		// Close shuts down the socket, which completes them.
+		return;
+	}
+
+	conn->watching = 0;
+
+	if (conn->polled) {
+		as_uring_poll_cancel(event_loop, conn);
+	}
+}
+
+static int
+as_uring_write_poll(as_event_command* cmd)
+{
+	if (cmd->conn->socket.ctx) {
+		do {
+			uint32_t size;
+			uint8_t* buf = as_event_write_segment(cmd, &size);
+			int rv = as_tls_write_once(&cmd->conn->socket, buf, size);
+			if (rv > 0) {
+				as_uring_watch_write(cmd);
+				cmd->pos += rv;
+				continue;
+			}
+			else if (rv == -1) {
+				// TLS sometimes need to read even when we are writing.
+				as_uring_watch_read(cmd);
+				return AS_EVENT_TLS_NEED_READ;
+			}
+			else if (rv == -2) {
+				// TLS wants a write, we're all set for that.
+				as_uring_watch_write(cmd);
+				return AS_EVENT_WRITE_INCOMPLETE;
+			}
+			else if (rv < -2) {
+				int fd = cmd->conn->socket.fd;
+
+				if (! as_event_socket_retry(cmd)) {
+					as_error err;
+					as_socket_error(fd, cmd->node, &err, AEROSPIKE_ERR_TLS_ERROR, "TLS write failed", rv);
+					as_event_socket_error(cmd, &err);
+				}
+				return AS_EVENT_WRITE_ERROR;
+			}
+			// as_tls_write_once can't return 0
+		} while (cmd->pos < cmd->len);
+	}
+	else {
+		int fd = cmd->conn->socket.fd;
+		ssize_t bytes;
+
+		do {
+			bytes = as_event_send(cmd, fd);
+			if (bytes > 0) {
+				cmd->pos += bytes;
+				continue;
+			}
+
+			if (bytes < 0) {
+				int e = as_last_error();
+
+				if (e == AS_WOULDBLOCK) {
+					as_uring_watch_write(cmd);
+					return AS_EVENT_WRITE_INCOMPLETE;
+				}
+
+				if (! as_event_socket_retry(cmd)) {
+					as_error err;
+					as_socket_error(fd, cmd->node, &err, AEROSPIKE_ERR_ASYNC_CONNECTION, "Socket write failed", e);
+					as_event_socket_error(cmd, &err);
+				}
+				return AS_EVENT_WRITE_ERROR;
+			}
+			else {
+				if (! as_event_socket_retry(cmd)) {
+					as_error err;
+					as_socket_error(fd, cmd->node, &err, AEROSPIKE_ERR_ASYNC_CONNECTION, "Socket write closed by peer", 0);
+					as_event_socket_error(cmd, &err);
+				}
+				return AS_EVENT_WRITE_ERROR;
+			}
+		} while (cmd->pos < cmd->len);
+	}
+
+	// Socket timeout applies only to read events.
+	// Reset event received because we are switching from a write to a read state.
+	cmd->flags &= ~AS_ASYNC_FLAGS_EVENT_RECEIVED;
+	return AS_EVENT_WRITE_COMPLETE;
+}
+
+static int
+as_uring_read_poll(as_event_command* cmd)
+{
+	cmd->flags |= AS_ASYNC_FLAGS_EVENT_RECEIVED;
+
+	if (cmd->conn->socket.ctx) {
+		do {
+			int rv = as_tls_read_once(&cmd->conn->socket, cmd->buf + cmd->pos, cmd->len - cmd->pos);
+			if (rv > 0) {
+				as_uring_watch_read(cmd);
+				cmd->pos += rv;
+				continue;
+			}
+			else if (rv == -1) {
+				// TLS wants a read
+				as_uring_watch_read(cmd);
+				return AS_EVENT_READ_INCOMPLETE;
+			}
+			else if (rv == -2) {
+				// TLS sometimes needs to write, even when the app is reading.
+				as_uring_watch_write(cmd);
+				return AS_EVENT_TLS_NEED_WRITE;
+			}
+			else if (rv < -2) {
+				int fd = cmd->conn->socket.fd;
+
+				if (! as_event_socket_retry(cmd)) {
+					as_error err;
+					as_socket_error(fd, cmd->node, &err, AEROSPIKE_ERR_TLS_ERROR, "TLS read failed", rv);
+					as_event_socket_error(cmd, &err);
+				}
+				return AS_EVENT_READ_ERROR;
+			}
+			// as_tls_read_once doesn't return 0
+		} while (cmd->pos < cmd->len);
+	}
+	else {
+		int fd = cmd->conn->socket.fd;
+		ssize_t bytes;
+
+		do {
+			bytes = read(fd, cmd->buf + cmd->pos, cmd->len - cmd->pos);
+
+			if (bytes > 0) {
+				cmd->pos += bytes;
+				continue;
+			}
+
+			if (bytes < 0) {
+				int e = as_last_error();
+
+				if (e == EWOULDBLOCK) {
+					as_uring_watch_read(cmd);
+					return AS_EVENT_READ_INCOMPLETE;
+				}
+
+				if (! as_event_socket_retry(cmd)) {
+					as_error err;
+					as_socket_error(fd, cmd->node, &err, AEROSPIKE_ERR_ASYNC_CONNECTION, "Socket read failed", e);
+					as_event_socket_error(cmd, &err);
+				}
+				return AS_EVENT_READ_ERROR;
+			}
+			else {
+				if (! as_event_socket_retry(cmd)) {
+					as_error err;
+					as_socket_error(fd, cmd->node, &err, AEROSPIKE_ERR_ASYNC_CONNECTION, "Socket read closed by peer", 0);
+					as_event_socket_error(cmd, &err);
+				}
+				return AS_EVENT_READ_ERROR;
+			}
+		} while (cmd->pos < cmd->len);
+	}
+
+	as_node_add_bytes_in(cmd->node, cmd->len);
+	return AS_EVENT_READ_COMPLETE;
+}
+
+static inline void
+as_uring_poll_read_start(as_event_command* cmd)
+{
+	as_node_add_bytes_out(cmd->node, cmd->len);
+	cmd->command_sent_counter++;
+	cmd->len = sizeof(as_proto);
+	cmd->pos = 0;
+	cmd->state = AS_ASYNC_STATE_COMMAND_READ_HEADER;
+
+	as_uring_watch_read(cmd);
+
+	if (cmd->pipe_listener != NULL) {
+		as_pipe_read_start(cmd);
+	}
+}
+
+static inline bool
+as_uring_set_read_body(as_event_command* cmd)
+{
+	as_proto* proto = (as_proto*)cmd->buf;
+	as_proto_swap_from_be(proto);
+	cmd->compressed = proto->type == AS_COMPRESSED_MESSAGE_TYPE;
+	size_t size = proto->sz;
+
+	cmd->len = (uint32_t)size;
+	cmd->pos = 0;
+	cmd->state = AS_ASYNC_STATE_COMMAND_READ_BODY;
+
+	if (cmd->len > cmd->read_capacity) {
+		if (cmd->flags & AS_ASYNC_FLAGS_FREE_BUF) {
+			cf_free(cmd->buf);
+		}
+		cmd->buf = cf_malloc(size);
+		cmd->read_capacity = cmd->len;
+		cmd->flags |= AS_ASYNC_FLAGS_FREE_BUF;
+	}
+	return cmd->len == sizeof(as_msg);
+}
+
+static int
+as_uring_command_peek_block(as_event_command* cmd)
+{
+	// Batch, scan, query may be waiting on end block.
+	// Prepare for next message block.
+	cmd->len = sizeof(as_proto);
+	cmd->pos = 0;
+	cmd->state = AS_ASYNC_STATE_COMMAND_READ_HEADER;
+
+	int rv = as_uring_read_poll(cmd);
+	if (rv != AS_EVENT_READ_COMPLETE) {
+		return rv;
+	}
+
+	// Check for end block size.
+	if (as_uring_set_read_body(cmd)) {
+		// Look like we received end block.  Read and parse to make sure.
+		rv = as_uring_read_poll(cmd);
+		if (rv != AS_EVENT_READ_COMPLETE) {
+			return rv;
+		}
+
+		if (! as_event_command_parse_results(cmd)) {
+			// We did not finish after all. Prepare to read next header.
+			cmd->len = sizeof(as_proto);
+			cmd->pos = 0;
+			cmd->state = AS_ASYNC_STATE_COMMAND_READ_HEADER;
+		}
+		else {
+			return AS_EVENT_COMMAND_DONE;
+		}
+	}
+	// Otherwise, received normal data block.  Stop reading for fairness reasons and wait
+	// till next iteration.
+	return AS_EVENT_READ_COMPLETE;
+}
+
+static int
+as_uring_parse_authentication(as_event_command* cmd)
+{
+	int rv;
+	if (cmd->state == AS_ASYNC_STATE_AUTH_READ_HEADER) {
+		// Read response length
+		rv = as_uring_read_poll(cmd);
+		if (rv != AS_EVENT_READ_COMPLETE) {
+			return rv;
+		}
+		as_event_set_auth_parse_header(cmd);
+
+		if (cmd->len > cmd->read_capacity) {
+			as_error err;
+			as_error_update(&err, AEROSPIKE_ERR_CLIENT, "Authenticate response size is corrupt: %u", cmd->len);
+			as_event_parse_error(cmd, &err);
+			return AS_EVENT_READ_ERROR;
+		}
+	}
+
+	rv = as_uring_read_poll(cmd);
+	if (rv != AS_EVENT_READ_COMPLETE) {
+		return rv;
+	}
+
+	// Parse authentication response.
+	uint8_t code = cmd->buf[AS_ASYNC_AUTH_RETURN_CODE];
+
+	if (code) {
+		// Can't authenticate socket, so must close it.
+		as_node_signal_login(cmd->node);
+		as_error err;
+		as_error_update(&err, code, "Authentication failed: %s", as_error_string(code));
+		as_event_parse_error(cmd, &err);
+		return AS_EVENT_READ_ERROR;
+	}
+
+	as_event_command_write_start(cmd);
+	return AS_EVENT_READ_COMPLETE;
+}
+
+static int
+as_uring_command_read(as_event_command* cmd)
+{
+	int rv;
+
+	if (cmd->state == AS_ASYNC_STATE_COMMAND_READ_HEADER) {
+		// Read response length
+		rv = as_uring_read_poll(cmd);
+		if (rv != AS_EVENT_READ_COMPLETE) {
+			return rv;
+		}
+		as_uring_set_read_body(cmd);
+	}
+
+	// Read response body
+	rv = as_uring_read_poll(cmd);
+	if (rv != AS_EVENT_READ_COMPLETE) {
+		return rv;
+	}
+
+	if (! as_event_command_parse_results(cmd)) {
+		// Batch, scan, query is not finished.
+		return as_uring_command_peek_block(cmd);
+	}
+
+	return AS_EVENT_COMMAND_DONE;
+}
+
+static bool
+as_uring_tls_connect(as_event_command* cmd, as_event_connection* conn)
+{
+	int rv = as_tls_connect_once(&conn->socket);
+	if (rv < -2) {
+		if (! as_event_socket_retry(cmd)) {
+			// Failed, error has been logged.
+			as_error err;
+			as_error_set_message(&err, AEROSPIKE_ERR_TLS_ERROR, "TLS connection failed");
+			as_event_socket_error(cmd, &err);
+		}
+		return false;
+	}
+	else if (rv == -1) {
+		// TLS needs a read.
+		as_uring_watch_read(cmd);
+	}
+	else if (rv == -2) {
+		// TLS needs a write.
+		as_uring_watch_write(cmd);
+	}
+	else if (rv == 0) {
+		if (! as_event_socket_retry(cmd)) {
+			as_error err;
+			as_error_set_message(&err, AEROSPIKE_ERR_TLS_ERROR, "TLS connection shutdown");
+			as_event_socket_error(cmd, &err);
+		}
+		return false;
+	}
+	else
+	{
+		// TLS connection established.
+		if (cmd->cluster->user) {
+			as_event_set_auth_write(cmd);
+			cmd->state = AS_ASYNC_STATE_AUTH_WRITE;
+		}
+		else {
+			as_event_set_write(cmd);
+			cmd->state = AS_ASYNC_STATE_COMMAND_WRITE;
+		}
+		as_uring_watch_write(cmd);
+	}
+	return true;
+}
+
+static void
+as_uring_callback_common(as_event_command* cmd, as_event_connection* conn)
+{
+	switch (cmd->state) {
+	case AS_ASYNC_STATE_TLS_CONNECT:
+		do {
+			if (! as_uring_tls_connect(cmd, conn)) {
+				return;
+			}
+		} while (as_tls_read_pending(&cmd->conn->socket) > 0);
+		break;
+
+	case AS_ASYNC_STATE_AUTH_READ_HEADER:
+	case AS_ASYNC_STATE_AUTH_READ_BODY:
+		// If we're using TLS we must loop until there are no bytes
+		// left in the encryption buffer because we won't get another
+		// poll event.
+		do {
+			switch (as_uring_parse_authentication(cmd)) {
+				case AS_EVENT_COMMAND_DONE:
+				case AS_EVENT_READ_ERROR:
+					// Do not touch cmd again because it's been deallocated.
+					return;
+
+				case AS_EVENT_READ_COMPLETE:
+					as_uring_watch_read(cmd);
+					break;
+
+				default:
+					break;
+			}
+		} while (as_tls_read_pending(&cmd->conn->socket) > 0);
+		break;
+
+	case AS_ASYNC_STATE_COMMAND_READ_HEADER:
+	case AS_ASYNC_STATE_COMMAND_READ_BODY:
+		// If we're using TLS we must loop until there are no bytes
+		// left in the encryption buffer because we won't get another
+		// poll event.
+		do {
+			switch (as_uring_command_read(cmd)) {
+			case AS_EVENT_COMMAND_DONE:
+			case AS_EVENT_READ_ERROR:
+				// Do not touch cmd again because it's been deallocated.
+				return;
+
+			case AS_EVENT_READ_COMPLETE:
+				as_uring_watch_read(cmd);
+				break;
+
+			default:
+				break;
+			}
+		} while (as_tls_read_pending(&cmd->conn->socket) > 0);
+		break;
+
+	case AS_ASYNC_STATE_AUTH_WRITE:
+	case AS_ASYNC_STATE_COMMAND_WRITE:
+		as_uring_watch_write(cmd);
+
+		if (as_uring_write_poll(cmd) == AS_EVENT_WRITE_COMPLETE) {
+			// Done with write. Register for read.
+			if (cmd->state == AS_ASYNC_STATE_AUTH_WRITE) {
+				as_event_set_auth_read_header(cmd);
+				as_uring_watch_read(cmd);
+			}
+			else {
+				as_uring_poll_read_start(cmd);
+			}
+		}
+		break;
+
+	default:
+		as_log_error("unexpected cmd state %d", cmd->state);
+		break;
+	}
+}
+
+static void
+as_uring_poll_callback(as_event_connection* conn, int revents)
+{
+	as_event_command* cmd;
+
+	// Errors and hangups are reported regardless of the requested mask.  Handle them
+	// on the read path when reading, so the read reports the socket error.
+	if ((revents & POLLIN) || ((revents & (POLLERR | POLLHUP)) && (conn->watching & POLLIN))) {
+		if (conn->pipeline) {
+			as_pipe_connection* pipe = (as_pipe_connection*)conn;
+
+			if (pipe->writer && cf_ll_size(&pipe->readers) == 0) {
+				// Authentication response will only have a writer.
+				cmd = pipe->writer;
+			}
+			else {
+				// Next response is at head of reader linked list.
+				cf_ll_element* link = cf_ll_get_head(&pipe->readers);
+
+				if (link) {
+					cmd = as_pipe_link_to_command(link);
+				}
+				else {
+					as_log_debug("Pipeline read event ignored");
+					return;
+				}
+			}
+		}
+		else {
+			cmd = ((as_async_connection*)conn)->cmd;
+		}
+	}
+	else {
+		cmd = conn->pipeline ?
+			((as_pipe_connection*)conn)->writer :
+			((as_async_connection*)conn)->cmd;
+
+		if (! cmd) {
+			as_log_debug("Pipeline write event ignored");
+			return;
+		}
+	}
+
+	as_uring_callback_common(cmd, conn);
+}
+
+static void
+as_uring_poll_complete(as_event_loop* event_loop, as_event_connection* conn, int res)
+{
+	// Poll requests are one-shot.
+	conn->polled = 0;
+
+	// Canceled polls only need to be rearmed.  Report poll failures as socket errors,
+	// so the callback's read or write surfaces the error.
+	int revents = (res == -ECANCELED)? 0 : (res < 0)? POLLERR : res;
+
+	if (revents && conn->watching) {
+		// Hold connection while callback runs, so a close from the callback does not
+		// free it.
+		conn->pending++;
+		as_uring_poll_callback(conn, revents);
+		conn->pending--;
+
+		if (conn->closed) {
+			if (conn->pending == 0) {
+				cf_free(conn);
+			}
+			return;
+		}
+	}
+
+	// Rearm poll if still watching.  This also applies a new mask after a canceled poll.
+	if (conn->watching && ! conn->polled) {
+		as_uring_poll_submit(event_loop, conn);
+	}
+}
+
+/******************************************************************************
+ * DIRECT MODE
+ *****************************************************************************/
+
+static inline void
+as_uring_track(as_event_command* cmd, struct io_uring_sqe* sqe, uint8_t type)
+{
+	as_event_connection* conn = cmd->conn;
+	io_uring_sqe_set_data(sqe, as_uring_data(conn, type));
+	conn->owner = cmd;
+	conn->io = type;
+	conn->pending++;
+	cmd->ops++;
+}
+
+static void
+as_uring_io_error(as_event_command* cmd, int res, const char* message)
+{
+	int fd = cmd->conn->socket.fd;
+
+	if (! as_event_socket_retry(cmd)) {
+		as_error err;
+		as_socket_error(fd, cmd->node, &err, AEROSPIKE_ERR_ASYNC_CONNECTION, message, -res);
+		as_event_socket_error(cmd, &err);
+	}
+}
+
+static void
+as_uring_write(as_event_command* cmd)
+{
+	struct io_uring_sqe* sqe = as_uring_get_sqe(cmd->event_loop);
+
+	if (! sqe) {
+		as_uring_io_error(cmd, -EBUSY, "Socket write submit failed");
+		return;
+	}
+
+	uint32_t size;
+	uint8_t* buf = as_event_write_segment(cmd, &size);
+	io_uring_prep_send(sqe, cmd->conn->socket.fd, buf, size, MSG_NOSIGNAL);
+	as_uring_track(cmd, sqe, AS_URING_WRITE);
+}
+
+static void
+as_uring_read(as_event_command* cmd)
+{
+	struct io_uring_sqe* sqe = as_uring_get_sqe(cmd->event_loop);
+
+	if (! sqe) {
+		as_uring_io_error(cmd, -EBUSY, "Socket read submit failed");
+		return;
+	}
+
+	io_uring_prep_recv(sqe, cmd->conn->socket.fd, cmd->buf + cmd->pos, cmd->len - cmd->pos, 0);
+	as_uring_track(cmd, sqe, AS_URING_READ);
+}
+
+void
+as_event_command_write_start(as_event_command* cmd)
+{
+	as_event_set_write(cmd);
+	cmd->state = AS_ASYNC_STATE_COMMAND_WRITE;
+
+	if (as_uring_poll_mode(cmd->conn)) {
+		as_uring_watch_write(cmd);
+
+		if (as_uring_write_poll(cmd) == AS_EVENT_WRITE_COMPLETE) {
+			// Done with write. Register for read.
+			as_uring_poll_read_start(cmd);
+		}
+		return;
+	}
+
+	// Write is submitted with all other requests at the end of the event loop iteration.
+	as_uring_write(cmd);
+}
+
+static void
+as_uring_write_complete(as_event_command* cmd, int res)
+{
+	if (res <= 0) {
+		if (res == -EAGAIN || res == -EINTR) {
+			as_uring_write(cmd);
+			return;
+		}
+		as_uring_io_error(cmd, res, res ? "Socket write failed" : "Socket write closed by peer");
+		return;
+	}
+
+	cmd->pos += res;
+
+	if (cmd->pos < cmd->len) {
+		// Write next segment or remainder of a short write.
+		as_uring_write(cmd);
+		return;
+	}
+
+	// Socket timeout applies only to read events.
+	// Reset event received because we are switching from a write to a read state.
+	cmd->flags &= ~AS_ASYNC_FLAGS_EVENT_RECEIVED;
+
+	if (cmd->state == AS_ASYNC_STATE_AUTH_WRITE) {
+		as_event_set_auth_read_header(cmd);
+	}
+	else {
+		as_node_add_bytes_out(cmd->node, cmd->len);
+		cmd->command_sent_counter++;
+		cmd->len = sizeof(as_proto);
+		cmd->pos = 0;
+		cmd->state = AS_ASYNC_STATE_COMMAND_READ_HEADER;
+	}
+	as_uring_read(cmd);
+}
+
+static void
+as_uring_read_complete(as_event_command* cmd, int res)
+{
+	if (res <= 0) {
+		if (res == -EAGAIN || res == -EINTR) {
+			as_uring_read(cmd);
+			return;
+		}
+		as_uring_io_error(cmd, res, res ? "Socket read failed" : "Socket read closed by peer");
+		return;
+	}
+
+	cmd->flags |= AS_ASYNC_FLAGS_EVENT_RECEIVED;
+	cmd->pos += res;
+
+	if (cmd->pos < cmd->len) {
+		as_uring_read(cmd);
+		return;
+	}
+
+	as_node_add_bytes_in(cmd->node, cmd->len);
+
+	switch (cmd->state) {
+	case AS_ASYNC_STATE_AUTH_READ_HEADER: {
+		as_event_set_auth_parse_header(cmd);
+
+		if (cmd->len > cmd->read_capacity) {
+			as_error err;
+			as_error_update(&err, AEROSPIKE_ERR_CLIENT, "Authenticate response size is corrupt: %u", cmd->len);
+			as_event_parse_error(cmd, &err);
+			return;
+		}
+		as_uring_read(cmd);
+		break;
+	}
+
+	case AS_ASYNC_STATE_AUTH_READ_BODY: {
+		// Parse authentication response.
+		uint8_t code = cmd->buf[AS_ASYNC_AUTH_RETURN_CODE];
+
+		if (code) {
+			// Can't authenticate socket, so must close it.
+			as_node_signal_login(cmd->node);
+			as_error err;
+			as_error_update(&err, code, "Authentication failed: %s", as_error_string(code));
+			as_event_parse_error(cmd, &err);
+			return;
+		}
+		as_event_command_write_start(cmd);
+		break;
+	}
+
+	case AS_ASYNC_STATE_COMMAND_READ_HEADER:
+		as_uring_set_read_body(cmd);
+		as_uring_read(cmd);
+		break;
+
+	case AS_ASYNC_STATE_COMMAND_READ_BODY:
+		if (! as_event_command_parse_results(cmd)) {
+			// Batch, scan, query is not finished.  Read next message block.
+			cmd->len = sizeof(as_proto);
+			cmd->pos = 0;
+			cmd->state = AS_ASYNC_STATE_COMMAND_READ_HEADER;
+			as_uring_read(cmd);
+		}
+		// Otherwise, cmd has been deallocated.
+		break;
+
+	default:
+		as_log_error("unexpected cmd state %d", cmd->state);
+		break;
+	}
+}
+
+/******************************************************************************
+ * CONNECT
+ *****************************************************************************/
+
+/**
+ * Return node address index of connect attempt, or -1 when all addresses have been tried.
+ * Addresses of the primary address family are tried first, starting at the primary address.
+ */
+static int
+as_uring_address_index(as_node* node, uint32_t primary, uint32_t attempt)
+{
+	bool ipv4 = node->addresses[primary].addr.ss_family == AF_INET;
+	uint32_t begin1 = ipv4 ? 0 : AS_ADDRESS4_MAX;
+	uint32_t size1 = ipv4 ? node->address4_size : node->address6_size;
+	uint32_t begin2 = ipv4 ? AS_ADDRESS4_MAX : 0;
+	uint32_t size2 = ipv4 ? node->address6_size : node->address4_size;
+
+	if (attempt < size1) {
+		return (int)(begin1 + (primary - begin1 + attempt) % size1);
+	}
+
+	attempt -= size1;
+
+	if (attempt < size2) {
+		return (int)(begin2 + attempt);
+	}
+	return -1;
+}
+
+static void
+as_uring_connect_error(as_event_command* cmd, int rv)
+{
+	// Socket has already been closed. Release connection.
+	as_address* primary = &cmd->node->addresses[cmd->len];
+
+	cf_free(cmd->conn);
+	as_event_decr_conn(cmd);
+	cmd->event_loop->errors++;
+
+	if (as_event_command_retry(cmd, true)) {
+		return;
+	}
+
+	as_error err;
+	as_error_update(&err, AEROSPIKE_ERR_ASYNC_CONNECTION, "Connect failed: %d %s %s", rv, cmd->node->name, primary->name);
+
+	// Only timer needs to be released on socket connection failure.
+	if (cmd->flags & AS_ASYNC_FLAGS_HAS_TIMER) {
+		as_event_stop_timer(cmd);
+	}
+	as_event_error_callback(cmd, &err);
+}
+
+static void
+as_uring_connect_next(as_event_command* cmd, int rv)
+{
+	// While connecting, len holds the primary address index and pos holds the next
+	// connect attempt.  Both are reset when the write starts.
+	as_event_connection* conn = cmd->conn;
+	as_node* node = cmd->node;
+	int index;
+
+	while ((index = as_uring_address_index(node, cmd->len, cmd->pos)) >= 0) {
+		cmd->pos++;
+
+		as_address* address = &node->addresses[index];
+		int family = address->addr.ss_family;
+		as_socket_fd fd;
+
+		rv = as_socket_create_fd(family, &fd);
+
+		if (rv < 0) {
+			continue;
+		}
+
+		if (cmd->pipe_listener && ! as_pipe_modify_fd(fd)) {
+			as_close(fd);
+			rv = -1000;
+			continue;
+		}
+
+		// Connect blocks in the kernel instead of returning EINPROGRESS.
+		if (! as_uring_set_blocking(fd, true)) {
+			as_close(fd);
+			rv = -2;
+			continue;
+		}
+
+		as_tls_context* ctx = as_socket_get_tls_context(cmd->cluster->tls_ctx);
+
+		if (! as_socket_wrap(&conn->socket, family, fd, ctx, node->tls_name)) {
+			rv = -1001;
+			continue;
+		}
+
+		struct io_uring_sqe* sqe = as_uring_get_sqe(cmd->event_loop);
+
+		if (! sqe) {
+			as_socket_close(&conn->socket);
+			rv = -1003;
+			break;
+		}
+
+		socklen_t size = (family == AF_INET)? sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6);
+		io_uring_prep_connect(sqe, fd, (struct sockaddr*)&address->addr, size);
+		as_uring_track(cmd, sqe, AS_URING_CONNECT);
+
+		// Socket is registered, so timeouts close the connection.
+		conn->watching = POLLOUT;
+		return;
+	}
+
+	as_uring_connect_error(cmd, rv);
+}
+
+void
+as_event_connect(as_event_command* cmd)
+{
+	as_event_connection* conn = cmd->conn;
+	conn->owner = cmd;
+	conn->pending = 0;
+	conn->polled = 0;
+	conn->io = 0;
+	conn->closed = false;
+
+	cmd->len = as_load_uint32(&cmd->node->address_index);
+	cmd->pos = 0;
+	as_uring_connect_next(cmd, -1002);
+}
+
+static void
+as_uring_connect_complete(as_event_command* cmd, int res)
+{
+	as_event_connection* conn = cmd->conn;
+
+	if (res < 0) {
+		// Try next address.
+		as_socket_close(&conn->socket);
+		conn->watching = 0;
+		as_uring_connect_next(cmd, res);
+		return;
+	}
+
+	as_node* node = cmd->node;
+	uint32_t index = (uint32_t)as_uring_address_index(node, cmd->len, cmd->pos - 1);
+
+	if (index != cmd->len) {
+		// Replace invalid primary address with valid alias.
+		// Other threads may not see this change immediately.
+		// It's just a hint, not a requirement to try this new address first.
+		as_store_uint32(&node->address_index, index);
+		as_log_debug("Change node address %s %s", node->name, as_node_get_address_string(node));
+	}
+	cmd->event_loop->errors = 0; // Reset errors on valid connection.
+
+	if (as_uring_poll_mode(conn)) {
+		if (! as_uring_set_blocking(conn->socket.fd, false)) {
+			as_uring_io_error(cmd, -errno, "Socket mode change failed");
+			return;
+		}
+
+		if (conn->socket.ctx) {
+			cmd->state = AS_ASYNC_STATE_TLS_CONNECT;
+		}
+		else if (cmd->cluster->user) {
+			as_event_set_auth_write(cmd);
+			cmd->state = AS_ASYNC_STATE_AUTH_WRITE;
+		}
+		else {
+			as_event_set_write(cmd);
+			cmd->state = AS_ASYNC_STATE_COMMAND_WRITE;
+		}
+		as_uring_watch_write(cmd);
+		return;
+	}
+
+	if (cmd->cluster->user) {
+		as_event_set_auth_write(cmd);
+		cmd->state = AS_ASYNC_STATE_AUTH_WRITE;
+	}
+	else {
+		as_event_set_write(cmd);
+		cmd->state = AS_ASYNC_STATE_COMMAND_WRITE;
+	}
+	as_uring_write(cmd);
+}
+
+/******************************************************************************
+ * COMPLETIONS
+ *****************************************************************************/
+
+static bool
+as_uring_complete(as_event_loop* event_loop, uint64_t data, int res)
+{
+	int type = (int)(data & AS_URING_TYPE_MASK);
+
+	if (type == AS_URING_WAKEUP) {
+		return as_uring_wakeup(event_loop);
+	}
+
+	as_event_connection* conn = (as_event_connection*)(uintptr_t)(data & ~(uint64_t)AS_URING_TYPE_MASK);
+	conn->pending--;
+
+	if (type == AS_URING_POLL) {
+		if (conn->closed) {
+			if (conn->pending == 0) {
+				cf_free(conn);
+			}
+			return true;
+		}
+		as_uring_poll_complete(event_loop, conn, res);
+		return true;
+	}
+
+	as_event_command* cmd = conn->owner;
+	bool stale = cmd->released;
+
+	conn->io = 0;
+	cmd->ops--;
+
+	if (stale && cmd->ops == 0) {
+		// Command completed while the kernel still referenced its buffers.
+		as_event_command_free(cmd);
+	}
+
+	if (conn->closed) {
+		if (conn->pending == 0) {
+			cf_free(conn);
+		}
+		return true;
+	}
+
+	if (stale) {
+		return true;
+	}
+
+	switch (type) {
+	case AS_URING_CONNECT:
+		as_uring_connect_complete(cmd, res);
+		break;
+
+	case AS_URING_WRITE:
+		as_uring_write_complete(cmd, res);
+		break;
+
+	case AS_URING_READ:
+		as_uring_read_complete(cmd, res);
+		break;
+
+	default:
+		as_log_warn("Unknown io_uring request type: %d", type);
+		break;
+	}
+	return true;
+}
+
+/******************************************************************************
+ * CONNECTION FUNCTIONS
+ *****************************************************************************/
+
+void
+as_event_close_connection(as_event_connection* conn)
+{
+	if (conn->pending > 0) {
+		// Outstanding requests still reference the connection.  Shut down the socket to
+		// force their completion and free the connection when the last one completes.
+		shutdown(conn->socket.fd, SHUT_RDWR);
+		as_socket_close(&conn->socket);
+		conn->closed = true;
+		return;
+	}
+	as_socket_close(&conn->socket);
+	cf_free(conn);
+}
+
+static void
+as_uring_close_connections(as_conn_pool* pool)
+{
+	as_event_connection* conn;
+
+	// Queue connection commands to event loops.
+	while (as_conn_pool_get(pool, &conn)) {
+		as_event_close_connection(conn);
+		as_conn_pool_dec(pool);
+	}
+	as_conn_pool_destroy(pool);
+}
+
+void
+as_event_node_destroy(as_node* node)
+{
+	// Close connections.
+	for (uint32_t i = 0; i < as_event_loop_size; i++) {
+		as_uring_close_connections(&node->async_conn_pools[i]);
+		as_uring_close_connections(&node->pipe_conn_pools[i]);
+	}
+	cf_free(node->async_conn_pools);
+	cf_free(node->pipe_conn_pools);
+}
+
+#endif
@@ -17,6 +17,7 @@
 #include <aerospike/as_event.h>
 #include <aerospike/as_event_internal.h>
 #include <aerospike/as_async.h>
+#include <aerospike/as_command.h>
 #include <aerospike/as_log_macros.h>
 #include <aerospike/as_monitor.h>
 #include <aerospike/as_pipe.h>
@@ -82,35 +83,11 @@ as_uv_close_loop(as_event_loop* event_loop)
 static void
 as_uv_wakeup(uv_async_t* wakeup)
 {
-	// Read command pointers from queue.
 	as_event_loop* event_loop = wakeup->data;
-	as_event_commander cmd;
-	uint32_t i = 0;
-
-	// Only process original size of queue.  Recursive pre-registration errors can
-	// result in new commands being added while the loop is in process.  If we process
-	// them, we could end up in an infinite loop.
-	pthread_mutex_lock(&event_loop->lock);
-	uint32_t size = as_queue_size(&event_loop->queue);
-	bool status = as_queue_pop(&event_loop->queue, &cmd);
-	pthread_mutex_unlock(&event_loop->lock);
-
-	while (status) {
-		if (! cmd.executable) {
-			// Received stop signal.
-			as_uv_close_loop(event_loop);
-			return;
-		}
-		cmd.executable(cmd.udata);
 
-		if (++i < size) {
-			pthread_mutex_lock(&event_loop->lock);
-			status = as_queue_pop(&event_loop->queue, &cmd);
-			pthread_mutex_unlock(&event_loop->lock);
-		}
-		else {
-			break;
-		}
+	if (! as_event_process_queue(event_loop)) {
+		// Received stop signal.
+		as_uv_close_loop(event_loop);
 	}
 }
 
@@ -201,19 +178,10 @@ as_event_register_external_loop(as_event_loop* event_loop)
 	uv_async_init(event_loop->loop, event_loop->wakeup, as_uv_wakeup);
 }
 
-bool
-as_event_execute(as_event_loop* event_loop, as_event_executable executable, void* udata)
+void
+as_event_send_wakeup(as_event_loop* event_loop)
 {
-	// Send command through queue so it can be executed in event loop thread.
-	pthread_mutex_lock(&event_loop->lock);
-	as_event_commander qcmd = {.executable = executable, .udata = udata};
-	bool queued = as_queue_push(&event_loop->queue, &qcmd);
-	pthread_mutex_unlock(&event_loop->lock);
-
-	if (queued) {
-		uv_async_send(event_loop->wakeup);
-	}
-	return queued;
+	uv_async_send(event_loop->wakeup);
 }
 
 static inline as_event_command*
@@ -284,9 +252,12 @@ as_uv_command_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf)
 		return;
 	}
 
+	as_node_add_bytes_in(cmd->node, cmd->len);
+
 	if (cmd->state == AS_ASYNC_STATE_COMMAND_READ_HEADER) {
 		as_proto* proto = (as_proto*)cmd->buf;
 		as_proto_swap_from_be(proto);
+		cmd->compressed = proto->type == AS_COMPRESSED_MESSAGE_TYPE;
 		size_t size = proto->sz;
 		
 		cmd->len = (uint32_t)size;
@@ -322,7 +293,7 @@ as_uv_command_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf)
 		}
 	}
 
-	if (cmd->parse_results(cmd)) {
+	if (as_event_command_parse_results(cmd)) {
 		uv_read_stop(stream);
 
 		// Register the next reader, if there are readers left.
@@ -358,6 +329,7 @@ as_uv_command_write_complete(uv_write_t* req, int status)
 	as_event_command* cmd = req->data;
 	
 	if (status == 0) {
+		as_node_add_bytes_out(cmd->node, cmd->len);
 		cmd->command_sent_counter++;
 		cmd->len = sizeof(as_proto);
 		cmd->pos = 0;
@@ -401,9 +373,22 @@ as_uv_command_write_start(as_event_command* cmd, uv_stream_t* stream)
 
 	uv_write_t* write_req = &cmd->conn->req.write;
 	write_req->data = cmd;
-	uv_buf_t buf = uv_buf_init((char*)cmd + cmd->write_offset, cmd->len);
+	int status;
+
+	if (cmd->iov) {
+		// Send scratch buffer and in place bin values.  uv_write() copies the buffer array.
+		as_event_iov* ei = cmd->iov;
+		uv_buf_t* bufs = (uv_buf_t*)alloca(sizeof(uv_buf_t) * ei->n_iov);
 
-	int status = uv_write(write_req, stream, &buf, 1, as_uv_command_write_complete);
+		for (uint32_t i = 0; i < ei->n_iov; i++) {
+			bufs[i] = uv_buf_init((char*)ei->iov[i].iov_base, (unsigned int)ei->iov[i].iov_len);
+		}
+		status = uv_write(write_req, stream, bufs, ei->n_iov, as_uv_command_write_complete);
+	}
+	else {
+		uv_buf_t buf = uv_buf_init((char*)cmd + cmd->write_offset, cmd->len);
+		status = uv_write(write_req, stream, &buf, 1, as_uv_command_write_complete);
+	}
 
 	if (status) {
 		if (! as_event_socket_retry(cmd)) {
@@ -687,21 +672,16 @@ as_event_close_connection(as_event_connection* conn)
 	uv_close((uv_handle_t*)&conn->socket, as_uv_connection_closed);
 }
 
-static bool
-as_uv_queue_close_connections(as_node* node, as_conn_pool* pool, as_queue* cmd_queue)
+static void
+as_uv_queue_close_connections(as_node* node, as_conn_pool* pool, as_event_loop* event_loop)
 {
-	as_event_commander qcmd;
-	qcmd.executable = (as_event_executable)as_event_close_connection;
-	
 	as_event_connection* conn;
 	
 	// Queue connection commands to event loops.
 	while (as_conn_pool_get(pool, &conn)) {
-		qcmd.udata = conn;
-		
-		if (! as_queue_push(cmd_queue, &qcmd)) {
+		if (! as_event_execute(event_loop, (as_event_executable)as_event_close_connection, conn)) {
 			as_log_error("Failed to queue connection close");
-			return false;
+			return;
 		}
 		
 		// In this case, connection counts are decremented before the connection is closed.
@@ -710,7 +690,6 @@ as_uv_queue_close_connections(as_node* node, as_conn_pool* pool, as_queue* cmd_q
 		// referenced this node should be completed by the time this code is executed.
 		as_conn_pool_dec(pool);
 	}
-	return true;
 }
 
 void
@@ -719,13 +698,8 @@ as_event_node_destroy(as_node* node)
 	// Send close connection commands to event loops.
 	for (uint32_t i = 0; i < as_event_loop_size; i++) {
 		as_event_loop* event_loop = &as_event_loops[i];
-		
-		pthread_mutex_lock(&event_loop->lock);
-		as_uv_queue_close_connections(node, &node->async_conn_pools[i], &event_loop->queue);
-		as_uv_queue_close_connections(node, &node->pipe_conn_pools[i], &event_loop->queue);
-		pthread_mutex_unlock(&event_loop->lock);
-		
-		uv_async_send(event_loop->wakeup);
+		as_uv_queue_close_connections(node, &node->async_conn_pools[i], event_loop);
+		as_uv_queue_close_connections(node, &node->pipe_conn_pools[i], event_loop);
 	}
 		
 	// Destroy all queues.
@@ -97,6 +97,7 @@ as_info_command_node(
 	char** response
 	)
 {
+	uint64_t begin = cf_getus();
 	as_socket socket;
 	as_status status = as_node_get_connection(err, node, 0, deadline_ms, &socket);
 	
@@ -107,9 +108,13 @@ as_info_command_node(
 	status = as_info_command(err, &socket, node, command, send_asis, deadline_ms, 0, response);
 	
 	if (status == AEROSPIKE_ERR_TIMEOUT || status == AEROSPIKE_ERR_CLIENT) {
+		if (status == AEROSPIKE_ERR_TIMEOUT) {
+			as_node_add_timeout(node, err);
+		}
 		as_node_close_connection(&socket);
 	}
 	else {
+		as_node_add_latency(node, AS_LATENCY_TYPE_INFO, cf_getus() - begin);
 		as_node_put_connection(&socket, node->cluster->max_socket_idle);
 	}
 	return status;
@@ -17,6 +17,7 @@
 #include <aerospike/as_key.h>
 #include <aerospike/as_double.h>
 #include <aerospike/as_log_macros.h>
+#include <aerospike/as_ripemd160.h>
 #include <aerospike/as_string.h>
 #include <aerospike/as_bytes.h>
 
@@ -55,6 +56,73 @@ as_key_cons(as_key* key, bool free, const as_namespace ns, const char * set, con
 	return key;
 }
 
+static as_status
+as_key_value_size(as_error* err, const as_key* key, size_t* size)
+{
+	as_val* val = (as_val*)key->valuep;
+	
+	switch (val->type) {
+		case AS_INTEGER:
+		case AS_DOUBLE:
+			*size = 9;
+			return AEROSPIKE_OK;
+		case AS_STRING:
+			*size = as_string_len(as_string_fromval(val)) + 1;
+			return AEROSPIKE_OK;
+		case AS_BYTES:
+			*size = as_bytes_fromval(val)->size + 1;
+			return AEROSPIKE_OK;
+		default:
+			return as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid key type: %d", val->type);
+	}
+}
+
+static void
+as_key_value_write(const as_key* key, uint8_t* buf)
+{
+	as_val* val = (as_val*)key->valuep;
+	
+	switch (val->type) {
+		case AS_INTEGER: {
+			as_integer* v = as_integer_fromval(val);
+			buf[0] = AS_BYTES_INTEGER;
+			*(uint64_t*)&buf[1] = cf_swap_to_be64(v->value);
+			break;
+		}
+		case AS_DOUBLE: {
+			as_double* v = as_double_fromval(val);
+			buf[0] = AS_BYTES_DOUBLE;
+			*(double*)&buf[1] = cf_swap_to_big_float64(v->value);
+			break;
+		}
+		case AS_STRING: {
+			as_string* v = as_string_fromval(val);
+			buf[0] = AS_BYTES_STRING;
+			memcpy(&buf[1], v->value, as_string_len(v));
+			break;
+		}
+		case AS_BYTES: {
+			as_bytes* v = as_bytes_fromval(val);
+			// Note: v->type must be a blob type (AS_BYTES_BLOB, AS_BYTES_JAVA, AS_BYTES_PYTHON ...).
+			// Otherwise, the particle type will be reassigned to a non-blob which causes a
+			// mismatch between type and value.
+			buf[0] = v->type;
+			memcpy(&buf[1], v->value, v->size);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+static inline void
+as_keys_digest_done(as_key** keys, uint32_t n)
+{
+	for (uint32_t i = 0; i < n; i++) {
+		keys[i]->digest.init = true;
+	}
+}
+
 /******************************************************************************
  * FUNCTIONS
  *****************************************************************************/
@@ -196,55 +264,82 @@ as_key_set_digest(as_error* err, as_key* key)
 		return AEROSPIKE_OK;
 	}
 	
-	size_t set_len = strlen(key->set);
 	size_t size;
+	as_status status = as_key_value_size(err, key, &size);
 	
-	as_val* val = (as_val*)key->valuep;
-	uint8_t* buf;
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
 	
-	switch (val->type) {
-		case AS_INTEGER: {
-			as_integer* v = as_integer_fromval(val);
-			size = 9;
-			buf = alloca(size);
-			buf[0] = AS_BYTES_INTEGER;
-			*(uint64_t*)&buf[1] = cf_swap_to_be64(v->value);
-			break;
-		}
-		case AS_DOUBLE: {
-			as_double* v = as_double_fromval(val);
-			size = 9;
-			buf = alloca(size);
-			buf[0] = AS_BYTES_DOUBLE;
-			*(double*)&buf[1] = cf_swap_to_big_float64(v->value);
-			break;
+	uint8_t* buf = alloca(size);
+	as_key_value_write(key, buf);
+	cf_digest_compute2(key->set, strlen(key->set), buf, size, (cf_digest*)key->digest.value);
+	key->digest.init = true;
+	return AEROSPIKE_OK;
+}
+
+as_status
+as_keys_set_digests(as_error* err, as_key* keys, uint32_t n_keys)
+{
+	return as_keys_set_digests_stride(err, keys, n_keys, sizeof(as_key));
+}
+
+as_status
+as_keys_set_digests_stride(as_error* err, void* keys, uint32_t n_keys, size_t stride)
+{
+	uint8_t lanes[AS_RIPEMD160_LANES][AS_RIPEMD160_LANE_SIZE];
+	uint32_t lens[AS_RIPEMD160_LANES];
+	uint8_t* digests[AS_RIPEMD160_LANES];
+	as_key* pending[AS_RIPEMD160_LANES];
+	uint32_t n = 0;
+	uint8_t* p = keys;
+	
+	for (uint32_t i = 0; i < n_keys; i++, p += stride) {
+		as_key* key = (as_key*)p;
+		
+		if (key->digest.init) {
+			continue;
 		}
-		case AS_STRING: {
-			as_string* v = as_string_fromval(val);
-			size_t len = as_string_len(v);
-			size = len + 1;
-			buf = alloca(size);
-			buf[0] = AS_BYTES_STRING;
-			memcpy(&buf[1], v->value, len);
-			break;
+		
+		size_t set_len = strlen(key->set);
+		size_t size;
+		as_status status = as_key_value_size(err, key, &size);
+		
+		if (status != AEROSPIKE_OK) {
+			return status;
 		}
-		case AS_BYTES: {
-			as_bytes* v = as_bytes_fromval(val);
-			size = v->size + 1;
-			buf = alloca(size);
-			// Note: v->type must be a blob type (AS_BYTES_BLOB, AS_BYTES_JAVA, AS_BYTES_PYTHON ...).
-			// Otherwise, the particle type will be reassigned to a non-blob which causes a
-			// mismatch between type and value.
-			buf[0] = v->type;
-			memcpy(&buf[1], v->value, v->size);
-			break;
+		
+		if (set_len + size > AS_RIPEMD160_LANE_MAX) {
+			// Long keys do not fit in a lane.
+			status = as_key_set_digest(err, key);
+			
+			if (status != AEROSPIKE_OK) {
+				return status;
+			}
+			continue;
 		}
-		default: {
-			return as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid key type: %d", val->type);
+		
+		memcpy(lanes[n], key->set, set_len);
+		as_key_value_write(key, &lanes[n][set_len]);
+		lens[n] = (uint32_t)(set_len + size);
+		digests[n] = key->digest.value;
+		pending[n] = key;
+		
+		if (++n == AS_RIPEMD160_LANES) {
+			as_ripemd160_lanes(lanes, lens, n, digests);
+			as_keys_digest_done(pending, n);
+			n = 0;
 		}
 	}
-		
-	cf_digest_compute2(key->set, set_len, buf, size, (cf_digest*)key->digest.value);
-	key->digest.init = true;
+	
+	if (n == 1) {
+		// A single key is faster to digest by itself.
+		cf_digest_compute(lanes[0], lens[0], (cf_digest*)digests[0]);
+		pending[0]->digest.init = true;
+	}
+	else if (n > 1) {
+		as_ripemd160_lanes(lanes, lens, n, digests);
+		as_keys_digest_done(pending, n);
+	}
 	return AEROSPIKE_OK;
 }
@@ -408,6 +408,12 @@ as_lookup_node(
 		else if (strcmp(begin, "cluster-stable") == 0) {
 			features |= AS_FEATURES_CLUSTER_STABLE;
 		}
+		else if (strcmp(begin, "batch-any") == 0) {
+			features |= AS_FEATURES_BATCH_ANY;
+		}
+		else if (strcmp(begin, "pscans") == 0) {
+			features |= AS_FEATURES_PARTITION_SCAN;
+		}
 		begin = end;
 	}
 	node_info->features = features;
@@ -24,14 +24,18 @@
 #include <aerospike/as_info.h>
 #include <aerospike/as_log_macros.h>
 #include <aerospike/as_peers.h>
+#include <aerospike/as_poll.h>
 #include <aerospike/as_queue.h>
 #include <aerospike/as_socket.h>
 #include <aerospike/as_string.h>
 #include <aerospike/as_tls.h>
 #include <citrusleaf/cf_byte_order.h>
 
-// Replicas take ~2K per namespace, so this will cover most deployments:
-#define INFO_STACK_BUF_SIZE (16 * 1024)
+#if defined(_MSC_VER)
+#define AS_THREAD_LOCAL __declspec(thread)
+#else
+#define AS_THREAD_LOCAL __thread
+#endif
 
 /******************************************************************************
  * Function declarations.
@@ -48,10 +52,137 @@ as_partition_tables_update_all(as_cluster* cluster, as_node* node, char* buf, bo
 
 extern uint32_t as_event_loop_capacity;
 
+/******************************************************************************
+ * Globals.
+ *****************************************************************************/
+
+// Source of per-thread connection cache indexes.
+static uint32_t as_conn_thread_counter = 0;
+
+// Per-thread index used to select home connection pool and home cache slot.
+static AS_THREAD_LOCAL uint32_t as_conn_thread_index = 0;
+
+// Per-thread connection request counter used to sample cache hits/misses.
+static AS_THREAD_LOCAL uint32_t as_conn_cache_requests = 0;
+
 /******************************************************************************
  * Functions.
  *****************************************************************************/
 
+static inline uint32_t
+as_conn_get_thread_index(void)
+{
+	uint32_t index = as_conn_thread_index;
+
+	if (index == 0) {
+		// Assign sequential indexes on first use, so threads are spread evenly over
+		// pools and cache slots.
+		index = as_aaf_uint32(&as_conn_thread_counter, 1);
+		as_conn_thread_index = index;
+	}
+	return index;
+}
+
+static bool
+as_conn_cache_get(as_conn_pool_lock* pool_lock, uint32_t thread_index, as_socket* sock)
+{
+	as_conn_cache_slot* cache = pool_lock->cache;
+	uint32_t size = pool_lock->cache_size;
+	uint32_t home = thread_index % size;
+	uint32_t i = home;
+
+	// Only record one in AS_CONN_CACHE_SAMPLE requests, so threads rarely write
+	// the shared counters.
+	bool sample = (++as_conn_cache_requests & (AS_CONN_CACHE_SAMPLE - 1)) == 0;
+
+	// Start with home slot and then try to take connections cached by other threads.
+	do {
+		as_conn_cache_slot* slot = &cache[i];
+
+		if (as_load_uint32(&slot->state) == AS_CONN_CACHE_FULL &&
+			as_cas_uint32(&slot->state, AS_CONN_CACHE_FULL, AS_CONN_CACHE_BUSY)) {
+			*sock = slot->socket;
+			as_store_uint32(&slot->state, AS_CONN_CACHE_EMPTY);
+
+			if (sample) {
+				as_add_uint64(&pool_lock->cache_hits, AS_CONN_CACHE_SAMPLE);
+			}
+			return true;
+		}
+
+		if (++i >= size) {
+			i = 0;
+		}
+	} while (i != home);
+
+	if (sample) {
+		as_add_uint64(&pool_lock->cache_misses, AS_CONN_CACHE_SAMPLE);
+	}
+	return false;
+}
+
+bool
+as_conn_cache_put(as_conn_pool_lock* pool_lock, as_socket* sock)
+{
+	as_conn_cache_slot* cache = pool_lock->cache;
+	uint32_t size = pool_lock->cache_size;
+	uint32_t home = as_conn_get_thread_index() % size;
+	uint32_t i = home;
+
+	do {
+		as_conn_cache_slot* slot = &cache[i];
+
+		if (as_load_uint32(&slot->state) == AS_CONN_CACHE_EMPTY &&
+			as_cas_uint32(&slot->state, AS_CONN_CACHE_EMPTY, AS_CONN_CACHE_BUSY)) {
+			slot->socket = *sock;
+			as_store_uint32(&slot->state, AS_CONN_CACHE_FULL);
+			return true;
+		}
+
+		if (++i >= size) {
+			i = 0;
+		}
+	} while (i != home);
+
+	// All slots full.  Caller will put connection into pool.
+	return false;
+}
+
+static void
+as_conn_cache_init(as_conn_pool_lock* pool_lock, uint32_t size)
+{
+	pool_lock->cache_size = size;
+	pool_lock->cache_hits = 0;
+	pool_lock->cache_misses = 0;
+
+	if (size == 0) {
+		pool_lock->cache = NULL;
+		return;
+	}
+
+	pool_lock->cache = cf_malloc(sizeof(as_conn_cache_slot) * size);
+
+	for (uint32_t i = 0; i < size; i++) {
+		as_conn_cache_slot* slot = &pool_lock->cache[i];
+		as_socket_init(&slot->socket);
+		slot->state = AS_CONN_CACHE_EMPTY;
+	}
+}
+
+static void
+as_conn_cache_destroy(as_conn_pool_lock* pool_lock)
+{
+	// Node is being destroyed, so no other threads can be referencing cache.
+	for (uint32_t i = 0; i < pool_lock->cache_size; i++) {
+		as_conn_cache_slot* slot = &pool_lock->cache[i];
+
+		if (slot->state == AS_CONN_CACHE_FULL) {
+			as_socket_close(&slot->socket);
+		}
+	}
+	cf_free(pool_lock->cache);
+}
+
 static as_conn_pool*
 as_node_create_async_pools(uint32_t max_conns_per_node)
 {
@@ -107,7 +238,6 @@ as_node_create(as_cluster* cluster, as_node_info* node_info)
 
 	// Create connection pool queues.
 	node->conn_pool_locks = cf_malloc(sizeof(as_conn_pool_lock) * cluster->conn_pools_per_node);
-	node->conn_iter = 0;
 
 	uint32_t max = cluster->max_conns_per_node / cluster->conn_pools_per_node;
 	uint32_t rem = cluster->max_conns_per_node - (max * cluster->conn_pools_per_node);
@@ -117,6 +247,7 @@ as_node_create(as_cluster* cluster, as_node_info* node_info)
 		uint32_t capacity = i < rem ? max + 1 : max;
 		pthread_mutex_init(&pool_lock->lock, NULL);
 		as_conn_pool_init(&pool_lock->pool, sizeof(as_socket), capacity);
+		as_conn_cache_init(pool_lock, cluster->conn_cache_size);
 	}
 
 	// Initialize async queue.
@@ -129,6 +260,7 @@ as_node_create(as_cluster* cluster, as_node_info* node_info)
 		node->pipe_conn_pools = 0;
 	}
 
+	memset(&node->metrics, 0, sizeof(as_node_metrics));
 	node->peers_count = 0;
 	node->friends = 0;
 	node->failures = 0;
@@ -154,6 +286,8 @@ as_node_destroy(as_node* node)
 		as_conn_pool_lock* pool_lock = &node->conn_pool_locks[i];
 		as_socket sock;
 
+		as_conn_cache_destroy(pool_lock);
+
 		pthread_mutex_lock(&pool_lock->lock);
 		while (as_conn_pool_get(&pool_lock->pool, &sock)) {
 			as_socket_close(&sock);
@@ -408,6 +542,7 @@ as_node_get_connection(as_error* err, as_node* node, uint32_t socket_timeout, ui
 {
 	as_conn_pool_lock* pool_locks = node->conn_pool_locks;
 	uint32_t max = node->cluster->conn_pools_per_node;
+	uint32_t thread_index = as_conn_get_thread_index();
 	uint32_t initial_index;
 	bool backward;
 
@@ -416,34 +551,45 @@ as_node_get_connection(as_error* err, as_node* node, uint32_t socket_timeout, ui
 		backward = false;
 	}
 	else {
-		uint32_t iter = node->conn_iter++; // not atomic by design
-		initial_index = iter % max;
+		// Each thread has a home pool, so threads do not share a pool iterator.
+		initial_index = thread_index % max;
 		backward = true;
 	}
 
 	as_socket s;
 	as_conn_pool_lock* pool_lock = &pool_locks[initial_index];
 	uint32_t pool_index = initial_index;
+	bool peek = ! node->cluster->skip_conn_validation;
 	int len;
 	int ret;
 
 	while (1) {
 		ret = 0;
-		pthread_mutex_lock(&pool_lock->lock);
 
-		if (! as_conn_pool_get(&pool_lock->pool, &s)) {
-			ret = as_conn_pool_inc(&pool_lock->pool) ? 1 : -1;
+		// Try lock-free cache first.  Only lock pool on cache miss.
+		if (pool_lock->cache_size == 0 || ! as_conn_cache_get(pool_lock, thread_index, &s)) {
+			pthread_mutex_lock(&pool_lock->lock);
+
+			if (! as_conn_pool_get(&pool_lock->pool, &s)) {
+				ret = as_conn_pool_inc(&pool_lock->pool) ? 1 : -1;
+			}
+			pthread_mutex_unlock(&pool_lock->lock);
 		}
-		pthread_mutex_unlock(&pool_lock->lock);
 
 		if (ret == 0) {
 			// Found socket.
 			// Verify that socket is active and receive buffer is empty.
-			len = as_socket_validate(&s);
+			len = as_socket_validate(&s, peek);
 
 			if (len == 0) {
 				*sock = s;
 				sock->pool_lock = pool_lock;
+
+				if (! peek) {
+					// Dead connection is detected on first use instead.
+					sock->unvalidated = true;
+					as_incr_uint64(&node->metrics.conn_peeks_skipped);
+				}
 				return AEROSPIKE_OK;
 			}
 
@@ -485,6 +631,77 @@ as_node_get_connection(as_error* err, as_node* node, uint32_t socket_timeout, ui
 						   node->name, node->cluster->max_conns_per_node);
 }
 
+void
+as_node_validate_connections(as_node* node)
+{
+	uint32_t max = node->cluster->conn_pools_per_node;
+
+	for (uint32_t i = 0; i < max; i++) {
+		as_conn_pool_lock* pool_lock = &node->conn_pool_locks[i];
+
+		pthread_mutex_lock(&pool_lock->lock);
+		uint32_t size = as_queue_size(&pool_lock->pool.queue);
+		pthread_mutex_unlock(&pool_lock->lock);
+
+		// Check connections parked in the lock-free cache.  Claim each full slot, so
+		// command threads skip it while the socket is validated.
+		for (uint32_t j = 0; j < pool_lock->cache_size; j++) {
+			as_conn_cache_slot* slot = &pool_lock->cache[j];
+
+			if (! (as_load_uint32(&slot->state) == AS_CONN_CACHE_FULL &&
+				   as_cas_uint32(&slot->state, AS_CONN_CACHE_FULL, AS_CONN_CACHE_BUSY))) {
+				continue;
+			}
+
+			if (as_socket_validate(&slot->socket, true) == 0) {
+				as_store_uint32(&slot->state, AS_CONN_CACHE_FULL);
+				continue;
+			}
+
+			as_incr_uint64(&node->metrics.stale_conns);
+			as_socket s = slot->socket;
+			as_store_uint32(&slot->state, AS_CONN_CACHE_EMPTY);
+
+			as_socket_close(&s);
+			pthread_mutex_lock(&pool_lock->lock);
+			as_conn_pool_dec(&pool_lock->pool);
+			pthread_mutex_unlock(&pool_lock->lock);
+		}
+
+		// Rotate through the connections that were idle at the start.  The lock is only held
+		// for each pop/push, so command threads never wait on a peek.
+		for (uint32_t j = 0; j < size; j++) {
+			as_socket s;
+
+			pthread_mutex_lock(&pool_lock->lock);
+			bool found = as_conn_pool_get(&pool_lock->pool, &s);
+			pthread_mutex_unlock(&pool_lock->lock);
+
+			if (! found) {
+				break;
+			}
+
+			if (as_socket_validate(&s, true) == 0) {
+				pthread_mutex_lock(&pool_lock->lock);
+				bool status = as_conn_pool_put(&pool_lock->pool, &s);
+				pthread_mutex_unlock(&pool_lock->lock);
+
+				if (status) {
+					continue;
+				}
+			}
+			else {
+				as_incr_uint64(&node->metrics.stale_conns);
+			}
+
+			as_socket_close(&s);
+			pthread_mutex_lock(&pool_lock->lock);
+			as_conn_pool_dec(&pool_lock->pool);
+			pthread_mutex_unlock(&pool_lock->lock);
+		}
+	}
+}
+
 void
 as_node_signal_login(as_node* node)
 {
@@ -597,63 +814,339 @@ as_node_get_tend_connection(as_error* err, as_node* node)
 	return status;
 }
 
-static uint8_t*
-as_node_get_info(as_error* err, as_node* node, const char* names, size_t names_len, uint64_t deadline_ms, uint8_t* stack_buf)
+#define AS_NODE_TEND_WRITE 0
+#define AS_NODE_TEND_READ_HEADER 1
+#define AS_NODE_TEND_READ_BODY 2
+#define AS_NODE_TEND_COMPLETE 3
+
+#define AS_NODE_TEND_WANT_READ -1
+#define AS_NODE_TEND_WANT_WRITE -2
+#define AS_NODE_TEND_ERROR -3
+
+typedef as_status (*as_node_tend_process_fn)(
+	as_cluster* cluster, as_error* err, as_node* node, as_vector* values, as_peers* peers
+	);
+
+static void
+as_node_tend_init(as_node_tend* tend, const char* command, size_t command_len)
 {
-	as_socket* sock = &node->info_socket;
-	
 	// Prepare the write request buffer.
-	size_t write_size = sizeof(as_proto) + names_len;
-	as_proto* proto = (as_proto*)stack_buf;
-	
-	proto->sz = names_len;
+	size_t write_size = sizeof(as_proto) + command_len;
+	as_proto* proto = (as_proto*)cf_malloc(write_size);
+
+	proto->sz = command_len;
 	proto->version = AS_MESSAGE_VERSION;
 	proto->type = AS_INFO_MESSAGE_TYPE;
 	as_proto_swap_to_be(proto);
-	
-	memcpy((void*)(stack_buf + sizeof(as_proto)), (const void*)names, names_len);
 
-	// Write the request. Note that timeout_ms is never 0.
-	if (as_socket_write_deadline(err, sock, node, stack_buf, write_size, 0, deadline_ms) != AEROSPIKE_OK) {
-		return 0;
+	memcpy((uint8_t*)proto + sizeof(as_proto), command, command_len);
+
+	tend->buf = (uint8_t*)proto;
+	tend->len = write_size;
+	tend->pos = 0;
+	tend->status = AEROSPIKE_OK;
+	tend->state = AS_NODE_TEND_WRITE;
+	tend->want_write = true;
+}
+
+static inline void
+as_node_tend_fail(as_node_tend* tend, as_status status)
+{
+	tend->buf = NULL;
+	tend->status = status;
+	tend->state = AS_NODE_TEND_COMPLETE;
+}
+
+static void
+as_node_tend_close(as_node_tend* tend)
+{
+	cf_free(tend->buf);
+	as_socket_close(&tend->node->info_socket);
+	as_node_tend_fail(tend, tend->err.code);
+}
+
+static int
+as_node_tend_send(as_socket* sock, uint8_t* buf, size_t len, int* code)
+{
+	if (sock->ctx) {
+		int rv = as_tls_write_once(sock, buf, len);
+
+		if (rv < AS_NODE_TEND_WANT_WRITE) {
+			*code = rv;
+			return AS_NODE_TEND_ERROR;
+		}
+		return rv;
 	}
-	
-	// Reuse the buffer, read the response - first 8 bytes contains body size.
-	if (as_socket_read_deadline(err, sock, node, stack_buf, sizeof(as_proto), 0, deadline_ms) != AEROSPIKE_OK) {
-		return 0;
+
+#if defined(__linux__)
+	int rv = (int)send(sock->fd, buf, len, MSG_NOSIGNAL);
+#elif defined(_MSC_VER)
+	int rv = send(sock->fd, (const char*)buf, (int)len, 0);
+#else
+	int rv = (int)write(sock->fd, buf, len);
+#endif
+
+	if (rv > 0) {
+		return rv;
 	}
-	
-	proto = (as_proto*)stack_buf;
-	as_proto_swap_from_be(proto);
-	
-	// Sanity check body size.
-	if (proto->sz == 0 || proto->sz > 512 * 1024) {
-		as_error_update(err, AEROSPIKE_ERR_CLIENT, "Invalid info response size %lu", proto->sz);
-		return 0;
+
+	*code = as_last_error();
+	return (rv < 0 && *code == AS_WOULDBLOCK)? AS_NODE_TEND_WANT_WRITE : AS_NODE_TEND_ERROR;
+}
+
+static int
+as_node_tend_recv(as_socket* sock, uint8_t* buf, size_t len, int* code)
+{
+	if (sock->ctx) {
+		int rv = as_tls_read_once(sock, buf, len);
+
+		if (rv < AS_NODE_TEND_WANT_WRITE) {
+			*code = rv;
+			return AS_NODE_TEND_ERROR;
+		}
+		return rv;
 	}
-	
-	// Allocate a buffer if the response is bigger than the stack buffer -
-	// caller must free it if this call succeeds. Note that proto is overwritten
-	// if stack_buf is used, so we save the sz field here.
-	size_t proto_sz = proto->sz;
-	uint8_t* rbuf = proto_sz >= INFO_STACK_BUF_SIZE ? (uint8_t*)cf_malloc(proto_sz + 1) : stack_buf;
-	
-	if (! rbuf) {
-		as_error_set_message(err, AEROSPIKE_ERR_CLIENT, "Allocation failed for info response");
-		return 0;
+
+#if !defined(_MSC_VER)
+	int rv = (int)read(sock->fd, buf, len);
+#else
+	int rv = (int)recv(sock->fd, (char*)buf, (int)len, 0);
+#endif
+
+	if (rv > 0) {
+		return rv;
 	}
-	
-	// Read the response body.
-	if (as_socket_read_deadline(err, sock, node, rbuf, proto_sz, 0, deadline_ms) != AEROSPIKE_OK) {
-		if (rbuf != stack_buf) {
-			cf_free(rbuf);
+
+	if (rv == 0) {
+		// Server closed socket.
+		*code = 0;
+		return AS_NODE_TEND_ERROR;
+	}
+
+	*code = as_last_error();
+	return (*code == AS_WOULDBLOCK)? AS_NODE_TEND_WANT_READ : AS_NODE_TEND_ERROR;
+}
+
+static void
+as_node_tend_complete(
+	as_cluster* cluster, as_node_tend* tend, as_node_tend_process_fn process_fn, as_peers* peers
+	)
+{
+	as_node* node = tend->node;
+
+	// Null-terminate the response body.
+	tend->buf[tend->len] = 0;
+	as_node_add_bytes_in(node, sizeof(as_proto) + tend->len);
+
+	as_vector values;
+	as_vector_inita(&values, sizeof(as_name_value), 4);
+
+	as_info_parse_multi_response((char*)tend->buf, &values);
+	as_status status = process_fn(cluster, &tend->err, node, &values, peers);
+
+	if (status == AEROSPIKE_ERR_CLIENT) {
+		// Response does not match request.  Do not reuse socket.
+		as_socket_close(&node->info_socket);
+	}
+
+	as_vector_destroy(&values);
+	cf_free(tend->buf);
+	as_node_tend_fail(tend, status);
+}
+
+/**
+ * Advance info request as far as possible without blocking.
+ */
+static void
+as_node_tend_io(
+	as_cluster* cluster, as_node_tend* tend, as_node_tend_process_fn process_fn, as_peers* peers
+	)
+{
+	as_node* node = tend->node;
+	as_socket* sock = &node->info_socket;
+	int code;
+	int rv;
+
+	while (true) {
+		if (tend->state == AS_NODE_TEND_WRITE) {
+			rv = as_node_tend_send(sock, tend->buf + tend->pos, tend->len - tend->pos, &code);
+		}
+		else if (tend->state == AS_NODE_TEND_READ_HEADER) {
+			rv = as_node_tend_recv(sock, tend->header + tend->pos, tend->len - tend->pos, &code);
+		}
+		else {
+			rv = as_node_tend_recv(sock, tend->buf + tend->pos, tend->len - tend->pos, &code);
+		}
+
+		if (rv <= 0) {
+			if (rv == AS_NODE_TEND_WANT_READ) {
+				tend->want_write = false;
+				return;
+			}
+
+			if (rv == AS_NODE_TEND_WANT_WRITE) {
+				tend->want_write = true;
+				return;
+			}
+
+			const char* msg;
+
+			if (tend->state == AS_NODE_TEND_WRITE) {
+				msg = "Info write failed";
+			}
+			else {
+				msg = (code == 0)? "Info read closed by peer" : "Info read failed";
+			}
+			as_socket_error(sock->fd, node, &tend->err,
+				sock->ctx ? AEROSPIKE_ERR_TLS_ERROR : AEROSPIKE_ERR_CONNECTION, msg, code);
+			as_node_tend_close(tend);
+			return;
+		}
+
+		tend->pos += rv;
+
+		if (tend->pos < tend->len) {
+			continue;
+		}
+
+		if (tend->state == AS_NODE_TEND_WRITE) {
+			// Request sent.  Read the response - first 8 bytes contains body size.
+			as_node_add_bytes_out(node, tend->len);
+			cf_free(tend->buf);
+			tend->buf = NULL;
+			tend->len = sizeof(as_proto);
+			tend->pos = 0;
+			tend->state = AS_NODE_TEND_READ_HEADER;
+		}
+		else if (tend->state == AS_NODE_TEND_READ_HEADER) {
+			as_proto* proto = (as_proto*)tend->header;
+			as_proto_swap_from_be(proto);
+
+			// Sanity check body size.
+			if (proto->sz == 0 || proto->sz > 512 * 1024) {
+				as_error_update(&tend->err, AEROSPIKE_ERR_CLIENT, "Invalid info response size %lu",
+								(unsigned long)proto->sz);
+				as_node_tend_close(tend);
+				return;
+			}
+
+			tend->len = proto->sz;
+			tend->buf = cf_malloc(tend->len + 1);
+			tend->pos = 0;
+			tend->state = AS_NODE_TEND_READ_BODY;
+		}
+		else {
+			as_node_tend_complete(cluster, tend, process_fn, peers);
+			return;
+		}
+	}
+}
+
+/**
+ * Send info requests to all nodes and process responses as they arrive.  Requests
+ * that do not complete within the connection timeout fail with a timeout.
+ */
+static void
+as_node_tend_execute(
+	as_cluster* cluster, as_node_tend* tends, uint32_t n_tends, as_node_tend_process_fn process_fn,
+	as_peers* peers
+	)
+{
+	uint64_t deadline_ms = as_socket_deadline(cluster->conn_timeout_ms);
+	as_socket_fd max_fd = 0;
+	uint32_t pending = 0;
+
+	// Send all requests before waiting on any response.
+	for (uint32_t i = 0; i < n_tends; i++) {
+		as_node_tend* tend = &tends[i];
+
+		if (tend->state != AS_NODE_TEND_COMPLETE) {
+			as_socket_fd fd = tend->node->info_socket.fd;
+
+			if (fd > max_fd) {
+				max_fd = fd;
+			}
+			as_node_tend_io(cluster, tend, process_fn, peers);
+
+			if (tend->state != AS_NODE_TEND_COMPLETE) {
+				pending++;
+			}
+		}
+	}
+
+	if (pending == 0) {
+		return;
+	}
+
+	as_poll rpoll;
+	as_poll wpoll;
+	as_poll_init(&rpoll, max_fd);
+	as_poll_init(&wpoll, max_fd);
+
+	while (pending > 0) {
+		uint64_t now = cf_getms();
+
+		if (now >= deadline_ms) {
+			break;
+		}
+
+		as_poll_clear(&rpoll);
+		as_poll_clear(&wpoll);
+
+		for (uint32_t i = 0; i < n_tends; i++) {
+			as_node_tend* tend = &tends[i];
+
+			if (tend->state != AS_NODE_TEND_COMPLETE) {
+				as_poll_add(tend->want_write ? &wpoll : &rpoll, tend->node->info_socket.fd);
+			}
+		}
+
+		int rv = as_poll_sockets(&rpoll, &wpoll, max_fd, (uint32_t)(deadline_ms - now));
+
+		if (rv == 0) {
+			// Timeout.
+			break;
+		}
+
+		if (rv < 0) {
+			if (as_last_error() == AS_EINTR) {
+				continue;
+			}
+			break;
+		}
+
+		for (uint32_t i = 0; i < n_tends; i++) {
+			as_node_tend* tend = &tends[i];
+
+			if (tend->state == AS_NODE_TEND_COMPLETE) {
+				continue;
+			}
+
+			as_socket_fd fd = tend->node->info_socket.fd;
+
+			if (as_poll_contains(&rpoll, fd) || as_poll_contains(&wpoll, fd)) {
+				as_node_tend_io(cluster, tend, process_fn, peers);
+
+				if (tend->state == AS_NODE_TEND_COMPLETE) {
+					pending--;
+				}
+			}
+		}
+	}
+
+	as_poll_destroy(&rpoll);
+	as_poll_destroy(&wpoll);
+
+	// Fail requests that did not complete in time.
+	for (uint32_t i = 0; i < n_tends; i++) {
+		as_node_tend* tend = &tends[i];
+
+		if (tend->state != AS_NODE_TEND_COMPLETE) {
+			as_error_update(&tend->err, AEROSPIKE_ERR_TIMEOUT, "Info request timed out: %s",
+							as_node_get_address_string(tend->node));
+			as_node_tend_close(tend);
 		}
-		return 0;
 	}
-	
-	// Null-terminate the response body and return it.
-	rbuf[proto_sz] = 0;
-	return rbuf;
 }
 
 static as_status
@@ -715,20 +1208,11 @@ as_node_process_response(as_cluster* cluster, as_error* err, as_node* node, as_v
 }
 
 /**
- * Request current status from server node.
+ * Request current status from server nodes.
  */
-as_status
-as_node_refresh(as_cluster* cluster, as_error* err, as_node* node, as_peers* peers)
+void
+as_node_refresh(as_cluster* cluster, as_node_tend* tends, uint32_t n_tends, as_peers* peers)
 {
-	as_status status = as_node_get_tend_connection(err, node);
-	
-	if (status != AEROSPIKE_OK) {
-		return status;
-	}
-
-	// Set new deadline because login may have occurred which can take a long time.
-	uint64_t deadline_ms = as_socket_deadline(cluster->conn_timeout_ms);
-
 	const char* command;
 	size_t command_len;
 	
@@ -746,32 +1230,23 @@ as_node_refresh(as_cluster* cluster, as_error* err, as_node* node, as_peers* pee
 			command_len = sizeof(INFO_STR_CHECK) - 1;
 		}
 	}
-	
-	uint8_t stack_buf[INFO_STACK_BUF_SIZE];
-	uint8_t* buf = as_node_get_info(err, node, command, command_len, deadline_ms, stack_buf);
-	
-	if (! buf) {
-		as_socket_close(&node->info_socket);
-		return err->code;
-	}
-	
-	as_vector values;
-	as_vector_inita(&values, sizeof(as_name_value), 4);
-	
-	as_info_parse_multi_response((char*)buf, &values);
 
-	status = as_node_process_response(cluster, err, node, &values, peers);
+	for (uint32_t i = 0; i < n_tends; i++) {
+		as_node_tend* tend = &tends[i];
+		as_error_init(&tend->err);
 
-	if (status == AEROSPIKE_ERR_CLIENT) {
-		as_socket_close(&node->info_socket);
-	}
-		
-	if (buf != stack_buf) {
-		cf_free(buf);
+		// Connect and login are performed before any request is sent.
+		as_status status = as_node_get_tend_connection(&tend->err, tend->node);
+
+		if (status != AEROSPIKE_OK) {
+			as_node_tend_fail(tend, status);
+			continue;
+		}
+		as_node_tend_init(tend, command, command_len);
 	}
 
-	as_vector_destroy(&values);
-	return status;
+	// Set deadline after connections are established because login can take a long time.
+	as_node_tend_execute(cluster, tends, n_tends, as_node_process_response, peers);
 }
 
 static const char INFO_STR_PEERS_TLS_ALT[] = "peers-tls-alt\n";
@@ -803,10 +1278,9 @@ as_node_process_peers(as_cluster* cluster, as_error* err, as_node* node, as_vect
 	return AEROSPIKE_OK;
 }
 
-as_status
-as_node_refresh_peers(as_cluster* cluster, as_error* err, as_node* node, as_peers* peers)
+void
+as_node_refresh_peers(as_cluster* cluster, as_node_tend* tends, uint32_t n_tends, as_peers* peers)
 {
-	uint64_t deadline_ms = as_socket_deadline(cluster->conn_timeout_ms);
 	const char* command;
 	size_t command_len;
 
@@ -830,27 +1304,14 @@ as_node_refresh_peers(as_cluster* cluster, as_error* err, as_node* node, as_peer
 			command_len = sizeof(INFO_STR_PEERS_CLEAR_STD) - 1;
 		}
 	}
-	
-	uint8_t stack_buf[INFO_STACK_BUF_SIZE];
-	uint8_t* buf = as_node_get_info(err, node, command, command_len, deadline_ms, stack_buf);
-	
-	if (! buf) {
-		as_socket_close(&node->info_socket);
-		return err->code;
-	}
-	
-	as_vector values;
-	as_vector_inita(&values, sizeof(as_name_value), 4);
-	
-	as_info_parse_multi_response((char*)buf, &values);
-	as_status status = as_node_process_peers(cluster, err, node, &values, peers);
-	
-	if (buf != stack_buf) {
-		cf_free(buf);
+
+	for (uint32_t i = 0; i < n_tends; i++) {
+		as_node_tend* tend = &tends[i];
+		as_error_init(&tend->err);
+		as_node_tend_init(tend, command, command_len);
 	}
-	
-	as_vector_destroy(&values);
-	return status;
+
+	as_node_tend_execute(cluster, tends, n_tends, as_node_process_peers, peers);
 }
 
 static const char INFO_STR_GET_REPLICAS_OLD[] = "partition-generation\nreplicas-master\nreplicas-prole\n";
@@ -858,7 +1319,8 @@ static const char INFO_STR_GET_REPLICAS_ALL[] = "partition-generation\nreplicas-
 static const char INFO_STR_GET_REPLICAS_REGIME[] = "partition-generation\nreplicas\n";
 
 static as_status
-as_node_process_partitions(as_cluster* cluster, as_error* err, as_node* node, as_vector* values)
+as_node_process_partitions(as_cluster* cluster, as_error* err, as_node* node, as_vector* values,
+						   as_peers* peers)
 {
 	for (uint32_t i = 0; i < values->size; i++) {
 		as_name_value* nv = as_vector_get(values, i);
@@ -885,44 +1347,31 @@ as_node_process_partitions(as_cluster* cluster, as_error* err, as_node* node, as
 	return AEROSPIKE_OK;
 }
 
-as_status
-as_node_refresh_partitions(as_cluster* cluster, as_error* err, as_node* node, as_peers* peers)
+void
+as_node_refresh_partitions(as_cluster* cluster, as_node_tend* tends, uint32_t n_tends, as_peers* peers)
 {
-	uint64_t deadline_ms = as_socket_deadline(cluster->conn_timeout_ms);
-	const char* command;
-	size_t command_len;
+	for (uint32_t i = 0; i < n_tends; i++) {
+		as_node_tend* tend = &tends[i];
+		as_node* node = tend->node;
+		const char* command;
+		size_t command_len;
+
+		if (node->features & AS_FEATURES_REPLICAS) {
+			command = INFO_STR_GET_REPLICAS_REGIME;
+			command_len = sizeof(INFO_STR_GET_REPLICAS_REGIME) - 1;
+		}
+		else if (node->features & AS_FEATURES_REPLICAS_ALL) {
+			command = INFO_STR_GET_REPLICAS_ALL;
+			command_len = sizeof(INFO_STR_GET_REPLICAS_ALL) - 1;
+		}
+		else {
+			command = INFO_STR_GET_REPLICAS_OLD;
+			command_len = sizeof(INFO_STR_GET_REPLICAS_OLD) - 1;
+		}
 
-	if (node->features & AS_FEATURES_REPLICAS) {
-		command = INFO_STR_GET_REPLICAS_REGIME;
-		command_len = sizeof(INFO_STR_GET_REPLICAS_REGIME) - 1;
-	}
-	else if (node->features & AS_FEATURES_REPLICAS_ALL) {
-		command = INFO_STR_GET_REPLICAS_ALL;
-		command_len = sizeof(INFO_STR_GET_REPLICAS_ALL) - 1;
-	}
-	else {
-		command = INFO_STR_GET_REPLICAS_OLD;
-		command_len = sizeof(INFO_STR_GET_REPLICAS_OLD) - 1;
-	}
-	
-	uint8_t stack_buf[INFO_STACK_BUF_SIZE];
-	uint8_t* buf = as_node_get_info(err, node, command, command_len, deadline_ms, stack_buf);
-	
-	if (! buf) {
-		as_socket_close(&node->info_socket);
-		return err->code;
+		as_error_init(&tend->err);
+		as_node_tend_init(tend, command, command_len);
 	}
-	
-	as_vector values;
-	as_vector_inita(&values, sizeof(as_name_value), 4);
 
-	as_info_parse_multi_response((char*)buf, &values);
-	as_status status = as_node_process_partitions(cluster, err, node, &values);
-	
-	if (buf != stack_buf) {
-		cf_free(buf);
-	}
-	
-	as_vector_destroy(&values);
-	return status;
+	as_node_tend_execute(cluster, tends, n_tends, as_node_process_partitions, peers);
 }
@@ -15,13 +15,12 @@
  * the License.
  */
 #include <aerospike/as_operations.h>
-#include <aerospike/as_arraylist.h>
 #include <aerospike/as_bin.h>
 #include <aerospike/as_map_operations.h>
 #include <aerospike/as_msgpack.h>
-#include <aerospike/as_serializer.h>
 #include <citrusleaf/alloc.h>
 #include <citrusleaf/cf_byte_order.h>
+#include <limits.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
@@ -128,6 +127,12 @@ typedef struct {
 #endif
 } cdt_op_table_entry;
 
+typedef union {
+	as_val* val;
+	uint64_t u;
+	int64_t i;
+} as_cdt_arg;
+
 /******************************************************************************
  * MACROS
  *****************************************************************************/
@@ -494,6 +499,31 @@ as_operations_add_cdt(as_operations* ops, as_operator op, const as_bin_name name
 	return true;
 }
 
+static void
+as_operations_cdt_pack(as_packer* pk, const cdt_op_table_entry* entry, const as_cdt_arg* args, size_t n)
+{
+	as_pack_list_header(pk, (uint32_t)n);
+
+	for (size_t i = 0; i < n; i++) {
+		switch (entry->args[i]) {
+		case AS_CDT_PARAM_PAYLOAD:
+			as_pack_val(pk, args[i].val);
+			break;
+		case AS_CDT_PARAM_FLAGS:
+		case AS_CDT_PARAM_COUNT:
+			// Encoded as signed integer for compatibility with previous as_integer encoding.
+			as_pack_int64(pk, (int64_t)args[i].u);
+			break;
+		case AS_CDT_PARAM_INDEX:
+			as_pack_int64(pk, args[i].i);
+			break;
+		default:
+			as_pack_nil(pk);
+			break;
+		}
+	}
+}
+
 /**
  * Call with AS_OPERATIONS_CDT_OP only.
  */
@@ -509,61 +539,38 @@ as_operations_cdt_op(as_operations* ops, const as_bin_name name, as_cdt_optype o
 		return false;
 	}
 
-	va_list vl;
+	// Arguments are packed directly without creating intermediate list and integer values.
+	as_cdt_arg args[9];
+
 	if (n > 0) {
+		va_list vl;
 		va_start(vl, n);
-	}
-
-	as_arraylist list;
-	as_arraylist_inita(&list, (uint32_t)n + 1); // +1 to avoid alloca(0) undefined behavior
 
-	for (size_t i = 0; i < n; i++) {
-		as_cdt_paramtype type = entry->args[i];
-		switch (type) {
-		case AS_CDT_PARAM_PAYLOAD: {
-			as_val *arg = va_arg(vl, as_val *);
-
-			if (as_arraylist_append(&list, arg) != AS_ARRAYLIST_OK) {
-				va_end(vl);
-				as_arraylist_destroy(&list);
-				return false;
+		for (size_t i = 0; i < n; i++) {
+			switch (entry->args[i]) {
+			case AS_CDT_PARAM_PAYLOAD:
+				args[i].val = va_arg(vl, as_val*);
+				break;
+			case AS_CDT_PARAM_FLAGS:
+			case AS_CDT_PARAM_COUNT:
+				args[i].u = va_arg(vl, uint64_t);
+				break;
+			case AS_CDT_PARAM_INDEX:
+				args[i].i = va_arg(vl, int64_t);
+				break;
+			default:
+				args[i].u = 0;
+				break;
 			}
-			break;
 		}
-		case AS_CDT_PARAM_FLAGS:
-		case AS_CDT_PARAM_COUNT: {
-			uint64_t arg = va_arg(vl, uint64_t);
-
-			if (as_arraylist_append(&list, (as_val *)as_integer_new(arg)) != AS_ARRAYLIST_OK) {
-				va_end(vl);
-				as_arraylist_destroy(&list);
-				return false;
-			}
-			break;
-		}
-		case AS_CDT_PARAM_INDEX: {
-			int64_t arg = va_arg(vl, int64_t);
-
-			if (as_arraylist_append(&list, (as_val *)as_integer_new(arg)) != AS_ARRAYLIST_OK) {
-				va_end(vl);
-				as_arraylist_destroy(&list);
-				return false;
-			}
-			break;
-		}
-		default:
-			break;
-		}
-	}
-
-	if (n > 0) {
 		va_end(vl);
 	}
 
-	as_serializer ser;
-	as_msgpack_init(&ser);
+	// Size pass.  A packer without buffer only counts bytes.
+	as_packer pk = {.buffer = NULL, .capacity = INT_MAX};
+	as_operations_cdt_pack(&pk, entry, args, n);
 
-	uint32_t list_size = as_serializer_serialize_getsize(&ser, (as_val *) &list);
+	uint32_t list_size = (uint32_t)pk.offset;
 	as_bytes *bytes = as_bytes_new(sizeof(uint16_t) + list_size);
 	uint8_t *list_write = as_bytes_get(bytes);
 	uint16_t *list_write_op = (uint16_t *)list_write;
@@ -571,9 +578,21 @@ as_operations_cdt_op(as_operations* ops, const as_bin_name name, as_cdt_optype o
 	*list_write_op = cf_swap_to_be16(op);
 	list_write += sizeof(uint16_t);
 
-	as_serializer_serialize_presized(&ser, (const as_val *) &list, list_write);
-	as_serializer_destroy(&ser);
-	as_arraylist_destroy(&list);
+	// Write pass directly into the bin value.
+	pk.head = NULL;
+	pk.tail = NULL;
+	pk.buffer = list_write;
+	pk.offset = 0;
+	pk.capacity = (int)list_size;
+	as_operations_cdt_pack(&pk, entry, args, n);
+
+	// Payload values are owned by the operation.
+	for (size_t i = 0; i < n; i++) {
+		if (entry->args[i] == AS_CDT_PARAM_PAYLOAD) {
+			as_val_destroy(args[i].val);
+		}
+	}
+
 	bytes->size = bytes->capacity;
 	// as_bytes->type default to AS_BYTES_BLOB
 
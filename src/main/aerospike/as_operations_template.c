@@ -0,0 +1,293 @@
+/*
+ * Copyright 2008-2018 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_operations_template.h>
+#include <aerospike/as_command.h>
+#include <aerospike/as_bytes.h>
+#include <aerospike/as_double.h>
+#include <aerospike/as_integer.h>
+#include <aerospike/as_string.h>
+#include <citrusleaf/alloc.h>
+#include <citrusleaf/cf_byte_order.h>
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static bool
+as_template_op_patchable(const uint8_t* op)
+{
+	// Serialized operation: size(4) operation(1) particle type(1) version(1) name length(1).
+	switch (op[4]) {
+		case AS_OPERATOR_WRITE:
+		case AS_OPERATOR_INCR:
+		case AS_OPERATOR_APPEND:
+		case AS_OPERATOR_PREPEND:
+			break;
+		default:
+			return false;
+	}
+
+	uint8_t type = op[5];
+
+	return type == AS_BYTES_INTEGER || type == AS_BYTES_DOUBLE || type == AS_BYTES_STRING ||
+		(type >= AS_BYTES_BLOB && type <= AS_BYTES_ERLANG);
+}
+
+static inline bool
+as_template_args_set(const as_template_args* args, uint16_t index)
+{
+	return args && args->values[index].nil.type != AS_UNDEF;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+as_status
+as_operations_template_init(as_operations_template* tmpl, as_error* err, const as_operations* ops)
+{
+	as_error_reset(err);
+
+	uint32_t n_operations = ops->binops.size;
+
+	if (n_operations == 0) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM, "No operations defined");
+	}
+
+	as_buffer* buffers = (as_buffer*)alloca(sizeof(as_buffer) * n_operations);
+	memset(buffers, 0, sizeof(as_buffer) * n_operations);
+
+	size_t size = as_command_operate_set_attr(ops, buffers, &tmpl->read_attr, &tmpl->write_attr);
+
+	tmpl->buf = cf_malloc(size);
+	tmpl->offsets = cf_malloc(sizeof(uint32_t) * (n_operations + 1));
+
+	uint8_t* p = tmpl->buf;
+
+	for (uint32_t i = 0; i < n_operations; i++) {
+		as_binop* op = &ops->binops.entries[i];
+		tmpl->offsets[i] = (uint32_t)(p - tmpl->buf);
+		p = as_command_write_bin(p, op->op, &op->bin, &buffers[i]);
+	}
+	tmpl->offsets[n_operations] = (uint32_t)(p - tmpl->buf);
+	tmpl->ttl = ops->ttl;
+	tmpl->gen = ops->gen;
+	tmpl->n_operations = (uint16_t)n_operations;
+	return AEROSPIKE_OK;
+}
+
+void
+as_operations_template_destroy(as_operations_template* tmpl)
+{
+	cf_free(tmpl->buf);
+	cf_free(tmpl->offsets);
+	tmpl->buf = NULL;
+	tmpl->offsets = NULL;
+	tmpl->n_operations = 0;
+}
+
+void
+as_template_args_init(as_template_args* args, const as_operations_template* tmpl)
+{
+	args->n_values = tmpl->n_operations;
+	args->values = cf_calloc(args->n_values, sizeof(as_bin_value));
+	args->ttl = tmpl->ttl;
+	args->gen = tmpl->gen;
+	args->_free = true;
+}
+
+void
+as_template_args_destroy(as_template_args* args)
+{
+	if (args->_free) {
+		cf_free(args->values);
+	}
+	args->values = NULL;
+	args->n_values = 0;
+}
+
+bool
+as_template_args_set_int64(as_template_args* args, uint16_t index, int64_t value)
+{
+	if (index >= args->n_values) {
+		return false;
+	}
+	as_integer_init(&args->values[index].integer, value);
+	return true;
+}
+
+bool
+as_template_args_set_double(as_template_args* args, uint16_t index, double value)
+{
+	if (index >= args->n_values) {
+		return false;
+	}
+	as_double_init(&args->values[index].dbl, value);
+	return true;
+}
+
+bool
+as_template_args_set_str(as_template_args* args, uint16_t index, const char* value)
+{
+	if (index >= args->n_values) {
+		return false;
+	}
+	as_string_init(&args->values[index].string, (char*)value, false);
+	return true;
+}
+
+bool
+as_template_args_set_raw(as_template_args* args, uint16_t index, const uint8_t* value, uint32_t size)
+{
+	if (index >= args->n_values) {
+		return false;
+	}
+	as_bytes_init_wrap(&args->values[index].bytes, (uint8_t*)value, size, false);
+	return true;
+}
+
+as_status
+as_operations_template_size(
+	const as_operations_template* tmpl, as_error* err, const as_template_args* args, size_t* size
+	)
+{
+	size_t sz = tmpl->offsets[tmpl->n_operations];
+
+	if (! args) {
+		*size = sz;
+		return AEROSPIKE_OK;
+	}
+
+	if (args->n_values != tmpl->n_operations) {
+		return as_error_update(err, AEROSPIKE_ERR_PARAM,
+			"Template args count %u does not match operations count %u",
+			args->n_values, tmpl->n_operations);
+	}
+
+	for (uint16_t i = 0; i < tmpl->n_operations; i++) {
+		if (! as_template_args_set(args, i)) {
+			continue;
+		}
+
+		const uint8_t* op = tmpl->buf + tmpl->offsets[i];
+
+		if (! as_template_op_patchable(op)) {
+			return as_error_update(err, AEROSPIKE_ERR_PARAM,
+				"Template operation %u does not have a replaceable value", i);
+		}
+
+		as_val* val = (as_val*)&args->values[i];
+		size_t val_len;
+
+		switch (val->type) {
+			case AS_INTEGER:
+			case AS_DOUBLE:
+				val_len = 8;
+				break;
+			case AS_STRING:
+				val_len = as_string_len((as_string*)val);
+				break;
+			case AS_BYTES:
+				val_len = ((as_bytes*)val)->size;
+				break;
+			default:
+				return as_error_update(err, AEROSPIKE_ERR_PARAM,
+					"Invalid template value type %d for operation %u", val->type, i);
+		}
+
+		// Replace template value size with new value size.
+		uint32_t old_size = tmpl->offsets[i + 1] - tmpl->offsets[i];
+		sz = sz - old_size + AS_OPERATION_HEADER_SIZE + op[7] + val_len;
+	}
+	*size = sz;
+	return AEROSPIKE_OK;
+}
+
+uint8_t*
+as_operations_template_write(const as_operations_template* tmpl, const as_template_args* args, uint8_t* p)
+{
+	uint16_t n_operations = tmpl->n_operations;
+	uint16_t begin = 0;
+
+	for (uint16_t i = 0; i < n_operations; i++) {
+		if (! as_template_args_set(args, i)) {
+			continue;
+		}
+
+		// Copy unchanged operations since the last replaced value.
+		uint32_t len = tmpl->offsets[i] - tmpl->offsets[begin];
+
+		if (len > 0) {
+			memcpy(p, tmpl->buf + tmpl->offsets[begin], len);
+			p += len;
+		}
+		begin = i + 1;
+
+		// Copy operation header and bin name, then write replacement value.
+		const uint8_t* op = tmpl->buf + tmpl->offsets[i];
+		uint8_t name_len = op[7];
+		uint8_t* h = p;
+
+		memcpy(p, op, AS_OPERATION_HEADER_SIZE + name_len);
+		p += AS_OPERATION_HEADER_SIZE + name_len;
+
+		as_val* val = (as_val*)&args->values[i];
+		uint32_t val_len;
+		uint8_t val_type;
+
+		switch (val->type) {
+			default:
+			case AS_INTEGER: {
+				as_integer* v = as_integer_fromval(val);
+				*(uint64_t*)p = cf_swap_to_be64(v->value);
+				val_len = 8;
+				val_type = AS_BYTES_INTEGER;
+				break;
+			}
+			case AS_DOUBLE: {
+				as_double* v = as_double_fromval(val);
+				*(double*)p = cf_swap_to_big_float64(v->value);
+				val_len = 8;
+				val_type = AS_BYTES_DOUBLE;
+				break;
+			}
+			case AS_STRING: {
+				as_string* v = as_string_fromval(val);
+				// v->len was set by as_operations_template_size().
+				val_len = (uint32_t)v->len;
+				memcpy(p, v->value, val_len);
+				val_type = AS_BYTES_STRING;
+				break;
+			}
+			case AS_BYTES: {
+				as_bytes* v = as_bytes_fromval(val);
+				val_len = v->size;
+				memcpy(p, v->value, val_len);
+				val_type = v->type;
+				break;
+			}
+		}
+		p += val_len;
+
+		*(uint32_t*)h = cf_swap_to_be32(name_len + val_len + 4);
+		h[5] = val_type;
+	}
+
+	uint32_t len = tmpl->offsets[n_operations] - tmpl->offsets[begin];
+	memcpy(p, tmpl->buf + tmpl->offsets[begin], len);
+	return p + len;
+}
@@ -0,0 +1,392 @@
+/*
+ * Copyright 2008-2018 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_partition_tracker.h>
+#include <aerospike/as_cluster.h>
+#include <aerospike/as_log_macros.h>
+#include <aerospike/as_node.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <citrusleaf/cf_clock.h>
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define AS_PARTS_STATUS_VERSION 1
+#define AS_PARTS_STATUS_HEADER_SIZE 6
+#define AS_PART_STATUS_SIZE (3 + AS_DIGEST_VALUE_SIZE)
+
+#define AS_PART_STATUS_DONE 0x1
+#define AS_PART_STATUS_DIGEST 0x2
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+typedef struct as_node_count_s {
+	as_node* node;
+	uint32_t count;
+	uint32_t unit_size;
+	uint32_t unit_index;
+} as_node_count;
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+static as_partitions_status*
+as_partitions_status_create(uint16_t part_begin, uint16_t part_count)
+{
+	size_t size = sizeof(as_partitions_status) + (sizeof(as_partition_status) * part_count);
+	as_partitions_status* parts_all = cf_malloc(size);
+	parts_all->ref_count = 1;
+	parts_all->part_begin = part_begin;
+	parts_all->part_count = part_count;
+	parts_all->done = false;
+
+	for (uint16_t i = 0; i < part_count; i++) {
+		as_partition_status* ps = &parts_all->parts[i];
+		ps->part_id = part_begin + i;
+		ps->done = false;
+		ps->digest.init = false;
+	}
+	return parts_all;
+}
+
+static as_node_count*
+as_node_count_get(as_vector* counts, as_node* node)
+{
+	for (uint32_t i = 0; i < counts->size; i++) {
+		as_node_count* nc = as_vector_get(counts, i);
+
+		if (nc->node == node) {
+			return nc;
+		}
+	}
+
+	as_node_count* nc = as_vector_reserve(counts);
+	nc->node = node;
+	nc->unit_index = UINT32_MAX;
+	return nc;
+}
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+uint8_t*
+as_partitions_status_serialize(const as_partitions_status* parts_all, uint32_t* size)
+{
+	uint32_t sz = AS_PARTS_STATUS_HEADER_SIZE + (AS_PART_STATUS_SIZE * parts_all->part_count);
+	uint8_t* buf = cf_malloc(sz);
+	uint8_t* p = buf;
+
+	*p++ = AS_PARTS_STATUS_VERSION;
+	*(uint16_t*)p = cf_swap_to_be16(parts_all->part_begin);
+	p += sizeof(uint16_t);
+	*(uint16_t*)p = cf_swap_to_be16(parts_all->part_count);
+	p += sizeof(uint16_t);
+	*p++ = parts_all->done;
+
+	for (uint16_t i = 0; i < parts_all->part_count; i++) {
+		const as_partition_status* ps = &parts_all->parts[i];
+		uint8_t flags = 0;
+
+		if (ps->done) {
+			flags |= AS_PART_STATUS_DONE;
+		}
+
+		if (ps->digest.init) {
+			flags |= AS_PART_STATUS_DIGEST;
+		}
+
+		*(uint16_t*)p = cf_swap_to_be16(ps->part_id);
+		p += sizeof(uint16_t);
+		*p++ = flags;
+
+		if (ps->digest.init) {
+			memcpy(p, ps->digest.value, AS_DIGEST_VALUE_SIZE);
+		}
+		else {
+			memset(p, 0, AS_DIGEST_VALUE_SIZE);
+		}
+		p += AS_DIGEST_VALUE_SIZE;
+	}
+	*size = sz;
+	return buf;
+}
+
+as_status
+as_partitions_status_deserialize(
+	as_error* err, const uint8_t* buf, uint32_t size, as_partitions_status** parts_all
+	)
+{
+	as_error_reset(err);
+
+	if (size < AS_PARTS_STATUS_HEADER_SIZE || buf[0] != AS_PARTS_STATUS_VERSION) {
+		return as_error_set_message(err, AEROSPIKE_ERR_PARAM, "Invalid partitions status header");
+	}
+
+	const uint8_t* p = buf + 1;
+	uint16_t part_begin = cf_swap_from_be16(*(uint16_t*)p);
+	p += sizeof(uint16_t);
+	uint16_t part_count = cf_swap_from_be16(*(uint16_t*)p);
+	p += sizeof(uint16_t);
+	bool done = *p++;
+
+	if (part_count == 0 || size != AS_PARTS_STATUS_HEADER_SIZE + (AS_PART_STATUS_SIZE * part_count)) {
+		return as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid partitions status size: %u", size);
+	}
+
+	as_partitions_status* pa = as_partitions_status_create(part_begin, part_count);
+	pa->done = done;
+
+	for (uint16_t i = 0; i < part_count; i++) {
+		as_partition_status* ps = &pa->parts[i];
+		uint16_t part_id = cf_swap_from_be16(*(uint16_t*)p);
+		p += sizeof(uint16_t);
+
+		if (part_id != ps->part_id) {
+			cf_free(pa);
+			return as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid partition id %u at index %u",
+								   part_id, i);
+		}
+
+		uint8_t flags = *p++;
+		ps->done = (flags & AS_PART_STATUS_DONE) != 0;
+		ps->digest.init = (flags & AS_PART_STATUS_DIGEST) != 0;
+		memcpy(ps->digest.value, p, AS_DIGEST_VALUE_SIZE);
+		p += AS_DIGEST_VALUE_SIZE;
+	}
+	*parts_all = pa;
+	return AEROSPIKE_OK;
+}
+
+as_status
+as_partition_tracker_init(
+	as_partition_tracker* pt, as_error* err, as_cluster* cluster, const as_policy_base* policy,
+	as_partition_filter* pf, uint32_t max_units
+	)
+{
+	if (pf->count == 0 || (uint32_t)pf->begin + pf->count > cluster->n_partitions) {
+		return as_error_update(err, AEROSPIKE_ERR_PARAM, "Invalid partition range: begin=%u count=%u max=%u",
+							   pf->begin, pf->count, cluster->n_partitions);
+	}
+
+	if (pf->parts_all) {
+		if (pf->parts_all->part_begin != pf->begin || pf->parts_all->part_count != pf->count) {
+			return as_error_set_message(err, AEROSPIKE_ERR_PARAM,
+										"Partition filter range does not match partitions status");
+		}
+		pt->parts_all = as_partitions_status_reserve(pf->parts_all);
+	}
+	else {
+		pt->parts_all = as_partitions_status_create(pf->begin, pf->count);
+
+		if (pf->digest.init && pf->count == 1) {
+			pt->parts_all->parts[0].digest = pf->digest;
+		}
+		// Give the cursor to the caller so the scan can be resumed.
+		pf->parts_all = as_partitions_status_reserve(pt->parts_all);
+	}
+
+	as_vector_init(&pt->node_parts, sizeof(as_node_partitions), 16);
+	pt->deadline = policy->total_timeout ? cf_getms() + policy->total_timeout : 0;
+	pt->sleep_between_retries = policy->sleep_between_retries;
+	pt->max_retries = policy->max_retries;
+	pt->iteration = 1;
+	pt->max_units = max_units ? max_units : 1;
+	return AEROSPIKE_OK;
+}
+
+as_status
+as_partition_tracker_assign(as_partition_tracker* pt, as_error* err, as_cluster* cluster, const char* ns)
+{
+	as_partitions_status* parts_all = pt->parts_all;
+	uint32_t part_count = parts_all->part_count;
+	as_node** owners = cf_malloc(sizeof(as_node*) * part_count);
+
+	as_vector counts;
+	as_vector_inita(&counts, sizeof(as_node_count), 16);
+
+	as_error lookup_err;
+	as_error_init(&lookup_err);
+
+	uint8_t digest[AS_DIGEST_VALUE_SIZE];
+	memset(digest, 0, sizeof(digest));
+	uint32_t n_assigned = 0;
+
+	// Find current master of each partition that is not done.
+	for (uint32_t i = 0; i < part_count; i++) {
+		as_partition_status* ps = &parts_all->parts[i];
+		owners[i] = NULL;
+
+		if (ps->done) {
+			continue;
+		}
+
+		// Partition id is stored in the first two digest bytes.
+		memcpy(digest, &ps->part_id, sizeof(uint16_t));
+
+		as_node* node;
+
+		if (as_cluster_get_node(cluster, &lookup_err, ns, digest, AS_POLICY_REPLICA_MASTER, true,
+								&node) != AEROSPIKE_OK) {
+			// Partition unavailable. Retry on next iteration.
+			continue;
+		}
+		owners[i] = node;
+		as_node_count_get(&counts, node)->count++;
+		n_assigned++;
+	}
+
+	if (n_assigned == 0 && pt->iteration == 1 && lookup_err.code != AEROSPIKE_OK) {
+		// No partition could be mapped on the first attempt.  Report the cause.
+		cf_free(owners);
+		as_vector_destroy(&counts);
+		as_error_copy(err, &lookup_err);
+		return err->code;
+	}
+
+	// Split each node's partitions into work units so that total units approximates max_units.
+	uint32_t units_per_node = counts.size ? pt->max_units / counts.size : 1;
+
+	if (units_per_node == 0) {
+		units_per_node = 1;
+	}
+
+	for (uint32_t i = 0; i < counts.size; i++) {
+		as_node_count* nc = as_vector_get(&counts, i);
+		nc->unit_size = (nc->count + units_per_node - 1) / units_per_node;
+	}
+
+	for (uint32_t i = 0; i < part_count; i++) {
+		as_node* node = owners[i];
+
+		if (! node) {
+			continue;
+		}
+
+		as_node_count* nc = as_node_count_get(&counts, node);
+		as_node_partitions* np = NULL;
+
+		if (nc->unit_index != UINT32_MAX) {
+			np = as_vector_get(&pt->node_parts, nc->unit_index);
+
+			if (np->parts_full.size + np->parts_partial.size >= nc->unit_size) {
+				np = NULL;
+			}
+		}
+
+		if (! np) {
+			nc->unit_index = pt->node_parts.size;
+			np = as_vector_reserve(&pt->node_parts);
+			as_node_reserve(node);
+			np->node = node;
+			as_vector_init(&np->parts_full, sizeof(uint16_t), nc->unit_size);
+			as_vector_init(&np->parts_partial, sizeof(uint16_t), nc->unit_size);
+		}
+
+		as_partition_status* ps = &parts_all->parts[i];
+
+		if (ps->digest.init) {
+			as_vector_append(&np->parts_partial, &ps->part_id);
+		}
+		else {
+			as_vector_append(&np->parts_full, &ps->part_id);
+		}
+		as_node_release(node);
+	}
+
+	cf_free(owners);
+	as_vector_destroy(&counts);
+	return AEROSPIKE_OK;
+}
+
+bool
+as_partition_tracker_should_retry(as_status status)
+{
+	switch (status) {
+		case AEROSPIKE_ERR_TIMEOUT:
+		case AEROSPIKE_ERR_CONNECTION:
+		case AEROSPIKE_ERR_ASYNC_CONNECTION:
+		case AEROSPIKE_ERR_INVALID_NODE:
+		case AEROSPIKE_ERR_NO_MORE_CONNECTIONS:
+		case AEROSPIKE_ERR_CLUSTER:
+		case AEROSPIKE_ERR_CLUSTER_CHANGE:
+		case AEROSPIKE_ERR_DEVICE_OVERLOAD:
+			// Partitions that are not done will be reassigned to their current owner.
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+bool
+as_partition_tracker_is_complete(as_partition_tracker* pt, as_error* err)
+{
+	as_partitions_status* parts_all = pt->parts_all;
+	uint32_t remaining = 0;
+
+	for (uint32_t i = 0; i < parts_all->part_count; i++) {
+		if (! parts_all->parts[i].done) {
+			remaining++;
+		}
+	}
+
+	if (remaining == 0) {
+		parts_all->done = true;
+		return true;
+	}
+
+	if (pt->iteration > pt->max_retries) {
+		as_error_update(err, AEROSPIKE_ERR_CLUSTER,
+						"Partition scan failed after %u attempts: %u partitions unavailable",
+						pt->iteration, remaining);
+		return false;
+	}
+
+	if (pt->deadline && cf_getms() + pt->sleep_between_retries >= pt->deadline) {
+		as_error_update(err, AEROSPIKE_ERR_TIMEOUT,
+						"Partition scan timed out: %u partitions unavailable", remaining);
+		return false;
+	}
+
+	as_log_debug("Partition scan iteration %u: %u partitions unavailable", pt->iteration, remaining);
+	pt->iteration++;
+	return false;
+}
+
+void
+as_partition_tracker_release(as_partition_tracker* pt)
+{
+	for (uint32_t i = 0; i < pt->node_parts.size; i++) {
+		as_node_partitions* np = as_vector_get(&pt->node_parts, i);
+		as_node_release(np->node);
+		as_vector_destroy(&np->parts_full);
+		as_vector_destroy(&np->parts_partial);
+	}
+	as_vector_clear(&pt->node_parts);
+}
+
+void
+as_partition_tracker_destroy(as_partition_tracker* pt)
+{
+	as_partition_tracker_release(pt);
+	as_vector_destroy(&pt->node_parts);
+	as_partitions_status_release(pt->parts_all);
+}
@@ -323,7 +323,7 @@ as_pipe_get_connection(as_event_command* cmd)
 			conn->in_pool = false;
 
 			// Verify that socket is active.  Socket receive buffer may already have data.
-			int len = as_event_validate_connection(&conn->base);
+			int len = as_event_validate_connection(&conn->base, true);
 
 			if (len >= 0) {
 				as_log_trace("Validation OK");
@@ -345,7 +345,7 @@ as_pipe_get_connection(as_event_command* cmd)
 		conn = cf_malloc(sizeof(as_pipe_connection));
 		assert(conn != NULL);
 
-#if defined(AS_USE_LIBEV) || defined(AS_USE_LIBEVENT)
+#if defined(AS_USE_LIBEV) || defined(AS_USE_LIBEVENT) || defined(AS_USE_LIBURING)
 		as_socket_init(&conn->base.socket);
 #endif
 		conn->base.watching = 0;
@@ -29,6 +29,7 @@ as_policies_init(as_policies* p)
 	as_policy_remove_init(&p->remove);
 	as_policy_apply_init(&p->apply);
 	as_policy_batch_init(&p->batch);
+	as_policy_batch_write_init(&p->batch_write);
 	as_policy_scan_init(&p->scan);
 	as_policy_query_init(&p->query);
 	as_policy_info_init(&p->info);
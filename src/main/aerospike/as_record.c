@@ -17,6 +17,7 @@
 #include <aerospike/as_bin.h>
 #include <aerospike/as_bytes.h>
 #include <aerospike/as_double.h>
+#include <aerospike/as_geojson.h>
 #include <aerospike/as_integer.h>
 #include <aerospike/as_key.h>
 #include <aerospike/as_list.h>
@@ -80,10 +81,12 @@ as_record_defaults(as_record* rec, bool free, uint16_t nbins)
 		rec->bins._free = true;
 		rec->bins.capacity = nbins;
 		rec->bins.size = 0;
-		rec->bins.entries = (as_bin *) cf_malloc(sizeof(as_bin) * nbins);
+		rec->bins.entries = (as_bin *) cf_malloc(as_bins_alloc_size(nbins));
+		as_bins_index_init(&rec->bins);
 	}
 	else {
 		rec->bins._free = false;
+		rec->bins._index = false;
 		rec->bins.capacity = 0;
 		rec->bins.size = 0;
 		rec->bins.entries = NULL;
@@ -92,6 +95,52 @@ as_record_defaults(as_record* rec, bool free, uint16_t nbins)
 	return rec;
 }
 
+/**
+ * Find bin index by name.  Return -1 if not found.
+ *
+ * Wide records are searched with the bin name index stored after the bin entries.
+ * Bins appended without updating the index are searched linearly.  The record is
+ * not modified, so concurrent lookups are safe.
+ */
+static int
+as_record_find(const as_bins* bins, const char* name)
+{
+	int start = 0;
+
+	if (bins->_index && bins->size >= AS_BINS_INDEX_MIN) {
+		const uint32_t* count = (const uint32_t*)(bins->entries + bins->capacity);
+		uint32_t indexed = *count;
+
+		if (indexed > 0 && indexed <= bins->size) {
+			const uint32_t* slots = count + 1;
+			uint32_t mask = as_bins_index_slots(bins->capacity) - 1;
+			uint32_t hash = as_bins_name_hash(name);
+			uint32_t tag = hash & 0xFFFF0000;
+			uint32_t pos = hash & mask;
+			uint32_t slot;
+
+			while ((slot = slots[pos])) {
+				if ((slot & 0xFFFF0000) == tag) {
+					int i = (int)(slot & 0xFFFF) - 1;
+
+					if (strcmp(bins->entries[i].name, name) == 0) {
+						return i;
+					}
+				}
+				pos = (pos + 1) & mask;
+			}
+			start = (int)indexed;
+		}
+	}
+
+	for (int i = start; i < bins->size; i++) {
+		if (strcmp(bins->entries[i].name, name) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
 /**
  * Find a bin for updating.
  * Either return an existing bin of given name, or return an empty entry.
@@ -105,18 +154,22 @@ as_record_bin_forupdate(as_record* rec, const as_bin_name name)
 	}
 
 	// look for bin of same name
-	for(int i = 0; i < rec->bins.size; i++) {
-		if ( strcmp(rec->bins.entries[i].name, name) == 0 ) {
-			as_val_destroy(rec->bins.entries[i].valuep);
-			rec->bins.entries[i].valuep = NULL;
-			return &rec->bins.entries[i];
-		}
+	int i = as_record_find(&rec->bins, name);
+
+	if ( i >= 0 ) {
+		as_val_destroy(rec->bins.entries[i].valuep);
+		rec->bins.entries[i].valuep = NULL;
+		return &rec->bins.entries[i];
 	}
 
 	// bin not found, then append
 	if ( rec->bins.size < rec->bins.capacity ) {
 		// Note - caller must successfully populate bin once we increment size.
-		return &rec->bins.entries[rec->bins.size++];
+		// Name is set now so the bin can be indexed.
+		as_bin* bin = &rec->bins.entries[rec->bins.size++];
+		strcpy(bin->name, name);
+		as_bins_index_update(&rec->bins);
+		return bin;
 	}
 
 	return NULL;
@@ -143,6 +196,7 @@ as_record_release(as_record* rec)
 		rec->bins.entries = NULL;
 		rec->bins.capacity = 0;
 		rec->bins.size = 0;
+		rec->bins._index = false;
 
 		rec->key.ns[0] = '\0';
 		rec->key.set[0] = '\0';
@@ -154,6 +208,51 @@ as_record_release(as_record* rec)
 	}
 }
 
+static as_val*
+as_record_copy_value(as_val* val, void* space)
+{
+	// Scalar, string and blob values are copied into space.  Other values are shared.
+	switch (as_val_type(val)) {
+		case AS_INTEGER: {
+			as_integer_init((as_integer*)space, ((as_integer*)val)->value);
+			return (as_val*)space;
+		}
+		case AS_DOUBLE: {
+			as_double_init((as_double*)space, ((as_double*)val)->value);
+			return (as_val*)space;
+		}
+		case AS_STRING: {
+			as_string* v = (as_string*)val;
+			size_t len = as_string_len(v);
+			char* str = cf_malloc(len + 1);
+			memcpy(str, v->value, len);
+			str[len] = 0;
+			as_string_init_wlen((as_string*)space, str, len, true);
+			return (as_val*)space;
+		}
+		case AS_GEOJSON: {
+			as_geojson* v = (as_geojson*)val;
+			size_t len = as_geojson_len(v);
+			char* str = cf_malloc(len + 1);
+			memcpy(str, v->value, len);
+			str[len] = 0;
+			as_geojson_init_wlen((as_geojson*)space, str, len, true);
+			return (as_val*)space;
+		}
+		case AS_BYTES: {
+			as_bytes* v = (as_bytes*)val;
+			uint8_t* bytes = cf_malloc(v->size);
+			memcpy(bytes, v->value, v->size);
+			as_bytes_init_wrap((as_bytes*)space, bytes, v->size, true);
+			((as_bytes*)space)->type = v->type;
+			return (as_val*)space;
+		}
+		default: {
+			return as_val_reserve(val);
+		}
+	}
+}
+
 as_record*
 as_record_new(uint16_t nbins)
 {
@@ -175,6 +274,34 @@ as_record_destroy(as_record* rec)
 	as_rec_destroy((as_rec *) rec);
 }
 
+as_record*
+as_record_copy(const as_record* rec)
+{
+	as_record* copy = as_record_new(rec->bins.size);
+	if ( !copy ) return copy;
+
+	copy->gen = rec->gen;
+	copy->ttl = rec->ttl;
+
+	memcpy(copy->key.ns, rec->key.ns, sizeof(as_namespace));
+	memcpy(copy->key.set, rec->key.set, sizeof(as_set));
+	copy->key.digest = rec->key.digest;
+
+	if ( rec->key.valuep ) {
+		copy->key.valuep = (as_key_value*)as_record_copy_value((as_val*)rec->key.valuep, &copy->key.value);
+	}
+
+	for ( uint16_t i = 0; i < rec->bins.size; i++ ) {
+		as_bin* src = &rec->bins.entries[i];
+		as_bin* trg = &copy->bins.entries[i];
+		strcpy(trg->name, src->name);
+		trg->valuep = (as_bin_value*)as_record_copy_value((as_val*)src->valuep, &trg->value);
+		copy->bins.size++;
+	}
+	as_bins_index_update(&copy->bins);
+	return copy;
+}
+
 /******************************************************************************
  * VALUE FUNCTIONS
  *****************************************************************************/
@@ -330,12 +457,8 @@ as_record_set_nil(as_record* rec, const as_bin_name name)
 as_bin_value*
 as_record_get(const as_record* rec, const as_bin_name name)
 {
-	for(int i=0; i<rec->bins.size; i++) {
-		if ( strcmp(rec->bins.entries[i].name, name) == 0 ) {
-			return (as_bin_value *) rec->bins.entries[i].valuep;
-		}
-	}
-	return NULL;
+	int i = as_record_find(&rec->bins, name);
+	return (i >= 0)? (as_bin_value *) rec->bins.entries[i].valuep : NULL;
 }
 
 int64_t
@@ -0,0 +1,217 @@
+/*
+ * Copyright 2008-2018 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/as_ripemd160.h>
+#include <citrusleaf/cf_byte_order.h>
+#include <citrusleaf/cf_digest.h>
+#include <string.h>
+
+#if defined(__GNUC__)
+
+/******************************************************************************
+ * TYPES
+ *****************************************************************************/
+
+// One 32 bit word per lane.  Compiles to SSE/NEON registers, or AVX2 registers in the
+// AVX2 clone.
+typedef uint32_t as_rmd_vec __attribute__((vector_size(AS_RIPEMD160_LANES * sizeof(uint32_t))));
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#if defined(__x86_64__) && defined(__linux__) && defined(__GLIBC__) && !defined(__clang__)
+// Select AVX2 implementation at load time when the CPU supports it.
+#define AS_RMD_TARGETS __attribute__((target_clones("avx2", "default")))
+#else
+#define AS_RMD_TARGETS
+#endif
+
+#define AS_RMD_ROL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define AS_RMD_F0(x, y, z) ((x) ^ (y) ^ (z))
+#define AS_RMD_F1(x, y, z) (((x) & (y)) | (~(x) & (z)))
+#define AS_RMD_F2(x, y, z) (((x) | ~(y)) ^ (z))
+#define AS_RMD_F3(x, y, z) (((x) & (z)) | ((y) & ~(z)))
+#define AS_RMD_F4(x, y, z) ((x) ^ ((y) | ~(z)))
+
+// Sixteen steps of the left and right lines.
+#define AS_RMD_ROUND(round, FL, FR) \
+	for (int j = round * 16; j < round * 16 + 16; j++) { \
+		t = AS_RMD_ROL(al + FL(bl, cl, dl) + x[as_rmd_r[j]] + as_rmd_k[round], as_rmd_s[j]) + el; \
+		al = el; el = dl; dl = AS_RMD_ROL(cl, 10); cl = bl; bl = t; \
+		t = AS_RMD_ROL(ar + FR(br, cr, dr) + x[as_rmd_rp[j]] + as_rmd_kp[round], as_rmd_sp[j]) + er; \
+		ar = er; er = dr; dr = AS_RMD_ROL(cr, 10); cr = br; br = t; \
+	}
+
+/******************************************************************************
+ * STATIC VARIABLES
+ *****************************************************************************/
+
+static const uint8_t as_rmd_r[80] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	7, 4, 13, 1, 10, 6, 15, 3, 12, 0, 9, 5, 2, 14, 11, 8,
+	3, 10, 14, 4, 9, 15, 8, 1, 2, 7, 0, 6, 13, 11, 5, 12,
+	1, 9, 11, 10, 0, 8, 12, 4, 13, 3, 7, 15, 14, 5, 6, 2,
+	4, 0, 5, 9, 7, 12, 2, 10, 14, 1, 3, 8, 11, 6, 15, 13
+};
+
+static const uint8_t as_rmd_rp[80] = {
+	5, 14, 7, 0, 9, 2, 11, 4, 13, 6, 15, 8, 1, 10, 3, 12,
+	6, 11, 3, 7, 0, 13, 5, 10, 14, 15, 8, 12, 4, 9, 1, 2,
+	15, 5, 1, 3, 7, 14, 6, 9, 11, 8, 12, 2, 10, 0, 4, 13,
+	8, 6, 4, 1, 3, 11, 15, 0, 5, 12, 2, 13, 9, 7, 10, 14,
+	12, 15, 10, 4, 1, 5, 8, 7, 6, 2, 13, 14, 0, 3, 9, 11
+};
+
+static const uint8_t as_rmd_s[80] = {
+	11, 14, 15, 12, 5, 8, 7, 9, 11, 13, 14, 15, 6, 7, 9, 8,
+	7, 6, 8, 13, 11, 9, 7, 15, 7, 12, 15, 9, 11, 7, 13, 12,
+	11, 13, 6, 7, 14, 9, 13, 15, 14, 8, 13, 6, 5, 12, 7, 5,
+	11, 12, 14, 15, 14, 15, 9, 8, 9, 14, 5, 6, 8, 6, 5, 12,
+	9, 15, 5, 11, 6, 8, 13, 12, 5, 12, 13, 14, 11, 8, 5, 6
+};
+
+static const uint8_t as_rmd_sp[80] = {
+	8, 9, 9, 11, 13, 15, 15, 5, 7, 7, 8, 11, 14, 14, 12, 6,
+	9, 13, 15, 7, 12, 8, 9, 11, 7, 7, 12, 7, 6, 15, 13, 11,
+	9, 7, 15, 11, 8, 6, 6, 14, 12, 13, 5, 14, 13, 13, 7, 5,
+	15, 5, 8, 11, 14, 14, 6, 14, 6, 9, 12, 9, 12, 5, 15, 8,
+	8, 5, 12, 9, 12, 5, 14, 6, 8, 13, 6, 5, 15, 13, 11, 11
+};
+
+static const uint32_t as_rmd_k[5] = {
+	0x00000000, 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xA953FD4E
+};
+
+static const uint32_t as_rmd_kp[5] = {
+	0x50A28BE6, 0x5C4DD124, 0x6D703EF3, 0x7A6D76E9, 0x00000000
+};
+
+/******************************************************************************
+ * STATIC FUNCTIONS
+ *****************************************************************************/
+
+AS_RMD_TARGETS static void
+as_rmd_compress(
+	as_rmd_vec* h, uint8_t lanes[][AS_RIPEMD160_LANE_SIZE], const uint32_t* n_blocks, uint32_t block
+	)
+{
+	as_rmd_vec x[16];
+	as_rmd_vec mask;
+	uint32_t offset = block * 64;
+
+	// Transpose block words so each vector holds the same word of every lane.
+	for (int l = 0; l < AS_RIPEMD160_LANES; l++) {
+		bool active = n_blocks[l] > block;
+		mask[l] = active ? 0xFFFFFFFF : 0;
+
+		for (int w = 0; w < 16; w++) {
+			uint32_t v = 0;
+
+			if (active) {
+				memcpy(&v, &lanes[l][offset + w * 4], sizeof(uint32_t));
+			}
+			x[w][l] = cf_swap_from_le32(v);
+		}
+	}
+
+	as_rmd_vec al = h[0], bl = h[1], cl = h[2], dl = h[3], el = h[4];
+	as_rmd_vec ar = h[0], br = h[1], cr = h[2], dr = h[3], er = h[4];
+	as_rmd_vec t;
+
+	AS_RMD_ROUND(0, AS_RMD_F0, AS_RMD_F4);
+	AS_RMD_ROUND(1, AS_RMD_F1, AS_RMD_F3);
+	AS_RMD_ROUND(2, AS_RMD_F2, AS_RMD_F2);
+	AS_RMD_ROUND(3, AS_RMD_F3, AS_RMD_F1);
+	AS_RMD_ROUND(4, AS_RMD_F4, AS_RMD_F0);
+
+	as_rmd_vec r[5];
+	r[0] = h[1] + cl + dr;
+	r[1] = h[2] + dl + er;
+	r[2] = h[3] + el + ar;
+	r[3] = h[4] + al + br;
+	r[4] = h[0] + bl + cr;
+
+	// Lanes without this block keep their state.
+	for (int i = 0; i < 5; i++) {
+		h[i] = (r[i] & mask) | (h[i] & ~mask);
+	}
+}
+
+#endif
+
+/******************************************************************************
+ * FUNCTIONS
+ *****************************************************************************/
+
+void
+as_ripemd160_lanes(
+	uint8_t lanes[][AS_RIPEMD160_LANE_SIZE], const uint32_t* lens, uint32_t n, uint8_t* const* digests
+	)
+{
+#if defined(__GNUC__)
+	uint32_t n_blocks[AS_RIPEMD160_LANES];
+	uint32_t max_blocks = 0;
+
+	for (uint32_t i = 0; i < AS_RIPEMD160_LANES; i++) {
+		if (i >= n) {
+			n_blocks[i] = 0;
+			continue;
+		}
+
+		// Pad with 0x80, zeros and the message length in bits.
+		uint32_t len = lens[i];
+		uint32_t blocks = (len + 8) / 64 + 1;
+		uint32_t end = blocks * 64;
+		uint64_t bits = cf_swap_to_le64((uint64_t)len << 3);
+
+		lanes[i][len] = 0x80;
+		memset(&lanes[i][len + 1], 0, end - sizeof(uint64_t) - len - 1);
+		memcpy(&lanes[i][end - sizeof(uint64_t)], &bits, sizeof(uint64_t));
+
+		n_blocks[i] = blocks;
+
+		if (blocks > max_blocks) {
+			max_blocks = blocks;
+		}
+	}
+
+	as_rmd_vec h[5];
+	uint32_t init[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+	for (int i = 0; i < 5; i++) {
+		for (int l = 0; l < AS_RIPEMD160_LANES; l++) {
+			h[i][l] = init[i];
+		}
+	}
+
+	for (uint32_t b = 0; b < max_blocks; b++) {
+		as_rmd_compress(h, lanes, n_blocks, b);
+	}
+
+	for (uint32_t i = 0; i < n; i++) {
+		for (int w = 0; w < 5; w++) {
+			uint32_t v = cf_swap_to_le32(h[w][i]);
+			memcpy(digests[i] + w * 4, &v, sizeof(uint32_t));
+		}
+	}
+#else
+	for (uint32_t i = 0; i < n; i++) {
+		cf_digest_compute(lanes[i], lens[i], (cf_digest*)digests[i]);
+	}
+#endif
+}
@@ -30,6 +30,7 @@
 #include <signal.h>
 
 #if !defined(_MSC_VER)
+#include <sched.h>
 #include <sys/shm.h>
 #else
 #define WIN32_LEAN_AND_MEAN
@@ -127,6 +128,79 @@ as_shm_get_max_size()
 }
 #endif
 
+/**
+ * Reader spins before yielding the CPU to a writer that holds a sequence odd.
+ */
+#define AS_SHM_SPIN_MAX 100
+
+/**
+ * Reader yields before giving up on a consistent read.  The tend master may have died
+ * between write begin and end, leaving the sequence odd until another process takes over.
+ */
+#define AS_SHM_YIELD_MAX 1000
+
+#if defined(_MSC_VER)
+#define as_shm_cpu_pause() YieldProcessor()
+#define as_shm_yield() SwitchToThread()
+#else
+#if defined(__x86_64__) || defined(__i386__)
+#define as_shm_cpu_pause() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define as_shm_cpu_pause() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define as_shm_cpu_pause()
+#endif
+#define as_shm_yield() sched_yield()
+#endif
+
+/**
+ * Shared memory sequence locks have a single writer, the tend master.  The sequence is odd
+ * while an update is in progress.  Readers never block the writer or each other.
+ */
+static inline void
+as_shm_write_begin(uint32_t* seq)
+{
+	as_store_uint32(seq, *seq + 1);
+	as_fence_store();
+}
+
+static inline void
+as_shm_write_end(uint32_t* seq)
+{
+	as_fence_store();
+	as_store_uint32(seq, *seq + 1);
+}
+
+static inline bool
+as_shm_read_begin(uint32_t* seq, uint32_t* s)
+{
+	uint32_t count = 0;
+
+	while ((*s = as_load_uint32(seq)) & 1) {
+		// Writer is in progress.
+		if (count < AS_SHM_SPIN_MAX) {
+			as_shm_cpu_pause();
+		}
+		else if (count < AS_SHM_SPIN_MAX + AS_SHM_YIELD_MAX) {
+			as_shm_yield();
+		}
+		else {
+			// Writer is stalled or died.  Caller decides how to handle an inconsistent read.
+			return false;
+		}
+		count++;
+	}
+	as_fence_acquire();
+	return true;
+}
+
+static inline bool
+as_shm_read_retry(uint32_t* seq, uint32_t s)
+{
+	as_fence_acquire();
+	return as_load_uint32(seq) != s;
+}
+
 static int
 as_shm_find_node_index(as_cluster_shm* cluster_shm, const char* name)
 {
@@ -157,8 +231,8 @@ as_shm_add_nodes(as_cluster* cluster, as_vector* /* <as_node*> */ nodes_to_add)
 			// Node already exists.  Activate node.
 			as_node_shm* node_shm = &cluster_shm->nodes[node_index];
 			
-			// Update shared memory node in write lock.
-			as_swlock_write_lock(&node_shm->lock);
+			// Update shared memory node under sequence lock.
+			as_shm_write_begin(&node_shm->seq);
 			memcpy(&node_shm->addr, &address->addr, sizeof(struct sockaddr_storage));
 			if (node_to_add->tls_name) {
 				strcpy(node_shm->tls_name, node_to_add->tls_name);
@@ -168,7 +242,7 @@ as_shm_add_nodes(as_cluster* cluster, as_vector* /* <as_node*> */ nodes_to_add)
 			}
 			node_shm->features = node_to_add->features;
 			node_shm->active = true;
-			as_swlock_write_unlock(&node_shm->lock);
+			as_shm_write_end(&node_shm->seq);
 			
 			// Set shared memory node array index.
 			// Only referenced by shared memory tending thread, so volatile write not necessary.
@@ -179,8 +253,8 @@ as_shm_add_nodes(as_cluster* cluster, as_vector* /* <as_node*> */ nodes_to_add)
 			if (cluster_shm->nodes_size < cluster_shm->nodes_capacity) {
 				as_node_shm* node_shm = &cluster_shm->nodes[cluster_shm->nodes_size];
 				
-				// Update shared memory node in write lock.
-				as_swlock_write_lock(&node_shm->lock);
+				// Update shared memory node under sequence lock.
+				as_shm_write_begin(&node_shm->seq);
 				memcpy(node_shm->name, node_to_add->name, AS_NODE_NAME_SIZE);
 				memcpy(&node_shm->addr, &address->addr, sizeof(struct sockaddr_storage));
 				if (node_to_add->tls_name) {
@@ -191,7 +265,7 @@ as_shm_add_nodes(as_cluster* cluster, as_vector* /* <as_node*> */ nodes_to_add)
 				}
 				node_shm->features = node_to_add->features;
 				node_shm->active = true;
-				as_swlock_write_unlock(&node_shm->lock);
+				as_shm_write_end(&node_shm->seq);
 				
 				// Set shared memory node array index.
 				// Only referenced by shared memory tending thread, so volatile write not necessary.
@@ -222,17 +296,17 @@ as_shm_remove_nodes(as_cluster* cluster, as_vector* /* <as_node*> */ nodes_to_re
 		as_node* node_to_remove = as_vector_get_ptr(nodes_to_remove, i);
 		as_node_shm* node_shm = &cluster_shm->nodes[node_to_remove->index];
 		
-		// Update shared memory node in write lock.
-		as_swlock_write_lock(&node_shm->lock);
+		// Update shared memory node under sequence lock.
+		as_shm_write_begin(&node_shm->seq);
 		node_shm->active = false;
-		as_swlock_write_unlock(&node_shm->lock);
+		as_shm_write_end(&node_shm->seq);
 
 		as_store_ptr(&shm_info->local_nodes[node_to_remove->index], 0);
 	}
 	as_incr_uint32(&cluster_shm->nodes_gen);
 }
 
-static void
+static bool
 as_shm_reset_nodes(as_cluster* cluster)
 {
 	// Synchronize shared memory nodes with local nodes.
@@ -249,14 +323,26 @@ as_shm_reset_nodes(as_cluster* cluster)
 	as_vector nodes_to_remove;
 	as_vector_inita(&nodes_to_remove, sizeof(as_node*), max);
 
+	bool complete = true;
+
 	for (uint32_t i = 0; i < max; i++) {
 		as_node_shm* node_shm = &nodes_shm[i];
 		as_node* node = shm_info->local_nodes[i];
 
-		// Make copy of shared memory node under a read lock.
-		as_swlock_read_lock(&node_shm->lock);
-		memcpy(&node_tmp, node_shm, sizeof(as_node_shm));
-		as_swlock_read_unlock(&node_shm->lock);
+		// Make consistent copy of shared memory node without blocking the tend master.
+		uint32_t seq;
+		bool valid;
+
+		do {
+			valid = as_shm_read_begin(&node_shm->seq, &seq);
+			memcpy(&node_tmp, node_shm, sizeof(as_node_shm));
+		} while (valid && as_shm_read_retry(&node_shm->seq, seq));
+
+		if (! valid) {
+			// Node update did not finish.  Try again on the next tend.
+			complete = false;
+			continue;
+		}
 		
 		if (node_tmp.active) {
 			if (! node) {
@@ -295,6 +381,7 @@ as_shm_reset_nodes(as_cluster* cluster)
 	
 	as_vector_destroy(&nodes_to_add);
 	as_vector_destroy(&nodes_to_remove);
+	return complete;
 }
 
 bool
@@ -369,42 +456,28 @@ static void
 as_shm_partition_update(as_shm_info* shm_info, as_partition_shm* p, uint32_t node_index, bool master, bool owns, uint32_t regime)
 {
 	// node_index starts at one (zero indicates unset).
-	if (master) {
-		if (node_index == p->master) {
-			if (! owns) {
-				as_store_uint32(&p->master, 0);
-			}
-		}
-		else {
-			if (owns && regime >= as_load_uint32(&p->regime)) {
-				if (p->master) {
-					as_shm_force_replicas_refresh(shm_info, p->master);
-				}
-				as_store_uint32(&p->master, node_index);
-
-				if (regime > p->regime) {
-					as_store_uint32(&p->regime, regime);
-				}
-			}
+	// Only the tend master writes partitions, so plain reads are sufficient here.
+	uint32_t* replica_index = master ? &p->master : &p->prole;
+
+	if (node_index == *replica_index) {
+		if (! owns) {
+			as_shm_write_begin(&p->seq);
+			as_store_uint32(replica_index, 0);
+			as_shm_write_end(&p->seq);
 		}
 	}
 	else {
-		if (node_index == p->prole) {
-			if (! owns) {
-				as_store_uint32(&p->prole, 0);
+		if (owns && regime >= p->regime) {
+			if (*replica_index) {
+				as_shm_force_replicas_refresh(shm_info, *replica_index);
 			}
-		}
-		else {
-			if (owns && regime >= as_load_uint32(&p->regime)) {
-				if (p->prole) {
-					as_shm_force_replicas_refresh(shm_info, p->prole);
-				}
-				as_store_uint32(&p->prole, node_index);
+			as_shm_write_begin(&p->seq);
+			as_store_uint32(replica_index, node_index);
 
-				if (regime > p->regime) {
-					as_store_uint32(&p->regime, regime);
-				}
+			if (regime > p->regime) {
+				as_store_uint32(&p->regime, regime);
 			}
+			as_shm_write_end(&p->seq);
 		}
 	}
 }
@@ -518,14 +591,24 @@ as_partition_shm_get_node(as_cluster* cluster, as_partition_shm* p, as_policy_re
 {
 	// Make volatile reference so changes to tend thread will be reflected in this thread.
 	as_node** local_nodes = cluster->shm_info->local_nodes;
-	uint32_t master = as_load_uint32(&p->master);
+	uint32_t master;
+	uint32_t prole;
+	uint32_t seq;
+
+	// Read master/prole pair that was written in the same partition update.  If the update
+	// never finishes, use the last loaded pair.  A wrong node only causes a server redirect.
+	bool valid;
+
+	do {
+		valid = as_shm_read_begin(&p->seq, &seq);
+		master = as_load_uint32(&p->master);
+		prole = as_load_uint32(&p->prole);
+	} while (valid && as_shm_read_retry(&p->seq, seq));
 
 	if (replica == AS_POLICY_REPLICA_MASTER) {
 		return as_shm_reserve_master(cluster, local_nodes, master);
 	}
 
-	uint32_t prole = as_load_uint32(&p->prole);
-
 	if (! prole) {
 		return as_shm_reserve_node(cluster, local_nodes, master, cp_mode);
 	}
@@ -547,10 +630,48 @@ as_partition_shm_get_node(as_cluster* cluster, as_partition_shm* p, as_policy_re
 	return as_shm_reserve_node_alternate(cluster, local_nodes, prole, master, cp_mode);
 }
 
+static inline void
+as_shm_reset_seq(uint32_t* seq)
+{
+	uint32_t s = as_load_uint32(seq);
+
+	if (s & 1) {
+		as_store_uint32(seq, s + 1);
+	}
+}
+
+static void
+as_shm_reset_seqs(as_cluster_shm* cluster_shm)
+{
+	// A previous tend master may have died between write begin and end, leaving sequences
+	// odd.  Make every sequence even, so readers stop waiting and this process's updates
+	// keep the parity.  Partially written partitions are rewritten when this process
+	// refreshes partition maps on its first tend.
+	as_node_shm* nodes_shm = cluster_shm->nodes;
+
+	for (uint32_t i = 0; i < cluster_shm->nodes_capacity; i++) {
+		as_shm_reset_seq(&nodes_shm[i].seq);
+	}
+
+	as_partition_table_shm* tables = as_shm_get_partition_tables(cluster_shm);
+	uint32_t max_tables = cluster_shm->partition_tables_size;
+	uint32_t max_partitions = cluster_shm->n_partitions;
+
+	for (uint32_t i = 0; i < max_tables; i++) {
+		as_partition_table_shm* table = as_shm_get_partition_table(cluster_shm, tables, i);
+
+		for (uint32_t j = 0; j < max_partitions; j++) {
+			as_shm_reset_seq(&table->partitions[j].seq);
+		}
+	}
+	as_fence_store();
+}
+
 static void
 as_shm_takeover_cluster(as_shm_info* shm_info, as_cluster_shm* cluster_shm, uint32_t pid)
 {
 	as_log_info("Take over shared memory cluster: %d", pid);
+	as_shm_reset_seqs(cluster_shm);
 	as_store_uint32(&cluster_shm->owner_pid, pid);
 	shm_info->is_tend_master = true;
 }
@@ -654,9 +775,8 @@ as_shm_tender(void* userdata)
 			// Synchronize local cluster with shared memory cluster.
 			uint32_t gen = as_load_uint32(&cluster_shm->nodes_gen);
 			
-			if (nodes_gen != gen) {
+			if (nodes_gen != gen && as_shm_reset_nodes(cluster)) {
 				nodes_gen = gen;
-				as_shm_reset_nodes(cluster);
 			}
 		}
 
@@ -820,6 +940,7 @@ as_shm_create(as_cluster* cluster, as_error* err, as_config* config)
 		if (as_load_uint8(&cluster_shm->ready)) {
 			// Copy shared memory nodes to local nodes.
 			as_log_info("Cluster already initialized: %d", pid);
+			as_shm_reset_seqs(cluster_shm);
 			as_shm_reset_nodes(cluster);
 			as_cluster_add_seeds(cluster);
 		}
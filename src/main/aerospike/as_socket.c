@@ -30,8 +30,6 @@
 #include <sys/socket.h>
 #include <sys/time.h>
 
-#define AS_EINTR EINTR
-
 static inline bool
 as_socket_is_error(int e)
 {
@@ -39,8 +37,6 @@ as_socket_is_error(int e)
 }
 
 #else // _MSC_VER
-#define AS_EINTR WSAEINTR
-
 static inline bool
 as_socket_is_error(int e)
 {
@@ -160,6 +156,15 @@ as_socket_wrap(as_socket* sock, int family, as_socket_fd fd, as_tls_context* ctx
 	sock->family = family;
 #endif
 	sock->idle_check.max_socket_idle = sock->idle_check.last_used = 0;
+	sock->rbuf = NULL;
+	sock->rbuf_capacity = 0;
+	sock->rbuf_offset = 0;
+	sock->rbuf_len = 0;
+	sock->zbuf = NULL;
+	sock->zbuf_capacity = 0;
+	sock->zbuf_offset = 0;
+	sock->zbuf_len = 0;
+	sock->unvalidated = false;
 
 	if (ctx) {
 		if (as_tls_wrap(ctx, sock, tls_name) < 0) {
@@ -228,6 +233,42 @@ as_socket_close(as_socket* sock)
 	}
 	as_close(sock->fd);
 	sock->fd = -1;
+
+	if (sock->rbuf) {
+		cf_free(sock->rbuf);
+		sock->rbuf = NULL;
+		sock->rbuf_capacity = 0;
+	}
+	sock->rbuf_offset = 0;
+	sock->rbuf_len = 0;
+
+	if (sock->zbuf) {
+		cf_free(sock->zbuf);
+		sock->zbuf = NULL;
+		sock->zbuf_capacity = 0;
+	}
+	sock->zbuf_offset = 0;
+	sock->zbuf_len = 0;
+}
+
+void
+as_socket_trim(as_socket* sock)
+{
+	if (sock->rbuf_capacity > AS_SOCKET_RBUF_MAX && sock->rbuf_offset == sock->rbuf_len) {
+		cf_free(sock->rbuf);
+		sock->rbuf = NULL;
+		sock->rbuf_capacity = 0;
+		sock->rbuf_offset = 0;
+		sock->rbuf_len = 0;
+	}
+
+	if (sock->zbuf_capacity > AS_SOCKET_RBUF_MAX && sock->zbuf_offset == sock->zbuf_len) {
+		cf_free(sock->zbuf);
+		sock->zbuf = NULL;
+		sock->zbuf_capacity = 0;
+		sock->zbuf_offset = 0;
+		sock->zbuf_len = 0;
+	}
 }
 
 as_status
@@ -294,8 +335,13 @@ as_socket_validate_fd(as_socket_fd fd)
 }
 
 int
-as_socket_validate(as_socket* sock)
+as_socket_validate(as_socket* sock, bool peek)
 {
+	if (sock->rbuf_offset != sock->rbuf_len || sock->zbuf_offset != sock->zbuf_len) {
+		// Unconsumed response bytes from a previous command.
+		return -1;
+	}
+
 	if (sock->idle_check.max_socket_idle > 0) {
 		uint32_t idle = (uint32_t)cf_get_seconds() - sock->idle_check.last_used;
 
@@ -304,7 +350,63 @@ as_socket_validate(as_socket* sock)
 		}
 	}
 
-	return as_socket_validate_fd(sock->fd);
+	return peek ? as_socket_validate_fd(sock->fd) : 0;
+}
+
+/**
+ * Wait for socket to become ready after a non-blocking read/write would have blocked.
+ * Return AEROSPIKE_OK when the read/write should be attempted again.
+ */
+static as_status
+as_socket_wait(
+	as_error* err, as_socket* sock, struct as_node_s* node, uint32_t socket_timeout,
+	uint64_t deadline, bool read
+	)
+{
+	uint32_t timeout;
+
+	if (deadline > 0) {
+		uint64_t now = cf_getms();
+
+		if (now >= deadline) {
+			// Timeout.  Do not set error string to avoid affecting performance.
+			// Calling functions usually retry, so the error string is not used anyway.
+			err->code = AEROSPIKE_ERR_TIMEOUT;
+			err->message[0] = 0;
+			return AEROSPIKE_ERR_TIMEOUT;
+		}
+
+		timeout = (uint32_t)(deadline - now);
+
+		if (socket_timeout > 0 && socket_timeout < timeout) {
+			timeout = socket_timeout;
+		}
+	}
+	else {
+		timeout = socket_timeout;
+	}
+
+	int rv = as_poll_wait(sock->fd, timeout, read);
+
+	if (rv > 0) {
+		return AEROSPIKE_OK;
+	}
+
+	if (rv == 0) {
+		// Timeout.  Do not set error string to avoid affecting performance.
+		// Calling functions usually retry, so the error string is not used anyway.
+		err->code = AEROSPIKE_ERR_TIMEOUT;
+		err->message[0] = 0;
+		return AEROSPIKE_ERR_TIMEOUT;
+	}
+
+	int e = as_last_error();
+
+	if (e == AS_EINTR && ! as_socket_stop_on_interrupt) {
+		return AEROSPIKE_OK;
+	}
+	return as_socket_error(sock->fd, node, err, AEROSPIKE_ERR_CONNECTION,
+		read ? "Socket read error" : "Socket write error", e);
 }
 
 as_status
@@ -314,6 +416,10 @@ as_socket_write_deadline(
 	)
 {
 	if (sock->ctx) {
+		// A failed TLS write may have sent part of the record, so the connection no
+		// longer qualifies as stale.
+		sock->unvalidated = false;
+
 		as_status status = AEROSPIKE_OK;
 		int rv = as_tls_write(sock, buf, buf_len, socket_timeout, deadline);
 
@@ -327,101 +433,178 @@ as_socket_write_deadline(
 			status = err->code = AEROSPIKE_ERR_TIMEOUT;
 			err->message[0] = 0;
 		}
+		else {
+			as_node_add_bytes_out(node, buf_len);
+		}
 		return status;
 	}
 
-	as_poll poll;
-	as_poll_init(&poll, sock->fd);
-
+	// Sockets are non-blocking.  Attempt the write first and only wait for the socket
+	// to become writable when the write would block.
 	size_t pos = 0;
 	as_status status = AEROSPIKE_OK;
-	uint32_t timeout;
-	int try = 0;
 
 	do {
-		if (deadline > 0) {
-			uint64_t now = cf_getms();
-
-			if (now >= deadline) {
-				// Timeout.  Do not set error string to avoid affecting performance.
-				// Calling functions usually retry, so the error string is not used anyway.
-				status = err->code = AEROSPIKE_ERR_TIMEOUT;
-				err->message[0] = 0;
-				break;
-			}
+#if defined(__linux__) 
+		int w_bytes = (int)send(sock->fd, buf + pos, buf_len - pos, MSG_NOSIGNAL);
+#elif defined(_MSC_VER)
+		int w_bytes = send(sock->fd, buf + pos, (int)(buf_len - pos), 0);
+#else
+		int w_bytes = (int)write(sock->fd, buf + pos, buf_len - pos);
+#endif
 
-			timeout = (uint32_t)(deadline - now);
+		if (w_bytes > 0) {
+			pos += w_bytes;
+			continue;
+		}
 
-			if (socket_timeout > 0 && socket_timeout < timeout) {
-				timeout = socket_timeout;
-			}
+		if (w_bytes == 0) {
+			// We shouldn't see 0 returned unless we try to write 0 bytes, which we don't.
+			status = as_error_set_message(err, AEROSPIKE_ERR_CONNECTION, "Bad file descriptor");
+			break;
 		}
-		else {
-			timeout = socket_timeout;
+
+		int e = as_last_error();
+
+		if (e == AS_EINTR && ! as_socket_stop_on_interrupt) {
+			continue;
+		}
+
+		if (as_socket_is_error(e)) {
+			status = as_socket_error(sock->fd, node, err, AEROSPIKE_ERR_CONNECTION, "Socket write error", e);
+			break;
 		}
 
-		int rv = as_poll_socket(&poll, sock->fd, timeout, false);
+		status = as_socket_wait(err, sock, node, socket_timeout, deadline, false);
 
-		if (rv > 0) {
-#if defined(__linux__) 
-			int w_bytes = (int)send(sock->fd, buf + pos, buf_len - pos, MSG_NOSIGNAL);
-#elif defined(_MSC_VER)
-			int w_bytes = send(sock->fd, buf + pos, (int)(buf_len - pos), 0);
+		if (status != AEROSPIKE_OK) {
+			break;
+		}
+	} while (pos < buf_len);
+
+	if (pos > 0) {
+		// Server may have received the command.  A later failure is not a stale connection.
+		sock->unvalidated = false;
+	}
+	as_node_add_bytes_out(node, pos);
+	return status;
+}
+
+#if !defined(_MSC_VER)
+static as_status
+as_socket_writev_fd(
+	as_error* err, as_socket* sock, struct as_node_s* node, as_iovec* iov, uint32_t n_iov,
+	uint32_t socket_timeout, uint64_t deadline
+	)
+{
+	size_t sent = 0;
+	as_status status = AEROSPIKE_OK;
+
+	do {
+		int n = (n_iov < AS_IOV_MAX)? (int)n_iov : AS_IOV_MAX;
+#if defined(__linux__)
+		struct msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = iov;
+		msg.msg_iovlen = n;
+		ssize_t w_bytes = sendmsg(sock->fd, &msg, MSG_NOSIGNAL);
 #else
-			int w_bytes = (int)write(sock->fd, buf + pos, buf_len - pos);
+		ssize_t w_bytes = writev(sock->fd, iov, n);
 #endif
-		
-			if (w_bytes > 0) {
-				pos += w_bytes;
-			}
-			else if (w_bytes == 0) {
-				// We shouldn't see 0 returned unless we try to write 0 bytes, which we don't.
-				status = as_error_set_message(err, AEROSPIKE_ERR_CONNECTION, "Bad file descriptor");
-				break;
+
+		if (w_bytes > 0) {
+			// Skip buffers that were fully written and advance into the partial one.
+			size_t written = (size_t)w_bytes;
+			sent += written;
+
+			while (n_iov > 0 && written >= iov->iov_len) {
+				written -= iov->iov_len;
+				iov++;
+				n_iov--;
 			}
-			else {
-				int e = as_last_error();
-				if (as_socket_is_error(e)) {
-					status = as_socket_error(sock->fd, node, err, AEROSPIKE_ERR_CONNECTION, "Socket write error", e);
-					break;
-				}
+
+			if (written > 0) {
+				iov->iov_base = (uint8_t*)iov->iov_base + written;
+				iov->iov_len -= written;
 			}
+			continue;
 		}
-		else if (rv == 0) {
-			// Timeout.  Do not set error string to avoid affecting performance.
-			// Calling functions usually retry, so the error string is not used anyway.
-			status = err->code = AEROSPIKE_ERR_TIMEOUT;
-			err->message[0] = 0;
+
+		if (w_bytes == 0) {
+			status = as_error_set_message(err, AEROSPIKE_ERR_CONNECTION, "Bad file descriptor");
 			break;
 		}
-		else if (rv == -1) {
-			int e = as_last_error();
-			if (e != AS_EINTR || as_socket_stop_on_interrupt) {
-				status = as_socket_error(sock->fd, node, err, AEROSPIKE_ERR_CONNECTION, "Socket write error", e);
-				break;
-			}
+
+		int e = as_last_error();
+
+		if (e == AS_EINTR && ! as_socket_stop_on_interrupt) {
+			continue;
 		}
-	
-		try++;
-	
-	} while (pos < buf_len);
 
-	as_poll_destroy(&poll);
+		if (as_socket_is_error(e)) {
+			status = as_socket_error(sock->fd, node, err, AEROSPIKE_ERR_CONNECTION, "Socket write error", e);
+			break;
+		}
+
+		status = as_socket_wait(err, sock, node, socket_timeout, deadline, false);
+
+		if (status != AEROSPIKE_OK) {
+			break;
+		}
+	} while (n_iov > 0);
+
+	if (sent > 0) {
+		// Server may have received the command.  A later failure is not a stale connection.
+		sock->unvalidated = false;
+	}
+	as_node_add_bytes_out(node, sent);
 	return status;
 }
+#endif
 
 as_status
-as_socket_read_deadline(
-	as_error* err, as_socket* sock, as_node* node, uint8_t *buf, size_t buf_len,
+as_socket_writev_deadline(
+	as_error* err, as_socket* sock, struct as_node_s* node, const as_iovec* iov, uint32_t n_iov,
 	uint32_t socket_timeout, uint64_t deadline
 	)
 {
+#if !defined(_MSC_VER)
+	if (! sock->ctx && n_iov > 1) {
+		// Partial writes advance the buffers, so work on a copy.  The caller's
+		// buffers may be sent again on retry.
+		as_iovec* copy = (as_iovec*)alloca(sizeof(as_iovec) * n_iov);
+		memcpy(copy, iov, sizeof(as_iovec) * n_iov);
+		return as_socket_writev_fd(err, sock, node, copy, n_iov, socket_timeout, deadline);
+	}
+#endif
+
+	// TLS records are written one buffer at a time.
+	for (uint32_t i = 0; i < n_iov; i++) {
+		as_status status = as_socket_write_deadline(err, sock, node, (uint8_t*)iov[i].iov_base,
+			iov[i].iov_len, socket_timeout, deadline);
+
+		if (status != AEROSPIKE_OK) {
+			return status;
+		}
+	}
+	return AEROSPIKE_OK;
+}
+
+static as_status
+as_socket_read_fd(
+	as_error* err, as_socket* sock, as_node* node, uint8_t *buf, size_t buf_len, size_t min_len,
+	uint32_t socket_timeout, uint64_t deadline, size_t* len
+	)
+{
+	// Read at least min_len bytes and at most buf_len bytes.
 	if (sock->ctx) {
+		// TLS reads exactly min_len bytes.  OpenSSL buffers records internally.
 		as_status status = AEROSPIKE_OK;
-		int rv = as_tls_read(sock, buf, buf_len, socket_timeout, deadline);
+		int rv = as_tls_read(sock, buf, min_len, socket_timeout, deadline);
 
 		if (rv < 0) {
 			status = as_socket_error(sock->fd, node, err, AEROSPIKE_ERR_CONNECTION, "TLS read error", rv);
+			*len = 0;
 		}
 		else if (rv == 1) {
 			// Do not set error string to avoid affecting performance.
@@ -429,84 +612,241 @@ as_socket_read_deadline(
 			// not used anyway.
 			status = err->code = AEROSPIKE_ERR_TIMEOUT;
 			err->message[0] = 0;
+			*len = 0;
+		}
+		else {
+			as_node_add_bytes_in(node, min_len);
+			sock->unvalidated = false;
+			*len = min_len;
 		}
 		return status;
 	}
 
-	as_poll poll;
-	as_poll_init(&poll, sock->fd);
-
+	// Sockets are non-blocking.  Attempt the read first and only wait for the socket
+	// to become readable when no data is available.
 	size_t pos = 0;
 	as_status status = AEROSPIKE_OK;
-	uint32_t timeout;
-	int try = 0;
 
 	do {
-		if (deadline > 0) {
-			uint64_t now = cf_getms();
-
-			if (now >= deadline) {
-				// Timeout.  Do not set error string to avoid affecting performance.
-				// Calling functions usually retry, so the error string is not used anyway.
-				status = err->code = AEROSPIKE_ERR_TIMEOUT;
-				err->message[0] = 0;
-				break;
-			}
-
-			timeout = (uint32_t)(deadline - now);
+#if !defined(_MSC_VER)
+		int r_bytes = (int)read(sock->fd, buf + pos, buf_len - pos);
+#else
+		int r_bytes = (int)recv(sock->fd, buf + pos, (int)(buf_len - pos), 0);
+#endif
 
-			if (socket_timeout > 0 && socket_timeout < timeout) {
-				timeout = socket_timeout;
-			}
+		if (r_bytes > 0) {
+			pos += r_bytes;
+			continue;
 		}
-		else {
-			timeout = socket_timeout;
+
+		if (r_bytes == 0) {
+			// We believe this means that the server has closed this socket.
+			status = as_error_set_message(err, AEROSPIKE_ERR_CONNECTION, "Bad file descriptor");
+			break;
 		}
 
-		int rv = as_poll_socket(&poll, sock->fd, timeout, true);
+		int e = as_last_error();
 
-		if (rv > 0) {
-#if !defined(_MSC_VER)
-			int r_bytes = (int)read(sock->fd, buf + pos, buf_len - pos);
-#else
-			int r_bytes = (int)recv(sock->fd, buf + pos, (int)(buf_len - pos), 0);
-#endif
+		if (e == AS_EINTR && ! as_socket_stop_on_interrupt) {
+			continue;
+		}
 
-			if (r_bytes > 0) {
-				pos += r_bytes;
-			}
-			else if (r_bytes == 0) {
-				// We believe this means that the server has closed this socket.
-				status = as_error_set_message(err, AEROSPIKE_ERR_CONNECTION, "Bad file descriptor");
-				break;
-			}
-			else {
-				int e = as_last_error();
-				if (as_socket_is_error(e)) {
-					status = as_socket_error(sock->fd, node, err, AEROSPIKE_ERR_CONNECTION, "Socket read error", e);
-					break;
-				}
-			}
+		if (as_socket_is_error(e)) {
+			status = as_socket_error(sock->fd, node, err, AEROSPIKE_ERR_CONNECTION, "Socket read error", e);
+			break;
 		}
-		else if (rv == 0) {
-			// Timeout.  Do not set error string to avoid affecting performance.
-			// Calling functions usually retry, so the error string is not used anyway.
-			status = err->code = AEROSPIKE_ERR_TIMEOUT;
-			err->message[0] = 0;
+
+		status = as_socket_wait(err, sock, node, socket_timeout, deadline, true);
+
+		if (status != AEROSPIKE_OK) {
 			break;
 		}
-		else if (rv == -1) {
-			int e = as_last_error();
-			if (e != AS_EINTR || as_socket_stop_on_interrupt) {
-				status = as_socket_error(sock->fd, node, err, AEROSPIKE_ERR_CONNECTION, "Socket read error", e);
-				break;
-			}
+	} while (pos < min_len);
+
+	if (pos > 0) {
+		// Response has started to arrive, so the connection was not stale.
+		sock->unvalidated = false;
+	}
+	as_node_add_bytes_in(node, pos);
+	*len = pos;
+	return status;
+}
+
+static void
+as_socket_rbuf_prepare(as_socket* sock, uint32_t len)
+{
+	// Make room for len contiguous bytes starting at rbuf_offset.
+	uint32_t avail = sock->rbuf_len - sock->rbuf_offset;
+
+	if (avail == 0) {
+		sock->rbuf_offset = 0;
+		sock->rbuf_len = 0;
+
+		if (sock->rbuf_capacity > AS_SOCKET_RBUF_MAX && len <= AS_SOCKET_RBUF_MAX) {
+			// Release memory used by a previous large proto block.
+			cf_free(sock->rbuf);
+			sock->rbuf = NULL;
+			sock->rbuf_capacity = 0;
 		}
-	
-		try++;
-	
-	} while (pos < buf_len);
+	}
+
+	if (sock->rbuf_offset + len <= sock->rbuf_capacity) {
+		return;
+	}
+
+	if (len <= sock->rbuf_capacity) {
+		// Move partially received bytes to the front.
+		memmove(sock->rbuf, sock->rbuf + sock->rbuf_offset, avail);
+	}
+	else {
+		uint32_t capacity = (len > AS_SOCKET_RBUF_SIZE)? len : AS_SOCKET_RBUF_SIZE;
+		uint8_t* rbuf = cf_malloc(capacity);
+
+		if (avail > 0) {
+			memcpy(rbuf, sock->rbuf + sock->rbuf_offset, avail);
+		}
+		cf_free(sock->rbuf);
+		sock->rbuf = rbuf;
+		sock->rbuf_capacity = capacity;
+	}
+	sock->rbuf_offset = 0;
+	sock->rbuf_len = avail;
+}
+
+static as_status
+as_socket_rbuf_fill(
+	as_error* err, as_socket* sock, as_node* node, uint32_t len, uint32_t socket_timeout,
+	uint64_t deadline
+	)
+{
+	// Ensure len bytes are available at rbuf_offset.  Plain sockets read as much as the
+	// kernel has buffered, which may include the following proto blocks.
+	as_socket_rbuf_prepare(sock, len);
+
+	uint32_t avail = sock->rbuf_len - sock->rbuf_offset;
 
-	as_poll_destroy(&poll);
+	if (avail >= len) {
+		return AEROSPIKE_OK;
+	}
+
+	size_t n;
+	as_status status = as_socket_read_fd(err, sock, node, sock->rbuf + sock->rbuf_len,
+		sock->rbuf_capacity - sock->rbuf_len, len - avail, socket_timeout, deadline, &n);
+
+	sock->rbuf_len += (uint32_t)n;
 	return status;
 }
+
+static as_status
+as_socket_zbuf_view(as_error* err, as_socket* sock, size_t len, uint8_t** view)
+{
+	// A compressed block always holds complete proto messages, so reads never span
+	// inflated and received bytes.
+	uint32_t avail = sock->zbuf_len - sock->zbuf_offset;
+
+	if (len > avail) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT,
+			"Invalid compressed proto: requested %zu bytes, remaining %u", len, avail);
+	}
+
+	*view = sock->zbuf + sock->zbuf_offset;
+	sock->zbuf_offset += (uint32_t)len;
+	return AEROSPIKE_OK;
+}
+
+uint8_t*
+as_socket_zbuf_prepare(as_socket* sock, uint32_t len)
+{
+	if (len > sock->zbuf_capacity ||
+		(sock->zbuf_capacity > AS_SOCKET_RBUF_MAX && len <= AS_SOCKET_RBUF_MAX)) {
+		// Grow buffer or release memory used by a previous large response.
+		uint32_t capacity = (len > AS_SOCKET_RBUF_SIZE)? len : AS_SOCKET_RBUF_SIZE;
+		cf_free(sock->zbuf);
+		sock->zbuf = cf_malloc(capacity);
+		sock->zbuf_capacity = capacity;
+	}
+	sock->zbuf_offset = 0;
+	sock->zbuf_len = 0;
+	return sock->zbuf;
+}
+
+as_status
+as_socket_read_deadline(
+	as_error* err, as_socket* sock, as_node* node, uint8_t *buf, size_t buf_len,
+	uint32_t socket_timeout, uint64_t deadline
+	)
+{
+	size_t n;
+
+	if (sock->zbuf_offset != sock->zbuf_len) {
+		// Consume inflated response bytes.
+		uint8_t* view;
+		as_status status = as_socket_zbuf_view(err, sock, buf_len, &view);
+
+		if (status == AEROSPIKE_OK) {
+			memcpy(buf, view, buf_len);
+		}
+		return status;
+	}
+
+	if (sock->ctx) {
+		return as_socket_read_fd(err, sock, node, buf, buf_len, buf_len, socket_timeout, deadline, &n);
+	}
+
+	// Consume bytes already received.
+	uint32_t avail = sock->rbuf_len - sock->rbuf_offset;
+
+	if (avail > 0) {
+		n = (buf_len < avail)? buf_len : avail;
+		memcpy(buf, sock->rbuf + sock->rbuf_offset, n);
+		sock->rbuf_offset += (uint32_t)n;
+
+		if (n == buf_len) {
+			return AEROSPIKE_OK;
+		}
+		buf += n;
+		buf_len -= n;
+	}
+
+	if (buf_len >= AS_SOCKET_RBUF_SIZE) {
+		// Large reads go directly into the caller's buffer.
+		return as_socket_read_fd(err, sock, node, buf, buf_len, buf_len, socket_timeout, deadline, &n);
+	}
+
+	// Small reads fill the receive buffer, so the proto header and the rest of the
+	// response are usually received in a single read.
+	as_status status = as_socket_rbuf_fill(err, sock, node, (uint32_t)buf_len, socket_timeout, deadline);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	memcpy(buf, sock->rbuf + sock->rbuf_offset, buf_len);
+	sock->rbuf_offset += (uint32_t)buf_len;
+	return AEROSPIKE_OK;
+}
+
+as_status
+as_socket_read_view(
+	as_error* err, as_socket* sock, as_node* node, size_t buf_len,
+	uint32_t socket_timeout, uint64_t deadline, uint8_t** view
+	)
+{
+	if (buf_len > UINT32_MAX) {
+		return as_error_update(err, AEROSPIKE_ERR_CLIENT, "Invalid proto size: %zu", buf_len);
+	}
+
+	if (sock->zbuf_offset != sock->zbuf_len) {
+		return as_socket_zbuf_view(err, sock, buf_len, view);
+	}
+
+	as_status status = as_socket_rbuf_fill(err, sock, node, (uint32_t)buf_len, socket_timeout, deadline);
+
+	if (status != AEROSPIKE_OK) {
+		return status;
+	}
+
+	*view = sock->rbuf + sock->rbuf_offset;
+	sock->rbuf_offset += (uint32_t)buf_len;
+	return AEROSPIKE_OK;
+}
@@ -139,9 +139,6 @@ protocols_parse(as_config_tls* tlscfg, uint16_t* oprotocols, as_error* errp)
 static int
 wait_socket(as_socket_fd fd, uint32_t socket_timeout, uint64_t deadline, bool read)
 {
-	as_poll poll;
-	as_poll_init(&poll, fd);
-
 	uint32_t timeout;
 	int rv;
 
@@ -164,7 +161,7 @@ wait_socket(as_socket_fd fd, uint32_t socket_timeout, uint64_t deadline, bool re
 			timeout = socket_timeout;
 		}
 
-		rv = as_poll_socket(&poll, fd, timeout, read);
+		rv = as_poll_wait(fd, timeout, read);
 
 		if (rv > 0) {
 			rv = 0;  // success
@@ -176,8 +173,6 @@ wait_socket(as_socket_fd fd, uint32_t socket_timeout, uint64_t deadline, bool re
 		}
 		// rv == 0 timeout.  continue in case timed out before real timeout.
 	}
-
-	as_poll_destroy(&poll);
 	return rv;
 }
 
@@ -25,6 +25,7 @@
 #include <aerospike/as_integer.h>
 #include <aerospike/as_list.h>
 #include <aerospike/as_map.h>
+#include <aerospike/as_operations.h>
 #include <aerospike/as_record.h>
 #include <aerospike/as_sleep.h>
 #include <aerospike/as_status.h>
@@ -181,6 +182,36 @@ TEST( batch_get_1 , "Simple" )
     assert_int_eq( data.errors , 0 );
 }
 
+TEST( batch_get_regroup , "Batch get with replica regrouping enabled" )
+{
+    as_error err;
+
+    as_batch batch;
+    as_batch_inita(&batch, N_KEYS);
+
+    for (uint32_t i = 0; i < N_KEYS; i++) {
+        as_key_init_int64(as_batch_keyat(&batch,i), NAMESPACE, SET, i+1);
+    }
+
+    // Node failures are retried by regrouping unanswered keys by replica.
+    as_policy_batch policy;
+    as_policy_batch_init(&policy);
+    policy.concurrent = true;
+    policy.replica = AS_POLICY_REPLICA_SEQUENCE;
+    policy.base.max_retries = 3;
+
+    batch_read_data data = {0};
+
+    aerospike_batch_get(as, &err, &policy, &batch, batch_get_1_callback, &data);
+    if ( err.code != AEROSPIKE_OK ) {
+        info("error(%d): %s", err.code, err.message);
+    }
+    assert_int_eq( err.code , AEROSPIKE_OK );
+
+    assert_int_eq( data.found , N_KEYS - N_KEYS/20);
+    assert_int_eq( data.errors , 0 );
+}
+
 TEST( batch_get_sequence , "Batch get in sequence" )
 {
     as_error err;
@@ -447,6 +478,146 @@ TEST( batch_read_complex , "Batch read complex" )
     assert_int_eq(errors, 0);
 }
 
+TEST( batch_read_arena , "Batch read with arena bins" )
+{
+	as_error err;
+	char str[64];
+
+	for (int64_t i = N_KEYS + 11; i <= N_KEYS + 12; i++) {
+		as_key key;
+		as_key_init_int64(&key, NAMESPACE, SET, i);
+
+		sprintf(str, "arena-%d", (int)i);
+
+		as_record rec;
+		as_record_inita(&rec, 2);
+		as_record_set_int64(&rec, "val", i);
+		as_record_set_str(&rec, "str", str);
+
+		as_status status = aerospike_key_put(as, &err, NULL, &key, &rec);
+		assert_int_eq(status, AEROSPIKE_OK);
+		as_record_destroy(&rec);
+	}
+
+	as_policy_batch policy;
+	as_policy_batch_init(&policy);
+	policy.concurrent = true;
+
+	as_record* copy = NULL;
+
+	for (int arena = 1; arena >= 0; arena--) {
+		policy.arena_bins = arena;
+
+		as_batch_read_records* records = as_batch_read_create(2);
+
+		for (int64_t i = N_KEYS + 11; i <= N_KEYS + 12; i++) {
+			as_batch_read_record* record = as_batch_read_reserve(records);
+			as_key_init_int64(&record->key, NAMESPACE, SET, i);
+			record->read_all_bins = true;
+		}
+
+		as_status status = aerospike_batch_read(as, &err, &policy, records);
+
+		if (status == AEROSPIKE_ERR_UNSUPPORTED_FEATURE) {
+			info("aerospike_batch_read() not supported by connected cluster");
+			as_batch_read_destroy(records);
+			return;
+		}
+		assert_int_eq(status, AEROSPIKE_OK);
+
+		for (uint32_t i = 0; i < 2; i++) {
+			as_batch_read_record* record = as_vector_get(&records->list, i);
+			assert_int_eq(record->result, AEROSPIKE_OK);
+
+			sprintf(str, "arena-%d", N_KEYS + 11 + i);
+			assert_string_eq(as_record_get_str(&record->record, "str"), str);
+		}
+
+		if (arena) {
+			// Keep a record beyond the batch.
+			as_batch_read_record* record = as_vector_get(&records->list, 1);
+			copy = as_record_copy(&record->record);
+		}
+		as_batch_read_destroy(records);
+	}
+
+	sprintf(str, "arena-%d", N_KEYS + 12);
+	assert_string_eq(as_record_get_str(copy, "str"), str);
+	as_record_destroy(copy);
+
+	for (int64_t i = N_KEYS + 11; i <= N_KEYS + 12; i++) {
+		as_key key;
+		as_key_init_int64(&key, NAMESPACE, SET, i);
+		aerospike_key_remove(as, &err, NULL, &key);
+	}
+}
+
+TEST( batch_write_complex , "Batch write complex" )
+{
+	as_operations ops;
+	as_operations_inita(&ops, 2);
+	as_operations_add_write_int64(&ops, "bw", 77);
+	as_operations_add_read(&ops, "bw");
+
+	as_batch_write_records records;
+	as_batch_write_inita(&records, 3);
+
+	// Operate on two new records with shared operations.
+	for (int64_t i = N_KEYS + 1; i <= N_KEYS + 2; i++) {
+		as_batch_write_record* record = as_batch_write_reserve(&records);
+		as_key_init_int64(&record->key, NAMESPACE, SET, i);
+		record->type = AS_BATCH_WRITE_OPERATE;
+		record->ops = &ops;
+	}
+
+	// Remove a record that does not exist.
+	as_batch_write_record* record = as_batch_write_reserve(&records);
+	as_key_init_int64(&record->key, NAMESPACE, SET, N_KEYS + 3);
+	record->type = AS_BATCH_WRITE_REMOVE;
+
+	as_error err;
+	as_status status = aerospike_batch_write(as, &err, NULL, NULL, &records);
+
+	if (status == AEROSPIKE_ERR_UNSUPPORTED_FEATURE) {
+		info("aerospike_batch_write() not supported by connected cluster");
+		as_batch_write_destroy(&records);
+		as_operations_destroy(&ops);
+		return;
+	}
+
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	as_vector* list = &records.list;
+
+	for (uint32_t i = 0; i < 2; i++) {
+		record = as_vector_get(list, i);
+		assert_int_eq(record->result, AEROSPIKE_OK);
+		assert_int_eq(as_record_get_int64(&record->record, "bw", -1), 77);
+	}
+
+	record = as_vector_get(list, 2);
+	assert_int_eq(record->result, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+	as_batch_write_destroy(&records);
+	as_operations_destroy(&ops);
+
+	// Remove the new records.
+	as_batch_write_inita(&records, 2);
+
+	for (int64_t i = N_KEYS + 1; i <= N_KEYS + 2; i++) {
+		record = as_batch_write_reserve(&records);
+		as_key_init_int64(&record->key, NAMESPACE, SET, i);
+	}
+
+	status = aerospike_batch_remove(as, &err, NULL, NULL, &records);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	for (uint32_t i = 0; i < 2; i++) {
+		record = as_vector_get(list, i);
+		assert_int_eq(record->result, AEROSPIKE_OK);
+	}
+	as_batch_write_destroy(&records);
+}
+
 TEST( batch_get_post , "Post: Remove Records" )
 {
     as_error err;
@@ -473,9 +644,12 @@ TEST( batch_get_post , "Post: Remove Records" )
 SUITE( batch_get, "aerospike_batch_get tests" ) {
     suite_add( batch_get_pre );
     suite_add( batch_get_1 );
+    suite_add( batch_get_regroup );
     suite_add( batch_get_sequence );
     suite_add( multithreaded_batch_get );
     suite_add( batch_get_bins );
     suite_add( batch_read_complex );
+    suite_add( batch_read_arena );
+    suite_add( batch_write_complex );
     suite_add( batch_get_post );
 }
@@ -17,8 +17,10 @@
 #include <aerospike/aerospike.h>
 #include <aerospike/aerospike_key.h>
 #include <aerospike/aerospike_scan.h>
+#include <aerospike/aerospike_stats.h>
 #include <aerospike/as_arraylist.h>
 #include <aerospike/as_buffer.h>
+#include <aerospike/as_cluster.h>
 #include <aerospike/as_error.h>
 #include <aerospike/as_hashmap.h>
 #include <aerospike/as_integer.h>
@@ -31,6 +33,7 @@
 #include <aerospike/as_string.h>
 #include <aerospike/as_stringmap.h>
 #include <aerospike/as_val.h>
+#include <citrusleaf/cf_clock.h>
 
 #include "../test.h"
 
@@ -212,6 +215,170 @@ TEST( key_basics_get , "get: (test,test,foo) = {a: 123, b: 'abc', c: 456, d: 'de
     as_record_destroy(rec);
 }
 
+TEST( key_basics_get_hedged , "get with hedged read policy: (test,test,hedged)" ) {
+
+	as_error err;
+	as_error_reset(&err);
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "hedged");
+
+	// Large value, so responses take long enough for a 1ms hedge delay to expire sometimes.
+	uint32_t size = 256 * 1024;
+	uint8_t* bytes = malloc(size);
+	memset(bytes, 7, size);
+
+	as_record r;
+	as_record_inita(&r, 1);
+	as_record_set_raw(&r, "a", bytes, size);
+	as_status rc = aerospike_key_put(as, &err, NULL, &key, &r);
+	as_record_destroy(&r);
+	free(bytes);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+
+	// A hedge can only be sent when the key has a prole on another node.
+	as_node* master;
+	as_node* prole;
+	rc = as_cluster_get_node(as->cluster, &err, NAMESPACE, key.digest.value,
+							 AS_POLICY_REPLICA_SEQUENCE, true, &master);
+	assert_int_eq( rc, AEROSPIKE_OK );
+	rc = as_cluster_get_node(as->cluster, &err, NAMESPACE, key.digest.value,
+							 AS_POLICY_REPLICA_SEQUENCE, false, &prole);
+	assert_int_eq( rc, AEROSPIKE_OK );
+	bool has_prole = prole != master;
+	as_node_release(master);
+	as_node_release(prole);
+
+	as_policy_read policy;
+	as_policy_read_init(&policy);
+	policy.replica = AS_POLICY_REPLICA_SEQUENCE;
+	policy.hedge_delay = 1;
+
+	aerospike_metrics_reset(as);
+
+	// Read until a hedge has been sent or time limit is reached.
+	uint64_t limit = cf_getms() + 5000;
+	uint64_t hedges = 0;
+	uint32_t reads = 0;
+
+	while (hedges == 0 && cf_getms() < limit) {
+		as_record* rec = NULL;
+		rc = aerospike_key_get(as, &err, &policy, &key, &rec);
+
+		assert_int_eq( rc, AEROSPIKE_OK );
+		assert_int_eq( as_record_numbins(rec), 1 );
+		as_bytes* b = as_record_get_bytes(rec, "a");
+		assert_not_null( b );
+		assert_int_eq( as_bytes_size(b), size );
+		as_record_destroy(rec);
+		reads++;
+
+		as_cluster_stats stats;
+		aerospike_stats(as, &stats);
+
+		for (uint32_t i = 0; i < stats.nodes_size; i++) {
+			hedges += stats.nodes[i].metrics.hedges;
+		}
+		aerospike_stats_destroy(&stats);
+
+		if (! has_prole) {
+			break;
+		}
+	}
+
+	aerospike_key_remove(as, &err, NULL, &key);
+	as_key_destroy(&key);
+
+	if (has_prole) {
+		info("hedge sent after %u reads", reads);
+		assert_true( hedges > 0 );
+	}
+	else {
+		// Single copy of the record.  There is no alternate node to hedge to.
+		assert_int_eq( hedges, 0 );
+	}
+}
+
+TEST( key_basics_get_metrics , "get records read latency in node metrics: (test,test,foo)" ) {
+
+	as_error err;
+	as_error_reset(&err);
+
+	aerospike_metrics_reset(as);
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "foo");
+
+	as_record* rec = NULL;
+	as_status rc = aerospike_key_get(as, &err, NULL, &key, &rec);
+
+	as_key_destroy(&key);
+	as_record_destroy(rec);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+
+	as_cluster_stats stats;
+	aerospike_stats(as, &stats);
+
+	uint64_t reads = 0;
+	uint64_t writes = 0;
+	uint64_t bytes_in = 0;
+
+	for (uint32_t i = 0; i < stats.nodes_size; i++) {
+		as_node_metrics* metrics = &stats.nodes[i].metrics;
+
+		for (uint32_t j = 0; j < AS_LATENCY_BUCKETS; j++) {
+			reads += metrics->latency[AS_LATENCY_TYPE_READ].buckets[j];
+			writes += metrics->latency[AS_LATENCY_TYPE_WRITE].buckets[j];
+		}
+		bytes_in += metrics->bytes_in;
+	}
+	aerospike_stats_destroy(&stats);
+
+	assert_true( reads >= 1 );
+	assert_int_eq( writes, 0 );
+	assert_true( bytes_in > 0 );
+}
+
+TEST( key_basics_get_skip_validation , "get records with pooled connection peek skipped: (test,test,foo)" ) {
+
+	as_error err;
+	as_error_reset(&err);
+
+	aerospike_metrics_reset(as);
+	as->cluster->skip_conn_validation = true;
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "foo");
+
+	// First get may open a new connection.  Second get reuses the pooled connection.
+	as_status rc = AEROSPIKE_OK;
+
+	for (int i = 0; i < 2 && rc == AEROSPIKE_OK; i++) {
+		as_record* rec = NULL;
+		rc = aerospike_key_get(as, &err, NULL, &key, &rec);
+		as_record_destroy(rec);
+	}
+
+	as->cluster->skip_conn_validation = false;
+	as_key_destroy(&key);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+
+	as_cluster_stats stats;
+	aerospike_stats(as, &stats);
+
+	uint64_t peeks_skipped = 0;
+
+	for (uint32_t i = 0; i < stats.nodes_size; i++) {
+		peeks_skipped += stats.nodes[i].metrics.conn_peeks_skipped;
+	}
+	aerospike_stats_destroy(&stats);
+
+	assert_true( peeks_skipped >= 1 );
+}
+
 TEST( key_basics_select , "select: (test,test,foo) = {a: 123, b: 'abc'}" ) {
 
 	as_error err;
@@ -683,10 +850,21 @@ TEST( key_basics_compression , "put with compression write policy: (test,test,fo
 	as_key key;
 	as_key_init(&key, NAMESPACE, SET, "foo_comp");
 
+	as_cluster_stats stats;
+	aerospike_stats(as, &stats);
+	uint64_t compressed = stats.compress.count;
+	aerospike_stats_destroy(&stats);
+
 	as_status rc = aerospike_key_put(as, &err, &wpol, &key, rec);
 	assert_int_eq( rc, AEROSPIKE_OK );
 	as_record_destroy(rec);
 
+	// Compression statistics include the put.
+	aerospike_stats(as, &stats);
+	assert_true( stats.compress.count > compressed );
+	assert_true( stats.compress.raw_bytes > stats.compress.zip_bytes );
+	aerospike_stats_destroy(&stats);
+
 	as_error_reset(&err);
 	as_record * rrec=NULL;
 	rc = aerospike_key_get(as, &err, NULL, &key, &rrec);
@@ -698,6 +876,101 @@ TEST( key_basics_compression , "put with compression write policy: (test,test,fo
 	as_record_destroy(rrec);
 }
 
+TEST( key_basics_compress_response , "get with compressed response: (test,test,foo_comp_rsp) = {a: <bytes>, b: 'abc'}" ) {
+
+	as_error err;
+	as_error_reset(&err);
+
+	int count = 20000;
+	uint8_t *mybytes = alloca (count);
+	memset(mybytes, 7, count);
+
+	as_record r, * rec = &r;
+	as_record_init(rec, 2);
+	as_record_set_rawp(rec, "a", mybytes, count, false);
+	as_record_set_str(rec, "b", "abc");
+
+	// Compress the command with a fast compression level.
+	as_policy_write wpol;
+	as_policy_write_init(&wpol);
+	wpol.compression_threshold = 1000;
+	wpol.compression_level = 1;
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "foo_comp_rsp");
+
+	as_status rc = aerospike_key_put(as, &err, &wpol, &key, rec);
+	assert_int_eq( rc, AEROSPIKE_OK );
+	as_record_destroy(rec);
+
+	// Ask the server to compress the response.
+	as_policy_read rpol;
+	as_policy_read_init(&rpol);
+	rpol.base.compress = true;
+
+	as_error_reset(&err);
+	as_record * rrec=NULL;
+	rc = aerospike_key_get(as, &err, &rpol, &key, &rrec);
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_string_eq( as_record_get_str(rrec, "b"), "abc" );
+
+	as_bytes* b = as_record_get_bytes(rrec, "a");
+	assert_not_null( b );
+	assert_int_eq( b->size, count );
+	assert_int_eq( memcmp(b->value, mybytes, count), 0 );
+
+	as_key_destroy(&key);
+	as_record_destroy(rrec);
+}
+
+TEST( key_basics_large_bins , "put large bins sent in place: (test,test,foo_large) = {a: <bytes>, b: 'abc', c: <string>}" ) {
+
+	as_error err;
+	as_error_reset(&err);
+
+	// Larger than AS_COMMAND_ZERO_COPY_MIN, so values are not copied into the command buffer.
+	uint32_t count = 100000;
+	uint8_t* mybytes = malloc(count);
+
+	for (uint32_t i = 0; i < count; i++) {
+		mybytes[i] = (uint8_t)i;
+	}
+
+	char* mystr = malloc(count + 1);
+	memset(mystr, 'x', count);
+	mystr[count] = 0;
+
+	as_record r, * rec = &r;
+	as_record_init(rec, 3);
+	as_record_set_rawp(rec, "a", mybytes, count, false);
+	as_record_set_str(rec, "b", "abc");
+	as_record_set_strp(rec, "c", mystr, false);
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "foo_large");
+
+	as_status rc = aerospike_key_put(as, &err, NULL, &key, rec);
+	assert_int_eq( rc, AEROSPIKE_OK );
+	as_record_destroy(rec);
+
+	as_error_reset(&err);
+	as_record * rrec=NULL;
+	rc = aerospike_key_get(as, &err, NULL, &key, &rrec);
+	assert_int_eq( rc, AEROSPIKE_OK );
+
+	as_bytes* b = as_record_get_bytes(rrec, "a");
+	assert_not_null( b );
+	assert_int_eq( as_bytes_size(b), count );
+	assert_true( memcmp(as_bytes_get(b), mybytes, count) == 0 );
+	assert_string_eq( as_record_get_str(rrec, "b"), "abc" );
+	assert_int_eq( strlen(as_record_get_str(rrec, "c")), count );
+
+	as_key_destroy(&key);
+	as_record_destroy(rrec);
+	free(mystr);
+	free(mybytes);
+}
+
 static bool scan_cb(const as_val * val, void * udata)
 {
 	uint64_t *result = (uint64_t *) udata;
@@ -780,6 +1053,114 @@ TEST( key_basics_storekey , "store key" ) {
 
 }
 
+TEST( key_basics_digests , "multi-key digests match single key digests" ) {
+
+	as_error err;
+	as_error_reset(&err);
+
+	uint32_t n_keys = 1003;
+	as_key* keys = malloc(sizeof(as_key) * n_keys);
+	as_key* expect = malloc(sizeof(as_key) * n_keys);
+	char big[200];
+	memset(big, 'x', sizeof(big) - 1);
+	big[sizeof(big) - 1] = 0;
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		char str[64];
+
+		switch (i % 3) {
+			case 0:
+				as_key_init_int64(&keys[i], NAMESPACE, "digest_set", i);
+				break;
+			case 1:
+				sprintf(str, "digest_key_%u", i);
+				as_key_init_strp(&keys[i], NAMESPACE, "digest_set", strdup(str), true);
+				break;
+			default:
+				// Too long for a digest lane.
+				as_key_init_strp(&keys[i], NAMESPACE, "digest_set", big, false);
+				break;
+		}
+		memcpy(&expect[i], &keys[i], sizeof(as_key));
+	}
+
+	uint64_t begin = cf_getus();
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		as_status rc = as_key_set_digest(&err, &expect[i]);
+		assert_int_eq(rc, AEROSPIKE_OK);
+	}
+
+	uint64_t single = cf_getus() - begin;
+	begin = cf_getus();
+
+	as_status rc = as_keys_set_digests(&err, keys, n_keys);
+
+	uint64_t multi = cf_getus() - begin;
+	info("digests: keys=%u single=%" PRIu64 "us multi=%" PRIu64 "us", n_keys, single, multi);
+
+	assert_int_eq(rc, AEROSPIKE_OK);
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		assert_true(keys[i].digest.init);
+		assert_int_eq(memcmp(keys[i].digest.value, expect[i].digest.value, AS_DIGEST_VALUE_SIZE), 0);
+	}
+
+	for (uint32_t i = 0; i < n_keys; i++) {
+		as_key_destroy(&keys[i]);
+	}
+	free(keys);
+	free(expect);
+}
+
+TEST( key_basics_wide_record , "put and get record with many bins: (test,test,foo_wide)" ) {
+
+	as_error err;
+	as_error_reset(&err);
+
+	uint16_t n_bins = 200;
+	as_record rec;
+	as_record_init(&rec, n_bins);
+
+	for (uint16_t i = 0; i < n_bins; i++) {
+		char name[AS_BIN_NAME_MAX_SIZE];
+		sprintf(name, "b%u", i);
+		assert_true(as_record_set_int64(&rec, name, i));
+	}
+
+	// Replacing existing bins must not append.
+	for (uint16_t i = 0; i < n_bins; i += 10) {
+		char name[AS_BIN_NAME_MAX_SIZE];
+		sprintf(name, "b%u", i);
+		assert_true(as_record_set_int64(&rec, name, i * 2));
+	}
+	assert_int_eq(as_record_numbins(&rec), n_bins);
+	assert_false(as_record_set_int64(&rec, "overflow", 1));
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "foo_wide");
+
+	as_status rc = aerospike_key_put(as, &err, NULL, &key, &rec);
+	assert_int_eq(rc, AEROSPIKE_OK);
+	as_record_destroy(&rec);
+
+	as_record* prec = NULL;
+	rc = aerospike_key_get(as, &err, NULL, &key, &prec);
+	assert_int_eq(rc, AEROSPIKE_OK);
+	assert_int_eq(as_record_numbins(prec), n_bins);
+
+	for (uint16_t i = 0; i < n_bins; i++) {
+		char name[AS_BIN_NAME_MAX_SIZE];
+		sprintf(name, "b%u", i);
+		int64_t expect = (i % 10 == 0)? i * 2 : i;
+		assert_int_eq(as_record_get_int64(prec, name, -1), expect);
+	}
+	assert_null(as_record_get(prec, "missing"));
+
+	as_record_destroy(prec);
+	as_key_destroy(&key);
+}
+
 /******************************************************************************
  * TEST SUITE
  *****************************************************************************/
@@ -797,6 +1178,9 @@ SUITE( key_basics, "aerospike_key basic tests" ) {
 	suite_add( key_basics_put_generation );
 	suite_add( key_basics_put );
 	suite_add( key_basics_get );
+	suite_add( key_basics_get_hedged );
+	suite_add( key_basics_get_metrics );
+	suite_add( key_basics_get_skip_validation );
 	suite_add( key_basics_select );
 	suite_add( key_basics_operate );
 	suite_add( key_basics_get2 );
@@ -808,5 +1192,9 @@ SUITE( key_basics, "aerospike_key basic tests" ) {
 	suite_add( key_basics_read_raw_list );
 	suite_add( key_basics_list_map_double );
 	suite_add( key_basics_compression );
+	suite_add( key_basics_compress_response );
+	suite_add( key_basics_large_bins );
 	suite_add( key_basics_storekey );
+	suite_add( key_basics_digests );
+	suite_add( key_basics_wide_record );
 }
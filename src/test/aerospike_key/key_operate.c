@@ -260,6 +260,61 @@ TEST( key_operate_float , "operate: (test,test,opfloat) = {append, read, write,
 	}
 }
 
+TEST( key_operate_template , "operate: (test,test,tmpl) = template {incr, write, read}" ) {
+
+	as_error err;
+	as_error_reset(&err);
+
+	as_key key;
+	as_key_init(&key, NAMESPACE, SET, "tmpl");
+
+	as_status rc = aerospike_key_remove(as, &err, NULL, &key);
+	assert_true( rc == AEROSPIKE_OK || rc == AEROSPIKE_ERR_RECORD_NOT_FOUND );
+
+	as_operations ops;
+	as_operations_inita(&ops, 4);
+	as_operations_add_incr(&ops, "count", 1);
+	as_operations_add_write_str(&ops, "name", "");
+	as_operations_add_read(&ops, "count");
+	as_operations_add_read(&ops, "name");
+
+	as_operations_template tmpl;
+	rc = as_operations_template_init(&tmpl, &err, &ops);
+	assert_int_eq( rc, AEROSPIKE_OK );
+	as_operations_destroy(&ops);
+
+	// Template values.
+	as_record* rec = NULL;
+	rc = aerospike_key_operate_template(as, &err, NULL, &key, &tmpl, NULL, &rec);
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_int_eq( as_record_get_int64(rec, "count", 0), 1 );
+	assert_string_eq( as_record_get_str(rec, "name"), "" );
+	as_record_destroy(rec);
+
+	// Replacement values.
+	as_template_args args;
+	as_template_args_inita(&args, &tmpl);
+	assert_true( as_template_args_set_int64(&args, 0, 5) );
+	assert_true( as_template_args_set_str(&args, 1, "template") );
+
+	rec = NULL;
+	rc = aerospike_key_operate_template(as, &err, NULL, &key, &tmpl, &args, &rec);
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_int_eq( as_record_get_int64(rec, "count", 0), 6 );
+	assert_string_eq( as_record_get_str(rec, "name"), "template" );
+	as_record_destroy(rec);
+
+	// Read operations do not have replaceable values.
+	as_template_args_clear(&args);
+	as_template_args_set_int64(&args, 2, 1);
+
+	rec = NULL;
+	rc = aerospike_key_operate_template(as, &err, NULL, &key, &tmpl, &args, &rec);
+	assert_int_eq( rc, AEROSPIKE_ERR_PARAM );
+
+	as_operations_template_destroy(&tmpl);
+}
+
 /******************************************************************************
  * TEST SUITE
  *****************************************************************************/
@@ -271,4 +326,5 @@ SUITE( key_operate, "aerospike_key_operate tests" ) {
 	suite_add( key_operate_9 );
 	suite_add( key_operate_gen_equal );
 	suite_add( key_operate_float );
+	suite_add( key_operate_template );
 }
@@ -0,0 +1,232 @@
+/*
+ * Copyright 2008-2018 Aerospike, Inc.
+ *
+ * Portions may be licensed to Aerospike, Inc. under one or more contributor
+ * license agreements.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may not
+ * use this file except in compliance with the License. You may obtain a copy of
+ * the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations under
+ * the License.
+ */
+#include <aerospike/aerospike.h>
+#include <aerospike/aerospike_key.h>
+#include <aerospike/aerospike_pipeline.h>
+#include <aerospike/as_error.h>
+#include <aerospike/as_integer.h>
+#include <aerospike/as_operations.h>
+#include <aerospike/as_record.h>
+#include <aerospike/as_status.h>
+
+#include "../test.h"
+
+/******************************************************************************
+ * GLOBAL VARS
+ *****************************************************************************/
+
+extern aerospike* as;
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+#define NAMESPACE "test"
+#define SET "pipe_sync"
+#define N_KEYS 50
+
+/******************************************************************************
+ * TEST CASES
+ *****************************************************************************/
+
+TEST(pipeline_sync_put_get, "pipeline put and get")
+{
+	as_error err;
+	as_pipeline pipeline;
+	aerospike_pipeline_begin(as, &pipeline);
+
+	// Small window forces several write/read rounds per node.
+	pipeline.window = 7;
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		as_key key;
+		as_key_init_int64(&key, NAMESPACE, SET, i);
+
+		as_record rec;
+		as_record_inita(&rec, 2);
+		as_record_set_int64(&rec, "a", i);
+		as_record_set_str(&rec, "b", "pipe");
+
+		as_status status = aerospike_pipeline_put(&pipeline, &err, NULL, &key, &rec);
+		assert_int_eq(status, AEROSPIKE_OK);
+
+		as_record_destroy(&rec);
+		as_key_destroy(&key);
+	}
+	assert_int_eq(as_pipeline_size(&pipeline), N_KEYS);
+
+	as_status status = aerospike_pipeline_flush(&pipeline, &err);
+	assert_int_eq(status, AEROSPIKE_OK);
+	assert_int_eq(as_pipeline_size(&pipeline), 0);
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		assert_int_eq(as_pipeline_get_result(&pipeline, i)->status, AEROSPIKE_OK);
+	}
+
+	// Read records back in a second flush.  The last key does not exist.
+	as_record* recs[N_KEYS + 1];
+
+	for (uint32_t i = 0; i <= N_KEYS; i++) {
+		as_key key;
+		as_key_init_int64(&key, NAMESPACE, SET, i);
+		recs[i] = NULL;
+
+		status = aerospike_pipeline_get(&pipeline, &err, NULL, &key, &recs[i]);
+		assert_int_eq(status, AEROSPIKE_OK);
+		as_key_destroy(&key);
+	}
+
+	status = aerospike_pipeline_flush(&pipeline, &err);
+	assert_int_eq(status, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		assert_int_eq(as_pipeline_get_result(&pipeline, i)->status, AEROSPIKE_OK);
+		assert_not_null(recs[i]);
+		assert_int_eq(as_record_get_int64(recs[i], "a", -1), i);
+		assert_string_eq(as_record_get_str(recs[i], "b"), "pipe");
+		as_record_destroy(recs[i]);
+	}
+	assert_int_eq(as_pipeline_get_result(&pipeline, N_KEYS)->status, AEROSPIKE_ERR_RECORD_NOT_FOUND);
+	assert_false(as_pipeline_get_result(&pipeline, N_KEYS)->in_doubt);
+	assert_null(recs[N_KEYS]);
+
+	aerospike_pipeline_end(&pipeline);
+}
+
+TEST(pipeline_sync_operate, "pipeline operate")
+{
+	as_error err;
+	as_pipeline pipeline;
+	aerospike_pipeline_begin(as, &pipeline);
+
+	as_record* recs[N_KEYS];
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		as_key key;
+		as_key_init_int64(&key, NAMESPACE, SET, i);
+
+		as_operations ops;
+		as_operations_inita(&ops, 2);
+		as_operations_add_incr(&ops, "a", 100);
+		as_operations_add_read(&ops, "a");
+		recs[i] = NULL;
+
+		as_status status = aerospike_pipeline_operate(&pipeline, &err, NULL, &key, &ops, &recs[i]);
+		assert_int_eq(status, AEROSPIKE_OK);
+
+		as_operations_destroy(&ops);
+		as_key_destroy(&key);
+	}
+
+	as_status status = aerospike_pipeline_flush(&pipeline, &err);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		assert_int_eq(as_pipeline_get_result(&pipeline, i)->status, AEROSPIKE_OK);
+		assert_int_eq(as_record_get_int64(recs[i], "a", -1), i + 100);
+		as_record_destroy(recs[i]);
+	}
+
+	// Queue errors are returned immediately and the command is not queued.
+	as_key key;
+	as_key_init_int64(&key, NAMESPACE, SET, 0);
+
+	as_operations ops;
+	as_operations_inita(&ops, 1);
+	status = aerospike_pipeline_operate(&pipeline, &err, NULL, &key, &ops, NULL);
+	assert_int_eq(status, AEROSPIKE_ERR_PARAM);
+	assert_int_eq(as_pipeline_size(&pipeline), 0);
+	as_operations_destroy(&ops);
+
+	for (uint32_t i = 0; i < N_KEYS; i++) {
+		as_key_init_int64(&key, NAMESPACE, SET, i);
+		aerospike_key_remove(as, &err, NULL, &key);
+	}
+
+	aerospike_pipeline_end(&pipeline);
+}
+
+TEST(pipeline_sync_operate_read_timeout, "pipeline read-only operate failure is not in doubt")
+{
+	as_error err;
+	as_key key;
+	as_key_init_int64(&key, NAMESPACE, SET, N_KEYS);
+
+	uint32_t size = 1024 * 1024;
+	uint8_t* bytes = malloc(size);
+	memset(bytes, 7, size);
+
+	as_record rec;
+	as_record_inita(&rec, 1);
+	as_record_set_raw(&rec, "blob", bytes, size);
+
+	as_status status = aerospike_key_put(as, &err, NULL, &key, &rec);
+	as_record_destroy(&rec);
+	free(bytes);
+	assert_int_eq(status, AEROSPIKE_OK);
+
+	// Responses to later commands can not all arrive within the 1ms total timeout.
+	as_policy_operate policy;
+	as_policy_operate_init(&policy);
+	policy.base.total_timeout = 1;
+	policy.base.max_retries = 2;
+
+	as_pipeline pipeline;
+	aerospike_pipeline_begin(as, &pipeline);
+
+	uint32_t n_cmds = 32;
+
+	for (uint32_t i = 0; i < n_cmds; i++) {
+		as_operations ops;
+		as_operations_inita(&ops, 1);
+		as_operations_add_read(&ops, "blob");
+
+		status = aerospike_pipeline_operate(&pipeline, &err, &policy, &key, &ops, NULL);
+		assert_int_eq(status, AEROSPIKE_OK);
+		as_operations_destroy(&ops);
+	}
+
+	status = aerospike_pipeline_flush(&pipeline, &err);
+	assert_int_ne(status, AEROSPIKE_OK);
+
+	uint32_t failed = 0;
+
+	for (uint32_t i = 0; i < n_cmds; i++) {
+		as_pipeline_result* result = as_pipeline_get_result(&pipeline, i);
+
+		if (result->status != AEROSPIKE_OK) {
+			assert_false(result->in_doubt);
+			failed++;
+		}
+	}
+	assert_true(failed > 0);
+	assert_false(err.in_doubt);
+
+	aerospike_pipeline_end(&pipeline);
+	aerospike_key_remove(as, &err, NULL, &key);
+}
+
+/******************************************************************************
+ * TEST SUITE
+ *****************************************************************************/
+
+SUITE(key_pipeline_sync, "aerospike sync pipeline tests")
+{
+	suite_add(pipeline_sync_put_get);
+	suite_add(pipeline_sync_operate);
+	suite_add(pipeline_sync_operate_read_timeout);
+}
@@ -70,6 +70,7 @@ typedef struct scan_check_s {
 	char * set;
 	bool nobindata; // flag to be set when you dont expect to get back any bins 
 	uint32_t count;
+	uint32_t limit;
 	char * bins[10];
 } scan_check;
 
@@ -374,6 +375,23 @@ static void insert_data(int numrecs, const char *setname)
 }
 
 
+static bool scan_abort_callback(const as_val * val, void * udata)
+{
+	scan_check * check = (scan_check *) udata;
+
+	if ( !val ) {
+		return false;
+	}
+
+	// Stop when limit is reached.  The record that stops the scan is returned again on resume.
+	if ( check->count >= check->limit ) {
+		return false;
+	}
+	check->count++;
+	return true;
+}
+
+
 /******************************************************************************
  * TEST CASES
  *****************************************************************************/
@@ -433,6 +451,63 @@ TEST( scan_basics_set1 , "scan "SET1"" ) {
 	as_scan_destroy(&scan);
 }
 
+TEST( scan_basics_set1_borrow , "scan "SET1" with borrowed bin values" ) {
+
+	scan_check check = {
+		.failed = false,
+		.set = SET1,
+		.count = 0,
+		.nobindata = false,
+		.bins = { "bin1", "bin2", "bin3", NULL }
+	};
+
+	as_error err;
+
+	as_scan scan;
+	as_scan_init(&scan, NS, SET1);
+
+	as_policy_scan policy;
+	as_policy_scan_init(&policy);
+	policy.borrow_bins = true;
+
+	as_status rc = aerospike_scan_foreach(as, &err, &policy, &scan, scan_check_callback, &check);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_false( check.failed );
+	assert_int_eq( check.count, NUM_RECS_SET1 );
+
+	as_scan_destroy(&scan);
+}
+
+TEST( scan_basics_set1_stream , "scan "SET1" with separate reader thread" ) {
+
+	scan_check check = {
+		.failed = false,
+		.set = SET1,
+		.count = 0,
+		.nobindata = false,
+		.bins = { "bin1", "bin2", "bin3", NULL }
+	};
+
+	as_error err;
+
+	as_scan scan;
+	as_scan_init(&scan, NS, SET1);
+
+	as_policy_scan policy;
+	as_policy_scan_init(&policy);
+	policy.stream_buffers = 2;
+	policy.borrow_bins = true;
+
+	as_status rc = aerospike_scan_foreach(as, &err, &policy, &scan, scan_check_callback, &check);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_false( check.failed );
+	assert_int_eq( check.count, NUM_RECS_SET1 );
+
+	as_scan_destroy(&scan);
+}
+
 TEST( scan_predexp_set1 , "scan "SET1" w/ 25 <= bin1 <= 33" ) {
 
 	scan_check check = {
@@ -495,6 +570,71 @@ TEST( scan_basics_set1_concurrent , "scan "SET1" concurrently" ) {
 	as_scan_destroy(&scan);
 }
 
+TEST( scan_basics_set1_partitions , "scan "SET1" by partition and resume from cursor" ) {
+
+	scan_check check = {
+		.failed = false,
+		.set = SET1,
+		.count = 0,
+		.nobindata = false,
+		.bins = { "bin1", "bin2", "bin3", NULL }
+	};
+
+	as_error err;
+
+	as_scan scan;
+	as_scan_init(&scan, NS, SET1);
+	as_scan_set_concurrent(&scan, true);
+
+	// Scan first half of partitions.
+	as_partition_filter pf;
+	as_partition_filter_set_range(&pf, 0, 2048);
+
+	as_status rc = aerospike_scan_partitions(as, &err, NULL, &scan, &pf, scan_check_callback, &check);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_false( check.failed );
+	assert_not_null( pf.parts_all );
+	assert_true( pf.parts_all->done );
+	as_partition_filter_destroy(&pf);
+
+	// Stop second half early, then resume from a cursor that has been persisted and restored.
+	as_partition_filter_set_range(&pf, 2048, 2048);
+	as_scan_set_concurrent(&scan, false);
+	check.limit = check.count + 10;
+
+	rc = aerospike_scan_partitions(as, &err, NULL, &scan, &pf, scan_abort_callback, &check);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_not_null( pf.parts_all );
+
+	uint32_t size;
+	uint8_t* buf = as_partitions_status_serialize(pf.parts_all, &size);
+	as_partition_filter_destroy(&pf);
+
+	as_partitions_status* parts_all;
+	rc = as_partitions_status_deserialize(&err, buf, size, &parts_all);
+	cf_free(buf);
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_int_eq( parts_all->part_begin, 2048 );
+	assert_int_eq( parts_all->part_count, 2048 );
+
+	as_partition_filter_set_partitions(&pf, parts_all);
+	as_partitions_status_release(parts_all);
+
+	rc = aerospike_scan_partitions(as, &err, NULL, &scan, &pf, scan_check_callback, &check);
+
+	assert_int_eq( rc, AEROSPIKE_OK );
+	assert_false( check.failed );
+	assert_true( pf.parts_all->done );
+	as_partition_filter_destroy(&pf);
+
+	assert_int_eq( check.count, NUM_RECS_SET1 );
+	info("Got %d records in the partition scan. Expected %d", check.count, NUM_RECS_SET1);
+
+	as_scan_destroy(&scan);
+}
+
 TEST( scan_basics_set1_select , "scan "SET1" and select 'bin1'" ) {
 
 	scan_check check = {
@@ -931,8 +1071,11 @@ SUITE( scan_basics, "aerospike_scan basic tests" ) {
 
 	suite_add( scan_basics_null_set );
 	suite_add( scan_basics_set1 );
+	suite_add( scan_basics_set1_borrow );
+	suite_add( scan_basics_set1_stream );
 	suite_add( scan_predexp_set1 );
 	suite_add( scan_basics_set1_concurrent );
+	suite_add( scan_basics_set1_partitions );
 	suite_add( scan_basics_set1_select );
 	suite_add( scan_basics_set1_nodata );
 	suite_add( scan_basics_background );
@@ -373,6 +373,7 @@ PLAN(aerospike_test) {
 	plan_add(key_apply);
 	plan_add(key_apply2);
 	plan_add(key_operate);
+	plan_add(key_pipeline_sync);
 
 	// cdt
 	plan_add(list_basics);